@@ -18,11 +18,19 @@
 #include "itkImageToImageMetric.h"
 
 #include "itkImageSamplerBase.h"
+#include "itkReadOnlyImageSampler.h"
 #include "itkGradientImageFilter.h"
 #include "itkBSplineInterpolateImageFunction.h"
 #include "itkLimiterFunctionBase.h"
 #include "itkFixedArray.h"
 #include "itkAdvancedTransform.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkImportImageContainer.h"
+#include "itkMultiThreader.h"
+#include "elxProfiler.h"
+
+#include <vector>
+#include <string>
 
 namespace itk
 {
@@ -52,6 +60,24 @@ namespace itk
  *   unless you have a good reason for it...
  * \li Some convenience functions are provided, such as the IsInsideMovingMask
  *   and CheckNumberOfSamples.
+ * \li Multi-threading support: the sample container is split in chunks, which
+ *   are processed by separate threads. Each thread has its own copy of the
+ *   measure, derivative and number of pixels counted, which are combined
+ *   afterwards. Inheriting metrics have to implement ThreadedGetValueAndDerivative()
+ *   to make use of this. The number of threads follows the global maximum set
+ *   by the MultiThreader, i.e. the -threads command line argument of elastix.
+ * \li Concurrent copies: CreateConcurrentCopies() creates copies of the metric that
+ *   shares the read-only setup (images, interpolator, masks, limiters), but
+ *   has its own transform and its own intermediate results. A metric and its
+ *   copies can compute their value and derivative at the same time, in
+ *   different threads, which optimizers use to evaluate several parameter
+ *   vectors at once. Updating an image sampler is not thread-safe, so a copy
+ *   has a ReadOnlyImageSampler, which copies the samples of the sampler of
+ *   this metric. That sampler has to be updated in the calling thread
+ *   first, by PrepareConcurrentEvaluation(). Inheriting
+ *   metrics that have more settings, or buffers allocated by Initialize(),
+ *   extend InitializeConcurrentCopy(), and declare this by setting
+ *   m_SupportsConcurrentCopies.
  *
  * \ingroup RegistrationMetrics
  *
@@ -116,6 +142,7 @@ public:
   typedef typename MovingImageType::RegionType            MovingImageRegionType;
   typedef FixedArray< double,
     itkGetStaticConstMacro(MovingImageDimension) >        MovingImageDerivativeScalesType;
+  typedef std::vector< Pointer >                          ConcurrentCopyContainerType;
 
   /** Typedefs for the ImageSampler. */
   typedef ImageSamplerBase< FixedImageType >              ImageSamplerType;
@@ -211,16 +238,92 @@ public:
   itkSetMacro( MovingImageDerivativeScales, MovingImageDerivativeScalesType );
   itkGetConstReferenceMacro( MovingImageDerivativeScales, MovingImageDerivativeScalesType );
 
+  /** Set/Get whether to evaluate the moving image value and derivative from
+   * a packed image, which is computed once in Initialize(). For each voxel it
+   * stores the value and the gradient next to each other, in floats, so in 3D
+   * a voxel takes 16 bytes. The value and the gradient are then obtained
+   * together by linear interpolation of the packed image, which is much
+   * cheaper than evaluating a B-spline interpolator and its derivative.
+   * NB: the moving image is then linearly interpolated, also when a B-spline
+   * interpolator was set. The gradient is the (central difference) gradient
+   * image, linearly interpolated. Intended for the large images of the first
+   * resolutions; default false. */
+  itkSetMacro( UsePackedMovingImage, bool );
+  itkGetConstMacro( UsePackedMovingImage, bool );
+
+  /** Set/Get whether to use multi-threading for the computation of the
+   * value and derivative. Only metrics that implement the
+   * ThreadedGetValueAndDerivative() function make use of this; default false. */
+  itkSetMacro( UseMultiThread, bool );
+  itkGetConstMacro( UseMultiThread, bool );
+
+  /** Set/Get the number of threads used by the metric. The default is the
+   * MultiThreader's global default, which respects the global maximum. */
+  virtual void SetNumberOfThreads( unsigned int numberOfThreads )
+  {
+    this->m_Threader->SetNumberOfThreads( numberOfThreads );
+    this->Modified();
+  }
+  virtual unsigned int GetNumberOfThreads( void ) const
+  {
+    return this->m_Threader->GetNumberOfThreads();
+  }
+
+  /** Set/Get whether the caller takes care of the transform parameters.
+   * If true, SetTransformParameters() leaves the transform alone. The
+   * CombinationImageToImageMetric sets the parameters of the shared
+   * transform once, and then evaluates its sub metrics concurrently with
+   * this flag on: setting the parameters from several threads at the same
+   * time is a race, since e.g. the B-spline transform rewraps its
+   * coefficient images. Default false. */
+  itkSetMacro( TransformParametersAreSetExternally, bool );
+  itkGetConstMacro( TransformParametersAreSetExternally, bool );
+
+  /** Set the parameters of the transform, unless
+   * TransformParametersAreSetExternally. This hides the non-virtual
+   * ImageToImageMetric::SetTransformParameters(). */
+  void SetTransformParameters( const ParametersType & parameters ) const;
+
   /** Initialize the Metric by making sure that all the components
    *  are present and plugged together correctly.
    * \li Call the superclass' implementation
    * \li Cache the number of transform parameters
    * \li Initialize the image sampler, if used.
    * \li Check if a B-spline interpolator has been set
+   * \li Compute the packed moving image, if wanted
    * \li Check if an AdvancedTransform has been set
    */
   virtual void Initialize( void ) throw ( ExceptionObject );
 
+  /** Create numberOfCopies copies of this metric, that can compute their
+   * value and derivative in other threads at the same time as this metric.
+   * A copy shares the read-only setup of this metric, and has its own copy
+   * of the transform. Call it after Initialize(); create new copies after
+   * every Initialize(). The threads of this metric are divided among this
+   * metric and the copies, which are assumed to be evaluated at the same
+   * time.
+   * Copies are only made if the metric supports them (see
+   * GetSupportsConcurrentCopies()) and GetIsDefinedByParameters() of the
+   * transform is true. Otherwise, or if copying fails, copies is left
+   * empty, false is returned, and reason tells why. The copies are not
+   * evaluated; PrepareConcurrentEvaluation() provides their samples. */
+  virtual bool CreateConcurrentCopies( unsigned int numberOfCopies,
+    ConcurrentCopyContainerType & copies, std::string & reason ) const;
+
+  /** Whether InitializeConcurrentCopy() copies all settings of the metric,
+   * so that CreateConcurrentCopies() can be used. False by default; set to
+   * true in the constructor of a metric that does. A subclass that adds
+   * settings has to extend InitializeConcurrentCopy(), or set it to false.
+   */
+  itkGetConstMacro( SupportsConcurrentCopies, bool );
+
+  /** Update what the concurrent copies share with this metric, before this
+   * metric and its copies are evaluated at the same time. Call it in the
+   * calling thread, e.g. via ConcurrentCostFunctionEvaluator::SetPrepareCommand().
+   * It updates the image sampler, of which the copies copy the samples, so
+   * that the evaluation of this metric finds it up to date. */
+  virtual void PrepareConcurrentEvaluation( void );
+
   /** Experimental feature: compute SelfHessian.
    * This base class just returns an identity matrix of the right size. */
   virtual void GetSelfHessian( const TransformParametersType & parameters, HessianType & H ) const;
@@ -255,10 +358,51 @@ protected:
   typedef GradientImageFilter<
     MovingImageType, RealType, RealType>                        CentralDifferenceGradientFilterType;
 
+  /** Typedefs for the packed moving image. Each voxel holds the value,
+   * followed by the gradient. The buffer is reference counted, so that
+   * concurrent copies of the metric can share it. */
+  typedef float                                                 PackedMovingImageValueType;
+  typedef ImportImageContainer<
+    unsigned long, PackedMovingImageValueType >                 PackedMovingImageType;
+  itkStaticConstMacro( PackedMovingImageStride, unsigned int,
+    MovingImageDimension + 1 );
+
   /** Typedefs for support of sparse Jacobians and compact support of transformations. */
   typedef typename
     AdvancedTransformType::NonZeroJacobianIndicesType           NonZeroJacobianIndicesType;
 
+  /** Typedefs for concurrent copies. */
+  typedef AdvancedImageToImageMetric<
+    TFixedImage, TMovingImage >                                 AdvancedImageToImageMetricType;
+  typedef AdvancedCombinationTransform<
+    ScalarType, FixedImageDimension >                           CombinationTransformType;
+
+  /** Typedefs for multi-threading. */
+  typedef MultiThreader                                         ThreaderType;
+  typedef typename ThreaderType::ThreadInfoStruct               ThreadInfoType;
+
+  /** Struct that is passed as user data to the threader callbacks. */
+  struct MultiThreaderParameterType
+  {
+    const Self *            st_Metric;
+    DerivativeValueType *   st_DerivativePointer;
+  };
+
+  /** Variables that each thread computes in ThreadedGetValueAndDerivative.
+   * Every thread writes only to its own struct, so no locking is needed.
+   * An exception of the thread is stored, and thrown after all threads
+   * have finished. */
+  struct GetValueAndDerivativePerThreadStruct
+  {
+    unsigned long   st_NumberOfPixelsCounted;
+    MeasureType     st_Value;
+    DerivativeType  st_Derivative;
+    bool            st_Failed;
+    ExceptionObject st_Exception;
+  };
+  typedef std::vector<
+    GetValueAndDerivativePerThreadStruct >                      GetValueAndDerivativePerThreadType;
+
   /** Protected Variables **************/
 
   /** Variables for ImageSampler support. m_ImageSampler is mutable, because it is
@@ -272,6 +416,11 @@ protected:
   typename BSplineInterpolatorFloatType::Pointer             m_BSplineInterpolatorFloat;
   typename CentralDifferenceGradientFilterType::Pointer m_CentralDifferenceGradientFilter;
 
+  /** Variables for the packed moving image. */
+  typename PackedMovingImageType::Pointer m_PackedMovingImage;
+  MovingImageRegionType   m_PackedMovingImageRegion;
+  unsigned long           m_PackedMovingImageOffsetTable[ MovingImageDimension ];
+
   /** Variables to store the AdvancedTransform. */
   bool m_TransformIsAdvanced;
   typename AdvancedTransformType::Pointer           m_AdvancedTransform;
@@ -288,6 +437,11 @@ protected:
   MovingImageLimiterOutputType                       m_MovingImageMinLimit;
   MovingImageLimiterOutputType                       m_MovingImageMaxLimit;
 
+  /** Variables for multi-threading. */
+  typename ThreaderType::Pointer                     m_Threader;
+  mutable MultiThreaderParameterType                 m_ThreaderMetricParameters;
+  mutable GetValueAndDerivativePerThreadType         m_GetValueAndDerivativePerThreadVariables;
+
   /** Protected methods ************** */
 
   /** Methods for image sampler support **********/
@@ -316,12 +470,25 @@ protected:
    * If a BSplineInterpolationFunction is used, this class obtain
    * image derivatives from the BSpline interpolator. Otherwise,
    * image derivatives are computed using nearest neighbor interpolation
-   * of a precomputed (central difference) gradient image. */
+   * of a precomputed (central difference) gradient image. If the packed
+   * moving image is used, value and derivative are both linearly interpolated
+   * in the packed image. */
   virtual bool EvaluateMovingImageValueAndDerivative(
     const MovingImagePointType & mappedPoint,
     RealType & movingImageValue,
     MovingImageDerivativeType * gradient ) const;
 
+  /** Compute the packed moving image if UsePackedMovingImage is true, and
+   * release it otherwise; called by Initialize. */
+  virtual void InitializePackedMovingImage( void );
+
+  /** Linearly interpolate the value, and possibly the gradient, in the
+   * packed moving image. The continuous index should be inside the buffer. */
+  void EvaluatePackedMovingImageValueAndDerivative(
+    const MovingImageContinuousIndexType & cindex,
+    RealType & movingImageValue,
+    MovingImageDerivativeType * gradient ) const;
+
   /** Methods to support transforms with sparse Jacobians, like the BSplineTransform **********/
 
   /** Check if the transform is an AdvancedTransform. Called by Initialize. */
@@ -335,6 +502,18 @@ protected:
     const FixedImagePointType & fixedImagePoint,
     MovingImagePointType & mappedPoint ) const;
 
+  /** Transform the points of the samples [begin, end) of the sample
+   * container at once, with the batch TransformPoints() of the advanced
+   * transform. The fixed and mapped points are stored in the given
+   * buffers, which are resized when needed, so that their memory can be
+   * reused by the caller. Returns true, like TransformPoint().
+   */
+  virtual bool TransformPoints(
+    const ImageSampleContainerType * sampleContainer,
+    unsigned long begin, unsigned long end,
+    std::vector< FixedImagePointType > & fixedPoints,
+    std::vector< MovingImagePointType > & mappedPoints ) const;
+
   /** This function returns a reference to the transform Jacobians.
    * This is either a reference to the full TransformJacobian or
    * a reference to a sparse Jacobians.
@@ -374,12 +553,61 @@ protected:
   itkSetMacro( UseFixedImageLimiter, bool );
   itkSetMacro( UseMovingImageLimiter, bool );
 
+  /** Methods for multi-threading support. ***************/
+
+  /** Allocate and reset the per-thread variables. Called before launching
+   * the threads, so it also handles a changed number of parameters. */
+  virtual void InitializeThreadingParameters( void ) const;
+
+  /** Compute the range [begin, end) of samples that a thread processes. */
+  virtual void GetThreadSampleRange( unsigned int threadID,
+    unsigned long numberOfSamples,
+    unsigned long & begin, unsigned long & end ) const;
+
+  /** Launch the threads that call ThreadedGetValueAndDerivative(), and
+   * throw the exception of the first thread that failed, if any. */
+  virtual void LaunchGetValueAndDerivativeThreaderCallback( void ) const;
+
+  /** GetValueAndDerivative threader callback function. */
+  static ITK_THREAD_RETURN_TYPE GetValueAndDerivativeThreaderCallback( void * arg );
+
+  /** Compute the value and derivative contribution of the samples of one
+   * thread, and store them in m_GetValueAndDerivativePerThreadVariables.
+   * Inheriting metrics that support multi-threading have to override this;
+   * this implementation throws an exception. */
+  virtual void ThreadedGetValueAndDerivative( unsigned int threadID ) const;
+
+  /** Sum the per-thread number of pixels counted, values and derivatives.
+   * The result is not normalized; m_NumberOfPixelsCounted is updated.
+   * The derivatives are summed multi-threaded, over chunks of parameters. */
+  virtual void AccumulateThreadedValueAndDerivative(
+    MeasureType & value, DerivativeType & derivative ) const;
+
+  /** AccumulateDerivatives threader callback function. */
+  static ITK_THREAD_RETURN_TYPE AccumulateDerivativesThreaderCallback( void * arg );
+
+  /** Methods for concurrent copies. ***************/
+
+  /** Pass the setup of this metric to a copy of the same type, which
+   * already has its own transform. Shares the images, interpolator, masks,
+   * image sampler, limiters and packed moving image, and copies the
+   * settings. Inheriting metrics extend this for their own settings and
+   * buffers; they should call the Superclass' implementation first. */
+  virtual void InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const;
+
+  /** Create a transform of the same type, with the same fixed parameters
+   * and parameters. The initial transform of a combination transform is
+   * shared. Returns 0 if this is not possible, or if the transform is not
+   * defined by its parameters, see AdvancedTransform::GetIsDefinedByParameters(). */
+  virtual TransformPointer CreateConcurrentTransformCopy( void ) const;
+
 private:
   AdvancedImageToImageMetric(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
 
   /** Private member variables. */
   bool    m_UseImageSampler;
+  bool    m_SupportsConcurrentCopies;
   double  m_FixedLimitRangeRatio;
   double  m_MovingLimitRangeRatio;
   bool    m_UseFixedImageLimiter;
@@ -387,6 +615,9 @@ private:
   double  m_RequiredRatioOfValidSamples;
   bool    m_UseMovingImageDerivativeScales;
   MovingImageDerivativeScalesType m_MovingImageDerivativeScales;
+  bool    m_UseMultiThread;
+  bool    m_UsePackedMovingImage;
+  bool    m_TransformParametersAreSetExternally;
 
 }; // end class AdvancedImageToImageMetric
 
@@ -18,6 +18,8 @@
 #include "itkAdvancedImageToImageMetric.h"
 #include "itkImageRegionConstIterator.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "vcl_cmath.h"
+#include <typeinfo>
 
 namespace itk
 {
@@ -40,6 +42,7 @@ AdvancedImageToImageMetric<TFixedImage,TMovingImage>
 
   this->m_ImageSampler = 0;
   this->m_UseImageSampler = false;
+  this->m_SupportsConcurrentCopies = false;
   this->m_RequiredRatioOfValidSamples = 0.25;
 
   this->m_BSplineInterpolator = 0;
@@ -47,6 +50,12 @@ AdvancedImageToImageMetric<TFixedImage,TMovingImage>
   this->m_InterpolatorIsBSpline = false;
   this->m_InterpolatorIsBSplineFloat = false;
   this->m_CentralDifferenceGradientFilter = 0;
+  this->m_UsePackedMovingImage = false;
+  this->m_PackedMovingImage = 0;
+  for ( unsigned int i = 0; i < MovingImageDimension; ++i )
+  {
+    this->m_PackedMovingImageOffsetTable[ i ] = 0;
+  }
 
   this->m_AdvancedTransform = 0;
   this->m_TransformIsAdvanced = false;
@@ -67,6 +76,15 @@ AdvancedImageToImageMetric<TFixedImage,TMovingImage>
   this->m_MovingImageMinLimit = NumericTraits< MovingImageLimiterOutputType >::Zero;
   this->m_MovingImageMaxLimit = NumericTraits< MovingImageLimiterOutputType >::One;
 
+  /** Multi-threading. The threader's default number of threads respects
+   * the global maximum, which is set by the -threads command line argument.
+   */
+  this->m_UseMultiThread = false;
+  this->m_TransformParametersAreSetExternally = false;
+  this->m_Threader = ThreaderType::New();
+  this->m_ThreaderMetricParameters.st_Metric = this;
+  this->m_ThreaderMetricParameters.st_DerivativePointer = 0;
+
 } // end Constructor
 
 
@@ -91,12 +109,32 @@ AdvancedImageToImageMetric<TFixedImage,TMovingImage>
   /** Check if the interpolator is a B-spline interpolator. */
   this->CheckForBSplineInterpolator();
 
+  /** Compute the packed moving image, if wanted. */
+  this->InitializePackedMovingImage();
+
   /** Check if the transform is an advanced transform. */
   this->CheckForAdvancedTransform();
 
 } // end Initialize()
 
 
+/**
+ * ******************* SetTransformParameters ***********************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::SetTransformParameters( const ParametersType & parameters ) const
+{
+  if ( !this->m_TransformParametersAreSetExternally )
+  {
+    this->Superclass::SetTransformParameters( parameters );
+  }
+
+} // end SetTransformParameters()
+
+
 /**
  * ****************** ComputeFixedImageExtrema ***************************
  */
@@ -374,6 +412,70 @@ AdvancedImageToImageMetric<TFixedImage,TMovingImage>
 } // end CheckForBSplineInterpolator()
 
 
+/**
+ * ****************** InitializePackedMovingImage **********************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::InitializePackedMovingImage( void )
+{
+  /** Release the memory if the packed image is not wanted. */
+  if ( !this->m_UsePackedMovingImage )
+  {
+    this->m_PackedMovingImage = 0;
+    return;
+  }
+
+  /** Use the gradient image if it exists, otherwise compute the central
+   * difference gradient just for packing it. */
+  GradientImagePointer gradientImage = this->m_GradientImage;
+  if ( gradientImage.IsNull() )
+  {
+    typename CentralDifferenceGradientFilterType::Pointer gradientFilter
+      = CentralDifferenceGradientFilterType::New();
+    gradientFilter->SetUseImageSpacing( true );
+    gradientFilter->SetInput( this->m_MovingImage );
+    gradientFilter->Update();
+    gradientImage = gradientFilter->GetOutput();
+  }
+
+  /** Store the geometry of the buffer. */
+  this->m_PackedMovingImageRegion = this->m_MovingImage->GetBufferedRegion();
+  const unsigned long numberOfVoxels
+    = this->m_PackedMovingImageRegion.GetNumberOfPixels();
+  unsigned long offset = PackedMovingImageStride;
+  for ( unsigned int i = 0; i < MovingImageDimension; ++i )
+  {
+    this->m_PackedMovingImageOffsetTable[ i ] = offset;
+    offset *= this->m_PackedMovingImageRegion.GetSize()[ i ];
+  }
+
+  /** Interleave the values and the gradients. A new buffer is created, so
+   * that concurrent copies of the metric keep using the old one. */
+  this->m_PackedMovingImage = PackedMovingImageType::New();
+  this->m_PackedMovingImage->Reserve( numberOfVoxels * PackedMovingImageStride );
+  typedef ImageRegionConstIterator< MovingImageType >   MovingIteratorType;
+  typedef ImageRegionConstIterator< GradientImageType > GradientIteratorType;
+  MovingIteratorType mit( this->m_MovingImage, this->m_PackedMovingImageRegion );
+  GradientIteratorType git( gradientImage, this->m_PackedMovingImageRegion );
+  PackedMovingImageValueType * packed = this->m_PackedMovingImage->GetBufferPointer();
+  for ( mit.GoToBegin(), git.GoToBegin(); !mit.IsAtEnd(); ++mit, ++git )
+  {
+    *packed = static_cast<PackedMovingImageValueType>( mit.Get() );
+    ++packed;
+    const GradientPixelType & grad = git.Get();
+    for ( unsigned int i = 0; i < MovingImageDimension; ++i )
+    {
+      *packed = static_cast<PackedMovingImageValueType>( grad[ i ] );
+      ++packed;
+    }
+  }
+
+} // end InitializePackedMovingImage()
+
+
 /**
  * ****************** CheckForAdvancedTransform **********************
  * Check if the transform is of type AdvancedTransform.
@@ -426,7 +528,20 @@ AdvancedImageToImageMetric<TFixedImage,TMovingImage>
   MovingImageContinuousIndexType cindex;
   this->m_Interpolator->ConvertPointToContinuousIndex( mappedPoint, cindex );
   bool sampleOk = this->m_Interpolator->IsInsideBuffer( cindex );
-  if ( sampleOk )
+  if ( sampleOk && this->m_PackedMovingImage.IsNotNull() )
+  {
+    /** Compute value and possibly derivative in one go. */
+    this->EvaluatePackedMovingImageValueAndDerivative(
+      cindex, movingImageValue, gradient );
+    if ( gradient && this->m_UseMovingImageDerivativeScales )
+    {
+      for ( unsigned int i = 0; i < MovingImageDimension; ++i )
+      {
+        (*gradient)[ i ] *= this->m_MovingImageDerivativeScales[ i ];
+      }
+    }
+  }
+  else if ( sampleOk )
   {
     /** Compute value and possibly derivative. */
     movingImageValue = this->m_Interpolator->EvaluateAtContinuousIndex( cindex );
@@ -471,6 +586,92 @@ AdvancedImageToImageMetric<TFixedImage,TMovingImage>
 } // end EvaluateMovingImageValueAndDerivative()
 
 
+/**
+ * ************** EvaluatePackedMovingImageValueAndDerivative ***************
+ */
+
+template < class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::EvaluatePackedMovingImageValueAndDerivative(
+  const MovingImageContinuousIndexType & cindex,
+  RealType & movingImageValue,
+  MovingImageDerivativeType * gradient ) const
+{
+  /** Compute the offset of the voxel below cindex and the distances to it.
+   * Near the border the voxel is clamped to the buffer, with distance zero,
+   * so that no voxel outside the buffer gets a nonzero weight. */
+  const MovingImageIndexType & startIndex = this->m_PackedMovingImageRegion.GetIndex();
+  const typename MovingImageRegionType::SizeType & size
+    = this->m_PackedMovingImageRegion.GetSize();
+  double distance[ MovingImageDimension ];
+  unsigned long baseOffset = 0;
+  for ( unsigned int i = 0; i < MovingImageDimension; ++i )
+  {
+    const double position = cindex[ i ] - static_cast<double>( startIndex[ i ] );
+    const long lastIndex = static_cast<long>( size[ i ] ) - 1;
+    long baseIndex = static_cast<long>( vcl_floor( position ) );
+    distance[ i ] = position - static_cast<double>( baseIndex );
+    if ( baseIndex < 0 )
+    {
+      baseIndex = 0;
+      distance[ i ] = 0.0;
+    }
+    else if ( baseIndex >= lastIndex )
+    {
+      baseIndex = lastIndex;
+      distance[ i ] = 0.0;
+    }
+    baseOffset += static_cast<unsigned long>( baseIndex )
+      * this->m_PackedMovingImageOffsetTable[ i ];
+  }
+
+  /** Accumulate the value and the gradient of the 2^D neighbours. */
+  double result[ PackedMovingImageStride ];
+  for ( unsigned int j = 0; j < PackedMovingImageStride; ++j )
+  {
+    result[ j ] = 0.0;
+  }
+  const unsigned int numberOfNeighbours = 1 << MovingImageDimension;
+  const unsigned int numberOfValues = gradient ? PackedMovingImageStride : 1;
+  for ( unsigned int n = 0; n < numberOfNeighbours; ++n )
+  {
+    double weight = 1.0;
+    unsigned long offset = baseOffset;
+    for ( unsigned int i = 0; i < MovingImageDimension; ++i )
+    {
+      if ( n & ( 1 << i ) )
+      {
+        weight *= distance[ i ];
+        offset += this->m_PackedMovingImageOffsetTable[ i ];
+      }
+      else
+      {
+        weight *= 1.0 - distance[ i ];
+      }
+    }
+    if ( weight == 0.0 ) continue;
+
+    const PackedMovingImageValueType * voxel
+      = this->m_PackedMovingImage->GetBufferPointer() + offset;
+    for ( unsigned int j = 0; j < numberOfValues; ++j )
+    {
+      result[ j ] += weight * voxel[ j ];
+    }
+  }
+
+  movingImageValue = static_cast<RealType>( result[ 0 ] );
+  if ( gradient )
+  {
+    for ( unsigned int i = 0; i < MovingImageDimension; ++i )
+    {
+      (*gradient)[ i ] = result[ i + 1 ];
+    }
+  }
+
+} // end EvaluatePackedMovingImageValueAndDerivative()
+
+
 /**
  * ********************** TransformPoint ************************
  *
@@ -495,6 +696,44 @@ AdvancedImageToImageMetric<TFixedImage,TMovingImage>
 } // end TransformPoint()
 
 
+/**
+ * *************** TransformPoints ****************
+ */
+
+template < class TFixedImage, class TMovingImage >
+bool
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::TransformPoints(
+  const ImageSampleContainerType * sampleContainer,
+  unsigned long begin, unsigned long end,
+  std::vector< FixedImagePointType > & fixedPoints,
+  std::vector< MovingImagePointType > & mappedPoints ) const
+{
+  const unsigned long numberOfPoints = end - begin;
+  if ( fixedPoints.size() < numberOfPoints )
+  {
+    fixedPoints.resize( numberOfPoints );
+    mappedPoints.resize( numberOfPoints );
+  }
+  if ( numberOfPoints == 0 )
+  {
+    return true;
+  }
+
+  for ( unsigned long i = 0; i < numberOfPoints; ++i )
+  {
+    sampleContainer->GetImageCoordinates( begin + i, fixedPoints[ i ] );
+  }
+  this->m_AdvancedTransform->TransformPoints(
+    &( fixedPoints[ 0 ] ), &( mappedPoints[ 0 ] ), numberOfPoints );
+
+  /** For future use: return whether the samples are valid */
+  const bool valid = true;
+  return valid;
+
+} // end TransformPoints()
+
+
 /**
  * *************** EvaluateTransformJacobian ****************
  */
@@ -579,6 +818,469 @@ AdvancedImageToImageMetric<TFixedImage,TMovingImage>
 } // end CheckNumberOfSamples()
 
 
+/**
+ * ******************* InitializeThreadingParameters *******************
+ */
+
+template < class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::InitializeThreadingParameters( void ) const
+{
+  /** Resize the per-thread variables, if the number of threads changed. */
+  const unsigned int numberOfThreads = this->m_Threader->GetNumberOfThreads();
+  if ( this->m_GetValueAndDerivativePerThreadVariables.size() != numberOfThreads )
+  {
+    this->m_GetValueAndDerivativePerThreadVariables.resize( numberOfThreads );
+  }
+
+  /** Reset the per-thread variables. The derivatives are only reallocated
+   * when the number of parameters changed, e.g. in a new resolution.
+   */
+  const unsigned int numberOfParameters = this->GetNumberOfParameters();
+  for ( unsigned int i = 0; i < numberOfThreads; ++i )
+  {
+    GetValueAndDerivativePerThreadStruct & threadVariables
+      = this->m_GetValueAndDerivativePerThreadVariables[ i ];
+    threadVariables.st_NumberOfPixelsCounted = 0;
+    threadVariables.st_Value = NumericTraits<MeasureType>::Zero;
+    if ( threadVariables.st_Derivative.GetSize() != numberOfParameters )
+    {
+      threadVariables.st_Derivative.SetSize( numberOfParameters );
+    }
+    threadVariables.st_Derivative.Fill( NumericTraits<DerivativeValueType>::Zero );
+  }
+
+} // end InitializeThreadingParameters()
+
+
+/**
+ * ******************* GetThreadSampleRange *******************
+ */
+
+template < class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::GetThreadSampleRange( unsigned int threadID,
+  unsigned long numberOfSamples,
+  unsigned long & begin, unsigned long & end ) const
+{
+  /** Divide the samples in contiguous chunks of (almost) equal size. */
+  const unsigned int numberOfThreads = this->m_Threader->GetNumberOfThreads();
+  const unsigned long chunkSize
+    = ( numberOfSamples + numberOfThreads - 1 ) / numberOfThreads;
+
+  begin = vnl_math_min( threadID * chunkSize, numberOfSamples );
+  end = vnl_math_min( ( threadID + 1 ) * chunkSize, numberOfSamples );
+
+} // end GetThreadSampleRange()
+
+
+/**
+ * *********** LaunchGetValueAndDerivativeThreaderCallback ***************
+ */
+
+template < class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::LaunchGetValueAndDerivativeThreaderCallback( void ) const
+{
+  tmrProfileScope( "Metric::ThreadedGetValueAndDerivative" );
+
+  for ( unsigned int i = 0; i < this->m_GetValueAndDerivativePerThreadVariables.size(); ++i )
+  {
+    this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Failed = false;
+  }
+
+  /** Setup threader and launch. */
+  this->m_Threader->SetSingleMethod( GetValueAndDerivativeThreaderCallback,
+    const_cast<void *>( static_cast<const void *>(
+    &this->m_ThreaderMetricParameters ) ) );
+  this->m_Threader->SingleMethodExecute();
+
+  /** Throw the exceptions of the threads in this thread. */
+  for ( unsigned int i = 0; i < this->m_GetValueAndDerivativePerThreadVariables.size(); ++i )
+  {
+    if ( this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Failed )
+    {
+      throw this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Exception;
+    }
+  }
+
+} // end LaunchGetValueAndDerivativeThreaderCallback()
+
+
+/**
+ * ************ GetValueAndDerivativeThreaderCallback ****************
+ */
+
+template < class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::GetValueAndDerivativeThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>( arg );
+  const unsigned int threadID = infoStruct->ThreadID;
+
+  MultiThreaderParameterType * temp
+    = static_cast<MultiThreaderParameterType *>( infoStruct->UserData );
+
+  /** An exception can not leave the thread, so it is stored. */
+  try
+  {
+    tmrProfileScope( "Thread" );
+    temp->st_Metric->ThreadedGetValueAndDerivative( threadID );
+  }
+  catch ( ExceptionObject & excp )
+  {
+    GetValueAndDerivativePerThreadStruct & threadVariables
+      = temp->st_Metric->m_GetValueAndDerivativePerThreadVariables[ threadID ];
+    threadVariables.st_Exception = excp;
+    threadVariables.st_Failed = true;
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end GetValueAndDerivativeThreaderCallback()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivative *******************
+ */
+
+template < class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::ThreadedGetValueAndDerivative( unsigned int itkNotUsed( threadID ) ) const
+{
+  /** Throw an exception if this function is not overridden. The exception
+   * is thrown again after the threads have finished. */
+  itkExceptionMacro( << "ERROR: The ThreadedGetValueAndDerivative method is not "
+    << "implemented in your metric, so it does not support multi-threading" );
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ************** AccumulateThreadedValueAndDerivative *****************
+ */
+
+template < class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::AccumulateThreadedValueAndDerivative(
+  MeasureType & value, DerivativeType & derivative ) const
+{
+  tmrProfileScope( "Metric::AccumulateThreadedValueAndDerivative" );
+  const unsigned int numberOfThreads = this->m_Threader->GetNumberOfThreads();
+
+  /** Accumulate the number of pixels counted and the value. */
+  this->m_NumberOfPixelsCounted = 0;
+  value = NumericTraits<MeasureType>::Zero;
+  for ( unsigned int i = 0; i < numberOfThreads; ++i )
+  {
+    this->m_NumberOfPixelsCounted
+      += this->m_GetValueAndDerivativePerThreadVariables[ i ].st_NumberOfPixelsCounted;
+    value += this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Value;
+  }
+
+  /** Accumulate the derivatives. For many parameters this is worth
+   * doing multi-threaded, each thread summing a chunk of the parameters.
+   */
+  derivative.SetSize( this->GetNumberOfParameters() );
+  this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+  this->m_Threader->SetSingleMethod( AccumulateDerivativesThreaderCallback,
+    const_cast<void *>( static_cast<const void *>(
+    &this->m_ThreaderMetricParameters ) ) );
+  this->m_Threader->SingleMethodExecute();
+  this->m_ThreaderMetricParameters.st_DerivativePointer = 0;
+
+  tmrProfileCount( "PixelsCounted", this->m_NumberOfPixelsCounted );
+
+} // end AccumulateThreadedValueAndDerivative()
+
+
+/**
+ * *************** AccumulateDerivativesThreaderCallback ****************
+ */
+
+template < class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::AccumulateDerivativesThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>( arg );
+  const unsigned int threadID = infoStruct->ThreadID;
+  const unsigned int numberOfThreads = infoStruct->NumberOfThreads;
+
+  MultiThreaderParameterType * temp
+    = static_cast<MultiThreaderParameterType *>( infoStruct->UserData );
+  const Self * metric = temp->st_Metric;
+
+  /** Determine the chunk of parameters of this thread. */
+  unsigned long jmin = 0;
+  unsigned long jmax = 0;
+  metric->GetThreadSampleRange( threadID,
+    metric->GetNumberOfParameters(), jmin, jmax );
+
+  /** Sum the per-thread derivatives, always in the same thread order,
+   * so that the result does not depend on the thread scheduling.
+   */
+  DerivativeValueType * derivative = temp->st_DerivativePointer;
+  for ( unsigned long j = jmin; j < jmax; ++j )
+  {
+    DerivativeValueType sum = NumericTraits<DerivativeValueType>::Zero;
+    for ( unsigned int i = 0; i < numberOfThreads; ++i )
+    {
+      sum += metric->m_GetValueAndDerivativePerThreadVariables[ i ].st_Derivative[ j ];
+    }
+    derivative[ j ] = sum;
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end AccumulateDerivativesThreaderCallback()
+
+
+/**
+ * ********************* CreateConcurrentCopies ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::CreateConcurrentCopies( unsigned int numberOfCopies,
+  ConcurrentCopyContainerType & copies, std::string & reason ) const
+{
+  copies.clear();
+  reason = "";
+  if ( numberOfCopies == 0 )
+  {
+    return true;
+  }
+
+  /** Check the capabilities of the metric and the transform. */
+  if ( !this->GetSupportsConcurrentCopies() )
+  {
+    reason = std::string( "the metric " ) + this->GetNameOfClass()
+      + " does not support concurrent copies";
+    return false;
+  }
+  if ( this->m_Transform.IsNull() )
+  {
+    reason = "no transform is set";
+    return false;
+  }
+  const AdvancedTransformType * advancedTransform
+    = dynamic_cast<const AdvancedTransformType *>( this->m_Transform.GetPointer() );
+  if ( !advancedTransform || !advancedTransform->GetIsDefinedByParameters() )
+  {
+    reason = std::string( "the transform " ) + this->m_Transform->GetNameOfClass()
+      + " is not defined by its parameters alone";
+    return false;
+  }
+
+  /** The threads of this metric are divided among this metric and the
+   * copies. */
+  const unsigned int numberOfThreads = vnl_math_max( static_cast<unsigned int>(
+    this->m_Threader->GetNumberOfThreads() ) / ( numberOfCopies + 1 ), 1u );
+
+  try
+  {
+    for ( unsigned int i = 0; i < numberOfCopies; ++i )
+    {
+      /** Create a metric of the same type, with its own transform. */
+      Pointer copy = dynamic_cast<Self *>( this->CreateAnother().GetPointer() );
+      if ( copy.IsNull() )
+      {
+        reason = std::string( "the metric " ) + this->GetNameOfClass()
+          + " can not be created";
+        copies.clear();
+        return false;
+      }
+      TransformPointer transformCopy = this->CreateConcurrentTransformCopy();
+      if ( transformCopy.IsNull() )
+      {
+        reason = std::string( "the transform " ) + this->m_Transform->GetNameOfClass()
+          + " can not be copied";
+        copies.clear();
+        return false;
+      }
+      copy->Superclass::SetTransform( transformCopy );
+      this->InitializeConcurrentCopy( copy );
+      copy->m_Threader->SetNumberOfThreads( numberOfThreads );
+      copies.push_back( copy );
+    }
+  }
+  catch ( ExceptionObject & excp )
+  {
+    reason = std::string( "copying the metric failed: " ) + excp.GetDescription();
+    copies.clear();
+    return false;
+  }
+
+  return true;
+
+} // end CreateConcurrentCopies()
+
+
+/**
+ * ********************* PrepareConcurrentEvaluation ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::PrepareConcurrentEvaluation( void )
+{
+  /** Regenerate the samples if needed, e.g. after SelectNewSamples(). */
+  if ( this->m_UseImageSampler && this->m_ImageSampler.IsNotNull() )
+  {
+    this->m_ImageSampler->Update();
+  }
+
+} // end PrepareConcurrentEvaluation()
+
+
+/**
+ * ********************* InitializeConcurrentCopy ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const
+{
+  /** The read-only setup of the ImageToImageMetric. */
+  copy->SetFixedImage( this->m_FixedImage );
+  copy->SetMovingImage( this->m_MovingImage );
+  copy->SetInterpolator( this->m_Interpolator );
+  copy->SetFixedImageRegion( this->GetFixedImageRegion() );
+  copy->m_FixedImageMask = this->m_FixedImageMask;
+  copy->m_MovingImageMask = this->m_MovingImageMask;
+  copy->m_ComputeGradient = this->m_ComputeGradient;
+  copy->m_GradientImage = this->m_GradientImage;
+
+  /** The image sampler. Updating a sampler is not thread-safe, so the copy
+   * gets a sampler that only copies the samples of the sampler of this
+   * metric, which has to be updated in the calling thread. */
+  if ( this->m_ImageSampler.IsNotNull() )
+  {
+    typedef ReadOnlyImageSampler< FixedImageType > ReadOnlyImageSamplerType;
+    typename ReadOnlyImageSamplerType::Pointer sampler = ReadOnlyImageSamplerType::New();
+    sampler->SetSourceSampleContainer( this->m_ImageSampler->GetOutput() );
+    sampler->SetInputImageRegion( this->m_ImageSampler->GetInputImageRegion() );
+    sampler->SetMask( this->m_ImageSampler->GetMask() );
+    copy->m_ImageSampler = sampler;
+  }
+  copy->m_UseImageSampler = this->m_UseImageSampler;
+  copy->m_RequiredRatioOfValidSamples = this->m_RequiredRatioOfValidSamples;
+
+  /** The image derivative computation. */
+  copy->m_InterpolatorIsBSpline = this->m_InterpolatorIsBSpline;
+  copy->m_InterpolatorIsBSplineFloat = this->m_InterpolatorIsBSplineFloat;
+  copy->m_BSplineInterpolator = this->m_BSplineInterpolator;
+  copy->m_BSplineInterpolatorFloat = this->m_BSplineInterpolatorFloat;
+  copy->m_CentralDifferenceGradientFilter = this->m_CentralDifferenceGradientFilter;
+  copy->m_UseMovingImageDerivativeScales = this->m_UseMovingImageDerivativeScales;
+  copy->m_MovingImageDerivativeScales = this->m_MovingImageDerivativeScales;
+
+  /** The packed moving image. */
+  copy->m_UsePackedMovingImage = this->m_UsePackedMovingImage;
+  copy->m_PackedMovingImage = this->m_PackedMovingImage;
+  copy->m_PackedMovingImageRegion = this->m_PackedMovingImageRegion;
+  for ( unsigned int i = 0; i < MovingImageDimension; ++i )
+  {
+    copy->m_PackedMovingImageOffsetTable[ i ] = this->m_PackedMovingImageOffsetTable[ i ];
+  }
+
+  /** The limiters. */
+  copy->m_FixedImageLimiter = this->m_FixedImageLimiter;
+  copy->m_MovingImageLimiter = this->m_MovingImageLimiter;
+  copy->m_UseFixedImageLimiter = this->m_UseFixedImageLimiter;
+  copy->m_UseMovingImageLimiter = this->m_UseMovingImageLimiter;
+  copy->m_FixedLimitRangeRatio = this->m_FixedLimitRangeRatio;
+  copy->m_MovingLimitRangeRatio = this->m_MovingLimitRangeRatio;
+  copy->m_FixedImageTrueMin = this->m_FixedImageTrueMin;
+  copy->m_FixedImageTrueMax = this->m_FixedImageTrueMax;
+  copy->m_MovingImageTrueMin = this->m_MovingImageTrueMin;
+  copy->m_MovingImageTrueMax = this->m_MovingImageTrueMax;
+  copy->m_FixedImageMinLimit = this->m_FixedImageMinLimit;
+  copy->m_FixedImageMaxLimit = this->m_FixedImageMaxLimit;
+  copy->m_MovingImageMinLimit = this->m_MovingImageMinLimit;
+  copy->m_MovingImageMaxLimit = this->m_MovingImageMaxLimit;
+
+  /** Multi-threading. CreateConcurrentCopies() sets the number of threads. */
+  copy->m_UseMultiThread = this->m_UseMultiThread;
+
+  /** The copy of the transform, which was set before. */
+  copy->CheckForAdvancedTransform();
+
+} // end InitializeConcurrentCopy()
+
+
+/**
+ * ********************* CreateConcurrentTransformCopy ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+typename AdvancedImageToImageMetric<TFixedImage,TMovingImage>::TransformPointer
+AdvancedImageToImageMetric<TFixedImage,TMovingImage>
+::CreateConcurrentTransformCopy( void ) const
+{
+  /** Only transforms that are known to be copied completely by their
+   * fixed parameters and parameters. CreateAnother() does not copy the
+   * other state. */
+  const AdvancedTransformType * advancedTransform
+    = dynamic_cast<const AdvancedTransformType *>( this->m_Transform.GetPointer() );
+  if ( !advancedTransform || !advancedTransform->GetIsDefinedByParameters() )
+  {
+    return 0;
+  }
+  TransformPointer copy
+    = dynamic_cast<TransformType *>( this->m_Transform->CreateAnother().GetPointer() );
+  if ( copy.IsNull() )
+  {
+    return 0;
+  }
+
+  try
+  {
+    /** A combination transform needs a current transform of the right
+     * type, which elastix transforms create in their constructor. The
+     * initial transform is not changed during the optimization. */
+    const CombinationTransformType * combination
+      = dynamic_cast<const CombinationTransformType *>( this->m_Transform.GetPointer() );
+    if ( combination )
+    {
+      CombinationTransformType * combinationCopy
+        = dynamic_cast<CombinationTransformType *>( copy.GetPointer() );
+      if ( !combinationCopy || !combinationCopy->GetCurrentTransform()
+        || typeid( *combinationCopy->GetCurrentTransform() )
+        != typeid( *combination->GetCurrentTransform() ) )
+      {
+        return 0;
+      }
+      combinationCopy->SetInitialTransform( combination->GetInitialTransform() );
+      combinationCopy->SetUseComposition( combination->GetUseComposition() );
+      combinationCopy->SetUseAddition( combination->GetUseAddition() );
+    }
+
+    /** SetParametersByValue, because SetParameters may keep a reference. */
+    copy->SetFixedParameters( this->m_Transform->GetFixedParameters() );
+    copy->SetParametersByValue( this->m_Transform->GetParameters() );
+  }
+  catch ( ExceptionObject & excp )
+  {
+    itkDebugMacro( "Transform copy failed: " << excp );
+    return 0;
+  }
+
+  return copy;
+
+} // end CreateConcurrentTransformCopy()
+
+
 /**
  * ********************* PrintSelf ****************************
  */
@@ -640,6 +1342,8 @@ AdvancedImageToImageMetric<TFixedImage,TMovingImage>
     << this->m_BSplineInterpolatorFloat.GetPointer() << std::endl;
   os << indent.GetNextIndent() << "CentralDifferenceGradientFilter: "
     << this->m_CentralDifferenceGradientFilter.GetPointer() << std::endl;
+  os << indent.GetNextIndent() << "UsePackedMovingImage: "
+    << this->m_UsePackedMovingImage << std::endl;
 
   /** Variables used when the transform is a B-spline transform. */
   os << indent << "Variables store the transform as an AdvancedTransform: " << std::endl;
@@ -657,6 +1361,13 @@ AdvancedImageToImageMetric<TFixedImage,TMovingImage>
   os << indent.GetNextIndent() << "MovingImageDerivativeScales: "
     << this->m_MovingImageDerivativeScales << std::endl;
 
+  /** Variables related to multi-threading. */
+  os << indent << "Variables related to multi-threading: " << std::endl;
+  os << indent.GetNextIndent() << "UseMultiThread: "
+    << this->m_UseMultiThread << std::endl;
+  os << indent.GetNextIndent() << "Threader: "
+    << this->m_Threader.GetPointer() << std::endl;
+
 } // end PrintSelf()
 
 
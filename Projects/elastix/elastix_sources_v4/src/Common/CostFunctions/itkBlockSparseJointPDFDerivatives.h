@@ -0,0 +1,230 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkBlockSparseJointPDFDerivatives_h
+#define __itkBlockSparseJointPDFDerivatives_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include <vector>
+#include <utility>
+
+
+namespace itk
+{
+
+/**
+ * \class BlockSparseJointPDFDerivatives
+ * \brief A compact storage of the derivatives of a joint histogram to
+ * the transform parameters.
+ *
+ * The dense alternative is a 3D image of size
+ * NumberOfParameters x NumberOfMovingBins x NumberOfFixedBins. For transforms
+ * with a sparse Jacobian, such as the B-spline transform, most of its entries
+ * stay zero: a histogram bin only receives contributions from the parameters
+ * with a nonzero Jacobian at the samples whose Parzen window covers that bin.
+ *
+ * This class divides the parameter dimension of each histogram bin in
+ * blocks of BlockSize parameters. A block is only allocated when one of its
+ * entries is updated. The nonzero Jacobian indices of a B-spline transform
+ * come in runs of consecutive parameters, so they end up in a few blocks.
+ * The blocks are stored contiguously in a pool, whose memory is kept
+ * across Reset() calls.
+ *
+ * The bins are indexed like the dense image:
+ * binIndex = movingBin + fixedBin * NumberOfMovingBins.
+ *
+ * \warning The pointer returned by GetBlock() is invalidated by the next
+ * allocation of a block.
+ *
+ * \ingroup Metrics
+ * \sa ParzenWindowHistogramImageToImageMetric
+ */
+
+template < class TValue >
+class BlockSparseJointPDFDerivatives : public Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef BlockSparseJointPDFDerivatives  Self;
+  typedef Object                          Superclass;
+  typedef SmartPointer<Self>              Pointer;
+  typedef SmartPointer<const Self>        ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BlockSparseJointPDFDerivatives, Object );
+
+  /** Typedefs. */
+  typedef TValue          ValueType;
+  typedef unsigned long   SizeValueType;
+  typedef unsigned int    SlotType;
+
+  /** The number of parameters per block. Must be a power of two. */
+  itkStaticConstMacro( BlockSize, unsigned int, 16 );
+  itkStaticConstMacro( BlockSizeLog2, unsigned int, 4 );
+
+  /** Set the dimensions and remove all entries. */
+  virtual void SetSize( SizeValueType numberOfParameters,
+    SizeValueType numberOfMovingBins, SizeValueType numberOfFixedBins );
+
+  /** Get the dimensions. */
+  itkGetConstMacro( NumberOfParameters, SizeValueType );
+  itkGetConstMacro( NumberOfMovingBins, SizeValueType );
+  itkGetConstMacro( NumberOfFixedBins, SizeValueType );
+  SizeValueType GetNumberOfBins( void ) const
+  {
+    return this->m_NumberOfMovingBins * this->m_NumberOfFixedBins;
+  }
+
+  /** The number of allocated blocks, and the memory they use in bytes. */
+  SizeValueType GetNumberOfAllocatedBlocks( void ) const
+  {
+    return this->m_AllocatedBlocks.size();
+  }
+  virtual SizeValueType GetMemoryUsage( void ) const;
+
+  /** Set all entries to zero. The blocks are released, but the memory of
+   * the pool is kept for the next computation.
+   */
+  virtual void Reset( void );
+
+  /** Get a pointer to the first entry of block blockIndex of bin binIndex.
+   * The block is allocated (and zeroed) if it does not exist yet.
+   */
+  inline ValueType * GetBlock( SizeValueType binIndex, SizeValueType blockIndex )
+  {
+    std::vector<SlotType> & row = this->m_BlockTable[ binIndex ];
+    if ( row.empty() )
+    {
+      row.resize( this->m_NumberOfBlocksPerBin, UnallocatedBlock() );
+    }
+    SlotType & slot = row[ blockIndex ];
+    if ( slot == UnallocatedBlock() )
+    {
+      slot = this->AllocateBlock( binIndex, blockIndex );
+    }
+    return &( this->m_Pool[ static_cast<SizeValueType>( slot ) * BlockSize ] );
+  }
+
+  /** Add value to the entry of parameter mu in bin binIndex. */
+  inline void AddValue( SizeValueType binIndex, SizeValueType mu, ValueType value )
+  {
+    this->GetBlock( binIndex, mu >> BlockSizeLog2 )[ mu & ( BlockSize - 1 ) ] += value;
+  }
+
+  /** Make sure that all blocks that are allocated in other are also
+   * allocated in this container. Not thread safe.
+   */
+  virtual void AllocateBlocksOf( const Self * other );
+
+  /** Add the entries of other to this container, only for the bins in the
+   * range [binBegin, binEnd). Requires that AllocateBlocksOf( other ) was
+   * called. Several threads may call this function at the same time, as
+   * long as their bin ranges do not overlap.
+   */
+  virtual void AddBins( const Self * other,
+    SizeValueType binBegin, SizeValueType binEnd );
+
+  /** Add the entries of the bins in the range [binBegin, binEnd) to a
+   * dense buffer, laid out like the dense joint histogram derivatives
+   * image: entry (mu, bin) is at dense[ bin * NumberOfParameters + mu ].
+   * Several threads may call this function at the same time, as long as
+   * their bin ranges do not overlap.
+   */
+  virtual void AddBinsToDense( ValueType * dense,
+    SizeValueType binBegin, SizeValueType binEnd ) const;
+
+  /** Compute derivative[mu] += sum_bins binWeights[bin] * entry(mu, bin),
+   * for all mu. The derivative array should have length NumberOfParameters.
+   */
+  template < class TDerivativeValue >
+  void AddWeightedSum( const double * binWeights, TDerivativeValue * derivative ) const
+  {
+    const SizeValueType numberOfBlocks = this->m_AllocatedBlocks.size();
+    for ( SizeValueType b = 0; b < numberOfBlocks; ++b )
+    {
+      const double weight = binWeights[ this->m_AllocatedBlocks[ b ].first ];
+      if ( weight == 0.0 ) continue;
+
+      const SizeValueType muBegin = this->m_AllocatedBlocks[ b ].second << BlockSizeLog2;
+      const SizeValueType muEnd = muBegin + BlockSize < this->m_NumberOfParameters
+        ? muBegin + BlockSize : this->m_NumberOfParameters;
+      const ValueType * block = &( this->m_Pool[ b * BlockSize ] );
+      TDerivativeValue * deriv = derivative + muBegin;
+      for ( SizeValueType mu = muBegin; mu < muEnd; ++mu )
+      {
+        *deriv += static_cast<TDerivativeValue>( weight * (*block) );
+        ++deriv;
+        ++block;
+      }
+    }
+  }
+
+protected:
+
+  BlockSparseJointPDFDerivatives();
+  virtual ~BlockSparseJointPDFDerivatives() {};
+
+  /** Print Self. */
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  /** Append a zeroed block to the pool and return its slot number. */
+  virtual SlotType AllocateBlock( SizeValueType binIndex, SizeValueType blockIndex );
+
+  /** The value used to mark an unallocated block in the block table. */
+  static SlotType UnallocatedBlock( void )
+  {
+    return static_cast<SlotType>( -1 );
+  }
+
+  /** Typedefs for the storage. */
+  typedef std::pair< SizeValueType, SizeValueType >   BlockLocationType;
+  typedef std::vector< BlockLocationType >            BlockLocationContainerType;
+  typedef std::vector< std::vector<SlotType> >        BlockTableType;
+  typedef std::vector< ValueType >                    PoolType;
+
+  /** For each bin the pool slot of each of its blocks. A row is only
+   * allocated when its bin is updated for the first time.
+   */
+  BlockTableType              m_BlockTable;
+
+  /** The (bin, block) of each slot in the pool. */
+  BlockLocationContainerType  m_AllocatedBlocks;
+
+  /** The values of all allocated blocks. */
+  PoolType                    m_Pool;
+
+private:
+
+  BlockSparseJointPDFDerivatives( const Self& );  // purposely not implemented
+  void operator=( const Self& );                  // purposely not implemented
+
+  SizeValueType m_NumberOfParameters;
+  SizeValueType m_NumberOfMovingBins;
+  SizeValueType m_NumberOfFixedBins;
+  SizeValueType m_NumberOfBlocksPerBin;
+
+}; // end class BlockSparseJointPDFDerivatives
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBlockSparseJointPDFDerivatives.hxx"
+#endif
+
+#endif // end #ifndef __itkBlockSparseJointPDFDerivatives_h
@@ -0,0 +1,233 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkBlockSparseJointPDFDerivatives_hxx
+#define __itkBlockSparseJointPDFDerivatives_hxx
+
+#include "itkBlockSparseJointPDFDerivatives.h"
+#include "itkNumericTraits.h"
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template < class TValue >
+BlockSparseJointPDFDerivatives<TValue>
+::BlockSparseJointPDFDerivatives()
+{
+  this->m_NumberOfParameters = 0;
+  this->m_NumberOfMovingBins = 0;
+  this->m_NumberOfFixedBins = 0;
+  this->m_NumberOfBlocksPerBin = 0;
+
+} // end Constructor
+
+
+/**
+ * ********************* SetSize ****************************
+ */
+
+template < class TValue >
+void
+BlockSparseJointPDFDerivatives<TValue>
+::SetSize( SizeValueType numberOfParameters,
+  SizeValueType numberOfMovingBins, SizeValueType numberOfFixedBins )
+{
+  this->m_NumberOfParameters = numberOfParameters;
+  this->m_NumberOfMovingBins = numberOfMovingBins;
+  this->m_NumberOfFixedBins = numberOfFixedBins;
+  this->m_NumberOfBlocksPerBin
+    = ( numberOfParameters + BlockSize - 1 ) >> BlockSizeLog2;
+
+  /** Release all memory. */
+  BlockTableType().swap( this->m_BlockTable );
+  BlockLocationContainerType().swap( this->m_AllocatedBlocks );
+  PoolType().swap( this->m_Pool );
+  this->m_BlockTable.resize( this->GetNumberOfBins() );
+
+  this->Modified();
+
+} // end SetSize()
+
+
+/**
+ * ********************* Reset ****************************
+ */
+
+template < class TValue >
+void
+BlockSparseJointPDFDerivatives<TValue>
+::Reset( void )
+{
+  /** Only the allocated blocks have to be marked as unallocated again. */
+  const SizeValueType numberOfBlocks = this->m_AllocatedBlocks.size();
+  for ( SizeValueType b = 0; b < numberOfBlocks; ++b )
+  {
+    const BlockLocationType & location = this->m_AllocatedBlocks[ b ];
+    this->m_BlockTable[ location.first ][ location.second ] = UnallocatedBlock();
+  }
+
+  /** clear() keeps the capacity of the vectors. */
+  this->m_AllocatedBlocks.clear();
+  this->m_Pool.clear();
+
+} // end Reset()
+
+
+/**
+ * ********************* AllocateBlock ****************************
+ */
+
+template < class TValue >
+typename BlockSparseJointPDFDerivatives<TValue>::SlotType
+BlockSparseJointPDFDerivatives<TValue>
+::AllocateBlock( SizeValueType binIndex, SizeValueType blockIndex )
+{
+  const SlotType slot = static_cast<SlotType>( this->m_AllocatedBlocks.size() );
+  this->m_AllocatedBlocks.push_back( BlockLocationType( binIndex, blockIndex ) );
+  this->m_Pool.resize( this->m_Pool.size() + BlockSize,
+    NumericTraits<ValueType>::Zero );
+  return slot;
+
+} // end AllocateBlock()
+
+
+/**
+ * ********************* AllocateBlocksOf ****************************
+ */
+
+template < class TValue >
+void
+BlockSparseJointPDFDerivatives<TValue>
+::AllocateBlocksOf( const Self * other )
+{
+  const SizeValueType numberOfBlocks = other->m_AllocatedBlocks.size();
+  for ( SizeValueType b = 0; b < numberOfBlocks; ++b )
+  {
+    const BlockLocationType & location = other->m_AllocatedBlocks[ b ];
+    this->GetBlock( location.first, location.second );
+  }
+
+} // end AllocateBlocksOf()
+
+
+/**
+ * ********************* AddBins ****************************
+ */
+
+template < class TValue >
+void
+BlockSparseJointPDFDerivatives<TValue>
+::AddBins( const Self * other, SizeValueType binBegin, SizeValueType binEnd )
+{
+  const SizeValueType numberOfBlocks = other->m_AllocatedBlocks.size();
+  for ( SizeValueType b = 0; b < numberOfBlocks; ++b )
+  {
+    const BlockLocationType & location = other->m_AllocatedBlocks[ b ];
+    if ( location.first < binBegin || location.first >= binEnd ) continue;
+
+    /** The block exists already, so this does not modify the table. */
+    const SizeValueType slot = this->m_BlockTable[ location.first ][ location.second ];
+    ValueType * target = &( this->m_Pool[ slot * BlockSize ] );
+    const ValueType * source = &( other->m_Pool[ b * BlockSize ] );
+    for ( unsigned int i = 0; i < BlockSize; ++i )
+    {
+      target[ i ] += source[ i ];
+    }
+  }
+
+} // end AddBins()
+
+
+/**
+ * ********************* AddBinsToDense ****************************
+ */
+
+template < class TValue >
+void
+BlockSparseJointPDFDerivatives<TValue>
+::AddBinsToDense( ValueType * dense,
+  SizeValueType binBegin, SizeValueType binEnd ) const
+{
+  const SizeValueType numberOfBlocks = this->m_AllocatedBlocks.size();
+  for ( SizeValueType b = 0; b < numberOfBlocks; ++b )
+  {
+    const BlockLocationType & location = this->m_AllocatedBlocks[ b ];
+    if ( location.first < binBegin || location.first >= binEnd ) continue;
+
+    /** The last block of a bin may extend beyond the last parameter. */
+    const SizeValueType muBegin = location.second << BlockSizeLog2;
+    const SizeValueType muEnd = muBegin + BlockSize < this->m_NumberOfParameters
+      ? muBegin + BlockSize : this->m_NumberOfParameters;
+    ValueType * target = dense + location.first * this->m_NumberOfParameters;
+    const ValueType * source = &( this->m_Pool[ b * BlockSize ] );
+    for ( SizeValueType mu = muBegin; mu < muEnd; ++mu )
+    {
+      target[ mu ] += *source;
+      ++source;
+    }
+  }
+
+} // end AddBinsToDense()
+
+
+/**
+ * ********************* GetMemoryUsage ****************************
+ */
+
+template < class TValue >
+typename BlockSparseJointPDFDerivatives<TValue>::SizeValueType
+BlockSparseJointPDFDerivatives<TValue>
+::GetMemoryUsage( void ) const
+{
+  SizeValueType memory = this->m_Pool.capacity() * sizeof( ValueType )
+    + this->m_AllocatedBlocks.capacity() * sizeof( BlockLocationType );
+  for ( SizeValueType i = 0; i < this->m_BlockTable.size(); ++i )
+  {
+    memory += this->m_BlockTable[ i ].capacity() * sizeof( SlotType );
+  }
+  return memory;
+
+} // end GetMemoryUsage()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+template < class TValue >
+void
+BlockSparseJointPDFDerivatives<TValue>
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfParameters: " << this->m_NumberOfParameters << std::endl;
+  os << indent << "NumberOfMovingBins: " << this->m_NumberOfMovingBins << std::endl;
+  os << indent << "NumberOfFixedBins: " << this->m_NumberOfFixedBins << std::endl;
+  os << indent << "BlockSize: " << BlockSize << std::endl;
+  os << indent << "NumberOfAllocatedBlocks: "
+    << this->GetNumberOfAllocatedBlocks() << std::endl;
+  os << indent << "MemoryUsage: " << this->GetMemoryUsage() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+
+#endif // end #ifndef __itkBlockSparseJointPDFDerivatives_hxx
@@ -17,6 +17,7 @@
 
 #include "itkAdvancedImageToImageMetric.h"
 #include "itkBSplineKernelFunction.h"
+#include "itkBlockSparseJointPDFDerivatives.h"
 
 
 namespace itk
@@ -48,6 +49,12 @@ namespace itk
    *  - A fixed and moving number of histogram bins can be chosen.
    *  - More use of iterators instead of raw buffer pointers.
    *  - An optional FiniteDifference derivative estimation.
+   *  - An optional block-sparse storage of the explicit joint pdf derivatives,
+   *    which is used automatically for large transforms with a sparse Jacobian.
+   *  - Optional multi-threaded construction of the joint histogram (and its
+   *    derivatives or incremental versions). Each thread fills a private
+   *    joint histogram using a chunk of the samples; the private histograms
+   *    are then summed, in a fixed order, into m_JointPDF.
    *
    * \warning This class is not thread safe due the member data structures
    *  used to the store the sampled points and the marginal and joint pdfs.
@@ -197,6 +204,21 @@ namespace itk
     itkGetConstReferenceMacro( UseExplicitPDFDerivatives, bool );
     itkBooleanMacro( UseExplicitPDFDerivatives );
 
+    /** The maximum number of elements of a dense explicit joint pdf
+     * derivatives array (nrofparams * nrofmovingbins * nroffixedbins).
+     * If the dense array would be larger, and the transform has a sparse
+     * Jacobian, a BlockSparseJointPDFDerivatives is used instead.
+     * Set it to 0 to always use the sparse storage for such transforms.
+     * This option should be set before calling Initialize(); Default: 2^24.
+     */
+    itkSetMacro( MaximumDenseJointPDFDerivativesSize, unsigned long );
+    itkGetConstMacro( MaximumDenseJointPDFDerivativesSize, unsigned long );
+
+    /** Whether the explicit joint pdf derivatives are stored sparsely.
+     * Determined by Initialize().
+     */
+    itkGetConstMacro( UseSparseJointPDFDerivatives, bool );
+
     /** Whether you plan to call the GetDerivative/GetValueAndDerivative method or not.
      * This option should be set before calling Initialize(); Default: false.
      */
@@ -236,6 +258,7 @@ namespace itk
     typedef typename Superclass::MovingImageIndexType               MovingImageIndexType;
     typedef typename Superclass::FixedImagePointType                FixedImagePointType;
     typedef typename Superclass::MovingImagePointType               MovingImagePointType;
+    typedef typename Superclass::AdvancedImageToImageMetricType     AdvancedImageToImageMetricType;
     typedef typename Superclass::MovingImageContinuousIndexType     MovingImageContinuousIndexType;
     typedef typename Superclass::BSplineInterpolatorType            BSplineInterpolatorType;
     typedef typename Superclass::MovingImageDerivativeType          MovingImageDerivativeType;
@@ -258,6 +281,8 @@ namespace itk
     typedef IncrementalMarginalPDFType::RegionType  IncrementalMarginalPDFRegionType;
     typedef IncrementalMarginalPDFType::SizeType    IncrementalMarginalPDFSizeType;
     typedef Array<double>                           ParzenValueContainerType;
+    typedef BlockSparseJointPDFDerivatives<
+      PDFValueType >                                SparseJointPDFDerivativesType;
 
     /** Typedefs for Parzen kernel. */
     typedef KernelFunction KernelFunctionType;
@@ -274,6 +299,7 @@ namespace itk
     mutable MarginalPDFType                       m_MovingImageMarginalPDF;
     typename JointPDFType::Pointer                m_JointPDF;
     typename JointPDFDerivativesType::Pointer     m_JointPDFDerivatives;
+    typename SparseJointPDFDerivativesType::Pointer m_SparseJointPDFDerivatives;
     typename JointPDFDerivativesType::Pointer     m_IncrementalJointPDFRight;
     typename JointPDFDerivativesType::Pointer     m_IncrementalJointPDFLeft;
     typename IncrementalMarginalPDFType::Pointer  m_FixedIncrementalMarginalPDFRight;
@@ -314,10 +340,16 @@ namespace itk
 
     /** Update the joint PDF with a pixel pair; on demand also updates the
      * pdf derivatives (if the Jacobian pointers are nonzero).
+     * The results are added to the given jointPDF and jointPDFDerivatives,
+     * which are normally m_JointPDF and m_JointPDFDerivatives, or a
+     * thread's private copy of them. If sparseJointPDFDerivatives is
+     * nonzero, the pdf derivatives are added to it instead.
      */
     virtual void UpdateJointPDFAndDerivatives(
       RealType fixedImageValue, RealType movingImageValue,
-      const DerivativeType * imageJacobian, const NonZeroJacobianIndicesType * nzji ) const;
+      const DerivativeType * imageJacobian, const NonZeroJacobianIndicesType * nzji,
+      JointPDFType * jointPDF, JointPDFDerivativesType * jointPDFDerivatives,
+      SparseJointPDFDerivativesType * sparseJointPDFDerivatives = 0 ) const;
 
     /** Update the joint PDF and the incremental pdfs.
      * The input is a pixel pair (fixed, moving, moving mask) and
@@ -325,6 +357,9 @@ namespace itk
      * each k that has a nonzero Jacobian. And for mu-delta*e_k of course.
      * Also updates the PerturbedAlpha's
      * This function is used when UseFiniteDifferenceDerivative is true.
+     * The results are added to the given histograms and perturbed alphas.
+     * If the sparse incremental pdfs are nonzero, the incremental pdfs are
+     * added to them instead of to the dense ones.
      *
      * \todo The IsInsideMovingMask return bools are converted to doubles (1 or 0) to
      * simplify the computation. But this may not be necessary.
@@ -335,7 +370,14 @@ namespace itk
       const DerivativeType & movingImageValuesLeft,
       const DerivativeType & movingMaskValuesRight,
       const DerivativeType & movingMaskValuesLeft,
-      const NonZeroJacobianIndicesType & nzji ) const;
+      const NonZeroJacobianIndicesType & nzji,
+      JointPDFType * jointPDF,
+      JointPDFDerivativesType * incrementalJointPDFRight,
+      JointPDFDerivativesType * incrementalJointPDFLeft,
+      DerivativeType & perturbedAlphaRight,
+      DerivativeType & perturbedAlphaLeft,
+      SparseJointPDFDerivativesType * sparseIncrementalJointPDFRight = 0,
+      SparseJointPDFDerivativesType * sparseIncrementalJointPDFLeft = 0 ) const;
 
     /** Update the pdf derivatives
      * adds -image_jac[mu]*factor to the bin
@@ -345,7 +387,15 @@ namespace itk
     void UpdateJointPDFDerivatives(
       const JointPDFIndexType & pdfIndex, double factor,
       const DerivativeType & imageJacobian,
-      const NonZeroJacobianIndicesType & nzji ) const;
+      const NonZeroJacobianIndicesType & nzji,
+      JointPDFDerivativesType * jointPDFDerivatives ) const;
+
+    /** Same as above, for sparsely stored pdf derivatives. */
+    void UpdateJointPDFDerivatives(
+      const JointPDFIndexType & pdfIndex, double factor,
+      const DerivativeType & imageJacobian,
+      const NonZeroJacobianIndicesType & nzji,
+      SparseJointPDFDerivativesType * sparseJointPDFDerivatives ) const;
 
     /** Multiply the pdf entries by the given normalization factor. */
     virtual void NormalizeJointPDF(
@@ -418,10 +468,130 @@ namespace itk
      */
     virtual void ComputePDFs( const ParametersType & parameters ) const;
 
+    /** Loop over the samples [begin, end) of the sample container and add
+     * their contributions to the given joint histogram. Used by ComputePDFs,
+     * both in the single-threaded and the multi-threaded case.
+     */
+    virtual void ComputePDFsForSampleRange(
+      const ImageSampleContainerType * sampleContainer,
+      unsigned long begin, unsigned long end,
+      JointPDFType * jointPDF,
+      unsigned long & numberOfPixelsCounted ) const;
+
+    /** Loop over the samples [begin, end) of the sample container and add
+     * their contributions to the given joint histogram and its derivatives.
+     * Used by ComputePDFsAndPDFDerivatives.
+     */
+    virtual void ComputePDFsAndPDFDerivativesForSampleRange(
+      const ImageSampleContainerType * sampleContainer,
+      unsigned long begin, unsigned long end,
+      JointPDFType * jointPDF,
+      JointPDFDerivativesType * jointPDFDerivatives,
+      SparseJointPDFDerivativesType * sparseJointPDFDerivatives,
+      unsigned long & numberOfPixelsCounted ) const;
+
+    /** Loop over the samples [begin, end) of the sample container and add
+     * their contributions to the given joint histogram, incremental joint
+     * histograms and (not yet inverted) perturbed alphas.
+     * Used by ComputePDFsAndIncrementalPDFs. If the sparse incremental
+     * histograms are nonzero, they are used instead of the dense ones.
+     */
+    virtual void ComputePDFsAndIncrementalPDFsForSampleRange(
+      const ImageSampleContainerType * sampleContainer,
+      unsigned long begin, unsigned long end,
+      JointPDFType * jointPDF,
+      JointPDFDerivativesType * incrementalJointPDFRight,
+      JointPDFDerivativesType * incrementalJointPDFLeft,
+      DerivativeType & perturbedAlphaRight,
+      DerivativeType & perturbedAlphaLeft,
+      unsigned long & numberOfPixelsCounted,
+      double & sumOfMovingMaskValues,
+      SparseJointPDFDerivativesType * sparseIncrementalJointPDFRight = 0,
+      SparseJointPDFDerivativesType * sparseIncrementalJointPDFLeft = 0 ) const;
+
+    /** Typedefs for multi-threaded computation of the pdfs. */
+    typedef typename Superclass::ThreaderType           ThreaderType;
+    typedef typename Superclass::ThreadInfoType         ThreadInfoType;
+
+    /** The types of histogram computation that can be done multi-threaded. */
+    enum PDFComputationType {
+      PDFs = 0,
+      PDFsAndPDFDerivatives,
+      PDFsAndIncrementalPDFs };
+
+    /** The data passed to the threader callbacks. */
+    struct ParzenWindowHistogramMultiThreaderParameterType
+    {
+      const Self *        st_Metric;
+      PDFComputationType  st_PDFComputation;
+    };
+
+    /** The per-thread histograms and counters. Thread 0 directly uses the
+     * member histograms; the other threads use private copies, which are
+     * only allocated when needed and kept for subsequent calls. The private
+     * copies of the pdf derivatives and incremental pdfs are always block
+     * sparse, so that their memory is bounded by the number of entries that
+     * a thread actually updates, instead of by the number of parameters.
+     */
+    struct ParzenWindowHistogramPerThreadStruct
+    {
+      unsigned long                               st_NumberOfPixelsCounted;
+      double                                      st_SumOfMovingMaskValues;
+      typename JointPDFType::Pointer              st_JointPDF;
+      typename JointPDFDerivativesType::Pointer   st_JointPDFDerivatives;
+      typename SparseJointPDFDerivativesType::Pointer st_SparseJointPDFDerivatives;
+      typename JointPDFDerivativesType::Pointer   st_IncrementalJointPDFRight;
+      typename JointPDFDerivativesType::Pointer   st_IncrementalJointPDFLeft;
+      typename SparseJointPDFDerivativesType::Pointer st_SparseIncrementalJointPDFRight;
+      typename SparseJointPDFDerivativesType::Pointer st_SparseIncrementalJointPDFLeft;
+      DerivativeType                              st_PerturbedAlphaRight;
+      DerivativeType                              st_PerturbedAlphaLeft;
+    };
+    typedef std::vector<
+      ParzenWindowHistogramPerThreadStruct >      ParzenWindowHistogramPerThreadType;
+
+    /** Multi-threaded versions of the ComputePDFs* functions. */
+    virtual void ComputePDFsMultiThreaded(
+      const ParametersType & parameters, PDFComputationType computation ) const;
+
+    /** Prepare the per-thread histograms for the requested computation. */
+    virtual void InitializeParzenWindowHistogramThreadingParameters(
+      PDFComputationType computation ) const;
+
+    /** Allocate a thread's private block sparse pdf derivatives, if it does
+     * not have the requested size yet, and set all its entries to zero.
+     */
+    void InitializeThreadSparseJointPDFDerivatives(
+      typename SparseJointPDFDerivativesType::Pointer & sparse,
+      unsigned long numberOfParameters,
+      unsigned long numberOfMovingBins,
+      unsigned long numberOfFixedBins ) const;
+
+    /** Compute the contribution of a thread's samples to its histograms. */
+    virtual void ThreadedComputePDFs(
+      unsigned int threadID, PDFComputationType computation ) const;
+
+    /** Sum a chunk of the per-thread histograms into the member histograms. */
+    virtual void ThreadedReducePDFs(
+      unsigned int threadID, PDFComputationType computation ) const;
+
+    /** The threader callbacks, which call ThreadedComputePDFs and ThreadedReducePDFs. */
+    static ITK_THREAD_RETURN_TYPE ComputePDFsThreaderCallback( void * arg );
+    static ITK_THREAD_RETURN_TYPE ReducePDFsThreaderCallback( void * arg );
+
+    /** Variables for multi-threading. */
+    mutable ParzenWindowHistogramMultiThreaderParameterType m_ParzenWindowHistogramThreaderParameters;
+    mutable ParzenWindowHistogramPerThreadType              m_ParzenWindowHistogramPerThreadVariables;
+
     /** Some initialization functions, called by Initialize. */
     virtual void InitializeHistograms( void );
     virtual void InitializeKernels( void );
 
+    /** Copy the histogram settings and set up the histograms and Parzen
+     * windows of the concurrent copy.
+     */
+    virtual void InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const;
+
     /**  Get the value and analytic derivatives for single valued optimizers.
      * Called by GetValueAndDerivative if UseFiniteDifferenceDerivative == false
      * Implement this method in subclasses.
@@ -453,6 +623,8 @@ namespace itk
     double m_FiniteDifferencePerturbation;
 
     bool m_UseExplicitPDFDerivatives;
+    bool m_UseSparseJointPDFDerivatives;
+    unsigned long m_MaximumDenseJointPDFDerivativesSize;
 
   }; // end class ParzenWindowHistogramImageToImageMetric
 
@@ -34,10 +34,15 @@ namespace itk
     ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
     ::ParzenWindowHistogramImageToImageMetric()
   {
+    /** InitializeConcurrentCopy() copies the histogram settings; the
+     * subclasses copy their own settings. */
+    this->m_SupportsConcurrentCopies = true;
+
     this->m_NumberOfFixedHistogramBins = 32;
     this->m_NumberOfMovingHistogramBins = 32;
     this->m_JointPDF = 0;
     this->m_JointPDFDerivatives = 0;
+    this->m_SparseJointPDFDerivatives = 0;
     this->m_FixedImageNormalizedMin = 0.0;
     this->m_MovingImageNormalizedMin = 0.0;
     this->m_FixedImageBinSize = 0.0;
@@ -65,6 +70,12 @@ namespace itk
     this->SetUseMovingImageLimiter( true );
 
     this->m_UseExplicitPDFDerivatives = true;
+    this->m_UseSparseJointPDFDerivatives = false;
+    this->m_MaximumDenseJointPDFDerivativesSize = 1UL << 24;
+
+    /** Multi-threading. */
+    this->m_ParzenWindowHistogramThreaderParameters.st_Metric = this;
+    this->m_ParzenWindowHistogramThreaderParameters.st_PDFComputation = PDFs;
 
   } // end Constructor
 
@@ -92,6 +103,10 @@ namespace itk
       << this->m_FixedKernelBSplineOrder << std::endl;
     os << indent << "MovingKernelBSplineOrder: "
       << this->m_MovingKernelBSplineOrder << std::endl;
+    os << indent << "MaximumDenseJointPDFDerivativesSize: "
+      << this->m_MaximumDenseJointPDFDerivativesSize << std::endl;
+    os << indent << "UseSparseJointPDFDerivatives: "
+      << this->m_UseSparseJointPDFDerivatives << std::endl;
 
     /*double m_MovingImageNormalizedMin;
     double m_FixedImageNormalizedMin;
@@ -144,6 +159,53 @@ namespace itk
   } // end Initialize()
 
 
+  /**
+   * ********************* InitializeConcurrentCopy *****************************
+   */
+
+  template <class TFixedImage, class TMovingImage>
+    void
+    ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
+    ::InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const
+  {
+    /** Call the superclass to share the images, sampler and limiters. */
+    this->Superclass::InitializeConcurrentCopy( copy );
+
+    Self * thisCopy = dynamic_cast<Self *>( copy );
+    if ( thisCopy == 0 )
+    {
+      itkExceptionMacro( << "The concurrent copy is not a " << this->GetNameOfClass() );
+    }
+
+    /** Copy the settings. */
+    thisCopy->m_NumberOfFixedHistogramBins = this->m_NumberOfFixedHistogramBins;
+    thisCopy->m_NumberOfMovingHistogramBins = this->m_NumberOfMovingHistogramBins;
+    thisCopy->m_FixedKernelBSplineOrder = this->m_FixedKernelBSplineOrder;
+    thisCopy->m_MovingKernelBSplineOrder = this->m_MovingKernelBSplineOrder;
+    thisCopy->m_UseDerivative = this->m_UseDerivative;
+    thisCopy->m_UseFiniteDifferenceDerivative = this->m_UseFiniteDifferenceDerivative;
+    thisCopy->m_FiniteDifferencePerturbation = this->m_FiniteDifferencePerturbation;
+    thisCopy->m_UseExplicitPDFDerivatives = this->m_UseExplicitPDFDerivatives;
+    thisCopy->m_UseSparseJointPDFDerivatives = this->m_UseSparseJointPDFDerivatives;
+    thisCopy->m_MaximumDenseJointPDFDerivativesSize = this->m_MaximumDenseJointPDFDerivativesSize;
+
+    /** The copy gets its own histograms and Parzen windows, as in Initialize(). */
+    thisCopy->InitializeHistograms();
+    thisCopy->InitializeKernels();
+    if ( thisCopy->GetUseDerivative() && thisCopy->GetUseFiniteDifferenceDerivative() )
+    {
+      thisCopy->m_PerturbedAlphaRight.SetSize( thisCopy->GetNumberOfParameters() );
+      thisCopy->m_PerturbedAlphaLeft.SetSize( thisCopy->GetNumberOfParameters() );
+    }
+    else
+    {
+      thisCopy->m_PerturbedAlphaRight.SetSize( 0 );
+      thisCopy->m_PerturbedAlphaLeft.SetSize( 0 );
+    }
+
+  } // end InitializeConcurrentCopy()
+
+
   /**
    * ****************** InitializeHistograms *****************************
    */
@@ -213,6 +275,8 @@ namespace itk
     /** Allocate memory for the joint PDF and joint PDF derivatives. */
 
     /** First set these ones to zero */
+    this->m_UseSparseJointPDFDerivatives = false;
+    this->m_SparseJointPDFDerivatives = 0;
     this->m_FixedIncrementalMarginalPDFRight = 0;
     this->m_MovingIncrementalMarginalPDFRight = 0;
     this->m_FixedIncrementalMarginalPDFLeft = 0;
@@ -309,7 +373,19 @@ namespace itk
       } // end if this->GetUseFiniteDifferenceDerivative()
       else
       {
-        if ( this->m_UseExplicitPDFDerivatives )
+        /** Check if the pdf derivatives would be too large to store densely.
+         * The sparse storage only helps when the transform has a sparse Jacobian.
+         */
+        const unsigned long numberOfParameters = this->GetNumberOfParameters();
+        const double denseSize = static_cast<double>( numberOfParameters )
+          * this->m_NumberOfMovingHistogramBins * this->m_NumberOfFixedHistogramBins;
+        const bool sparseJacobian = this->m_AdvancedTransform.IsNotNull()
+          && this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() < numberOfParameters;
+        this->m_UseSparseJointPDFDerivatives = this->m_UseExplicitPDFDerivatives
+          && sparseJacobian
+          && denseSize > static_cast<double>( this->m_MaximumDenseJointPDFDerivativesSize );
+
+        if ( this->m_UseExplicitPDFDerivatives && !this->m_UseSparseJointPDFDerivatives )
         {
           this->m_IncrementalJointPDFRight = 0;
           this->m_IncrementalJointPDFLeft = 0;
@@ -318,6 +394,16 @@ namespace itk
           this->m_JointPDFDerivatives->SetRegions( jointPDFDerivativesRegion );
           this->m_JointPDFDerivatives->Allocate();
         }
+        else if ( this->m_UseSparseJointPDFDerivatives )
+        {
+          this->m_IncrementalJointPDFRight = 0;
+          this->m_IncrementalJointPDFLeft = 0;
+          this->m_JointPDFDerivatives = 0;
+
+          this->m_SparseJointPDFDerivatives = SparseJointPDFDerivativesType::New();
+          this->m_SparseJointPDFDerivatives->SetSize( numberOfParameters,
+            this->m_NumberOfMovingHistogramBins, this->m_NumberOfFixedHistogramBins );
+        }
         else
         {
           /** De-allocate large amount of memory for the m_JointPDFDerivatives. */
@@ -495,7 +581,10 @@ namespace itk
     ::UpdateJointPDFAndDerivatives(
       RealType fixedImageValue, RealType movingImageValue,
       const DerivativeType * imageJacobian,
-      const NonZeroJacobianIndicesType * nzji) const
+      const NonZeroJacobianIndicesType * nzji,
+      JointPDFType * jointPDF,
+      JointPDFDerivativesType * jointPDFDerivatives,
+      SparseJointPDFDerivativesType * sparseJointPDFDerivatives ) const
   {
     typedef ImageSliceIteratorWithIndex< JointPDFType >  PDFIteratorType;
 
@@ -523,13 +612,16 @@ namespace itk
       movingImageParzenWindowTerm, movingImageParzenWindowIndex,
       this->m_MovingKernel, movingParzenValues );
 
-    /** Position the JointPDFWindow. */
+    /** Position the JointPDFWindow. A local copy of the window is used,
+     * since this function may be called by several threads at once.
+     */
     JointPDFIndexType pdfWindowIndex;
     pdfWindowIndex[ 0 ] = movingImageParzenWindowIndex;
     pdfWindowIndex[ 1 ] = fixedImageParzenWindowIndex;
-    this->m_JointPDFWindow.SetIndex( pdfWindowIndex );
+    JointPDFRegionType jointPDFWindow = this->m_JointPDFWindow;
+    jointPDFWindow.SetIndex( pdfWindowIndex );
 
-    PDFIteratorType it( this->m_JointPDF, this->m_JointPDFWindow );
+    PDFIteratorType it( jointPDF, jointPDFWindow );
     it.GoToBegin();
     it.SetFirstDirection( 0 );
     it.SetSecondDirection( 1 );
@@ -569,9 +661,18 @@ namespace itk
         for ( unsigned int m = 0; m < movingParzenValues.GetSize(); ++m )
         {
           it.Value() += static_cast<PDFValueType>( fv * movingParzenValues[ m ] );
-          this->UpdateJointPDFDerivatives(
-            it.GetIndex(), fv_et * derivativeMovingParzenValues[ m ],
-            *imageJacobian, *nzji );
+          if ( sparseJointPDFDerivatives )
+          {
+            this->UpdateJointPDFDerivatives(
+              it.GetIndex(), fv_et * derivativeMovingParzenValues[ m ],
+              *imageJacobian, *nzji, sparseJointPDFDerivatives );
+          }
+          else
+          {
+            this->UpdateJointPDFDerivatives(
+              it.GetIndex(), fv_et * derivativeMovingParzenValues[ m ],
+              *imageJacobian, *nzji, jointPDFDerivatives );
+          }
           ++it;
         }
         it.NextLine();
@@ -591,12 +692,13 @@ namespace itk
     ::UpdateJointPDFDerivatives(
     const JointPDFIndexType & pdfIndex, double factor,
     const DerivativeType & imageJacobian,
-    const NonZeroJacobianIndicesType & nzji  ) const
+    const NonZeroJacobianIndicesType & nzji,
+    JointPDFDerivativesType * jointPDFDerivatives ) const
   {
     /** Get the pointer to the element with index [0, pdfIndex[0], pdfIndex[1]]. */
-    PDFValueType * derivPtr = this->m_JointPDFDerivatives->GetBufferPointer() +
-      ( pdfIndex[0] * this->m_JointPDFDerivatives->GetOffsetTable()[1] ) +
-      ( pdfIndex[1] * this->m_JointPDFDerivatives->GetOffsetTable()[2] );
+    PDFValueType * derivPtr = jointPDFDerivatives->GetBufferPointer() +
+      ( pdfIndex[0] * jointPDFDerivatives->GetOffsetTable()[1] ) +
+      ( pdfIndex[1] * jointPDFDerivatives->GetOffsetTable()[2] );
 
     if ( nzji.size() == this->GetNumberOfParameters() )
     {
@@ -623,6 +725,47 @@ namespace itk
   } // end UpdateJointPDFDerivatives()
 
 
+  /**
+   * *************** UpdateJointPDFDerivatives (sparse) *******************
+   */
+
+  template < class TFixedImage, class TMovingImage >
+    void
+    ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
+    ::UpdateJointPDFDerivatives(
+    const JointPDFIndexType & pdfIndex, double factor,
+    const DerivativeType & imageJacobian,
+    const NonZeroJacobianIndicesType & nzji,
+    SparseJointPDFDerivativesType * sparseJointPDFDerivatives ) const
+  {
+    typedef typename SparseJointPDFDerivativesType::SizeValueType SizeValueType;
+    const unsigned int blockSizeLog2 = SparseJointPDFDerivativesType::BlockSizeLog2;
+    const SizeValueType blockMask = SparseJointPDFDerivativesType::BlockSize - 1;
+
+    const SizeValueType binIndex = static_cast<SizeValueType>(
+      pdfIndex[ 0 ] + pdfIndex[ 1 ] * this->m_NumberOfMovingHistogramBins );
+
+    /** Loop over the non-zero Jacobians. Consecutive indices mostly lie in
+     * the same block, so the block pointer is only looked up when the block
+     * changes. Note that looking up a block may invalidate the previous one.
+     */
+    SizeValueType currentBlock = 0;
+    PDFValueType * blockPtr = 0;
+    for ( unsigned int i = 0; i < imageJacobian.GetSize(); ++i )
+    {
+      const SizeValueType mu = nzji[ i ];
+      const SizeValueType block = mu >> blockSizeLog2;
+      if ( blockPtr == 0 || block != currentBlock )
+      {
+        blockPtr = sparseJointPDFDerivatives->GetBlock( binIndex, block );
+        currentBlock = block;
+      }
+      blockPtr[ mu & blockMask ] -= static_cast<PDFValueType>( imageJacobian[ i ] * factor );
+    }
+
+  } // end UpdateJointPDFDerivatives()
+
+
   /**
    * *************** EvaluateTransformJacobianInnerProduct ****************
    */
@@ -718,7 +861,7 @@ namespace itk
   {
     typedef ImageLinearIteratorWithIndex<JointPDFType> JointPDFLinearIterator;
     JointPDFLinearIterator linearIter(
-      this->m_JointPDF, this->m_JointPDF->GetBufferedRegion() );
+      jointPDF, jointPDF->GetBufferedRegion() );
     linearIter.SetDirection( direction );
     linearIter.GoToBegin();
     unsigned int marginalIndex = 0;
@@ -804,11 +947,26 @@ namespace itk
     const DerivativeType & movingImageValuesLeft,
     const DerivativeType & movingMaskValuesRight,
     const DerivativeType & movingMaskValuesLeft,
-    const NonZeroJacobianIndicesType & nzji ) const
+    const NonZeroJacobianIndicesType & nzji,
+    JointPDFType * jointPDF,
+    JointPDFDerivativesType * incrementalJointPDFRight,
+    JointPDFDerivativesType * incrementalJointPDFLeft,
+    DerivativeType & perturbedAlphaRight,
+    DerivativeType & perturbedAlphaLeft,
+    SparseJointPDFDerivativesType * sparseIncrementalJointPDFRight,
+    SparseJointPDFDerivativesType * sparseIncrementalJointPDFLeft ) const
   {
-    /** Pointers to the first pixels in the incremental joint pdfs. */
-    PDFValueType * incRightBasePtr = this->m_IncrementalJointPDFRight->GetBufferPointer();
-    PDFValueType * incLeftBasePtr = this->m_IncrementalJointPDFLeft->GetBufferPointer();
+    typedef typename SparseJointPDFDerivativesType::SizeValueType SizeValueType;
+    const bool useSparse = sparseIncrementalJointPDFRight != 0;
+
+    /** Pointers to the first pixels in the dense incremental joint pdfs. */
+    PDFValueType * incRightBasePtr = 0;
+    PDFValueType * incLeftBasePtr = 0;
+    if ( !useSparse )
+    {
+      incRightBasePtr = incrementalJointPDFRight->GetBufferPointer();
+      incLeftBasePtr = incrementalJointPDFLeft->GetBufferPointer();
+    }
 
     /** The Parzen value containers. */
     ParzenValueContainerType fixedParzenValues( this->m_JointPDFWindow.GetSize()[1] );
@@ -856,11 +1014,24 @@ namespace itk
         {
           const PDFValueType fv_mask_mv =
             static_cast<PDFValueType>( fv_mask * movingParzenValues[ m ] );
-          this->m_JointPDF->GetPixel( pdfIndex ) += fv_mask_mv;
+          jointPDF->GetPixel( pdfIndex ) += fv_mask_mv;
+
+          if ( useSparse )
+          {
+            const SizeValueType binIndex = static_cast<SizeValueType>(
+              pdfIndex[ 0 ] + pdfIndex[ 1 ] * this->m_NumberOfMovingHistogramBins );
+            for ( unsigned int i = 0; i < nzji.size(); ++i )
+            {
+              sparseIncrementalJointPDFRight->AddValue( binIndex, nzji[ i ], -fv_mask_mv );
+              sparseIncrementalJointPDFLeft->AddValue( binIndex, nzji[ i ], -fv_mask_mv );
+            }
+            ++(pdfIndex[ 0 ]);
+            continue;
+          }
 
           unsigned long offset = static_cast<unsigned long>(
-            pdfIndex[ 0 ] * this->m_IncrementalJointPDFRight->GetOffsetTable()[ 1 ] +
-            pdfIndex[ 1 ] * this->m_IncrementalJointPDFRight->GetOffsetTable()[ 2 ] );
+            pdfIndex[ 0 ] * incrementalJointPDFRight->GetOffsetTable()[ 1 ] +
+            pdfIndex[ 1 ] * incrementalJointPDFRight->GetOffsetTable()[ 2 ] );
 
           /** Get the pointer to the element with index [0, pdfIndex[0], pdfIndex[1]]. */
           PDFValueType * incRightPtr = incRightBasePtr + offset;
@@ -928,7 +1099,16 @@ namespace itk
           {
             const PDFValueType fv_mask_mv =
               static_cast<PDFValueType>( fv_mask * movingParzenValues[m] );
-            this->m_IncrementalJointPDFRight->GetPixel( rindex ) += fv_mask_mv;
+            if ( useSparse )
+            {
+              sparseIncrementalJointPDFRight->AddValue( static_cast<SizeValueType>(
+                rindex[ 1 ] + rindex[ 2 ] * this->m_NumberOfMovingHistogramBins ),
+                mu, fv_mask_mv );
+            }
+            else
+            {
+              incrementalJointPDFRight->GetPixel( rindex ) += fv_mask_mv;
+            }
             ++(rindex[ 1 ]);
           } // end for m
 
@@ -964,7 +1144,16 @@ namespace itk
           {
             const PDFValueType fv_mask_mv =
               static_cast<PDFValueType>( fv_mask * movingParzenValues[ m ] );
-            this->m_IncrementalJointPDFLeft->GetPixel( lindex ) += fv_mask_mv;
+            if ( useSparse )
+            {
+              sparseIncrementalJointPDFLeft->AddValue( static_cast<SizeValueType>(
+                lindex[ 1 ] + lindex[ 2 ] * this->m_NumberOfMovingHistogramBins ),
+                mu, fv_mask_mv );
+            }
+            else
+            {
+              incrementalJointPDFLeft->GetPixel( lindex ) += fv_mask_mv;
+            }
             ++(lindex[ 1 ]);
           } // end for m
 
@@ -975,8 +1164,8 @@ namespace itk
       } // end if maskl
 
       /** Update the perturbed alphas. */
-      this->m_PerturbedAlphaRight[mu] += ( maskr - movingMaskValue );
-      this->m_PerturbedAlphaLeft[mu] += ( maskl - movingMaskValue );
+      perturbedAlphaRight[mu] += ( maskr - movingMaskValue );
+      perturbedAlphaLeft[mu] += ( maskl - movingMaskValue );
     } // end for i
 
 
@@ -992,6 +1181,14 @@ namespace itk
     ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
     ::ComputePDFs( const ParametersType& parameters ) const
   {
+    tmrProfileScope( "ParzenWindowHistogram::ComputePDFs" );
+
+    /** Option for now to still use the single threaded code. */
+    if ( this->GetUseMultiThread() )
+    {
+      return this->ComputePDFsMultiThreaded( parameters, PDFs );
+    }
+
     /** Initialize some variables. */
     this->m_JointPDF->FillBuffer( 0.0 );
     this->m_NumberOfPixelsCounted = 0;
@@ -1004,16 +1201,44 @@ namespace itk
     this->GetImageSampler()->Update();
     ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-    /** Create iterator over the sample container. */
-    typename ImageSampleContainerType::ConstIterator fiter;
-    typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-    typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
-
     /** Loop over sample container and compute contribution of each sample to pdfs. */
-    for ( fiter = fbegin; fiter != fend; ++fiter )
+    unsigned long numberOfPixelsCounted = 0;
+    this->ComputePDFsForSampleRange( sampleContainer, 0, sampleContainer->Size(),
+      this->m_JointPDF, numberOfPixelsCounted );
+    this->m_NumberOfPixelsCounted = numberOfPixelsCounted;
+
+    /** Check if enough samples were valid. */
+    this->CheckNumberOfSamples( sampleContainer->Size(), this->m_NumberOfPixelsCounted );
+
+    /** Compute alpha. */
+    this->m_Alpha = 0.0;
+    if ( this->m_NumberOfPixelsCounted > 0 )
+    {
+      this->m_Alpha = 1.0 / static_cast<double>( this->m_NumberOfPixelsCounted );
+    }
+
+  } // end ComputePDFs()
+
+
+  /**
+   * ******************** ComputePDFsForSampleRange ***********************
+   */
+
+  template < class TFixedImage, class TMovingImage >
+    void
+    ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
+    ::ComputePDFsForSampleRange(
+    const ImageSampleContainerType * sampleContainer,
+    unsigned long begin, unsigned long end,
+    JointPDFType * jointPDF,
+    unsigned long & numberOfPixelsCounted ) const
+  {
+    /** Loop over the samples and compute contribution of each sample to pdfs. */
+    for ( unsigned long pos = begin; pos < end; ++pos )
     {
       /** Read fixed coordinates and initialize some variables. */
-      const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+      const FixedImagePointType fixedPoint
+        = sampleContainer->GetImageCoordinates( pos );
       RealType movingImageValue;
       MovingImagePointType mappedPoint;
 
@@ -1037,10 +1262,11 @@ namespace itk
 
       if ( sampleOk )
       {
-        this->m_NumberOfPixelsCounted++;
+        numberOfPixelsCounted++;
 
         /** Get the fixed image value. */
-        RealType fixedImageValue = static_cast<RealType>( (*fiter).Value().m_ImageValue );
+        RealType fixedImageValue = static_cast<RealType>(
+          sampleContainer->GetImageValue( pos ) );
 
         /** Make sure the values fall within the histogram range. */
         fixedImageValue = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
@@ -1048,22 +1274,12 @@ namespace itk
 
         /** Compute this sample's contribution to the joint distributions. */
         this->UpdateJointPDFAndDerivatives(
-          fixedImageValue, movingImageValue, 0, 0 );
+          fixedImageValue, movingImageValue, 0, 0, jointPDF, 0 );
       }
 
     } // end iterating over fixed image spatial sample container for loop
 
-    /** Check if enough samples were valid. */
-    this->CheckNumberOfSamples( sampleContainer->Size(), this->m_NumberOfPixelsCounted );
-
-    /** Compute alpha. */
-    this->m_Alpha = 0.0;
-    if ( this->m_NumberOfPixelsCounted > 0 )
-    {
-      this->m_Alpha = 1.0 / static_cast<double>( this->m_NumberOfPixelsCounted );
-    }
-
-  } // end ComputePDFs()
+  } // end ComputePDFsForSampleRange()
 
 
   /**
@@ -1075,17 +1291,27 @@ namespace itk
     ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
     ::ComputePDFsAndPDFDerivatives( const ParametersType& parameters ) const
   {
+    tmrProfileScope( "ParzenWindowHistogram::ComputePDFsAndPDFDerivatives" );
+
+    /** Option for now to still use the single threaded code. */
+    if ( this->GetUseMultiThread() )
+    {
+      return this->ComputePDFsMultiThreaded( parameters, PDFsAndPDFDerivatives );
+    }
+
     /** Initialize some variables. */
     this->m_JointPDF->FillBuffer( 0.0 );
-    this->m_JointPDFDerivatives->FillBuffer( 0.0 );
+    if ( this->m_UseSparseJointPDFDerivatives )
+    {
+      this->m_SparseJointPDFDerivatives->Reset();
+    }
+    else
+    {
+      this->m_JointPDFDerivatives->FillBuffer( 0.0 );
+    }
     this->m_Alpha = 0.0;
     this->m_NumberOfPixelsCounted = 0;
 
-    /** Array that stores dM(x)/dmu, and the sparse jacobian+indices. */
-    NonZeroJacobianIndicesType nzji( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
-    DerivativeType imageJacobian( nzji.size() );
-    TransformJacobianType jacobian;
-
     /** Set up the parameters in the transform. */
     this->SetTransformParameters( parameters );
 
@@ -1093,16 +1319,54 @@ namespace itk
     this->GetImageSampler()->Update();
     ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-    /** Create iterator over the sample container. */
-    typename ImageSampleContainerType::ConstIterator fiter;
-    typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-    typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
-
     /** Loop over sample container and compute contribution of each sample to pdfs. */
-    for ( fiter = fbegin; fiter != fend; ++fiter )
+    unsigned long numberOfPixelsCounted = 0;
+    this->ComputePDFsAndPDFDerivativesForSampleRange(
+      sampleContainer, 0, sampleContainer->Size(),
+      this->m_JointPDF, this->m_JointPDFDerivatives,
+      this->m_SparseJointPDFDerivatives, numberOfPixelsCounted );
+    this->m_NumberOfPixelsCounted = numberOfPixelsCounted;
+
+    /** Check if enough samples were valid. */
+    this->CheckNumberOfSamples(
+      sampleContainer->Size(), this->m_NumberOfPixelsCounted );
+
+    /** Compute alpha. */
+    this->m_Alpha = 0.0;
+    if ( this->m_NumberOfPixelsCounted > 0 )
+    {
+      this->m_Alpha = 1.0 / static_cast<double>( this->m_NumberOfPixelsCounted );
+    }
+
+  } // end ComputePDFsAndPDFDerivatives()
+
+
+  /**
+   * *************** ComputePDFsAndPDFDerivativesForSampleRange ****************
+   */
+
+  template < class TFixedImage, class TMovingImage >
+    void
+    ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
+    ::ComputePDFsAndPDFDerivativesForSampleRange(
+    const ImageSampleContainerType * sampleContainer,
+    unsigned long begin, unsigned long end,
+    JointPDFType * jointPDF,
+    JointPDFDerivativesType * jointPDFDerivatives,
+    SparseJointPDFDerivativesType * sparseJointPDFDerivatives,
+    unsigned long & numberOfPixelsCounted ) const
+  {
+    /** Array that stores dM(x)/dmu, and the sparse jacobian+indices. */
+    NonZeroJacobianIndicesType nzji( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
+    DerivativeType imageJacobian( nzji.size() );
+    TransformJacobianType jacobian;
+
+    /** Loop over the samples and compute contribution of each sample to pdfs. */
+    for ( unsigned long pos = begin; pos < end; ++pos )
     {
       /** Read fixed coordinates and initialize some variables. */
-      const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+      const FixedImagePointType fixedPoint
+        = sampleContainer->GetImageCoordinates( pos );
       RealType movingImageValue;
       MovingImagePointType mappedPoint;
       MovingImageDerivativeType movingImageDerivative;
@@ -1127,10 +1391,11 @@ namespace itk
 
       if ( sampleOk )
       {
-        this->m_NumberOfPixelsCounted++;
+        numberOfPixelsCounted++;
 
         /** Get the fixed image value. */
-        RealType fixedImageValue = static_cast<RealType>( (*fiter).Value().m_ImageValue );
+        RealType fixedImageValue = static_cast<RealType>(
+          sampleContainer->GetImageValue( pos ) );
 
         /** Make sure the values fall within the histogram range. */
         fixedImageValue = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
@@ -1146,23 +1411,13 @@ namespace itk
 
         /** Update the joint pdf and the joint pdf derivatives. */
         this->UpdateJointPDFAndDerivatives(
-          fixedImageValue, movingImageValue, &imageJacobian, &nzji );
+          fixedImageValue, movingImageValue, &imageJacobian, &nzji,
+          jointPDF, jointPDFDerivatives, sparseJointPDFDerivatives );
 
       } //end if-block check sampleOk
     } // end iterating over fixed image spatial sample container for loop
 
-    /** Check if enough samples were valid. */
-    this->CheckNumberOfSamples(
-      sampleContainer->Size(), this->m_NumberOfPixelsCounted );
-
-    /** Compute alpha. */
-    this->m_Alpha = 0.0;
-    if ( this->m_NumberOfPixelsCounted > 0 )
-    {
-      this->m_Alpha = 1.0 / static_cast<double>( this->m_NumberOfPixelsCounted );
-    }
-
-  } // end ComputePDFsAndPDFDerivatives()
+  } // end ComputePDFsAndPDFDerivativesForSampleRange()
 
 
    /**
@@ -1174,6 +1429,14 @@ namespace itk
     ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
     ::ComputePDFsAndIncrementalPDFs( const ParametersType& parameters ) const
   {
+    tmrProfileScope( "ParzenWindowHistogram::ComputePDFsAndIncrementalPDFs" );
+
+    /** Option for now to still use the single threaded code. */
+    if ( this->GetUseMultiThread() )
+    {
+      return this->ComputePDFsMultiThreaded( parameters, PDFsAndIncrementalPDFs );
+    }
+
     /** Initialize some variables. */
     this->m_JointPDF->FillBuffer( 0.0 );
     this->m_IncrementalJointPDFRight->FillBuffer( 0.0 );
@@ -1184,6 +1447,79 @@ namespace itk
 
     this->m_NumberOfPixelsCounted = 0;
     double sumOfMovingMaskValues = 0.0;
+
+    /** Set up the parameters in the transform. */
+    this->SetTransformParameters( parameters );
+
+    /** Update the imageSampler and get a handle to the sample container. */
+    this->GetImageSampler()->Update();
+    ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+
+    /** Loop over sample container and compute contribution of each sample to pdfs. */
+    unsigned long numberOfPixelsCounted = 0;
+    this->ComputePDFsAndIncrementalPDFsForSampleRange(
+      sampleContainer, 0, sampleContainer->Size(),
+      this->m_JointPDF,
+      this->m_IncrementalJointPDFRight, this->m_IncrementalJointPDFLeft,
+      this->m_PerturbedAlphaRight, this->m_PerturbedAlphaLeft,
+      numberOfPixelsCounted, sumOfMovingMaskValues );
+    this->m_NumberOfPixelsCounted = numberOfPixelsCounted;
+
+    /** Check if enough samples were valid. */
+    this->CheckNumberOfSamples(
+      sampleContainer->Size(), this->m_NumberOfPixelsCounted );
+
+    /** Compute alpha and its perturbed versions. */
+    this->m_Alpha = 0.0;
+    if ( sumOfMovingMaskValues > 1e-14 )
+    {
+      this->m_Alpha = 1.0 / sumOfMovingMaskValues;
+    }
+    for ( unsigned int i = 0; i < this->GetNumberOfParameters(); ++i )
+    {
+      this->m_PerturbedAlphaRight[ i ] += sumOfMovingMaskValues;
+      this->m_PerturbedAlphaLeft[ i ] += sumOfMovingMaskValues;
+      if ( this->m_PerturbedAlphaRight[i] > 1e-10 )
+      {
+        this->m_PerturbedAlphaRight[ i ] = 1.0 / this->m_PerturbedAlphaRight[ i ];
+      }
+      else
+      {
+         this->m_PerturbedAlphaRight[ i ] = 0.0;
+      }
+      if ( this->m_PerturbedAlphaLeft[ i ] > 1e-10 )
+      {
+        this->m_PerturbedAlphaLeft[ i ] = 1.0 / this->m_PerturbedAlphaLeft[ i ];
+      }
+      else
+      {
+         this->m_PerturbedAlphaLeft[ i ] = 0.0;
+      }
+    }
+
+  } // end ComputePDFsAndIncrementalPDFs()
+
+
+  /**
+   * ************** ComputePDFsAndIncrementalPDFsForSampleRange ****************
+   */
+
+  template < class TFixedImage, class TMovingImage >
+    void
+    ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
+    ::ComputePDFsAndIncrementalPDFsForSampleRange(
+    const ImageSampleContainerType * sampleContainer,
+    unsigned long begin, unsigned long end,
+    JointPDFType * jointPDF,
+    JointPDFDerivativesType * incrementalJointPDFRight,
+    JointPDFDerivativesType * incrementalJointPDFLeft,
+    DerivativeType & perturbedAlphaRight,
+    DerivativeType & perturbedAlphaLeft,
+    unsigned long & numberOfPixelsCounted,
+    double & sumOfMovingMaskValues,
+    SparseJointPDFDerivativesType * sparseIncrementalJointPDFRight,
+    SparseJointPDFDerivativesType * sparseIncrementalJointPDFLeft ) const
+  {
     const double delta = this->GetFiniteDifferencePerturbation();
 
     /** sparse jacobian+indices. */
@@ -1196,23 +1532,12 @@ namespace itk
     DerivativeType movingMaskValuesRight( nzji.size() );
     DerivativeType movingMaskValuesLeft( nzji.size() );
 
-    /** Set up the parameters in the transform. */
-    this->SetTransformParameters( parameters );
-
-    /** Update the imageSampler and get a handle to the sample container. */
-    this->GetImageSampler()->Update();
-    ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
-
-    /** Create iterator over the sample container. */
-    typename ImageSampleContainerType::ConstIterator fiter;
-    typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-    typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
-
-    /** Loop over sample container and compute contribution of each sample to pdfs. */
-    for ( fiter = fbegin; fiter != fend; ++fiter )
+    /** Loop over the samples and compute contribution of each sample to pdfs. */
+    for ( unsigned long pos = begin; pos < end; ++pos )
     {
       /** Read fixed coordinates. */
-      const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+      const FixedImagePointType fixedPoint
+        = sampleContainer->GetImageCoordinates( pos );
 
       /** Transform point and check if it is inside the B-spline support region.
        * if not, skip this sample.
@@ -1223,7 +1548,8 @@ namespace itk
       if ( sampleOk )
       {
         /** Get the fixed image value and make sure the value falls within the histogram range. */
-        RealType fixedImageValue = static_cast<RealType>( (*fiter).Value().m_ImageValue );
+        RealType fixedImageValue = static_cast<RealType>(
+          sampleContainer->GetImageValue( pos ) );
         fixedImageValue = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
 
         /** Check if point is inside mask. */
@@ -1262,7 +1588,7 @@ namespace itk
 
         /** count how many samples were used. */
         sumOfMovingMaskValues += movingMaskValue;
-        this->m_NumberOfPixelsCounted += static_cast<unsigned int>( sampleOk );
+        numberOfPixelsCounted += static_cast<unsigned int>( sampleOk );
 
         /** Get the TransformJacobian dT/dmu. We assume the transform is a linear
          * function of its parameters, so that we can evaluate T(x;\mu+delta_ek)
@@ -1338,17 +1664,95 @@ namespace itk
         this->UpdateJointPDFAndIncrementalPDFs(
           fixedImageValue, movingImageValue, movingMaskValue,
           movingImageValuesRight, movingImageValuesLeft,
-          movingMaskValuesRight, movingMaskValuesLeft, nzji );
+          movingMaskValuesRight, movingMaskValuesLeft, nzji,
+          jointPDF, incrementalJointPDFRight, incrementalJointPDFLeft,
+          perturbedAlphaRight, perturbedAlphaLeft,
+          sparseIncrementalJointPDFRight, sparseIncrementalJointPDFLeft );
 
       } //end if-block check sampleOk
     } // end iterating over fixed image spatial sample container for loop
 
+  } // end ComputePDFsAndIncrementalPDFsForSampleRange()
+
+
+  /**
+   * ****************** ComputePDFsMultiThreaded *****************************
+   */
+
+  template < class TFixedImage, class TMovingImage >
+    void
+    ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
+    ::ComputePDFsMultiThreaded( const ParametersType & parameters,
+    PDFComputationType computation ) const
+  {
+    tmrProfileScope( "ParzenWindowHistogram::ComputePDFsMultiThreaded" );
+
+    /** Initialize some variables. */
+    this->m_NumberOfPixelsCounted = 0;
+    this->m_Alpha = 0.0;
+
+    /** Set up the parameters in the transform. */
+    this->SetTransformParameters( parameters );
+
+    /** Update the imageSampler and get a handle to the sample container. */
+    this->GetImageSampler()->Update();
+    ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+
+    /** Reset the member histograms and the per-thread histograms. */
+    this->InitializeParzenWindowHistogramThreadingParameters( computation );
+
+    /** Launch the threads; each fills its own histograms. */
+    this->m_ParzenWindowHistogramThreaderParameters.st_PDFComputation = computation;
+    void * userData = const_cast<void *>( static_cast<const void *>(
+      &this->m_ParzenWindowHistogramThreaderParameters ) );
+    this->m_Threader->SetSingleMethod( ComputePDFsThreaderCallback, userData );
+    this->m_Threader->SingleMethodExecute();
+
+    /** Accumulate the number of pixels counted and the sum of the mask values. */
+    const unsigned int numberOfThreads = this->m_Threader->GetNumberOfThreads();
+    double sumOfMovingMaskValues = 0.0;
+    for ( unsigned int i = 0; i < numberOfThreads; ++i )
+    {
+      this->m_NumberOfPixelsCounted
+        += this->m_ParzenWindowHistogramPerThreadVariables[ i ].st_NumberOfPixelsCounted;
+      sumOfMovingMaskValues
+        += this->m_ParzenWindowHistogramPerThreadVariables[ i ].st_SumOfMovingMaskValues;
+    }
+
     /** Check if enough samples were valid. */
     this->CheckNumberOfSamples(
       sampleContainer->Size(), this->m_NumberOfPixelsCounted );
 
-    /** Compute alpha and its perturbed versions. */
-    this->m_Alpha = 0.0;
+    /** Sum the per-thread histograms into the member histograms. This is only
+     * needed when more than one thread did contribute.
+     */
+    if ( numberOfThreads > 1 || computation == PDFsAndIncrementalPDFs )
+    {
+      /** Allocating sparse blocks is not thread safe, so first make sure
+       * that all blocks of the other threads exist in the member.
+       */
+      if ( computation == PDFsAndPDFDerivatives && this->m_UseSparseJointPDFDerivatives )
+      {
+        for ( unsigned int i = 1; i < numberOfThreads; ++i )
+        {
+          this->m_SparseJointPDFDerivatives->AllocateBlocksOf(
+            this->m_ParzenWindowHistogramPerThreadVariables[ i ].st_SparseJointPDFDerivatives );
+        }
+      }
+      this->m_Threader->SetSingleMethod( ReducePDFsThreaderCallback, userData );
+      this->m_Threader->SingleMethodExecute();
+    }
+
+    /** Compute alpha, and for finite differences its perturbed versions. */
+    if ( computation != PDFsAndIncrementalPDFs )
+    {
+      if ( this->m_NumberOfPixelsCounted > 0 )
+      {
+        this->m_Alpha = 1.0 / static_cast<double>( this->m_NumberOfPixelsCounted );
+      }
+      return;
+    }
+
     if ( sumOfMovingMaskValues > 1e-14 )
     {
       this->m_Alpha = 1.0 / sumOfMovingMaskValues;
@@ -1375,11 +1779,346 @@ namespace itk
       }
     }
 
-  } // end ComputePDFsAndIncrementalPDFs()
+  } // end ComputePDFsMultiThreaded()
+
+
+  /**
+   * ********* InitializeParzenWindowHistogramThreadingParameters ***********
+   */
+
+  template < class TFixedImage, class TMovingImage >
+    void
+    ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
+    ::InitializeParzenWindowHistogramThreadingParameters(
+    PDFComputationType computation ) const
+  {
+    const unsigned int numberOfThreads = this->m_Threader->GetNumberOfThreads();
+    if ( this->m_ParzenWindowHistogramPerThreadVariables.size() != numberOfThreads )
+    {
+      this->m_ParzenWindowHistogramPerThreadVariables.resize( numberOfThreads );
+    }
+
+    /** Thread 0 directly writes into the member histograms. */
+    this->m_JointPDF->FillBuffer( 0.0 );
+    if ( computation == PDFsAndPDFDerivatives )
+    {
+      if ( this->m_UseSparseJointPDFDerivatives )
+      {
+        this->m_SparseJointPDFDerivatives->Reset();
+      }
+      else
+      {
+        this->m_JointPDFDerivatives->FillBuffer( 0.0 );
+      }
+    }
+    else if ( computation == PDFsAndIncrementalPDFs )
+    {
+      this->m_IncrementalJointPDFRight->FillBuffer( 0.0 );
+      this->m_IncrementalJointPDFLeft->FillBuffer( 0.0 );
+      this->m_PerturbedAlphaRight.Fill( 0.0 );
+      this->m_PerturbedAlphaLeft.Fill( 0.0 );
+    }
+
+    const unsigned int numberOfParameters = this->GetNumberOfParameters();
+    for ( unsigned int i = 0; i < numberOfThreads; ++i )
+    {
+      ParzenWindowHistogramPerThreadStruct & threadVariables
+        = this->m_ParzenWindowHistogramPerThreadVariables[ i ];
+      threadVariables.st_NumberOfPixelsCounted = 0;
+      threadVariables.st_SumOfMovingMaskValues = 0.0;
+
+      /** The perturbed alphas are small, so every thread has a private copy,
+       * which is added to the (zero-initialized) member afterwards.
+       */
+      if ( computation == PDFsAndIncrementalPDFs )
+      {
+        if ( threadVariables.st_PerturbedAlphaRight.GetSize() != numberOfParameters )
+        {
+          threadVariables.st_PerturbedAlphaRight.SetSize( numberOfParameters );
+          threadVariables.st_PerturbedAlphaLeft.SetSize( numberOfParameters );
+        }
+        threadVariables.st_PerturbedAlphaRight.Fill( 0.0 );
+        threadVariables.st_PerturbedAlphaLeft.Fill( 0.0 );
+      }
+
+      if ( i == 0 )
+      {
+        threadVariables.st_JointPDF = this->m_JointPDF;
+        threadVariables.st_JointPDFDerivatives = this->m_JointPDFDerivatives;
+        threadVariables.st_SparseJointPDFDerivatives = 0;
+        if ( this->m_UseSparseJointPDFDerivatives )
+        {
+          threadVariables.st_SparseJointPDFDerivatives = this->m_SparseJointPDFDerivatives;
+        }
+        threadVariables.st_IncrementalJointPDFRight = this->m_IncrementalJointPDFRight;
+        threadVariables.st_IncrementalJointPDFLeft = this->m_IncrementalJointPDFLeft;
+        threadVariables.st_SparseIncrementalJointPDFRight = 0;
+        threadVariables.st_SparseIncrementalJointPDFLeft = 0;
+        continue;
+      }
+
+      /** Allocate private histograms for the other threads, when needed. */
+      const JointPDFRegionType jointPDFRegion
+        = this->m_JointPDF->GetLargestPossibleRegion();
+      if ( threadVariables.st_JointPDF.IsNull()
+        || threadVariables.st_JointPDF->GetLargestPossibleRegion() != jointPDFRegion )
+      {
+        threadVariables.st_JointPDF = JointPDFType::New();
+        threadVariables.st_JointPDF->SetRegions( jointPDFRegion );
+        threadVariables.st_JointPDF->Allocate();
+      }
+      threadVariables.st_JointPDF->FillBuffer( 0.0 );
+
+      /** The private pdf derivatives are block sparse, also when the member
+       * is dense; a dense copy per thread would need
+       * threads x parameters x bins memory.
+       */
+      const unsigned long numberOfMovingBins = this->m_NumberOfMovingHistogramBins;
+      const unsigned long numberOfFixedBins = this->m_NumberOfFixedHistogramBins;
+      threadVariables.st_JointPDFDerivatives = 0;
+      threadVariables.st_IncrementalJointPDFRight = 0;
+      threadVariables.st_IncrementalJointPDFLeft = 0;
+      if ( computation == PDFsAndPDFDerivatives )
+      {
+        this->InitializeThreadSparseJointPDFDerivatives(
+          threadVariables.st_SparseJointPDFDerivatives,
+          numberOfParameters, numberOfMovingBins, numberOfFixedBins );
+      }
+      else if ( computation == PDFsAndIncrementalPDFs )
+      {
+        this->InitializeThreadSparseJointPDFDerivatives(
+          threadVariables.st_SparseIncrementalJointPDFRight,
+          numberOfParameters, numberOfMovingBins, numberOfFixedBins );
+        this->InitializeThreadSparseJointPDFDerivatives(
+          threadVariables.st_SparseIncrementalJointPDFLeft,
+          numberOfParameters, numberOfMovingBins, numberOfFixedBins );
+      }
+    }
+
+  } // end InitializeParzenWindowHistogramThreadingParameters()
+
+
+  /**
+   * ********* InitializeThreadSparseJointPDFDerivatives ***********
+   */
+
+  template < class TFixedImage, class TMovingImage >
+    void
+    ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
+    ::InitializeThreadSparseJointPDFDerivatives(
+    typename SparseJointPDFDerivativesType::Pointer & sparse,
+    unsigned long numberOfParameters,
+    unsigned long numberOfMovingBins,
+    unsigned long numberOfFixedBins ) const
+  {
+    /** Only (re)allocate when the size changed; otherwise keep the memory. */
+    if ( sparse.IsNull()
+      || sparse->GetNumberOfParameters() != numberOfParameters
+      || sparse->GetNumberOfMovingBins() != numberOfMovingBins
+      || sparse->GetNumberOfFixedBins() != numberOfFixedBins )
+    {
+      sparse = SparseJointPDFDerivativesType::New();
+      sparse->SetSize( numberOfParameters, numberOfMovingBins, numberOfFixedBins );
+    }
+    sparse->Reset();
+
+  } // end InitializeThreadSparseJointPDFDerivatives()
+
+
+  /**
+   * ******************* ComputePDFsThreaderCallback *******************
+   */
+
+  template < class TFixedImage, class TMovingImage >
+    ITK_THREAD_RETURN_TYPE
+    ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
+    ::ComputePDFsThreaderCallback( void * arg )
+  {
+    ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>( arg );
+    const unsigned int threadID = infoStruct->ThreadID;
+
+    ParzenWindowHistogramMultiThreaderParameterType * temp
+      = static_cast<ParzenWindowHistogramMultiThreaderParameterType *>( infoStruct->UserData );
+
+    {
+      tmrProfileScope( "Thread" );
+      temp->st_Metric->ThreadedComputePDFs( threadID, temp->st_PDFComputation );
+    }
+
+    return ITK_THREAD_RETURN_VALUE;
+
+  } // end ComputePDFsThreaderCallback()
+
+
+  /**
+   * ******************* ThreadedComputePDFs *******************
+   */
+
+  template < class TFixedImage, class TMovingImage >
+    void
+    ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
+    ::ThreadedComputePDFs( unsigned int threadID,
+    PDFComputationType computation ) const
+  {
+    ParzenWindowHistogramPerThreadStruct & threadVariables
+      = this->m_ParzenWindowHistogramPerThreadVariables[ threadID ];
+
+    /** Get a handle to the sample container and the samples of this thread. */
+    ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+    unsigned long pos_begin = 0;
+    unsigned long pos_end = 0;
+    this->GetThreadSampleRange( threadID, sampleContainer->Size(),
+      pos_begin, pos_end );
+
+    /** Use local counters, to avoid false sharing. */
+    unsigned long numberOfPixelsCounted = 0;
+    double sumOfMovingMaskValues = 0.0;
+
+    if ( computation == PDFs )
+    {
+      this->ComputePDFsForSampleRange( sampleContainer, pos_begin, pos_end,
+        threadVariables.st_JointPDF, numberOfPixelsCounted );
+    }
+    else if ( computation == PDFsAndPDFDerivatives )
+    {
+      this->ComputePDFsAndPDFDerivativesForSampleRange(
+        sampleContainer, pos_begin, pos_end,
+        threadVariables.st_JointPDF, threadVariables.st_JointPDFDerivatives,
+        threadVariables.st_SparseJointPDFDerivatives, numberOfPixelsCounted );
+    }
+    else
+    {
+      this->ComputePDFsAndIncrementalPDFsForSampleRange(
+        sampleContainer, pos_begin, pos_end,
+        threadVariables.st_JointPDF,
+        threadVariables.st_IncrementalJointPDFRight,
+        threadVariables.st_IncrementalJointPDFLeft,
+        threadVariables.st_PerturbedAlphaRight,
+        threadVariables.st_PerturbedAlphaLeft,
+        numberOfPixelsCounted, sumOfMovingMaskValues,
+        threadVariables.st_SparseIncrementalJointPDFRight,
+        threadVariables.st_SparseIncrementalJointPDFLeft );
+    }
+
+    threadVariables.st_NumberOfPixelsCounted = numberOfPixelsCounted;
+    threadVariables.st_SumOfMovingMaskValues = sumOfMovingMaskValues;
+
+  } // end ThreadedComputePDFs()
+
+
+  /**
+   * ******************* ReducePDFsThreaderCallback *******************
+   */
+
+  template < class TFixedImage, class TMovingImage >
+    ITK_THREAD_RETURN_TYPE
+    ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
+    ::ReducePDFsThreaderCallback( void * arg )
+  {
+    ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>( arg );
+    const unsigned int threadID = infoStruct->ThreadID;
+
+    ParzenWindowHistogramMultiThreaderParameterType * temp
+      = static_cast<ParzenWindowHistogramMultiThreaderParameterType *>( infoStruct->UserData );
+
+    temp->st_Metric->ThreadedReducePDFs( threadID, temp->st_PDFComputation );
+
+    return ITK_THREAD_RETURN_VALUE;
+
+  } // end ReducePDFsThreaderCallback()
+
+
+  /**
+   * ******************* ThreadedReducePDFs *******************
+   */
+
+  template < class TFixedImage, class TMovingImage >
+    void
+    ParzenWindowHistogramImageToImageMetric<TFixedImage,TMovingImage>
+    ::ThreadedReducePDFs( unsigned int threadID,
+    PDFComputationType computation ) const
+  {
+    const unsigned int numberOfThreads = this->m_Threader->GetNumberOfThreads();
+    const ParzenWindowHistogramPerThreadType & perThread
+      = this->m_ParzenWindowHistogramPerThreadVariables;
+
+    /** Each thread sums a chunk of the histogram bins. The per-thread
+     * contributions are always added in the same order, so that the result
+     * does not depend on the thread scheduling.
+     */
+    unsigned long jmin = 0;
+    unsigned long jmax = 0;
+    this->GetThreadSampleRange( threadID,
+      this->m_JointPDF->GetPixelContainer()->Size(), jmin, jmax );
+    PDFValueType * jointPDF = this->m_JointPDF->GetBufferPointer();
+    for ( unsigned int i = 1; i < numberOfThreads; ++i )
+    {
+      const PDFValueType * threadJointPDF = perThread[ i ].st_JointPDF->GetBufferPointer();
+      for ( unsigned long j = jmin; j < jmax; ++j )
+      {
+        jointPDF[ j ] += threadJointPDF[ j ];
+      }
+    }
+
+    if ( computation == PDFsAndPDFDerivatives && this->m_UseSparseJointPDFDerivatives )
+    {
+      /** The blocks were already allocated, so each thread handles a
+       * chunk of the bins.
+       */
+      this->GetThreadSampleRange( threadID,
+        this->m_SparseJointPDFDerivatives->GetNumberOfBins(), jmin, jmax );
+      for ( unsigned int i = 1; i < numberOfThreads; ++i )
+      {
+        this->m_SparseJointPDFDerivatives->AddBins(
+          perThread[ i ].st_SparseJointPDFDerivatives, jmin, jmax );
+      }
+    }
+    else if ( computation == PDFsAndPDFDerivatives )
+    {
+      /** Add the sparse blocks of the other threads to the dense member,
+       * for a chunk of the bins. */
+      const unsigned long numberOfBins = this->m_NumberOfMovingHistogramBins
+        * this->m_NumberOfFixedHistogramBins;
+      this->GetThreadSampleRange( threadID, numberOfBins, jmin, jmax );
+      PDFValueType * jointPDFDerivatives = this->m_JointPDFDerivatives->GetBufferPointer();
+      for ( unsigned int i = 1; i < numberOfThreads; ++i )
+      {
+        perThread[ i ].st_SparseJointPDFDerivatives->AddBinsToDense(
+          jointPDFDerivatives, jmin, jmax );
+      }
+    }
+    else if ( computation == PDFsAndIncrementalPDFs )
+    {
+      const unsigned long numberOfBins = this->m_NumberOfMovingHistogramBins
+        * this->m_NumberOfFixedHistogramBins;
+      this->GetThreadSampleRange( threadID, numberOfBins, jmin, jmax );
+      PDFValueType * incRight = this->m_IncrementalJointPDFRight->GetBufferPointer();
+      PDFValueType * incLeft = this->m_IncrementalJointPDFLeft->GetBufferPointer();
+      for ( unsigned int i = 1; i < numberOfThreads; ++i )
+      {
+        perThread[ i ].st_SparseIncrementalJointPDFRight->AddBinsToDense(
+          incRight, jmin, jmax );
+        perThread[ i ].st_SparseIncrementalJointPDFLeft->AddBinsToDense(
+          incLeft, jmin, jmax );
+      }
+
+      /** The perturbed alphas of all threads, including thread 0. */
+      this->GetThreadSampleRange( threadID,
+        this->GetNumberOfParameters(), jmin, jmax );
+      for ( unsigned int i = 0; i < numberOfThreads; ++i )
+      {
+        for ( unsigned long j = jmin; j < jmax; ++j )
+        {
+          this->m_PerturbedAlphaRight[ j ] += perThread[ i ].st_PerturbedAlphaRight[ j ];
+          this->m_PerturbedAlphaLeft[ j ] += perThread[ i ].st_PerturbedAlphaLeft[ j ];
+        }
+      }
+    }
+
+  } // end ThreadedReducePDFs()
 
 
 } // end namespace itk
 
 
 #endif // end #ifndef _itkParzenWindowHistogramImageToImageMetric_HXX__
-
@@ -122,9 +122,16 @@ public:
   /** Get a pointer to the Transform.  */
   itkGetConstObjectMacro( Transform, TransformType );
 
-  /** Set the parameters defining the Transform. */
+  /** Set the parameters defining the Transform, unless
+   * TransformParametersAreSetExternally. */
   void SetTransformParameters( const ParametersType & parameters ) const;
 
+  /** Set/Get whether the caller takes care of the transform parameters.
+   * See AdvancedImageToImageMetric::SetTransformParametersAreSetExternally().
+   * Default false. */
+  itkSetMacro( TransformParametersAreSetExternally, bool );
+  itkGetConstMacro( TransformParametersAreSetExternally, bool );
+
   /** Return the number of parameters required by the transform. */
   unsigned int GetNumberOfParameters( void ) const
   { return this->m_Transform->GetNumberOfParameters(); }
@@ -162,6 +169,7 @@ protected:
   mutable TransformPointer    m_Transform;
 
   mutable unsigned int        m_NumberOfPointsCounted;
+  bool                        m_TransformParametersAreSetExternally;
 
 private:
   SingleValuedPointSetToPointSetMetric(const Self&); //purposely not implemented
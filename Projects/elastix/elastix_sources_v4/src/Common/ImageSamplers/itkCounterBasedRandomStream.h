@@ -0,0 +1,130 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkCounterBasedRandomStream_h
+#define __itkCounterBasedRandomStream_h
+
+#include "itkMacro.h"
+
+namespace itk
+{
+
+  /** \class CounterBasedRandomStream
+   *
+   * \brief A light-weight counter-based random number generator.
+   *
+   * The n-th number of a stream is a hash of the seed, the two keys that
+   * identify the stream, and n. So a stream has no state besides its
+   * counter, and any stream can be started without generating the numbers
+   * of the other streams first. This makes it suitable for multi-threaded
+   * code: when the keys are derived from the work item (e.g. the sample
+   * number) instead of the thread, the results do not depend on the number
+   * of threads.
+   *
+   * The hash is the 32 bit integer hash by C. Wellons ("lowbias32"),
+   * applied in a few rounds. It is meant for sampling, not for cryptography.
+   *
+   * \ingroup ImageSamplers
+   */
+
+  class CounterBasedRandomStream
+  {
+  public:
+
+    /** Typedef's. */
+    typedef unsigned int    IntegerType;
+    typedef unsigned long   KeyType;
+
+    /** Constructor. */
+    CounterBasedRandomStream()
+    {
+      this->Initialize( 0, 0, 0 );
+    }
+
+    /** Start the stream that is identified by the seed and two keys. */
+    void Initialize( IntegerType seed, KeyType key1, KeyType key2 )
+    {
+      IntegerType key = Hash( seed ^ 0x9e3779b9U );
+      key = Hash( key ^ Low( key1 ) ) + High( key1 );
+      key = Hash( key ^ Low( key2 ) ) + High( key2 );
+      this->m_Key = Hash( key );
+      this->m_Counter = 0;
+    }
+
+    /** Get the next 32 bit random integer. */
+    IntegerType GetNextInteger( void )
+    {
+      const IntegerType x = Hash( this->m_Counter ^ this->m_Key );
+      this->m_Counter = ( this->m_Counter + 1 ) & 0xffffffffU;
+      return Hash( x + this->m_Key );
+    }
+
+    /** Get a random number in [0,1), with 53 random bits. */
+    double GetVariateWithOpenUpperRange( void )
+    {
+      const double a = static_cast<double>( this->GetNextInteger() >> 5 );
+      const double b = static_cast<double>( this->GetNextInteger() >> 6 );
+      return ( a * 67108864.0 + b ) * ( 1.0 / 9007199254740992.0 );
+    }
+
+    /** Get a random number in [a,b). */
+    double GetUniformVariate( double a, double b )
+    {
+      return a + ( b - a ) * this->GetVariateWithOpenUpperRange();
+    }
+
+    /** Get a random integer in [0,n]. */
+    unsigned long GetIntegerVariate( unsigned long n )
+    {
+      const unsigned long r = static_cast<unsigned long>(
+        this->GetVariateWithOpenUpperRange() * ( static_cast<double>( n ) + 1.0 ) );
+      return r > n ? n : r;
+    }
+
+  protected:
+
+    /** The integer hash. */
+    static IntegerType Hash( IntegerType x )
+    {
+      x &= 0xffffffffU;
+      x ^= x >> 16;
+      x = ( x * 0x7feb352dU ) & 0xffffffffU;
+      x ^= x >> 15;
+      x = ( x * 0x846ca68bU ) & 0xffffffffU;
+      x ^= x >> 16;
+      return x;
+    }
+
+    /** The lower and upper 32 bits of a key. Shifting twice is well
+     * defined also when KeyType has only 32 bits. */
+    static IntegerType Low( KeyType k )
+    {
+      return static_cast<IntegerType>( k & 0xffffffffUL );
+    }
+    static IntegerType High( KeyType k )
+    {
+      return static_cast<IntegerType>( ( ( k >> 16 ) >> 16 ) & 0xffffffffUL );
+    }
+
+  private:
+
+    IntegerType   m_Key;
+    IntegerType   m_Counter;
+
+  }; // end class CounterBasedRandomStream
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkCounterBasedRandomStream_h
@@ -69,6 +69,8 @@ namespace itk
     /** Other typdefs. */
     typedef typename InputImageType::IndexType    InputImageIndexType;
     typedef typename InputImageType::PointType    InputImagePointType;
+    typedef typename InputImageType::SizeType     InputImageSizeType;
+    typedef typename Superclass::ImageSampleValueType ImageSampleValueType;
 
     /** Selecting new samples makes no sense if nothing changed.
      * The same samples would be selected anyway.
@@ -97,6 +99,10 @@ namespace itk
     /** Function that does the work. */
     virtual void GenerateData( void );
 
+    /** Sample a contiguous part of the voxels of the region, as they would
+     * be visited by a region iterator. */
+    virtual void ThreadedGenerateData( unsigned int threadID );
+
   private:
 
     /** The private constructor. */
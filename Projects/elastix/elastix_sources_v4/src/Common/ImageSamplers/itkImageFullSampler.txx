@@ -67,6 +67,13 @@ namespace itk
         itkExceptionMacro( << "ERROR: failed to allocate memory for the sample container." );
       }
 
+      /** The threads put their samples directly in the container. */
+      if ( this->m_UseMultiThread )
+      {
+        this->LaunchThreadedGenerateData();
+        return;
+      }
+
       /** Simply loop over the image and store all samples in the container. */
       unsigned long ind = 0;
       for( iter.GoToBegin(); !iter.IsAtEnd(); ++iter, ++ind )
@@ -94,6 +101,15 @@ namespace itk
       {
         mask->GetSource()->Update();
       }
+
+      /** The threads collect their samples, which are merged afterwards. */
+      if ( this->m_UseMultiThread )
+      {
+        this->LaunchThreadedGenerateData();
+        this->MergeThreaderSampleContainers();
+        return;
+      }
+
       /** Loop over the image and check if the points falls within the mask. */
       for( iter.GoToBegin(); ! iter.IsAtEnd(); ++iter )
       {
@@ -116,11 +132,92 @@ namespace itk
 
         } // end if
       } // end for
+
+      /** Release the memory that push_back() allocated in advance. */
+      sampleContainer->Squeeze();
+
     } // end else (if mask exists)
 
   } // end GenerateData
 
 
+  /**
+   * ******************* ThreadedGenerateData *******************
+   */
+
+  template< class TInputImage >
+    void
+    ImageFullSampler< TInputImage >
+    ::ThreadedGenerateData( unsigned int threadID )
+  {
+    /** Get handles to the input image, the output, and the mask. */
+    const InputImageType * inputImage = this->GetInput();
+    ImageSampleContainerType * sampleContainer = this->GetOutput();
+    ImageSampleContainerType * threadContainer
+      = this->m_ThreaderSampleContainer[ threadID ];
+    const MaskType * mask = this->GetMask();
+
+    /** Get the voxels of this thread. */
+    const InputImageRegionType & region = this->GetCroppedInputImageRegion();
+    unsigned long begin = 0;
+    unsigned long end = 0;
+    this->GetThreadRange( threadID, region.GetNumberOfPixels(), begin, end );
+    if ( begin == end ) return;
+
+    /** With a mask, at most all voxels of this thread are stored. The
+     * region is already cropped to the bounding box of the mask. */
+    if ( mask != 0 )
+    {
+      threadContainer->ReserveCapacity( end - begin );
+    }
+
+    /** Compute the index of the first voxel. */
+    typedef typename InputImageIndexType::IndexValueType IndexValueType;
+    const InputImageIndexType & regionIndex = region.GetIndex();
+    const InputImageSizeType & regionSize = region.GetSize();
+    InputImageIndexType index;
+    unsigned long offset = begin;
+    for ( unsigned int d = 0; d < InputImageDimension; ++d )
+    {
+      index[ d ] = regionIndex[ d ]
+        + static_cast<IndexValueType>( offset % regionSize[ d ] );
+      offset /= regionSize[ d ];
+    }
+
+    /** Loop over the voxels. Without a mask, the samples are stored at
+     * their final position in the output. */
+    InputImagePointType point;
+    for ( unsigned long ind = begin; ind < end; ++ind )
+    {
+      inputImage->TransformIndexToPhysicalPoint( index, point );
+      if ( mask == 0 )
+      {
+        sampleContainer->SetImageCoordinates( ind, point );
+        sampleContainer->SetImageValue( ind,
+          static_cast<ImageSampleValueType>( inputImage->GetPixel( index ) ) );
+      }
+      else if ( mask->IsInside( point ) )
+      {
+        threadContainer->PushBack( point,
+          static_cast<ImageSampleValueType>( inputImage->GetPixel( index ) ) );
+      }
+
+      /** Go to the next index, x running fastest. */
+      for ( unsigned int d = 0; d < InputImageDimension; ++d )
+      {
+        ++index[ d ];
+        if ( index[ d ] < regionIndex[ d ]
+          + static_cast<IndexValueType>( regionSize[ d ] ) )
+        {
+          break;
+        }
+        index[ d ] = regionIndex[ d ];
+      }
+    } // end for
+
+  } // end ThreadedGenerateData()
+
+
   /**
    * ******************* PrintSelf *******************
    */
@@ -83,6 +83,7 @@ namespace itk
     typedef typename InputImageType::SizeType               SampleGridSizeType;
     typedef InputImageIndexType                             SampleGridIndexType;
     typedef typename InputImageType::SizeType               InputImageSizeType;
+    typedef typename Superclass::ImageSampleValueType       ImageSampleValueType;
 
     /** Set/Get the sample grid spacing for each dimension (only integer factors)
      * This function overrules previous calls to SetNumberOfSamples.
@@ -148,12 +149,20 @@ namespace itk
     /** Function that does the work. */
     virtual void GenerateData( void );
 
+    /** Sample a contiguous part of the grid points, in the same order as
+     * GenerateData(). */
+    virtual void ThreadedGenerateData( unsigned int threadID );
+
     /** An array of integer spacing factors */
     SampleGridSpacingType m_SampleGridSpacing;
 
     /** The number of samples entered in the SetNumberOfSamples method */
     unsigned long m_RequestedNumberOfSamples;
 
+    /** The first index and the size of the grid, computed in GenerateData(). */
+    SampleGridIndexType   m_SampleGridIndex;
+    SampleGridSizeType    m_SampleGridSize;
+
   private:
 
     /** The private constructor. */
@@ -84,6 +84,29 @@ namespace itk
     }
     index = sampleGridIndex;
 
+    /** Let the threads sample the grid. Without a mask the threads put
+     * their samples directly in the container. */
+    if ( this->m_UseMultiThread )
+    {
+      this->m_SampleGridIndex = sampleGridIndex;
+      this->m_SampleGridSize = sampleGridSize;
+      if ( mask.IsNull() )
+      {
+        sampleContainer->Reserve( numberOfSamplesOnGrid );
+        this->LaunchThreadedGenerateData();
+      }
+      else
+      {
+        if ( mask->GetSource() )
+        {
+          mask->GetSource()->Update();
+        }
+        this->LaunchThreadedGenerateData();
+        this->MergeThreaderSampleContainers();
+      }
+      return;
+    }
+
     if ( mask.IsNull() )
     {
       /** Ugly loop over the grid. */
@@ -179,11 +202,92 @@ namespace itk
           index[ 3 ] += this->m_SampleGridSpacing[ 3 ];
         }
       } // end t
+
+      /** Release the memory that push_back() allocated in advance. */
+      sampleContainer->Squeeze();
+
     } // else (if mask exists)
 
   } // end GenerateData
 
 
+  /**
+   * ******************* ThreadedGenerateData *******************
+   */
+
+  template< class TInputImage >
+    void
+    ImageGridSampler< TInputImage >
+    ::ThreadedGenerateData( unsigned int threadID )
+  {
+    /** Get handles to the input image, the output, and the mask. */
+    const InputImageType * inputImage = this->GetInput();
+    ImageSampleContainerType * sampleContainer = this->GetOutput();
+    ImageSampleContainerType * threadContainer
+      = this->m_ThreaderSampleContainer[ threadID ];
+    const MaskType * mask = this->GetMask();
+
+    /** Get the grid points of this thread. */
+    unsigned long numberOfSamplesOnGrid = 1;
+    for ( unsigned int d = 0; d < InputImageDimension; ++d )
+    {
+      numberOfSamplesOnGrid *= this->m_SampleGridSize[ d ];
+    }
+    unsigned long begin = 0;
+    unsigned long end = 0;
+    this->GetThreadRange( threadID, numberOfSamplesOnGrid, begin, end );
+    if ( begin == end ) return;
+
+    /** With a mask, at most all grid points of this thread are stored. */
+    if ( mask != 0 )
+    {
+      threadContainer->ReserveCapacity( end - begin );
+    }
+
+    /** Compute the position on the grid of the first point. */
+    SampleGridSizeType gridPosition;
+    unsigned long offset = begin;
+    for ( unsigned int d = 0; d < InputImageDimension; ++d )
+    {
+      gridPosition[ d ] = offset % this->m_SampleGridSize[ d ];
+      offset /= this->m_SampleGridSize[ d ];
+    }
+
+    /** Loop over the grid points. */
+    SampleGridIndexType index;
+    InputImagePointType point;
+    for ( unsigned long ind = begin; ind < end; ++ind )
+    {
+      for ( unsigned int d = 0; d < InputImageDimension; ++d )
+      {
+        index[ d ] = this->m_SampleGridIndex[ d ]
+          + gridPosition[ d ] * this->m_SampleGridSpacing[ d ];
+      }
+      inputImage->TransformIndexToPhysicalPoint( index, point );
+
+      if ( mask == 0 )
+      {
+        sampleContainer->SetImageCoordinates( ind, point );
+        sampleContainer->SetImageValue( ind,
+          static_cast<ImageSampleValueType>( inputImage->GetPixel( index ) ) );
+      }
+      else if ( mask->IsInside( point ) )
+      {
+        threadContainer->PushBack( point,
+          static_cast<ImageSampleValueType>( inputImage->GetPixel( index ) ) );
+      }
+
+      /** Go to the next grid point, x running fastest. */
+      for ( unsigned int d = 0; d < InputImageDimension; ++d )
+      {
+        if ( ++gridPosition[ d ] < this->m_SampleGridSize[ d ] ) break;
+        gridPosition[ d ] = 0;
+      }
+    } // end for
+
+  } // end ThreadedGenerateData()
+
+
   /**
    * ******************* SetNumberOfSamples *******************
    */
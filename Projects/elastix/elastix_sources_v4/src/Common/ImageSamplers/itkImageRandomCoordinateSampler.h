@@ -19,6 +19,7 @@
 #include "itkInterpolateImageFunction.h"
 #include "itkBSplineInterpolateImageFunction.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
+#include <vector>
 
 namespace itk
 {
@@ -29,6 +30,12 @@ namespace itk
    *
    * This image sampler generates not only samples that correspond with
    * pixel locations, but selects points in physical space.
+   *
+   * When new samples are selected every iteration, the sample container and
+   * the buffer of random coordinates keep their memory, and the interpolator
+   * is only given the input image again when the image or the interpolator
+   * has changed. For the default B-spline interpolator this avoids
+   * recomputing the B-spline coefficients of the whole image every iteration.
 	 *
 	 * \ingroup ImageSamplers
    */
@@ -69,6 +76,7 @@ namespace itk
     typedef typename Superclass::InputImagePointType          InputImagePointType;
     typedef typename Superclass::InputImagePointValueType     InputImagePointValueType;
     typedef typename Superclass::ImageSampleValueType         ImageSampleValueType;
+    typedef typename Superclass::RandomStreamType             RandomStreamType;
 
     /** The input image dimension. */
     itkStaticConstMacro( InputImageDimension, unsigned int,
@@ -102,6 +110,7 @@ namespace itk
   protected:
 
     typedef typename InterpolatorType::ContinuousIndexType   InputImageContinuousIndexType;
+    typedef std::vector< InputImageContinuousIndexType >     InputImageContinuousIndexContainerType;
 
     /** The constructor. */
     ImageRandomCoordinateSampler();
@@ -114,6 +123,11 @@ namespace itk
     /** Function that does the work. */
     virtual void GenerateData( void );
 
+    /** Generate the samples of one thread. The coordinates are drawn
+     * uniformly from the random stream of each sample, not by
+     * GenerateRandomCoordinate(). */
+    virtual void ThreadedGenerateData( unsigned int threadID );
+
     /** Generate a point randomly in a bounding box.
      * This method can be overwritten in subclasses if a different distribution is desired. */
     virtual void GenerateRandomCoordinate(
@@ -121,10 +135,29 @@ namespace itk
       const InputImageContinuousIndexType & largestContIndex,
       InputImageContinuousIndexType &       randomContIndex);
 
+    /** Generate numberOfCoordinates points randomly in a bounding box. The
+     * random numbers are drawn in the same order as by numberOfCoordinates
+     * calls to GenerateRandomCoordinate(), so both give the same points.
+     * Subclasses that overwrite GenerateRandomCoordinate() to get a different
+     * distribution should overwrite this method as well. */
+    virtual void GenerateRandomCoordinates(
+      const InputImageContinuousIndexType & smallestContIndex,
+      const InputImageContinuousIndexType & largestContIndex,
+      unsigned long                         numberOfCoordinates,
+      InputImageContinuousIndexContainerType & randomContIndices );
+
+    /** Set the input image of the interpolator, unless the interpolator
+     * already has the current input image and both did not change since. */
+    virtual void UpdateInterpolator( void );
+
     typename InterpolatorType::Pointer    m_Interpolator;
     typename RandomGeneratorType::Pointer m_RandomGenerator;
     InputImageSpacingType                 m_SampleRegionSize;
 
+    /** The sample region of the current GenerateData() call, used by the threads. */
+    InputImageContinuousIndexType         m_SmallestContIndex;
+    InputImageContinuousIndexType         m_LargestContIndex;
+
     /** Generate the two corners of a sampling region, given the two corners
      * of an image. If UseRandomSampleRegion=false, the smallesPoint and largestPoint
      * are just copies of the smallestImagePoint and largestImagePoint
@@ -145,6 +178,12 @@ namespace itk
 
     bool          m_UseRandomSampleRegion;
 
+    /** The time the interpolator was last given the input image. */
+    TimeStamp     m_InterpolatorUpdateTime;
+
+    /** Buffer for the random coordinates, kept to reuse its memory. */
+    InputImageContinuousIndexContainerType m_RandomContIndexBuffer;
+
   }; // end class ImageRandomCoordinateSampler
 
 
@@ -62,7 +62,7 @@ namespace itk
     typename InterpolatorType::Pointer interpolator = this->GetInterpolator();
 
     /** Set up the interpolator. */
-    interpolator->SetInputImage( inputImage );
+    this->UpdateInterpolator();
 
     /** Convert inputImageRegion to bounding box in physical space. */
     InputImageSizeType unitSize;
@@ -81,36 +81,68 @@ namespace itk
     /** Reserve memory for the output. */
     sampleContainer->Reserve( this->GetNumberOfSamples() );
 
-    /** Setup an iterator over the output, which is of ImageSampleContainerType. */
-    typename ImageSampleContainerType::Iterator iter;
-    typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
+    /** Let the threads generate the samples, in place. */
+    if ( this->m_UseMultiThread )
+    {
+      if ( !mask.IsNull() && mask->GetSource() )
+      {
+        mask->GetSource()->Update();
+      }
+      this->m_SmallestContIndex = smallestContIndex;
+      this->m_LargestContIndex = largestContIndex;
+      this->InitializeRandomStreams();
+      this->m_ThreaderMaximumNumberOfTries
+        = mask.IsNull() ? 0 : 10 * this->GetNumberOfSamples();
+      this->LaunchThreadedGenerateData();
+      if ( this->ThreaderFailed() )
+      {
+        sampleContainer->Reserve( 0 );
+        itkExceptionMacro( << "Could not find enough image samples within "
+          << "reasonable time. Probably the mask is too small" );
+      }
+      return;
+    }
 
-    InputImageContinuousIndexType sampleContIndex;
-    /** Fill the sample container. */
+    /** The samples are stored by position in the output container. */
+    const unsigned long numberOfSamples = sampleContainer->Size();
+
+    InputImagePointType samplePoint;
+    ImageSampleValueType sampleValue;
+    InputImageContinuousIndexContainerType & candidates = this->m_RandomContIndexBuffer;
+
+    /** Fill the sample container. The random coordinates are generated in
+     * batches of as many candidates as there are samples left to find.
+     * The candidates are checked in the order in which they were drawn,
+     * so the result is the same as when drawing them one by one. */
     if ( mask.IsNull() )
     {
-      /** Start looping over the sample container. */
-      for ( iter = sampleContainer->Begin(); iter != end; ++iter )
+      unsigned long pos = 0;
+      while ( pos < numberOfSamples )
       {
-        /** Make a reference to the current sample in the container. */
-        InputImagePointType & samplePoint = (*iter).Value().m_ImageCoordinates;
-        ImageSampleValueType & sampleValue = (*iter).Value().m_ImageValue;
+        /** Generate a batch of points in the input image region. */
+        const unsigned long numberOfCandidates = numberOfSamples - pos;
+        this->GenerateRandomCoordinates( smallestContIndex, largestContIndex,
+          numberOfCandidates, candidates );
 
-        /** Walk over the image until we find a valid point. */
-        do
+        for ( unsigned long c = 0; c < numberOfCandidates; ++c )
         {
-          /** Generate a point in the input image region. */
-          this->GenerateRandomCoordinate( smallestContIndex, largestContIndex, sampleContIndex );
-        } while ( !interpolator->IsInsideBuffer( sampleContIndex ) );
+          const InputImageContinuousIndexType & sampleContIndex = candidates[ c ];
+          if ( !interpolator->IsInsideBuffer( sampleContIndex ) ) continue;
 
-        /** Convert to point */
-        inputImage->TransformContinuousIndexToPhysicalPoint( sampleContIndex, samplePoint );
+          /** Convert to point */
+          inputImage->TransformContinuousIndexToPhysicalPoint( sampleContIndex, samplePoint );
+
+          /** Compute the value at the contindex. */
+          sampleValue = static_cast<ImageSampleValueType>(
+            this->m_Interpolator->EvaluateAtContinuousIndex( sampleContIndex ) );
 
-        /** Compute the value at the contindex. */
-        sampleValue = static_cast<ImageSampleValueType>(
-          this->m_Interpolator->EvaluateAtContinuousIndex( sampleContIndex ) );
+          /** Store the sample in the container. */
+          sampleContainer->SetImageCoordinates( pos, samplePoint );
+          sampleContainer->SetImageValue( pos, sampleValue );
+          ++pos;
 
-      } // end for loop
+        } // end for loop over the candidates
+      } // end while
     } // end if no mask
     else
     {
@@ -124,46 +156,120 @@ namespace itk
       unsigned long numberOfSamplesTried = 0;
       unsigned long maximumNumberOfSamplesToTry = 10 * this->GetNumberOfSamples();
 
-      /** Start looping over the sample container */
-      for ( iter = sampleContainer->Begin(); iter != end; ++iter )
+      unsigned long pos = 0;
+      while ( pos < numberOfSamples )
       {
-        /** Make a reference to the current sample in the container. */
-        InputImagePointType & samplePoint = (*iter).Value().m_ImageCoordinates;
-        ImageSampleValueType & sampleValue = (*iter).Value().m_ImageValue;
-
-        /** Walk over the image until we find a valid point */
-        do
+        /** Check if we are not trying eternally to find a valid point. */
+        if ( numberOfSamplesTried >= maximumNumberOfSamplesToTry )
+        {
+          /** Squeeze the sample container to the size that is still valid. */
+          sampleContainer->Reserve( pos );
+          itkExceptionMacro( << "Could not find enough image samples within "
+            << "reasonable time. Probably the mask is too small" );
+        }
+
+        /** Generate a batch of points in the input image region. */
+        const unsigned long numberOfCandidates = vnl_math_min(
+          numberOfSamples - pos, maximumNumberOfSamplesToTry - numberOfSamplesTried );
+        this->GenerateRandomCoordinates( smallestContIndex, largestContIndex,
+          numberOfCandidates, candidates );
+        numberOfSamplesTried += numberOfCandidates;
+
+        for ( unsigned long c = 0; c < numberOfCandidates; ++c )
         {
-          /** Check if we are not trying eternally to find a valid point. */
-          ++numberOfSamplesTried;
-          if ( numberOfSamplesTried > maximumNumberOfSamplesToTry )
-          {
-            /** Squeeze the sample container to the size that is still valid. */
-            typename ImageSampleContainerType::iterator stlnow = sampleContainer->begin();
-            typename ImageSampleContainerType::iterator stlend = sampleContainer->end();
-            stlnow += iter.Index();
-            sampleContainer->erase( stlnow, stlend);
-            itkExceptionMacro( << "Could not find enough image samples within "
-              << "reasonable time. Probably the mask is too small" );
-          }
-
-          /** Generate a point in the input image region. */
-          this->GenerateRandomCoordinate( smallestContIndex, largestContIndex, sampleContIndex );
+          const InputImageContinuousIndexType & sampleContIndex = candidates[ c ];
+          if ( !interpolator->IsInsideBuffer( sampleContIndex ) ) continue;
+
           inputImage->TransformContinuousIndexToPhysicalPoint( sampleContIndex, samplePoint );
+          if ( !mask->IsInside( samplePoint ) ) continue;
 
-        } while ( !interpolator->IsInsideBuffer( sampleContIndex ) ||
-                  !mask->IsInside( samplePoint ) );
+          /** Compute the value at the point. */
+          sampleValue = static_cast<ImageSampleValueType>(
+            this->m_Interpolator->EvaluateAtContinuousIndex( sampleContIndex ) );
 
-        /** Compute the value at the point. */
-        sampleValue = static_cast<ImageSampleValueType>(
-          this->m_Interpolator->EvaluateAtContinuousIndex( sampleContIndex ) );
+          /** Store the sample in the container. */
+          sampleContainer->SetImageCoordinates( pos, samplePoint );
+          sampleContainer->SetImageValue( pos, sampleValue );
+          ++pos;
 
-      } // end for loop
+        } // end for loop over the candidates
+      } // end while
     } // end if mask
 
   } // end GenerateData()
 
 
+  /**
+   * ******************* ThreadedGenerateData *******************
+   */
+
+  template< class TInputImage >
+    void
+    ImageRandomCoordinateSampler< TInputImage >
+    ::ThreadedGenerateData( unsigned int threadID )
+  {
+    /** Get handles to the input image, output sample container, and mask. */
+    const InputImageType * inputImage = this->GetInput();
+    ImageSampleContainerType * sampleContainer = this->GetOutput();
+    const MaskType * mask = this->GetMask();
+    const InterpolatorType * interpolator = this->m_Interpolator.GetPointer();
+
+    /** Get the samples of this thread. */
+    unsigned long begin = 0;
+    unsigned long end = 0;
+    this->GetThreadRange( threadID, sampleContainer->Size(), begin, end );
+
+    /** Make sure we are not eternally trying to find samples. The budget
+     * is shared by all threads; see ThreaderFailed(). */
+    const unsigned long maximumNumberOfSamplesToTry
+      = this->m_ThreaderMaximumNumberOfTries;
+    unsigned long numberOfSamplesTried = 0;
+
+    RandomStreamType stream;
+    InputImageContinuousIndexType sampleContIndex;
+    InputImagePointType samplePoint;
+    for ( unsigned long pos = begin; pos < end; ++pos )
+    {
+      this->InitializeRandomStream( stream, pos );
+      bool found = false;
+      while ( !found )
+      {
+        /** Without a mask only the points outside the buffer are rejected,
+         * which does not happen for the default sample region. */
+        if ( mask != 0 && numberOfSamplesTried == maximumNumberOfSamplesToTry )
+        {
+          this->m_ThreaderFailure[ threadID ] = 1;
+          this->m_ThreaderNumberOfTries[ threadID ] = numberOfSamplesTried;
+          return;
+        }
+        ++numberOfSamplesTried;
+
+        for ( unsigned int i = 0; i < InputImageDimension; ++i )
+        {
+          sampleContIndex[ i ] = static_cast<InputImagePointValueType>(
+            stream.GetUniformVariate(
+            this->m_SmallestContIndex[ i ], this->m_LargestContIndex[ i ] ) );
+        }
+        if ( !interpolator->IsInsideBuffer( sampleContIndex ) ) continue;
+
+        inputImage->TransformContinuousIndexToPhysicalPoint( sampleContIndex, samplePoint );
+        found = ( mask == 0 || mask->IsInside( samplePoint ) );
+      }
+
+      /** Compute the value at the point and store the sample. */
+      sampleContainer->SetImageCoordinates( pos, samplePoint );
+      sampleContainer->SetImageValue( pos, static_cast<ImageSampleValueType>(
+        interpolator->EvaluateAtContinuousIndex( sampleContIndex ) ) );
+    } // end for
+
+    if ( mask != 0 )
+    {
+      this->m_ThreaderNumberOfTries[ threadID ] = numberOfSamplesTried;
+    }
+
+  } // end ThreadedGenerateData()
+
+
   /**
    * ******************* GenerateRandomCoordinate *******************
    */
@@ -185,6 +291,66 @@ namespace itk
   } // end GenerateRandomCoordinate()
 
 
+  /**
+   * ******************* GenerateRandomCoordinates *******************
+   */
+
+  template< class TInputImage >
+    void
+    ImageRandomCoordinateSampler< TInputImage >::
+    GenerateRandomCoordinates(
+      const InputImageContinuousIndexType & smallestContIndex,
+      const InputImageContinuousIndexType & largestContIndex,
+      unsigned long                         numberOfCoordinates,
+      InputImageContinuousIndexContainerType & randomContIndices )
+  {
+    /** The buffer only grows, so its memory is reused. */
+    if ( randomContIndices.size() < numberOfCoordinates )
+    {
+      randomContIndices.resize( numberOfCoordinates );
+    }
+
+    RandomGeneratorType * generator = this->m_RandomGenerator.GetPointer();
+    for ( unsigned long n = 0; n < numberOfCoordinates; ++n )
+    {
+      InputImageContinuousIndexType & randomContIndex = randomContIndices[ n ];
+      for ( unsigned int i = 0; i < InputImageDimension; ++i )
+      {
+        randomContIndex[ i ] = static_cast<InputImagePointValueType>(
+          generator->GetUniformVariate( smallestContIndex[ i ], largestContIndex[ i ] ) );
+      }
+    }
+
+  } // end GenerateRandomCoordinates()
+
+
+  /**
+   * ******************* UpdateInterpolator *******************
+   */
+
+  template< class TInputImage >
+    void
+    ImageRandomCoordinateSampler< TInputImage >
+    ::UpdateInterpolator( void )
+  {
+    const InputImageType * inputImage = this->GetInput();
+    InterpolatorType * interpolator = this->m_Interpolator.GetPointer();
+
+    /** SetInputImage() may be expensive, for example the B-spline
+     * interpolator computes the B-spline coefficients of the whole image.
+     * So skip it if nothing changed since the last time. */
+    const unsigned long updateTime = this->m_InterpolatorUpdateTime.GetMTime();
+    if ( interpolator->GetInputImage() != inputImage
+      || inputImage->GetMTime() > updateTime
+      || interpolator->GetMTime() > updateTime )
+    {
+      interpolator->SetInputImage( inputImage );
+      this->m_InterpolatorUpdateTime.Modified();
+    }
+
+  } // end UpdateInterpolator()
+
+
   /**
    * ******************* GenerateSampleRegion *******************
    */
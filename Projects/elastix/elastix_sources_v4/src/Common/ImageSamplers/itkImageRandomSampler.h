@@ -64,6 +64,7 @@ namespace itk
     typedef typename Superclass::ImageSampleType              ImageSampleType;
     typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
     typedef typename Superclass::MaskType                     MaskType;
+    typedef typename Superclass::ImageSampleValueType         ImageSampleValueType;
 
     /** The input image dimension. */
     itkStaticConstMacro( InputImageDimension, unsigned int,
@@ -72,6 +73,8 @@ namespace itk
     /** Other typedefs. */
     typedef typename InputImageType::IndexType    InputImageIndexType;
     typedef typename InputImageType::PointType    InputImagePointType;
+    typedef typename InputImageType::SizeType     InputImageSizeType;
+    typedef typename Superclass::RandomStreamType RandomStreamType;
 
   protected:
 
@@ -83,6 +86,10 @@ namespace itk
     /** Function that does the work. */
     virtual void GenerateData( void );
 
+    /** Generate the samples of one thread. Each sample has its own random
+     * stream, so the result does not depend on the number of threads. */
+    virtual void ThreadedGenerateData( unsigned int threadID );
+
   private:
 
     /** The private constructor. */
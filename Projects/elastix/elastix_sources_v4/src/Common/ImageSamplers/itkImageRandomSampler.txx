@@ -39,14 +39,33 @@ namespace itk
     /** Reserve memory for the output. */
     sampleContainer->Reserve( this->GetNumberOfSamples() );
 
+    /** Let the threads generate the samples, in place. */
+    if ( this->m_UseMultiThread )
+    {
+      if ( !mask.IsNull() && mask->GetSource() )
+      {
+        mask->GetSource()->Update();
+      }
+      this->InitializeRandomStreams();
+      this->m_ThreaderMaximumNumberOfTries = 10 * this->GetNumberOfSamples();
+      this->LaunchThreadedGenerateData();
+      if ( this->ThreaderFailed() )
+      {
+        sampleContainer->Reserve( 0 );
+        itkExceptionMacro( << "Could not find enough image samples within "
+          << "reasonable time. Probably the mask is too small" );
+      }
+      return;
+    }
+
     /** Setup a random iterator over the input image. */
     typedef ImageRandomConstIteratorWithIndex< InputImageType > RandomIteratorType;
     RandomIteratorType randIter( inputImage, this->GetCroppedInputImageRegion() );
     randIter.GoToBegin();
 
-    /** Setup an iterator over the output, which is of ImageSampleContainerType. */
-    typename ImageSampleContainerType::Iterator iter;
-    typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
+    /** The samples are stored by position in the output container. */
+    const unsigned long numberOfSamples = sampleContainer->Size();
+    InputImagePointType inputPoint;
 
     /** Fill the sample container. */
     if ( mask.IsNull() )
@@ -55,14 +74,15 @@ namespace itk
       randIter.SetNumberOfSamples( this->GetNumberOfSamples()+1 );
       /** Advance one, in order to generate the same sequence as when using a mask */
       ++randIter;
-      for ( iter = sampleContainer->Begin(); iter != end; ++iter )
+      for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
       {
         /** Get the index, transform it to the physical coordinates and put it in the sample. */
         InputImageIndexType index = randIter.GetIndex();
-        inputImage->TransformIndexToPhysicalPoint( index,
-          (*iter).Value().m_ImageCoordinates );
+        inputImage->TransformIndexToPhysicalPoint( index, inputPoint );
+        sampleContainer->SetImageCoordinates( pos, inputPoint );
         /** Get the value and put it in the sample. */
-        (*iter).Value().m_ImageValue = randIter.Get();
+        sampleContainer->SetImageValue( pos,
+          static_cast<ImageSampleValueType>( randIter.Get() ) );
         /** Jump to a random position. */
         ++randIter;
 
@@ -74,12 +94,11 @@ namespace itk
       {
         mask->GetSource()->Update();
       }
-      InputImagePointType inputPoint;
       bool insideMask = false;
       /** Make sure we are not eternally trying to find samples: */
       randIter.SetNumberOfSamples( 10 * this->GetNumberOfSamples() );
       /** Loop over the sample container. */
-      for ( iter = sampleContainer->Begin(); iter != end; ++iter )
+      for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
       {
         /** Loop until a valid sample is found. */
         do
@@ -90,10 +109,7 @@ namespace itk
           if ( randIter.IsAtEnd() )
           {
             /** Squeeze the sample container to the size that is still valid. */
-            typename ImageSampleContainerType::iterator stlnow = sampleContainer->begin();
-            typename ImageSampleContainerType::iterator stlend = sampleContainer->end();
-            stlnow += iter.Index();
-            sampleContainer->erase( stlnow, stlend );
+            sampleContainer->Reserve( pos );
             itkExceptionMacro( << "Could not find enough image samples within "
               << "reasonable time. Probably the mask is too small" );
           }
@@ -105,8 +121,9 @@ namespace itk
         } while ( !insideMask );
 
         /** Put the coordinates and the value in the sample. */
-        (*iter).Value().m_ImageCoordinates = inputPoint;
-        (*iter).Value().m_ImageValue = randIter.Get();
+        sampleContainer->SetImageCoordinates( pos, inputPoint );
+        sampleContainer->SetImageValue( pos,
+          static_cast<ImageSampleValueType>( randIter.Get() ) );
 
       } // end for loop
 
@@ -120,6 +137,74 @@ namespace itk
   } // end GenerateData()
 
 
+  /**
+   * ******************* ThreadedGenerateData *******************
+   */
+
+  template< class TInputImage >
+    void
+    ImageRandomSampler< TInputImage >
+    ::ThreadedGenerateData( unsigned int threadID )
+  {
+    /** Get handles to the input image, output sample container, and mask. */
+    const InputImageType * inputImage = this->GetInput();
+    ImageSampleContainerType * sampleContainer = this->GetOutput();
+    const MaskType * mask = this->GetMask();
+
+    /** Get the samples of this thread. */
+    unsigned long begin = 0;
+    unsigned long end = 0;
+    this->GetThreadRange( threadID, sampleContainer->Size(), begin, end );
+
+    /** The region in which the voxels are picked. */
+    const InputImageRegionType & region = this->GetCroppedInputImageRegion();
+    const InputImageIndexType & regionIndex = region.GetIndex();
+    const InputImageSizeType & regionSize = region.GetSize();
+    const unsigned long numberOfPixels = region.GetNumberOfPixels();
+
+    /** Make sure we are not eternally trying to find samples. The budget
+     * is shared by all threads; see ThreaderFailed(). */
+    const unsigned long maximumNumberOfTries = this->m_ThreaderMaximumNumberOfTries;
+    unsigned long numberOfTries = 0;
+
+    RandomStreamType stream;
+    InputImageIndexType index;
+    InputImagePointType inputPoint;
+    for ( unsigned long pos = begin; pos < end; ++pos )
+    {
+      this->InitializeRandomStream( stream, pos );
+      do
+      {
+        if ( numberOfTries == maximumNumberOfTries )
+        {
+          this->m_ThreaderFailure[ threadID ] = 1;
+          this->m_ThreaderNumberOfTries[ threadID ] = numberOfTries;
+          return;
+        }
+        ++numberOfTries;
+
+        /** Pick a random voxel and transform it to the physical coordinates. */
+        unsigned long offset = stream.GetIntegerVariate( numberOfPixels - 1 );
+        for ( unsigned int d = 0; d < InputImageDimension; ++d )
+        {
+          index[ d ] = regionIndex[ d ]
+            + static_cast<long>( offset % regionSize[ d ] );
+          offset /= regionSize[ d ];
+        }
+        inputImage->TransformIndexToPhysicalPoint( index, inputPoint );
+      } while ( mask != 0 && !mask->IsInside( inputPoint ) );
+
+      /** Put the coordinates and the value in the sample. */
+      sampleContainer->SetImageCoordinates( pos, inputPoint );
+      sampleContainer->SetImageValue( pos,
+        static_cast<ImageSampleValueType>( inputImage->GetPixel( index ) ) );
+    } // end for
+
+    this->m_ThreaderNumberOfTries[ threadID ] = numberOfTries;
+
+  } // end ThreadedGenerateData()
+
+
 } // end namespace itk
 
 #endif // end #ifndef __ImageRandomSampler_txx
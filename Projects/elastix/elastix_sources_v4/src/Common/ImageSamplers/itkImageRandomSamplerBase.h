@@ -59,6 +59,7 @@ namespace itk
     typedef typename Superclass::ImageSampleType              ImageSampleType;
     typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
     typedef typename Superclass::MaskType                     MaskType;
+    typedef typename Superclass::ImageSampleValueType         ImageSampleValueType;
 
     /** The input image dimension. */
     itkStaticConstMacro( InputImageDimension, unsigned int,
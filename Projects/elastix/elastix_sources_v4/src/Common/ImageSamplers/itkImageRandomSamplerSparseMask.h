@@ -62,6 +62,7 @@ namespace itk
     typedef typename Superclass::ImageSampleType              ImageSampleType;
     typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
     typedef typename Superclass::MaskType                     MaskType;
+    typedef typename Superclass::RandomStreamType             RandomStreamType;
 
     /** The input image dimension. */
     itkStaticConstMacro( InputImageDimension, unsigned int,
@@ -57,6 +57,8 @@ namespace itk
     this->m_InternalFullSampler->SetInput( inputImage );
     this->m_InternalFullSampler->SetMask( this->GetMask() );
     this->m_InternalFullSampler->SetInputImageRegion( this->GetCroppedInputImageRegion() );
+    this->m_InternalFullSampler->SetUseMultiThread( this->m_UseMultiThread );
+    this->m_InternalFullSampler->SetNumberOfThreads( this->GetNumberOfThreads() );
 
     /** Use try/catch, since the full sampler may crash, due to insufficient
      * memory.
@@ -90,12 +92,29 @@ namespace itk
       = this->m_InternalFullSampler->GetOutput();
     unsigned long numberOfValidSamples = allValidSamples->Size();
 
-    /** Take random samples from the allValidSamples-container. */
+    /** Take random samples from the allValidSamples-container. When
+     * multi-threading, the random streams of the threaded samplers are used,
+     * so that the sample set is reproducible given the RandomSeed. Drawing
+     * an index is cheap, so this loop itself is not threaded. */
+    sampleContainer->Reserve( this->GetNumberOfSamples() );
+    if ( this->m_UseMultiThread )
+    {
+      this->InitializeRandomStreams();
+      RandomStreamType stream;
+      for ( unsigned long i = 0; i < this->GetNumberOfSamples(); ++i )
+      {
+        this->InitializeRandomStream( stream, i );
+        const unsigned long randomIndex
+          = stream.GetIntegerVariate( numberOfValidSamples - 1 );
+        sampleContainer->SetElement( i, allValidSamples->GetElement( randomIndex ) );
+      }
+      return;
+    }
     for ( unsigned int i = 0; i < this->GetNumberOfSamples(); ++i )
     {
       unsigned long randomIndex
         = this->m_RandomGenerator->GetIntegerVariate( numberOfValidSamples - 1 );
-      sampleContainer->push_back( allValidSamples->ElementAt( randomIndex ) );
+      sampleContainer->SetElement( i, allValidSamples->GetElement( randomIndex ) );
     }
 
   } // end GenerateData()
@@ -0,0 +1,283 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkImageSampleContainer_h
+#define __itkImageSampleContainer_h
+
+#include "itkDataObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageSample.h"
+#include <vector>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace itk
+{
+
+  /** \class ImageSampleAlignedAllocator
+   *
+   * \brief An STL allocator that returns memory aligned to 32 bytes,
+   * which is sufficient for SSE and AVX loads.
+   */
+
+  template < class T >
+  class ImageSampleAlignedAllocator
+  {
+  public:
+    typedef T               value_type;
+    typedef T *             pointer;
+    typedef const T *       const_pointer;
+    typedef T &             reference;
+    typedef const T &       const_reference;
+    typedef std::size_t     size_type;
+    typedef std::ptrdiff_t  difference_type;
+
+    template < class U > struct rebind
+    {
+      typedef ImageSampleAlignedAllocator<U> other;
+    };
+
+    /** The alignment in bytes. */
+    itkStaticConstMacro( Alignment, std::size_t, 32 );
+
+    ImageSampleAlignedAllocator() {};
+    ImageSampleAlignedAllocator( const ImageSampleAlignedAllocator & ) {};
+    template < class U >
+    ImageSampleAlignedAllocator( const ImageSampleAlignedAllocator<U> & ) {};
+    ~ImageSampleAlignedAllocator() {};
+
+    pointer address( reference x ) const { return &x; }
+    const_pointer address( const_reference x ) const { return &x; }
+
+    size_type max_size( void ) const
+    {
+      return ( static_cast<size_type>( -1 ) - Alignment ) / sizeof( T );
+    }
+
+    /** Allocate n elements. The original pointer is stored just before
+     * the aligned block.
+     */
+    pointer allocate( size_type n, const void * = 0 )
+    {
+      if ( n > this->max_size() ) throw std::bad_alloc();
+      char * raw = static_cast<char *>(
+        std::malloc( n * sizeof( T ) + Alignment + sizeof( void * ) ) );
+      if ( raw == 0 ) throw std::bad_alloc();
+      std::size_t aligned = reinterpret_cast<std::size_t>( raw + sizeof( void * ) );
+      aligned = ( aligned + Alignment - 1 ) & ~( Alignment - 1 );
+      reinterpret_cast<void **>( aligned )[ -1 ] = raw;
+      return reinterpret_cast<pointer>( aligned );
+    }
+
+    void deallocate( pointer p, size_type )
+    {
+      if ( p != 0 ) std::free( reinterpret_cast<void **>( p )[ -1 ] );
+    }
+
+    void construct( pointer p, const T & value ) { new( p ) T( value ); }
+    void destroy( pointer p ) { p->~T(); }
+
+    bool operator==( const ImageSampleAlignedAllocator & ) const { return true; }
+    bool operator!=( const ImageSampleAlignedAllocator & ) const { return false; }
+
+  }; // end class ImageSampleAlignedAllocator
+
+
+  /** \class ImageSampleContainer
+   *
+   * \brief A container of image samples, stored as a structure of arrays.
+   *
+   * Each coordinate (x, y, z, ...) and the image values are stored in
+   * separate contiguous, 32 byte aligned, arrays. Compared to a vector of
+   * ImageSample objects this allows vectorized loops over the coordinates
+   * of the samples.
+   *
+   * The samples are accessed by their position, for example:
+   * \code
+   *   for ( unsigned long pos = 0; pos < container->Size(); ++pos )
+   *   {
+   *     container->GetImageCoordinates( pos, point );
+   *     value = container->GetImageValue( pos );
+   *   }
+   * \endcode
+   * The raw arrays are available through GetImageCoordinatesArray() and
+   * GetImageValuesArray().
+   *
+   * The interface of the VectorDataContainer that was previously used is
+   * partly provided, i.e. SetElement(), GetElement(), push_back(),
+   * Reserve(), Squeeze() and Size(), so that samplers can fill the container
+   * with ImageSample objects.
+   *
+   * \ingroup ImageSamplers
+   */
+
+  template < class TImage >
+  class ITK_EXPORT ImageSampleContainer : public DataObject
+  {
+  public:
+
+    /** Standard class typedefs. */
+    typedef ImageSampleContainer        Self;
+    typedef DataObject                  Superclass;
+    typedef SmartPointer<Self>          Pointer;
+    typedef SmartPointer<const Self>    ConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro( Self );
+
+    /** Run-time type information (and related methods). */
+    itkTypeMacro( ImageSampleContainer, DataObject );
+
+    /** Typedef's. */
+    typedef TImage                                        ImageType;
+    typedef ImageSample< ImageType >                      ImageSampleType;
+    typedef ImageSampleType                               Element;
+    typedef unsigned long                                 ElementIdentifier;
+    typedef typename ImageSampleType::PointType           PointType;
+    typedef typename ImageSampleType::RealType            RealType;
+    typedef typename PointType::ValueType                 CoordinateValueType;
+
+    /** The image dimension. */
+    itkStaticConstMacro( ImageDimension, unsigned int, ImageType::ImageDimension );
+
+    /** Typedefs for the arrays. */
+    typedef std::vector< CoordinateValueType,
+      ImageSampleAlignedAllocator<CoordinateValueType> >  CoordinateArrayType;
+    typedef std::vector< RealType,
+      ImageSampleAlignedAllocator<RealType> >             ValueArrayType;
+
+    /** Get the number of samples. */
+    ElementIdentifier Size( void ) const
+    {
+      return static_cast<ElementIdentifier>( this->m_ImageValues.size() );
+    }
+
+    /** Set the number of samples. Existing samples are kept. */
+    void Reserve( ElementIdentifier size );
+
+    /** Release the memory that is not used by the current samples. */
+    void Squeeze( void );
+
+    /** Make room for at least capacity samples, without changing the
+     * number of samples, so that the following calls to PushBack() do not
+     * reallocate the arrays.
+     */
+    void ReserveCapacity( ElementIdentifier capacity );
+
+    /** Remove all samples. The memory is kept for the next use. */
+    virtual void Initialize( void );
+
+    /** Replace the samples by those of another container. */
+    void CopySamples( const Self * other );
+
+    /** Get/Set the coordinates of sample pos. */
+    void GetImageCoordinates( ElementIdentifier pos, PointType & point ) const
+    {
+      for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        point[ d ] = this->m_ImageCoordinates[ d ][ pos ];
+      }
+    }
+    PointType GetImageCoordinates( ElementIdentifier pos ) const
+    {
+      PointType point;
+      this->GetImageCoordinates( pos, point );
+      return point;
+    }
+    void SetImageCoordinates( ElementIdentifier pos, const PointType & point )
+    {
+      for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        this->m_ImageCoordinates[ d ][ pos ] = point[ d ];
+      }
+    }
+
+    /** Get/Set the image value of sample pos. */
+    const RealType & GetImageValue( ElementIdentifier pos ) const
+    {
+      return this->m_ImageValues[ pos ];
+    }
+    void SetImageValue( ElementIdentifier pos, const RealType & value )
+    {
+      this->m_ImageValues[ pos ] = value;
+    }
+
+    /** Get/Set a complete sample. SetElement() does not check the size. */
+    ImageSampleType GetElement( ElementIdentifier pos ) const
+    {
+      ImageSampleType sample;
+      this->GetImageCoordinates( pos, sample.m_ImageCoordinates );
+      sample.m_ImageValue = this->m_ImageValues[ pos ];
+      return sample;
+    }
+    void SetElement( ElementIdentifier pos, const ImageSampleType & sample )
+    {
+      this->SetImageCoordinates( pos, sample.m_ImageCoordinates );
+      this->m_ImageValues[ pos ] = sample.m_ImageValue;
+    }
+
+    /** Append a sample. Call ReserveCapacity() first when the number of
+     * samples to append is known. */
+    void push_back( const ImageSampleType & sample )
+    {
+      this->PushBack( sample.m_ImageCoordinates, sample.m_ImageValue );
+    }
+    void PushBack( const PointType & point, const RealType & value )
+    {
+      for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        this->m_ImageCoordinates[ d ].push_back( point[ d ] );
+      }
+      this->m_ImageValues.push_back( value );
+    }
+
+    /** Get the contiguous arrays, of length Size(). Returns 0 when the
+     * container is empty.
+     */
+    const CoordinateValueType * GetImageCoordinatesArray( unsigned int dim ) const
+    {
+      return this->Size() > 0 ? &( this->m_ImageCoordinates[ dim ][ 0 ] ) : 0;
+    }
+    const RealType * GetImageValuesArray( void ) const
+    {
+      return this->Size() > 0 ? &( this->m_ImageValues[ 0 ] ) : 0;
+    }
+
+  protected:
+
+    ImageSampleContainer() {};
+    virtual ~ImageSampleContainer() {};
+
+    /** PrintSelf. */
+    void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  private:
+
+    ImageSampleContainer( const Self& );  // purposely not implemented
+    void operator=( const Self& );        // purposely not implemented
+
+    CoordinateArrayType   m_ImageCoordinates[ ImageDimension ];
+    ValueArrayType        m_ImageValues;
+
+  }; // end class ImageSampleContainer
+
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageSampleContainer.txx"
+#endif
+
+#endif // end #ifndef __itkImageSampleContainer_h
@@ -0,0 +1,134 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkImageSampleContainer_txx
+#define __itkImageSampleContainer_txx
+
+#include "itkImageSampleContainer.h"
+
+namespace itk
+{
+
+  /**
+   * ******************* Reserve *******************
+   */
+
+  template< class TImage >
+    void
+    ImageSampleContainer< TImage >
+    ::Reserve( ElementIdentifier size )
+  {
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      this->m_ImageCoordinates[ d ].resize( size );
+    }
+    this->m_ImageValues.resize( size );
+
+  } // end Reserve()
+
+
+  /**
+   * ******************* Squeeze *******************
+   */
+
+  template< class TImage >
+    void
+    ImageSampleContainer< TImage >
+    ::Squeeze( void )
+  {
+    /** Swap with a copy of the exact size. */
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      CoordinateArrayType( this->m_ImageCoordinates[ d ] )
+        .swap( this->m_ImageCoordinates[ d ] );
+    }
+    ValueArrayType( this->m_ImageValues ).swap( this->m_ImageValues );
+
+  } // end Squeeze()
+
+
+  /**
+   * ******************* CopySamples *******************
+   */
+
+  template< class TImage >
+    void
+    ImageSampleContainer< TImage >
+    ::CopySamples( const Self * other )
+  {
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      this->m_ImageCoordinates[ d ] = other->m_ImageCoordinates[ d ];
+    }
+    this->m_ImageValues = other->m_ImageValues;
+
+  } // end CopySamples()
+
+
+  /**
+   * ******************* ReserveCapacity *******************
+   */
+
+  template< class TImage >
+    void
+    ImageSampleContainer< TImage >
+    ::ReserveCapacity( ElementIdentifier capacity )
+  {
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      this->m_ImageCoordinates[ d ].reserve( capacity );
+    }
+    this->m_ImageValues.reserve( capacity );
+
+  } // end ReserveCapacity()
+
+
+  /**
+   * ******************* Initialize *******************
+   */
+
+  template< class TImage >
+    void
+    ImageSampleContainer< TImage >
+    ::Initialize( void )
+  {
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      this->m_ImageCoordinates[ d ].clear();
+    }
+    this->m_ImageValues.clear();
+
+  } // end Initialize()
+
+
+  /**
+   * ******************* PrintSelf *******************
+   */
+
+  template< class TImage >
+    void
+    ImageSampleContainer< TImage >
+    ::PrintSelf( std::ostream & os, Indent indent ) const
+  {
+    Superclass::PrintSelf( os, indent );
+
+    os << indent << "Size: " << this->Size() << std::endl;
+    os << indent << "Capacity: " << this->m_ImageValues.capacity() << std::endl;
+
+  } // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkImageSampleContainer_txx
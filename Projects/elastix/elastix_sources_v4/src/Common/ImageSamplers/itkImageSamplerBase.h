@@ -17,8 +17,11 @@
 
 #include "itkImageToVectorContainerFilter.h"
 #include "itkImageSample.h"
-#include "itkVectorDataContainer.h"
+#include "itkImageSampleContainer.h"
+#include "itkCounterBasedRandomStream.h"
 #include "itkSpatialObject.h"
+#include "itkMultiThreader.h"
+#include "elxProfiler.h"
 
 
 namespace itk
@@ -33,6 +36,14 @@ namespace itk
    *    Can be given for each resolution. Select one of {Random, Full, Grid, RandomCoordinate}.\n
    *    example: <tt>(ImageSampler "Random")</tt> \n
    *    The default is Random.
+   *
+   * Samplers that support it generate their samples multi-threaded after
+   * SetUseMultiThread( true ). They implement ThreadedGenerateData(), which
+   * is run by LaunchThreadedGenerateData() using the number of threads of
+   * this ProcessObject. The random samplers then do not use the global
+   * Mersenne twister, but a CounterBasedRandomStream per sample, seeded
+   * with the RandomSeed. Since a stream belongs to a sample and not to a
+   * thread, the samples do not depend on the number of threads.
 	 *
 	 * \ingroup ImageSamplers
    */
@@ -40,7 +51,7 @@ namespace itk
   template < class TInputImage >
   class ImageSamplerBase :
     public ImageToVectorContainerFilter< TInputImage,
-      VectorDataContainer< unsigned long, ImageSample< TInputImage > > >
+      ImageSampleContainer< TInputImage > >
   {
   public:
 
@@ -48,9 +59,7 @@ namespace itk
     typedef ImageSamplerBase                  Self;
     typedef ImageToVectorContainerFilter<
       TInputImage,
-      VectorDataContainer<
-        unsigned long,
-        ImageSample< TInputImage > > >        Superclass;
+      ImageSampleContainer< TInputImage > >   Superclass;
     typedef SmartPointer<Self>                Pointer;
     typedef SmartPointer<const Self>          ConstPointer;
 
@@ -76,8 +85,7 @@ namespace itk
 
     /** Other typdefs. */
     typedef ImageSample< InputImageType >               ImageSampleType;
-    typedef VectorDataContainer< unsigned long,
-      ImageSampleType >                                 ImageSampleContainerType;
+    typedef ImageSampleContainer< InputImageType >      ImageSampleContainerType;
     typedef typename InputImageType::SizeType           InputImageSizeType;
     typedef typename InputImageType::IndexType          InputImageIndexType;
     typedef typename InputImageType::PointType          InputImagePointType;
@@ -89,6 +97,7 @@ namespace itk
     typedef typename MaskType::ConstPointer             MaskConstPointer;
     typedef std::vector< MaskConstPointer >             MaskVectorType;
     typedef std::vector< InputImageRegionType >         InputImageRegionVectorType;
+    typedef CounterBasedRandomStream                    RandomStreamType;
 
     /** ******************** Masks ******************** */
 
@@ -156,11 +165,33 @@ namespace itk
       return true;
     }
 
+    /** UpdateOutputData. Calls the superclass implementation, which runs
+     * GenerateData(), and adds the time and the number of samples to the
+     * tmr::Profiler, if it is enabled. */
+    virtual void UpdateOutputData( DataObject * output );
+
     /** Get a handle to the cropped InputImageregion. */
     itkGetConstReferenceMacro( CroppedInputImageRegion, InputImageRegionType );
 
+    /** ******************** Multi-threading ******************** */
+
+    /** Set/Get whether the samples are generated multi-threaded, if the
+     * sampler supports this. Default: false. */
+    itkSetMacro( UseMultiThread, bool );
+    itkGetConstMacro( UseMultiThread, bool );
+
+    /** Set/Get the seed of the random streams of the multi-threaded random
+     * samplers. Setting it restarts the sequence of sample sets. */
+    virtual void SetRandomSeed( unsigned int seed );
+    itkGetConstMacro( RandomSeed, unsigned int );
+
   protected:
 
+    /** Typedefs for multi-threading. */
+    typedef MultiThreader::ThreadInfoStruct             ThreadInfoType;
+    typedef typename ImageSampleContainerType::Pointer  ImageSampleContainerPointer;
+    typedef std::vector< ImageSampleContainerPointer >  ImageSampleContainerVectorType;
+
     /** The constructor. */
     ImageSamplerBase();
 
@@ -187,6 +218,59 @@ namespace itk
     /** Compute the intersection of the InputImageRegion and the bounding box of the mask. */
     void CropInputImageRegion( void );
 
+    /** Run ThreadedGenerateData() in all threads. Before that, the
+     * per-thread sample containers and failure flags are cleared. */
+    virtual void LaunchThreadedGenerateData( void );
+
+    /** Generate the part of the samples of one thread. Samplers that
+     * support multi-threading override this. Throwing an exception is not
+     * safe in a thread; set the failure flag of the thread instead. */
+    virtual void ThreadedGenerateData( unsigned int itkNotUsed( threadID ) ) {};
+
+    /** The function that is called by the threader. */
+    static ITK_THREAD_RETURN_TYPE ThreaderCallback( void * arg );
+
+    /** Divide [0, n) in contiguous chunks, one for each thread. */
+    void GetThreadRange( unsigned int threadID, unsigned long n,
+      unsigned long & begin, unsigned long & end ) const;
+
+    /** Copy the per-thread sample containers to the output, in the order
+     * of the threads. */
+    virtual void MergeThreaderSampleContainers( void );
+
+    /** Returns true if one of the threads set its failure flag, or if the
+     * threads together used more than m_ThreaderMaximumNumberOfTries. */
+    bool ThreaderFailed( void ) const;
+
+    /** Start a new sample set. The random streams of the samples of the new
+     * set are independent of those of the previous sets. */
+    void InitializeRandomStreams( void )
+    {
+      ++this->m_RandomSampleSetNumber;
+    }
+
+    /** Initialize a random stream for sample sampleNumber of the current
+     * sample set. */
+    void InitializeRandomStream( RandomStreamType & stream,
+      unsigned long sampleNumber ) const
+    {
+      stream.Initialize( this->m_RandomSeed,
+        this->m_RandomSampleSetNumber, sampleNumber );
+    }
+
+    /** Member variables for multi-threading. Samplers that retry rejected
+     * samples store the number of tries of each thread, and give up when
+     * all threads together need more than m_ThreaderMaximumNumberOfTries
+     * (0 means no limit). The samples are drawn from a stream per sample,
+     * so the total does not depend on the number of threads, and neither
+     * does the failure. A thread stops as soon as it alone exceeds the
+     * limit. */
+    bool                              m_UseMultiThread;
+    ImageSampleContainerVectorType    m_ThreaderSampleContainer;
+    std::vector< unsigned char >      m_ThreaderFailure;
+    std::vector< unsigned long >      m_ThreaderNumberOfTries;
+    unsigned long                     m_ThreaderMaximumNumberOfTries;
+
   private:
 
     /** The private constructor. */
@@ -205,6 +289,9 @@ namespace itk
     InputImageRegionType              m_CroppedInputImageRegion;
     InputImageRegionType              m_DummyInputImageRegion;
 
+    unsigned int                      m_RandomSeed;
+    unsigned long                     m_RandomSampleSetNumber;
+
   }; // end class ImageSamplerBase
 
 
@@ -16,6 +16,7 @@
 #define __ImageSamplerBase_txx
 
 #include "itkImageSamplerBase.h"
+#include "vnl/vnl_math.h"
 
 namespace itk
 {
@@ -32,6 +33,11 @@ namespace itk
     this->m_NumberOfMasks = 0;
     this->m_NumberOfInputImageRegions = 0;
 
+    this->m_UseMultiThread = false;
+    this->m_ThreaderMaximumNumberOfTries = 0;
+    this->m_RandomSeed = 0;
+    this->m_RandomSampleSetNumber = 0;
+
   } // end Constructor()
 
 
@@ -248,6 +254,173 @@ namespace itk
   } // end SelectNewSamplesOnUpdate()
 
 
+  /**
+   * ******************* UpdateOutputData *******************
+   */
+
+  template< class TInputImage >
+    void
+    ImageSamplerBase< TInputImage >
+    ::UpdateOutputData( DataObject * output )
+  {
+    tmrProfileScope( "ImageSampler::GenerateData" );
+    this->Superclass::UpdateOutputData( output );
+    tmrProfileCount( "Samples", this->GetOutput()->Size() );
+
+  } // end UpdateOutputData()
+
+
+  /**
+   * ******************* SetRandomSeed *******************
+   */
+
+  template< class TInputImage >
+    void
+    ImageSamplerBase< TInputImage >
+    ::SetRandomSeed( unsigned int seed )
+  {
+    if ( this->m_RandomSeed != seed || this->m_RandomSampleSetNumber != 0 )
+    {
+      this->m_RandomSeed = seed;
+      this->m_RandomSampleSetNumber = 0;
+      this->Modified();
+    }
+
+  } // end SetRandomSeed()
+
+
+  /**
+   * ******************* LaunchThreadedGenerateData *******************
+   */
+
+  template< class TInputImage >
+    void
+    ImageSamplerBase< TInputImage >
+    ::LaunchThreadedGenerateData( void )
+  {
+    /** The threader may limit the number of threads, so ask it afterwards. */
+    MultiThreader * threader = this->GetMultiThreader();
+    threader->SetNumberOfThreads( this->GetNumberOfThreads() );
+    const unsigned int numberOfThreads = threader->GetNumberOfThreads();
+
+    /** Prepare the per-thread variables. The containers keep their memory. */
+    this->m_ThreaderSampleContainer.resize( numberOfThreads );
+    for ( unsigned int i = 0; i < numberOfThreads; ++i )
+    {
+      if ( this->m_ThreaderSampleContainer[ i ].IsNull() )
+      {
+        this->m_ThreaderSampleContainer[ i ] = ImageSampleContainerType::New();
+      }
+      this->m_ThreaderSampleContainer[ i ]->Initialize();
+    }
+    this->m_ThreaderFailure.assign( numberOfThreads, 0 );
+    this->m_ThreaderNumberOfTries.assign( numberOfThreads, 0 );
+
+    /** Launch. */
+    threader->SetSingleMethod( this->ThreaderCallback, this );
+    threader->SingleMethodExecute();
+
+  } // end LaunchThreadedGenerateData()
+
+
+  /**
+   * ******************* ThreaderCallback *******************
+   */
+
+  template< class TInputImage >
+    ITK_THREAD_RETURN_TYPE
+    ImageSamplerBase< TInputImage >
+    ::ThreaderCallback( void * arg )
+  {
+    ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>( arg );
+    Self * sampler = static_cast<Self *>( infoStruct->UserData );
+
+    sampler->ThreadedGenerateData( infoStruct->ThreadID );
+
+    return ITK_THREAD_RETURN_VALUE;
+
+  } // end ThreaderCallback()
+
+
+  /**
+   * ******************* GetThreadRange *******************
+   */
+
+  template< class TInputImage >
+    void
+    ImageSamplerBase< TInputImage >
+    ::GetThreadRange( unsigned int threadID, unsigned long n,
+      unsigned long & begin, unsigned long & end ) const
+  {
+    const unsigned long numberOfThreads = this->m_ThreaderFailure.size();
+    const unsigned long chunkSize = ( n + numberOfThreads - 1 ) / numberOfThreads;
+
+    begin = vnl_math_min( threadID * chunkSize, n );
+    end = vnl_math_min( ( threadID + 1 ) * chunkSize, n );
+
+  } // end GetThreadRange()
+
+
+  /**
+   * ******************* MergeThreaderSampleContainers *******************
+   */
+
+  template< class TInputImage >
+    void
+    ImageSamplerBase< TInputImage >
+    ::MergeThreaderSampleContainers( void )
+  {
+    typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
+    const unsigned int numberOfThreads = this->m_ThreaderSampleContainer.size();
+
+    /** Compute the total size. */
+    unsigned long numberOfSamples = 0;
+    for ( unsigned int i = 0; i < numberOfThreads; ++i )
+    {
+      numberOfSamples += this->m_ThreaderSampleContainer[ i ]->Size();
+    }
+    sampleContainer->Reserve( numberOfSamples );
+
+    /** Copy, in the order of the threads. */
+    unsigned long pos = 0;
+    InputImagePointType point;
+    for ( unsigned int i = 0; i < numberOfThreads; ++i )
+    {
+      const ImageSampleContainerType * threadContainer
+        = this->m_ThreaderSampleContainer[ i ];
+      const unsigned long threadSize = threadContainer->Size();
+      for ( unsigned long j = 0; j < threadSize; ++j, ++pos )
+      {
+        threadContainer->GetImageCoordinates( j, point );
+        sampleContainer->SetImageCoordinates( pos, point );
+        sampleContainer->SetImageValue( pos, threadContainer->GetImageValue( j ) );
+      }
+    }
+
+  } // end MergeThreaderSampleContainers()
+
+
+  /**
+   * ******************* ThreaderFailed *******************
+   */
+
+  template< class TInputImage >
+    bool
+    ImageSamplerBase< TInputImage >
+    ::ThreaderFailed( void ) const
+  {
+    unsigned long numberOfTries = 0;
+    for ( unsigned int i = 0; i < this->m_ThreaderFailure.size(); ++i )
+    {
+      if ( this->m_ThreaderFailure[ i ] ) return true;
+      numberOfTries += this->m_ThreaderNumberOfTries[ i ];
+    }
+    return this->m_ThreaderMaximumNumberOfTries != 0
+      && numberOfTries > this->m_ThreaderMaximumNumberOfTries;
+
+  } // end ThreaderFailed()
+
+
   /**
    * ******************* IsInsideAllMasks *******************
    */
@@ -427,6 +600,8 @@ namespace itk
       os << indent.GetNextIndent() << this->m_InputImageRegionVector[ i ] << std::endl;
     }
     os << indent << "CroppedInputImageRegion" << this->m_CroppedInputImageRegion << std::endl;
+    os << indent << "UseMultiThread: " << this->m_UseMultiThread << std::endl;
+    os << indent << "RandomSeed: " << this->m_RandomSeed << std::endl;
 
   } // end PrintSelf()
 
@@ -70,6 +70,7 @@ namespace itk
     typedef typename Superclass::InputImagePointType          InputImagePointType;
     typedef typename Superclass::InputImagePointValueType     InputImagePointValueType;
     typedef typename Superclass::ImageSampleValueType         ImageSampleValueType;
+    typedef typename Superclass::RandomStreamType             RandomStreamType;
 
     /** The input image dimension. */
     itkStaticConstMacro( InputImageDimension, unsigned int,
@@ -118,6 +119,11 @@ namespace itk
     /** Function that does the work. */
     virtual void GenerateData( void );
 
+    /** Generate the samples of one thread. The coordinates are drawn
+     * uniformly from the random stream of each sample, not by
+     * GenerateRandomCoordinate(). */
+    virtual void ThreadedGenerateData( unsigned int threadID );
+
     /** Generate a point randomly in a bounding box.
      * This method can be overwritten in subclasses if a different distribution is desired. */
     virtual void GenerateRandomCoordinate(
@@ -125,10 +131,18 @@ namespace itk
       const InputImageContinuousIndexType & largestContIndex,
       InputImageContinuousIndexType &       randomContIndex);
 
+    /** Set the input image of the interpolator, unless the interpolator
+     * already has the current input image and both did not change since. */
+    virtual void UpdateInterpolator( void );
+
     typename InterpolatorType::Pointer    m_Interpolator;
     typename RandomGeneratorType::Pointer m_RandomGenerator;
     InputImageSpacingType                 m_SampleRegionSize;
 
+    /** The sample region of the current GenerateData() call, used by the threads. */
+    InputImageContinuousIndexType         m_SmallestContIndex;
+    InputImageContinuousIndexType         m_LargestContIndex;
+
     /** Generate the two corners of a sampling region. */
     virtual void GenerateSampleRegion(
       InputImageContinuousIndexType & smallestContIndex,
@@ -143,6 +157,9 @@ namespace itk
 
     bool          m_UseRandomSampleRegion;
 
+    /** The time the interpolator was last given the input image. */
+    TimeStamp     m_InterpolatorUpdateTime;
+
   }; // end class MultiInputImageRandomCoordinateSampler
 
 
@@ -69,7 +69,7 @@ namespace itk
     typename InterpolatorType::Pointer interpolator = this->GetInterpolator();
 
     /** Set up the interpolator. */
-    interpolator->SetInputImage( inputImage );
+    this->UpdateInterpolator();
 
     /** Get the intersection of all sample regions. */
     InputImageContinuousIndexType smallestContIndex;
@@ -80,21 +80,39 @@ namespace itk
     /** Reserve memory for the output. */
     sampleContainer->Reserve( this->GetNumberOfSamples() );
 
-    /** Setup an iterator over the output, which is of ImageSampleContainerType. */
-    typename ImageSampleContainerType::Iterator iter;
-    typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
+    /** Let the threads generate the samples, in place. */
+    if ( this->m_UseMultiThread )
+    {
+      if ( !mask.IsNull() )
+      {
+        this->UpdateAllMasks();
+      }
+      this->m_SmallestContIndex = smallestContIndex;
+      this->m_LargestContIndex = largestContIndex;
+      this->InitializeRandomStreams();
+      this->m_ThreaderMaximumNumberOfTries = 10 * this->GetNumberOfSamples();
+      this->LaunchThreadedGenerateData();
+      if ( this->ThreaderFailed() )
+      {
+        sampleContainer->Reserve( 0 );
+        itkExceptionMacro( << "Could not find enough image samples within "
+          << "reasonable time. Probably the mask is too small" );
+      }
+      return;
+    }
+
+    /** The samples are stored by position in the output container. */
+    const unsigned long numberOfSamples = sampleContainer->Size();
 
     InputImageContinuousIndexType sampleContIndex;
+    InputImagePointType samplePoint;
+    ImageSampleValueType sampleValue;
     /** Fill the sample container. */
     if ( mask.IsNull() )
     {
       /** Start looping over the sample container. */
-      for ( iter = sampleContainer->Begin(); iter != end; ++iter )
+      for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
       {
-        /** Make a reference to the current sample in the container. */
-        InputImagePointType & samplePoint = (*iter).Value().m_ImageCoordinates;
-        ImageSampleValueType & sampleValue = (*iter).Value().m_ImageValue;
-
         /** Generate a point in the input image region. */
         this->GenerateRandomCoordinate( smallestContIndex, largestContIndex, sampleContIndex );
 
@@ -105,6 +123,10 @@ namespace itk
         sampleValue = static_cast<ImageSampleValueType>(
           this->m_Interpolator->EvaluateAtContinuousIndex( sampleContIndex ) );
 
+        /** Store the sample in the container. */
+        sampleContainer->SetImageCoordinates( pos, samplePoint );
+        sampleContainer->SetImageValue( pos, sampleValue );
+
       } // end for loop
     } // end if no mask
     else
@@ -119,12 +141,8 @@ namespace itk
       unsigned long maximumNumberOfSamplesToTry = 10 * this->GetNumberOfSamples();
 
       /** Start looping over the sample container. */
-      for ( iter = sampleContainer->Begin(); iter != end; ++iter )
+      for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
       {
-        /** Make a reference to the current sample in the container. */
-        InputImagePointType & samplePoint = (*iter).Value().m_ImageCoordinates;
-        ImageSampleValueType & sampleValue = (*iter).Value().m_ImageValue;
-
         /** Walk over the image until we find a valid point. */
         do
         {
@@ -133,10 +151,7 @@ namespace itk
           if ( numberOfSamplesTried > maximumNumberOfSamplesToTry )
           {
             /** Squeeze the sample container to the size that is still valid. */
-            typename ImageSampleContainerType::iterator stlnow = sampleContainer->begin();
-            typename ImageSampleContainerType::iterator stlend = sampleContainer->end();
-            stlnow += iter.Index();
-            sampleContainer->erase( stlnow, stlend);
+            sampleContainer->Reserve( pos );
             itkExceptionMacro( << "Could not find enough image samples within "
               << "reasonable time. Probably the mask is too small" );
           }
@@ -150,12 +165,79 @@ namespace itk
         sampleValue = static_cast<ImageSampleValueType>(
           this->m_Interpolator->EvaluateAtContinuousIndex( sampleContIndex ) );
 
+        /** Store the sample in the container. */
+        sampleContainer->SetImageCoordinates( pos, samplePoint );
+        sampleContainer->SetImageValue( pos, sampleValue );
+
       } // end for loop
     } // end if mask
 
   } // end GenerateData()
 
 
+  /**
+   * ******************* ThreadedGenerateData *******************
+   */
+
+  template< class TInputImage >
+    void
+    MultiInputImageRandomCoordinateSampler< TInputImage >
+    ::ThreadedGenerateData( unsigned int threadID )
+  {
+    /** Get handles to the input image and output sample container. */
+    const InputImageType * inputImage = this->GetInput();
+    ImageSampleContainerType * sampleContainer = this->GetOutput();
+    const bool useMasks = this->GetMask() != 0;
+    const InterpolatorType * interpolator = this->m_Interpolator.GetPointer();
+
+    /** Get the samples of this thread. */
+    unsigned long begin = 0;
+    unsigned long end = 0;
+    this->GetThreadRange( threadID, sampleContainer->Size(), begin, end );
+
+    /** Make sure we are not eternally trying to find samples. The budget
+     * is shared by all threads; see ThreaderFailed(). */
+    const unsigned long maximumNumberOfSamplesToTry
+      = this->m_ThreaderMaximumNumberOfTries;
+    unsigned long numberOfSamplesTried = 0;
+
+    RandomStreamType stream;
+    InputImageContinuousIndexType sampleContIndex;
+    InputImagePointType samplePoint;
+    for ( unsigned long pos = begin; pos < end; ++pos )
+    {
+      this->InitializeRandomStream( stream, pos );
+      do
+      {
+        ++numberOfSamplesTried;
+        if ( numberOfSamplesTried > maximumNumberOfSamplesToTry )
+        {
+          this->m_ThreaderFailure[ threadID ] = 1;
+          this->m_ThreaderNumberOfTries[ threadID ] = numberOfSamplesTried;
+          return;
+        }
+
+        /** Generate a point in the input image region. */
+        for ( unsigned int i = 0; i < InputImageDimension; ++i )
+        {
+          sampleContIndex[ i ] = static_cast<InputImagePointValueType>(
+            stream.GetUniformVariate(
+            this->m_SmallestContIndex[ i ], this->m_LargestContIndex[ i ] ) );
+        }
+        inputImage->TransformContinuousIndexToPhysicalPoint( sampleContIndex, samplePoint );
+      } while ( useMasks && !this->IsInsideAllMasks( samplePoint ) );
+
+      /** Compute the value at the point and store the sample. */
+      sampleContainer->SetImageCoordinates( pos, samplePoint );
+      sampleContainer->SetImageValue( pos, static_cast<ImageSampleValueType>(
+        interpolator->EvaluateAtContinuousIndex( sampleContIndex ) ) );
+    } // end for
+
+    this->m_ThreaderNumberOfTries[ threadID ] = numberOfSamplesTried;
+
+  } // end ThreadedGenerateData()
+
+
   /**
    * ******************* GenerateSampleRegion *******************
    */
@@ -286,6 +368,31 @@ namespace itk
   } // end GenerateRandomCoordinate()
 
 
+  /**
+   * ******************* UpdateInterpolator *******************
+   */
+
+  template< class TInputImage >
+    void
+    MultiInputImageRandomCoordinateSampler< TInputImage >
+    ::UpdateInterpolator( void )
+  {
+    const InputImageType * inputImage = this->GetInput();
+    InterpolatorType * interpolator = this->m_Interpolator.GetPointer();
+
+    /** Skip the possibly expensive SetInputImage() if nothing changed. */
+    const unsigned long updateTime = this->m_InterpolatorUpdateTime.GetMTime();
+    if ( interpolator->GetInputImage() != inputImage
+      || inputImage->GetMTime() > updateTime
+      || interpolator->GetMTime() > updateTime )
+    {
+      interpolator->SetInputImage( inputImage );
+      this->m_InterpolatorUpdateTime.Modified();
+    }
+
+  } // end UpdateInterpolator()
+
+
   /**
    * ******************* PrintSelf *******************
    */
@@ -0,0 +1,122 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __ReadOnlyImageSampler_h
+#define __ReadOnlyImageSampler_h
+
+#include "itkImageSamplerBase.h"
+
+namespace itk
+{
+
+  /** \class ReadOnlyImageSampler
+   *
+   * \brief An image sampler that copies the samples of another sampler.
+   *
+   * Update() copies the output container of the source sampler, if it was
+   * regenerated since the previous copy. It does not update the source
+   * sampler, and it does not touch the pipeline of the input images, so
+   * several ReadOnlyImageSamplers can be updated in different threads at
+   * the same time. The source sampler must be updated beforehand, in the
+   * calling thread.
+   *
+   * The concurrent copies of an AdvancedImageToImageMetric use this
+   * sampler, see AdvancedImageToImageMetric::CreateConcurrentCopies().
+   *
+   * \ingroup ImageSamplers
+   */
+
+  template < class TInputImage >
+  class ReadOnlyImageSampler :
+    public ImageSamplerBase< TInputImage >
+  {
+  public:
+
+    /** Standard ITK-stuff. */
+    typedef ReadOnlyImageSampler              Self;
+    typedef ImageSamplerBase< TInputImage >   Superclass;
+    typedef SmartPointer<Self>                Pointer;
+    typedef SmartPointer<const Self>          ConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro( Self );
+
+    /** Run-time type information (and related methods). */
+    itkTypeMacro( ReadOnlyImageSampler, ImageSamplerBase );
+
+    /** Typedefs inherited from the superclass. */
+    typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
+
+    /** Set/Get the output container of the source sampler. */
+    virtual void SetSourceSampleContainer( const ImageSampleContainerType * arg )
+    {
+      this->m_SourceSampleContainer = arg;
+      this->m_SourceSampleContainerMTime = 0;
+      this->Modified();
+    }
+    virtual const ImageSampleContainerType * GetSourceSampleContainer( void ) const
+    {
+      return this->m_SourceSampleContainer.GetPointer();
+    }
+
+    /** Copy the samples of the source sampler, if they changed since the
+     * previous call. */
+    virtual void Update( void )
+    {
+      const ImageSampleContainerType * source = this->m_SourceSampleContainer;
+      if ( source && source->GetMTime() != this->m_SourceSampleContainerMTime )
+      {
+        this->GetOutput()->CopySamples( source );
+        this->m_SourceSampleContainerMTime = source->GetMTime();
+      }
+    }
+
+  protected:
+
+    /** The constructor. */
+    ReadOnlyImageSampler()
+    {
+      this->m_SourceSampleContainerMTime = 0;
+    };
+
+    /** The destructor. */
+    virtual ~ReadOnlyImageSampler() {};
+
+    /** There is nothing to generate; Update() copies the samples. */
+    virtual void GenerateData( void ) {};
+
+    /** PrintSelf. */
+    void PrintSelf( std::ostream& os, Indent indent ) const
+    {
+      Superclass::PrintSelf( os, indent );
+      os << indent << "SourceSampleContainer: "
+        << this->m_SourceSampleContainer.GetPointer() << std::endl;
+    };
+
+  private:
+
+    /** The private constructor. */
+    ReadOnlyImageSampler( const Self& );      // purposely not implemented
+    /** The private copy constructor. */
+    void operator=( const Self& );            // purposely not implemented
+
+    typename ImageSampleContainerType::ConstPointer   m_SourceSampleContainer;
+    unsigned long                                     m_SourceSampleContainerMTime;
+
+  }; // end class ReadOnlyImageSampler
+
+
+} // end namespace itk
+
+#endif // end #ifndef __ReadOnlyImageSampler_h
@@ -86,6 +86,24 @@
   #define DLL_API
 #endif
 
+//----------------------------------------------------------------------
+// ANN_THREAD_LOCAL, added for elastix
+//    The searches keep their state in global variables. These are made
+//    thread local, so that several threads can search a tree at the
+//    same time. ANN_THREAD_SAFE_SEARCH tells whether this is possible
+//    with the current compiler.
+//----------------------------------------------------------------------
+#if defined(_MSC_VER)
+  #define ANN_THREAD_LOCAL __declspec(thread)
+  #define ANN_THREAD_SAFE_SEARCH 1
+#elif defined(__GNUC__) || defined(__INTEL_COMPILER)
+  #define ANN_THREAD_LOCAL __thread
+  #define ANN_THREAD_SAFE_SEARCH 1
+#else
+  #define ANN_THREAD_LOCAL
+  #define ANN_THREAD_SAFE_SEARCH 0
+#endif
+
 //----------------------------------------------------------------------
 //  basic includes
 //----------------------------------------------------------------------
@@ -704,6 +722,25 @@ class ANNkdStats;       // stats on kd-tree
 class ANNkd_node;       // generic node in a kd-tree
 typedef ANNkd_node* ANNkd_ptr;  // pointer to a kd-tree node
 
+//----------------------------------------------------------------------
+// Parallel construction, added for elastix
+//    ANN does not depend on a thread library. Instead, the kd-tree
+//    constructor optionally accepts a task runner: a function that
+//    calls task(i, taskData) for i = 0..nTasks-1, possibly
+//    concurrently, and returns when all calls have finished. The top
+//    levels of the tree are then split serially, and the subtrees
+//    below are built as separate tasks. The resulting tree is the
+//    same as without a task runner.
+//----------------------------------------------------------------------
+typedef void (*ANNtaskFunction)(  // a task
+  int       i,        // task number
+  void      *taskData);   // data shared by all tasks
+typedef void (*ANNtaskRunner)(    // runs tasks 0..nTasks-1
+  int       nTasks,     // number of tasks
+  ANNtaskFunction task,     // the task function
+  void      *taskData,    // passed to the task function
+  void      *runnerData);   // passed to the task runner
+
 class DLL_API ANNkd_tree: public ANNpointSet {
 protected:
   int       dim;        // dimension of space
@@ -733,7 +770,10 @@ public:
     int       n,        // number of points
     int       dd,       // dimension
     int       bs = 1,     // bucket size
-    ANNsplitRule  split = ANN_KD_SUGGEST);  // splitting method
+    ANNsplitRule  split = ANN_KD_SUGGEST,  // splitting method
+    ANNtaskRunner runner = NULL,  // task runner (optional)
+    void      *runnerData = NULL, // passed to the task runner
+    int       nTasks = 1);    // wanted number of subtree tasks
 
   ANNkd_tree(             // build from dump file
     std::istream& in);      // input stream for dump file
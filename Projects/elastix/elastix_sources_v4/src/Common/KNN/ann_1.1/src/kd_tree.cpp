@@ -26,12 +26,15 @@
 //    Added optional pa, pi arguments to Skeleton kd_tree constructor
 //      for use in load constructor.
 //    Added annClose() to eliminate KD_TRIVIAL memory leak.
+//  Added for elastix
+//    Optional parallel construction through a task runner.
 //----------------------------------------------------------------------
 
 #include "kd_tree.h"          // kd-tree declarations
 #include "kd_split.h"         // kd-tree splitting rules
 #include "kd_util.h"          // kd-tree utilities
 #include <ANN/ANNperf.h>        // performance evaluation
+#include <vector>           // for the parallel construction
 
 //----------------------------------------------------------------------
 //  Global data
@@ -357,12 +360,145 @@ ANNkd_ptr rkd_tree(       // recursive construction of kd-tree
   }
 } 
 
+//----------------------------------------------------------------------
+//  Parallel construction (added for elastix)
+//    rkd_tree_top() splits the top levels of the tree exactly like
+//    rkd_tree(), but below the given depth it stores the subtrees as
+//    tasks instead of building them. The top nodes are recorded in
+//    preorder. After the task runner has built the subtrees, which
+//    work on disjoint parts of pidx, rkd_tree_assemble() creates the
+//    splitting nodes of the top levels.
+//----------------------------------------------------------------------
+
+struct ANNkd_task {           // a subtree to build
+  ANNidxArray     pidx;     // point indices of the subtree
+  int         n;        // number of points
+  ANNorthRect     *bnd_box;   // bounding box (owned)
+  ANNkd_ptr     root;     // the resulting subtree
+};
+
+struct ANNkd_top_node {         // a node of the top levels
+  int         task;     // task number, or -1 if splitting
+  int         cd;       // cutting dimension
+  ANNcoord      cv;       // cutting value
+  ANNcoord      lv, hv;     // low and high bounds along cd
+};
+
+struct ANNkd_task_data {        // data shared by the tasks
+  ANNpointArray   pa;       // point array
+  int         dim;      // dimension of space
+  int         bsp;      // bucket space
+  ANNkd_splitter    splitter;   // splitting routine
+  std::vector<ANNkd_task> *tasks;   // the tasks
+};
+
+static void rkd_tree_top(       // split the top levels
+  ANNpointArray   pa,       // point array
+  ANNidxArray     pidx,     // point indices to store in subtree
+  int         n,        // number of points
+  int         dim,      // dimension of space
+  int         bsp,      // bucket space
+  ANNorthRect     &bnd_box,   // bounding box for current node
+  ANNkd_splitter    splitter,   // splitting routine
+  int         depth,      // remaining number of top levels
+  std::vector<ANNkd_top_node> &nodes, // top nodes (appended)
+  std::vector<ANNkd_task> &tasks)   // tasks (appended)
+{
+  ANNkd_top_node node;
+  if (depth == 0 || n <= bsp) {     // postpone this subtree
+    node.task = (int) tasks.size();
+    node.cd = 0;
+    node.cv = node.lv = node.hv = 0;
+    nodes.push_back(node);
+    ANNkd_task task;
+    task.pidx = pidx;
+    task.n = n;
+    task.bnd_box = new ANNorthRect(dim, bnd_box);
+    task.root = NULL;
+    tasks.push_back(task);
+    return;
+  }
+  int n_lo;             // number on low side of cut
+  (*splitter)(pa, pidx, bnd_box, n, dim, node.cd, node.cv, n_lo);
+  node.task = -1;
+  node.lv = bnd_box.lo[node.cd];    // save bounds for cutting dimension
+  node.hv = bnd_box.hi[node.cd];
+  nodes.push_back(node);
+
+  bnd_box.hi[node.cd] = node.cv;    // left subtree
+  rkd_tree_top(pa, pidx, n_lo, dim, bsp, bnd_box, splitter,
+    depth - 1, nodes, tasks);
+  bnd_box.hi[node.cd] = node.hv;
+
+  bnd_box.lo[node.cd] = node.cv;    // right subtree
+  rkd_tree_top(pa, pidx + n_lo, n - n_lo, dim, bsp, bnd_box, splitter,
+    depth - 1, nodes, tasks);
+  bnd_box.lo[node.cd] = node.lv;
+}
+
+static void rkd_tree_task(        // build the subtree of task i
+  int         i,        // task number
+  void        *taskData)    // the ANNkd_task_data
+{
+  ANNkd_task_data *data = (ANNkd_task_data *) taskData;
+  ANNkd_task &task = (*data->tasks)[i];
+  task.root = rkd_tree(data->pa, task.pidx, task.n, data->dim,
+    data->bsp, *task.bnd_box, data->splitter);
+}
+
+static ANNkd_ptr rkd_tree_assemble(   // create the top nodes
+  const std::vector<ANNkd_top_node> &nodes, // top nodes in preorder
+  const std::vector<ANNkd_task> &tasks, // finished tasks
+  int         &pos)     // current position in nodes
+{
+  const ANNkd_top_node &node = nodes[pos++];
+  if (node.task >= 0) return tasks[node.task].root;
+  ANNkd_ptr lo = rkd_tree_assemble(nodes, tasks, pos);
+  ANNkd_ptr hi = rkd_tree_assemble(nodes, tasks, pos);
+  return new ANNkd_split(node.cd, node.cv, node.lv, node.hv, lo, hi);
+}
+
+static ANNkd_ptr rkd_tree_parallel(   // parallel construction
+  ANNpointArray   pa,       // point array
+  ANNidxArray     pidx,     // point indices
+  int         n,        // number of points
+  int         dim,      // dimension of space
+  int         bsp,      // bucket space
+  ANNorthRect     &bnd_box,   // bounding box
+  ANNkd_splitter    splitter,   // splitting routine
+  ANNtaskRunner   runner,     // task runner
+  void        *runnerData,  // passed to the task runner
+  int         nTasks)     // wanted number of tasks
+{
+  int depth = 0;            // at most 2^depth tasks
+  while ((1 << depth) < nTasks) depth++;
+
+  std::vector<ANNkd_top_node> nodes;
+  std::vector<ANNkd_task> tasks;
+  rkd_tree_top(pa, pidx, n, dim, bsp, bnd_box, splitter, depth, nodes, tasks);
+
+  ANNkd_task_data data;
+  data.pa = pa;
+  data.dim = dim;
+  data.bsp = bsp;
+  data.splitter = splitter;
+  data.tasks = &tasks;
+  (*runner)((int) tasks.size(), rkd_tree_task, &data, runnerData);
+
+  for (unsigned int i = 0; i < tasks.size(); i++) {
+    delete tasks[i].bnd_box;
+  }
+  int pos = 0;
+  return rkd_tree_assemble(nodes, tasks, pos);
+}
+
 //----------------------------------------------------------------------
 // kd-tree constructor
 //    This is the main constructor for kd-trees given a set of points.
 //    It first builds a skeleton tree, then computes the bounding box
 //    of the data points, and then invokes rkd_tree() to actually
 //    build the tree, passing it the appropriate splitting routine.
+//    If a task runner is given, rkd_tree_parallel() is used instead.
 //----------------------------------------------------------------------
 
 ANNkd_tree::ANNkd_tree(         // construct from point array
@@ -370,7 +506,10 @@ ANNkd_tree::ANNkd_tree(         // construct from point array
   int         n,        // number of points
   int         dd,       // dimension
   int         bs,       // bucket size
-  ANNsplitRule    split)      // splitting method
+  ANNsplitRule    split,      // splitting method
+  ANNtaskRunner   runner,     // task runner (optional)
+  void        *runnerData,  // passed to the task runner
+  int         nTasks)     // wanted number of subtree tasks
 {
   SkeletonTree(n, dd, bs);      // set up the basic stuff
   pts = pa;             // where the points are
@@ -382,24 +521,34 @@ ANNkd_tree::ANNkd_tree(         // construct from point array
   bnd_box_lo = annCopyPt(dd, bnd_box.lo);
   bnd_box_hi = annCopyPt(dd, bnd_box.hi);
 
-  switch (split) {          // build by rule
+  ANNkd_splitter splitter = NULL;
+  switch (split) {          // select splitting rule
   case ANN_KD_STD:          // standard kd-splitting rule
-    root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, kd_split);
+    splitter = kd_split;
     break;
   case ANN_KD_MIDPT:          // midpoint split
-    root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, midpt_split);
+    splitter = midpt_split;
     break;
   case ANN_KD_FAIR:         // fair split
-    root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, fair_split);
+    splitter = fair_split;
     break;
   case ANN_KD_SUGGEST:        // best (in our opinion)
   case ANN_KD_SL_MIDPT:       // sliding midpoint split
-    root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, sl_midpt_split);
+    splitter = sl_midpt_split;
     break;
   case ANN_KD_SL_FAIR:        // sliding fair split
-    root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, sl_fair_split);
+    splitter = sl_fair_split;
     break;
   default:
     annError("Illegal splitting method", ANNabort);
+    return;
+  }
+
+  if (runner == NULL || nTasks <= 1) {  // build by rule
+    root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, splitter);
+  }
+  else {
+    root = rkd_tree_parallel(pa, pidx, n, dd, bs, bnd_box, splitter,
+      runner, runnerData, nTasks);
   }
 }
@@ -22,19 +22,81 @@ namespace itk
 
   unsigned int ANNBinaryTreeCreator::m_NumberOfANNBinaryTrees = 0;
 
+  /** The data that is passed to the threads by RunANNTasks(). */
+  struct ANNTaskThreaderStruct
+  {
+    int               m_NumberOfTasks;
+    ANNtaskFunction   m_Task;
+    void *            m_TaskData;
+  };
+
   /**
    * ************************ CreateANNkDTree *************************
    */
 
   ANNBinaryTreeCreator::ANNkDTreeType * ANNBinaryTreeCreator::CreateANNkDTree(
     ANNPointArrayType pa, int n, int d, int bs,
-    ANNSplitRuleType split )
+    ANNSplitRuleType split, unsigned int numberOfThreads )
   {
     IncreaseReferenceCount();
-    return new ANNkd_tree( pa, n, d, bs, split );
+    if ( numberOfThreads <= 1 )
+    {
+      return new ANNkd_tree( pa, n, d, bs, split );
+    }
+
+    /** Create a few tasks per thread, since the subtrees are not
+     * always equally large.
+     */
+    MultiThreader::Pointer threader = MultiThreader::New();
+    threader->SetNumberOfThreads( numberOfThreads );
+    const int nTasks = 4 * static_cast<int>( threader->GetNumberOfThreads() );
+    return new ANNkd_tree( pa, n, d, bs, split,
+      RunANNTasks, threader.GetPointer(), nTasks );
   } // end CreateANNkDTree
 
 
+  /**
+   * ************************ RunANNTasks *************************
+   */
+
+  void ANNBinaryTreeCreator::RunANNTasks( int nTasks, ANNtaskFunction task,
+    void * taskData, void * runnerData )
+  {
+    MultiThreader * threader = static_cast<MultiThreader *>( runnerData );
+
+    ANNTaskThreaderStruct str;
+    str.m_NumberOfTasks = nTasks;
+    str.m_Task = task;
+    str.m_TaskData = taskData;
+
+    threader->SetSingleMethod( ANNTaskThreaderCallback, &str );
+    threader->SingleMethodExecute();
+  } // end RunANNTasks
+
+
+  /**
+   * ************************ ANNTaskThreaderCallback *************************
+   */
+
+  ITK_THREAD_RETURN_TYPE ANNBinaryTreeCreator::ANNTaskThreaderCallback( void * arg )
+  {
+    MultiThreader::ThreadInfoStruct * infoStruct
+      = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+    const int threadID = static_cast<int>( infoStruct->ThreadID );
+    const int nThreads = static_cast<int>( infoStruct->NumberOfThreads );
+    ANNTaskThreaderStruct * str
+      = static_cast<ANNTaskThreaderStruct *>( infoStruct->UserData );
+
+    /** Thread t runs the tasks t, t + nThreads, t + 2 nThreads, ... */
+    for ( int i = threadID; i < str->m_NumberOfTasks; i += nThreads )
+    {
+      str->m_Task( i, str->m_TaskData );
+    }
+
+    return ITK_THREAD_RETURN_VALUE;
+  } // end ANNTaskThreaderCallback
+
+
   /**
    * ************************ CreateANNbdTree *************************
    */
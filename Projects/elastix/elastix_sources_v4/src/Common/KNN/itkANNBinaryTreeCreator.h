@@ -17,6 +17,7 @@
 
 #include "itkObject.h"
 #include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
 #include "ANN/ANN.h"
 
 namespace itk
@@ -63,9 +64,12 @@ namespace itk
      * this class with static creating functions.
      */
 
-    /** Static function to create an ANN kDTree. */
+    /** Static function to create an ANN kDTree. If numberOfThreads > 1,
+     * the subtrees below the top levels are built by an itk::MultiThreader.
+     * The resulting tree is the same as the one that is built by a single thread.
+     */
     static ANNkDTreeType * CreateANNkDTree( ANNPointArrayType pa, int n, int d, int bs = 1,
-      ANNSplitRuleType split = ANN_KD_SUGGEST );
+      ANNSplitRuleType split = ANN_KD_SUGGEST, unsigned int numberOfThreads = 1 );
 
     /** Static function to create an ANN bdTree. */
     static ANNbdTreeType * CreateANNbdTree( ANNPointArrayType pa, int n, int d, int bs = 1,
@@ -88,6 +92,15 @@ namespace itk
 
   protected:
 
+    /** The ANN task runner, which runs the tasks with the MultiThreader
+     * that is passed as runnerData.
+     */
+    static void RunANNTasks( int nTasks, ANNtaskFunction task,
+      void * taskData, void * runnerData );
+
+    /** The function that is called by the threader. */
+    static ITK_THREAD_RETURN_TYPE ANNTaskThreaderCallback( void * arg );
+
     ANNBinaryTreeCreator(){};
     virtual ~ANNBinaryTreeCreator(){};
 
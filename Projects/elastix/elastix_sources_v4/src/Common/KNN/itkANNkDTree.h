@@ -69,6 +69,11 @@ namespace itk
     void SetSplittingRule( std::string rule );
     std::string GetSplittingRule( void );
 
+    /** Set and get the number of threads that are used to build the tree.
+     * Default: 1. */
+    itkSetMacro( NumberOfThreads, unsigned int );
+    itkGetConstMacro( NumberOfThreads, unsigned int );
+
     /** Set the maximum number of points that are to be visited. */
     //void SetMaximumNumberOfPointsToVisit( unsigned int num )
     //{
@@ -99,6 +104,7 @@ namespace itk
     ANNkDTreeType *         m_ANNTree;
     SplittingRuleType       m_SplittingRule;
     BucketSizeType          m_BucketSize;
+    unsigned int            m_NumberOfThreads;
 
   private:
 
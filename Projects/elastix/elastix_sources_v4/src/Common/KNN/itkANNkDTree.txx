@@ -32,6 +32,7 @@ namespace itk
     this->m_ANNTree = 0;
     this->m_SplittingRule = ANN_KD_SL_MIDPT;
     this->m_BucketSize = 1;
+    this->m_NumberOfThreads = 1;
 
   } // end Constructor()
 
@@ -125,7 +126,8 @@ namespace itk
     ANNBinaryTreeCreator::DeleteANNkDTree( this->m_ANNTree );
 
     this->m_ANNTree = ANNBinaryTreeCreator::CreateANNkDTree(
-      this->GetSample()->GetInternalContainer(), nop, dim, bcs, this->m_SplittingRule );
+      this->GetSample()->GetInternalContainer(), nop, dim, bcs,
+      this->m_SplittingRule, this->m_NumberOfThreads );
 
   } // end GenerateTree()
 
@@ -144,6 +146,7 @@ namespace itk
     os << indent << "ANNTree: " << this->m_ANNTree << std::endl;
     os << indent << "SplittingRule: " << this->m_SplittingRule << std::endl;
     os << indent << "BucketSize: " << this->m_BucketSize << std::endl;
+    os << indent << "NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
 
   } // end PrintSelf()
 
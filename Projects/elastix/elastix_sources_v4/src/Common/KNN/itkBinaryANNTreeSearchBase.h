@@ -74,6 +74,12 @@ namespace itk
     BinaryANNTreeSearchBase();
     virtual ~BinaryANNTreeSearchBase();
 
+    /** The ANN search state is thread local if the compiler supports it. */
+    virtual bool GetSearchIsThreadSafe( void ) const
+    {
+      return ANN_THREAD_SAFE_SEARCH != 0;
+    }
+
     /** Member variables. */
     typename BinaryANNTreeType::Pointer m_BinaryTreeAsITKANNType;
 
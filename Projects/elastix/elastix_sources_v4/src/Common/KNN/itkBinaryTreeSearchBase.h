@@ -17,6 +17,8 @@
 
 #include "itkObject.h"
 #include "itkArray.h"
+#include "itkArray2D.h"
+#include "itkMultiThreader.h"
 
 #include "itkBinaryTreeBase.h"
 
@@ -28,6 +30,10 @@ namespace itk
    *
    * \brief
    *
+   * BatchSearch() searches the nearest neighbours of all points of a list
+   * sample. If the searcher supports it, this is done multi-threaded, using
+   * NumberOfThreads threads. Each thread searches a contiguous range of
+   * query points, so the results do not depend on the number of threads.
    *
    * \ingroup ANNwrap
    */
@@ -53,6 +59,8 @@ namespace itk
       MeasurementVectorType             MeasurementVectorType;
     typedef Array< int >                IndexArrayType;
     typedef Array< double >             DistanceArrayType;
+    typedef Array2D< int >              IndexMatrixType;
+    typedef Array2D< double >           DistanceMatrixType;
 
     /** Set and get the binary tree. */
     virtual void SetBinaryTree( BinaryTreeType * tree );
@@ -66,15 +74,54 @@ namespace itk
     virtual void Search( const MeasurementVectorType & qp, IndexArrayType & ind,
       DistanceArrayType & dists ) = 0;
 
+    /** Set and get the number of threads used by BatchSearch(). Default: 1. */
+    itkSetMacro( NumberOfThreads, unsigned int );
+    itkGetConstMacro( NumberOfThreads, unsigned int );
+
+    /** Search the nearest neighbours of the first numberOfQueries points of
+     * queries. Row i of ind and dists contains the result of Search() for
+     * query point i.
+     */
+    virtual void BatchSearch( const ListSampleType * queries,
+      unsigned long numberOfQueries,
+      IndexMatrixType & ind, DistanceMatrixType & dists );
+
   protected:
 
     BinaryTreeSearchBase();
     virtual ~BinaryTreeSearchBase();
 
+    /** Returns true if Search() may be called by several threads at the
+     * same time. Default: false. */
+    virtual bool GetSearchIsThreadSafe( void ) const
+    {
+      return false;
+    }
+
+    /** Search the query points in [begin, end). */
+    virtual void BatchSearchRange( const ListSampleType * queries,
+      unsigned long begin, unsigned long end,
+      IndexMatrixType & ind, DistanceMatrixType & dists );
+
+    /** The function that is called by the threader. */
+    static ITK_THREAD_RETURN_TYPE BatchSearchThreaderCallback( void * arg );
+
+    /** The data that is passed to the threads. */
+    struct BatchSearchThreaderStruct
+    {
+      Self *                  m_Searcher;
+      const ListSampleType *  m_Queries;
+      unsigned long           m_NumberOfQueries;
+      IndexMatrixType *       m_Indices;
+      DistanceMatrixType *    m_Distances;
+    };
+
     /** Member variables. */
     typename BinaryTreeType::Pointer    m_BinaryTree;
     unsigned int   m_KNearestNeighbors;
     unsigned int   m_DataDimension;
+    unsigned int   m_NumberOfThreads;
+    MultiThreader::Pointer  m_Threader;
 
   private:
 
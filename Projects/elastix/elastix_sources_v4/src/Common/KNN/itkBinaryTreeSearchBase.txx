@@ -30,6 +30,8 @@ namespace itk
   {
     this->m_BinaryTree = 0;
     this->m_KNearestNeighbors = 1;
+    this->m_NumberOfThreads = 1;
+    this->m_Threader = MultiThreader::New();
   } // end Constructor
 
 
@@ -77,6 +79,104 @@ namespace itk
   } // end GetBinaryTree
 
 
+  /**
+   * ************************ BatchSearch *************************
+   */
+
+  template < class TBinaryTree >
+    void BinaryTreeSearchBase<TBinaryTree>
+    ::BatchSearch( const ListSampleType * queries,
+      unsigned long numberOfQueries,
+      IndexMatrixType & ind, DistanceMatrixType & dists )
+  {
+    const unsigned long n = numberOfQueries;
+    const unsigned int k = this->m_KNearestNeighbors;
+    ind.SetSize( n, k );
+    dists.SetSize( n, k );
+    if ( n == 0 ) return;
+
+    /** Search single-threaded if the searcher does not support threads,
+     * or if there are not enough query points to make it worthwhile.
+     */
+    if ( this->m_NumberOfThreads <= 1 || !this->GetSearchIsThreadSafe()
+      || n < 2 * this->m_NumberOfThreads )
+    {
+      this->BatchSearchRange( queries, 0, n, ind, dists );
+      return;
+    }
+
+    BatchSearchThreaderStruct str;
+    str.m_Searcher = this;
+    str.m_Queries = queries;
+    str.m_NumberOfQueries = n;
+    str.m_Indices = &ind;
+    str.m_Distances = &dists;
+
+    this->m_Threader->SetNumberOfThreads( this->m_NumberOfThreads );
+    this->m_Threader->SetSingleMethod( BatchSearchThreaderCallback, &str );
+    this->m_Threader->SingleMethodExecute();
+
+  } // end BatchSearch
+
+
+  /**
+   * ************************ BatchSearchRange *************************
+   */
+
+  template < class TBinaryTree >
+    void BinaryTreeSearchBase<TBinaryTree>
+    ::BatchSearchRange( const ListSampleType * queries,
+      unsigned long begin, unsigned long end,
+      IndexMatrixType & ind, DistanceMatrixType & dists )
+  {
+    const unsigned int k = this->m_KNearestNeighbors;
+    MeasurementVectorType qp;
+    IndexArrayType indices;
+    DistanceArrayType distances;
+
+    for ( unsigned long i = begin; i < end; ++i )
+    {
+      queries->GetMeasurementVector( i, qp );
+      this->Search( qp, indices, distances );
+      for ( unsigned int p = 0; p < k; ++p )
+      {
+        ind[ i ][ p ] = indices[ p ];
+        dists[ i ][ p ] = distances[ p ];
+      }
+    }
+
+  } // end BatchSearchRange
+
+
+  /**
+   * ******************* BatchSearchThreaderCallback *******************
+   */
+
+  template < class TBinaryTree >
+    ITK_THREAD_RETURN_TYPE
+    BinaryTreeSearchBase<TBinaryTree>
+    ::BatchSearchThreaderCallback( void * arg )
+  {
+    typedef MultiThreader::ThreadInfoStruct ThreadInfoType;
+    ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>( arg );
+    const unsigned long threadID = infoStruct->ThreadID;
+    const unsigned long nThreads = infoStruct->NumberOfThreads;
+    BatchSearchThreaderStruct * str
+      = static_cast<BatchSearchThreaderStruct *>( infoStruct->UserData );
+
+    /** Compute the contiguous range of query points of this thread. */
+    const unsigned long n = str->m_NumberOfQueries;
+    const unsigned long begin = ( n * threadID ) / nThreads;
+    const unsigned long end = ( n * ( threadID + 1 ) ) / nThreads;
+
+    str->m_Searcher->BatchSearchRange( str->m_Queries, begin, end,
+      *( str->m_Indices ), *( str->m_Distances ) );
+
+    return ITK_THREAD_RETURN_VALUE;
+
+  } // end BatchSearchThreaderCallback
+
+
 } // end namespace itk
 
 
@@ -36,6 +36,7 @@ PURPOSE. See the above copyright notices for more information.
 #include "itkImage.h"
 #include "itkImageRegion.h"
 #include "itkBSplineInterpolationWeightFunction2.h"
+#include "itkBSplineKernelFunction2.h"
 #include "itkBSplineInterpolationDerivativeWeightFunction.h"
 #include "itkBSplineInterpolationSecondOrderDerivativeWeightFunction.h"
 
@@ -212,6 +213,10 @@ public:
     itkGetStaticConstMacro( SpaceDimension ),
     itkGetStaticConstMacro( SplineOrder ) >                 SODerivativeWeightsFunctionType;
 
+  /** The 1D B-spline kernel, used by TransformPoints(). */
+  typedef BSplineKernelFunction2<
+    itkGetStaticConstMacro( SplineOrder ) >                 KernelType;
+
   /** Parameter index array type. */
   typedef typename Superclass::ParameterIndexArrayType  ParameterIndexArrayType;
 
@@ -229,6 +234,18 @@ public:
     ParameterIndexArrayType & indices,
     bool & inside ) const;
 
+  /** Transform a batch of points. Instead of the tensor product of the
+   * weights and the parameter indices, only the 1D weights are computed,
+   * and the coefficients are summed dimension by dimension. The 1D weights
+   * of a dimension are reused when the grid coordinate in that dimension
+   * equals that of the previous point, as happens for the points along a
+   * line of an image. The result equals TransformPoint() up to rounding.
+   */
+  virtual void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    unsigned long numberOfPoints ) const;
+
   /** Get number of weights. */
   unsigned long GetNumberOfWeights( void ) const
   {
@@ -249,6 +266,11 @@ public:
     return true;
   }
 
+  /** The grid follows from the fixed parameters, the coefficients from the
+   * parameters. Returns false if a bulk transform other than the identity
+   * is set, since that is not copied. */
+  virtual bool GetIsDefinedByParameters( void ) const;
+
   /** Compute the Jacobian matrix of the transformation at one point. */
   virtual const JacobianType & GetJacobian( const InputPointType & point ) const;
 
@@ -336,6 +358,11 @@ protected:
   std::vector< std::vector<
     typename SODerivativeWeightsFunctionType::Pointer > > m_SODerivativeWeightsFunctions;
 
+  /** The 1D kernel used by TransformPoints(). Its Evaluate() is const and
+   * keeps no state, so it is shared by concurrent calls.
+   */
+  typename KernelType::Pointer                            m_Kernel;
+
 private:
   AdvancedBSplineDeformableTransform(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
@@ -64,6 +64,7 @@ AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>
     }
   }
   this->m_SupportSize = this->m_WeightsFunction->GetSupportSize();
+  this->m_Kernel = KernelType::New();
 
   // Instantiate an identity transform
   typedef IdentityTransform<ScalarType, SpaceDimension> IdentityTransformType;
@@ -299,40 +300,61 @@ AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>
   this->m_WeightsFunction->Evaluate( cindex, supportIndex, weights );
 
   // For each dimension, correlate coefficient with weights
-  RegionType supportRegion;
-  supportRegion.SetSize( this->m_SupportSize );
-  supportRegion.SetIndex( supportIndex );
-
   outputPoint.Fill( NumericTraits<ScalarType>::Zero );
 
-  /** Create iterators over the coefficient images. */
-  typedef ImageRegionConstIterator<ImageType> IteratorType;
-  IteratorType iterator[ SpaceDimension ];
-  unsigned long counter = 0;
-  const PixelType * basePointer
-    = this->m_CoefficientImage[ 0 ]->GetBufferPointer();
-
+  /** Get the base pointers of the coefficient images. */
+  const PixelType * basePointers[ SpaceDimension ];
   for ( unsigned int j = 0; j < SpaceDimension; j++ )
   {
-    iterator[ j ] = IteratorType( this->m_CoefficientImage[ j ], supportRegion );
+    basePointers[ j ] = this->m_CoefficientImage[ j ]->GetBufferPointer();
   }
 
-  /** Loop over the support region. */
-  while ( !iterator[ 0 ].IsAtEnd() )
+  /** Loop over the support region, row by row. The coefficients in a row
+   * along the first dimension are contiguous in memory, and so are the
+   * corresponding weights.
+   */
+  const unsigned long rowLength = this->m_SupportSize[ 0 ];
+  const unsigned long numberOfRows
+    = WeightsFunctionType::NumberOfWeights / rowLength;
+  IndexType rowIndex = supportIndex;
+  unsigned long counter = 0;
+  for ( unsigned long row = 0; row < numberOfRows; ++row )
   {
+    const unsigned long rowOffset
+      = this->m_CoefficientImage[ 0 ]->ComputeOffset( rowIndex );
+
     // populate the indices array
-    indices[ counter ] = &(iterator[ 0 ].Value()) - basePointer;
+    for ( unsigned long k = 0; k < rowLength; ++k )
+    {
+      indices[ counter + k ] = rowOffset + k;
+    }
 
     // multiply weigth with coefficient to compute displacement
+    const double * rowWeights = &( weights[ counter ] );
     for ( unsigned int j = 0; j < SpaceDimension; j++ )
     {
-       outputPoint[ j ] += static_cast<ScalarType>(
-         weights[ counter ] * iterator[ j ].Value() );
-       ++iterator[ j ];
+      const PixelType * rowCoefficients = basePointers[ j ] + rowOffset;
+      for ( unsigned long k = 0; k < rowLength; ++k )
+      {
+        outputPoint[ j ] += static_cast<ScalarType>(
+          rowWeights[ k ] * rowCoefficients[ k ] );
+      }
+    }
+    counter += rowLength;
+
+    /** Go to the next row. */
+    for ( unsigned int j = 1; j < SpaceDimension; j++ )
+    {
+      ++rowIndex[ j ];
+      if ( rowIndex[ j ] < supportIndex[ j ]
+        + static_cast<typename IndexType::IndexValueType>( this->m_SupportSize[ j ] ) )
+      {
+        break;
+      }
+      rowIndex[ j ] = supportIndex[ j ];
     }
-    ++ counter;
 
-  } // end while
+  } // end for
 
   // The output point is the start point + displacement.
   for ( unsigned int j = 0; j < SpaceDimension; j++ )
@@ -365,6 +387,158 @@ AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>
 }
 
 
+/**
+ * ********************* GetIsDefinedByParameters ****************************
+ */
+
+template<class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
+bool
+AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>
+::GetIsDefinedByParameters( void ) const
+{
+  typedef IdentityTransform<ScalarType, SpaceDimension> IdentityTransformType;
+  return this->m_BulkTransform.IsNull()
+    || dynamic_cast<const IdentityTransformType *>(
+    this->m_BulkTransform.GetPointer() ) != 0;
+
+} // end GetIsDefinedByParameters()
+
+
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template<class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  unsigned long numberOfPoints ) const
+{
+  /** Without coefficients TransformPoint() warns and returns the input. */
+  if ( !this->m_CoefficientImage[ 0 ] )
+  {
+    this->Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+  }
+
+  typedef typename KernelType::WeightArrayType  OneDWeightsType;
+  typedef typename IndexType::IndexValueType    IndexValueType;
+  const KernelType * kernel = this->m_Kernel.GetPointer();
+
+  /** Get the base pointers of the coefficient images. */
+  const PixelType * basePointers[ SpaceDimension ];
+  for ( unsigned int j = 0; j < SpaceDimension; j++ )
+  {
+    basePointers[ j ] = this->m_CoefficientImage[ j ]->GetBufferPointer();
+  }
+  const unsigned long rowLength = this->m_SupportSize[ 0 ];
+  const unsigned long numberOfRows
+    = WeightsFunctionType::NumberOfWeights / rowLength;
+
+  /** The 1D weights of the previous point. */
+  OneDWeightsType weights1D[ SpaceDimension ];
+  ContinuousIndexType previousCIndex;
+  bool previousIsValid = false;
+
+  InputPointType transformedPoint;
+  ContinuousIndexType cindex;
+  IndexType supportIndex;
+  double displacement[ SpaceDimension ];
+  for ( unsigned long i = 0; i < numberOfPoints; ++i )
+  {
+    /** Take care of the initial transform. */
+    if ( this->m_BulkTransform )
+    {
+      transformedPoint = this->m_BulkTransform->TransformPoint( inputPoints[ i ] );
+    }
+    else
+    {
+      transformedPoint = inputPoints[ i ];
+    }
+    OutputPointType & outputPoint = outputPoints[ i ];
+
+    /** Outside the valid region the displacement is zero. */
+    this->TransformPointToContinuousGridIndex( transformedPoint, cindex );
+    if ( !this->InsideValidRegion( cindex ) )
+    {
+      for ( unsigned int j = 0; j < SpaceDimension; j++ )
+      {
+        outputPoint[ j ] = transformedPoint[ j ];
+      }
+      continue;
+    }
+
+    /** Compute the 1D weights, unless they equal those of the previous point.
+     * The weights of a dimension only depend on the grid coordinate in that
+     * dimension. */
+    this->m_WeightsFunction->ComputeStartIndex( cindex, supportIndex );
+    for ( unsigned int d = 0; d < SpaceDimension; d++ )
+    {
+      if ( !previousIsValid || cindex[ d ] != previousCIndex[ d ] )
+      {
+        kernel->Evaluate( cindex[ d ]
+          - static_cast<double>( supportIndex[ d ] ), weights1D[ d ] );
+      }
+    }
+    previousCIndex = cindex;
+    previousIsValid = true;
+
+    /** Loop over the support region, row by row. Each row is first summed
+     * with the weights of the first dimension, and then multiplied by the
+     * product of the weights of the other dimensions. */
+    for ( unsigned int j = 0; j < SpaceDimension; j++ )
+    {
+      displacement[ j ] = 0.0;
+    }
+    IndexType rowIndex = supportIndex;
+    for ( unsigned long row = 0; row < numberOfRows; ++row )
+    {
+      const unsigned long rowOffset
+        = this->m_CoefficientImage[ 0 ]->ComputeOffset( rowIndex );
+      double rowWeight = 1.0;
+      for ( unsigned int d = 1; d < SpaceDimension; d++ )
+      {
+        rowWeight *= weights1D[ d ][ rowIndex[ d ] - supportIndex[ d ] ];
+      }
+
+      for ( unsigned int j = 0; j < SpaceDimension; j++ )
+      {
+        const PixelType * rowCoefficients = basePointers[ j ] + rowOffset;
+        double rowSum = 0.0;
+        for ( unsigned long k = 0; k < rowLength; ++k )
+        {
+          rowSum += weights1D[ 0 ][ k ] * rowCoefficients[ k ];
+        }
+        displacement[ j ] += rowWeight * rowSum;
+      }
+
+      /** Go to the next row. */
+      for ( unsigned int d = 1; d < SpaceDimension; d++ )
+      {
+        ++rowIndex[ d ];
+        if ( rowIndex[ d ] < supportIndex[ d ]
+          + static_cast<IndexValueType>( this->m_SupportSize[ d ] ) )
+        {
+          break;
+        }
+        rowIndex[ d ] = supportIndex[ d ];
+      }
+    } // end for rows
+
+    /** The output point is the start point + displacement. */
+    for ( unsigned int j = 0; j < SpaceDimension; j++ )
+    {
+      outputPoint[ j ] = transformedPoint[ j ]
+        + static_cast<ScalarType>( displacement[ j ] );
+    }
+
+  } // end for points
+
+} // end TransformPoints()
+
+
 // Compute the Jacobian in one position
 template<class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
 const
@@ -1358,35 +1532,49 @@ AdvancedBSplineDeformableTransform<TScalarType, NDimensions,VSplineOrder>
 {
   nonZeroJacobianIndices.resize( this->GetNumberOfNonZeroJacobianIndices() );
 
-  /** Create an iterator over the coefficient image. */
-  ImageRegionConstIterator< ImageType >
-    it( this->m_CoefficientImage[ 0 ], supportRegion );
-
   /** Initialize some helper variables. */
   const unsigned long numberOfWeights = WeightsFunctionType::NumberOfWeights;
   const unsigned long parametersPerDim
     = this->GetNumberOfParametersPerDimension();
+  const IndexType & supportIndex = supportRegion.GetIndex();
+  const SizeType & supportSize = supportRegion.GetSize();
+  const unsigned long rowLength = supportSize[ 0 ];
+  IndexType rowIndex = supportIndex;
   unsigned long mu = 0;
 
   /** For all control points in the support region, set which of the
-   * indices in the parameter array are non-zero.
+   * indices in the parameter array are non-zero. The support region is
+   * traversed row by row; the parameters in a row along the first
+   * dimension are consecutive.
    */
-  const PixelType * basePointer = this->m_CoefficientImage[0]->GetBufferPointer();
-
-  while ( !it.IsAtEnd() )
+  while ( mu < numberOfWeights )
   {
-    unsigned long parameterNumber = &(it.Value()) - basePointer;
+    const unsigned long rowOffset
+      = this->m_CoefficientImage[ 0 ]->ComputeOffset( rowIndex );
 
     /** Update the nonZeroJacobianIndices for all directions. */
     for ( unsigned int dim = 0; dim < SpaceDimension; ++dim )
     {
-      nonZeroJacobianIndices[ mu + dim * numberOfWeights ]
-        = parameterNumber + dim * parametersPerDim;
+      unsigned long parameterNumber = rowOffset + dim * parametersPerDim;
+      unsigned long * nzjiPointer = &( nonZeroJacobianIndices[ mu + dim * numberOfWeights ] );
+      for ( unsigned long k = 0; k < rowLength; ++k )
+      {
+        nzjiPointer[ k ] = parameterNumber + k;
+      }
     }
+    mu += rowLength;
 
-    /** Increase the iterators. */
-    ++it;
-    ++mu;
+    /** Go to the next row. */
+    for ( unsigned int dim = 1; dim < SpaceDimension; ++dim )
+    {
+      ++rowIndex[ dim ];
+      if ( rowIndex[ dim ] < supportIndex[ dim ]
+        + static_cast<typename IndexType::IndexValueType>( supportSize[ dim ] ) )
+      {
+        break;
+      }
+      rowIndex[ dim ] = supportIndex[ dim ];
+    }
 
   } // end while
 
@@ -121,6 +121,14 @@ public:
   /**  Method to transform a point. */
   virtual OutputPointType TransformPoint( const InputPointType  & point ) const;
 
+  /** Method to transform a batch of points. The batch is passed on to the
+   * batch methods of the initial and current transform.
+   */
+  virtual void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    unsigned long numberOfPoints ) const;
+
   /** Return the number of parameters that completely define the CurrentTransform. */
   virtual unsigned int GetNumberOfParameters( void ) const;
 
@@ -164,6 +172,14 @@ public:
   virtual bool GetHasNonZeroSpatialHessian( void ) const;
   virtual bool HasNonZeroJacobianOfSpatialHessian( void ) const;
 
+  /** Returns whether the current transform is defined by its parameters.
+   * The initial transform is not optimized, so a copy may share it. */
+  virtual bool GetIsDefinedByParameters( void ) const
+  {
+    return this->m_CurrentTransform.IsNotNull()
+      && this->m_CurrentTransform->GetIsDefinedByParameters();
+  }
+
   /** Compute the Jacobian of the transformation. */
   virtual const JacobianType & GetJacobian( const InputPointType & point ) const;
 
@@ -173,6 +189,13 @@ public:
     JacobianType & j,
     NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const;
 
+  /** Compute the (sparse) Jacobians of a batch of points. */
+  virtual void GetJacobians(
+    const InputPointType * inputPoints,
+    JacobianType * jacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    unsigned long numberOfPoints ) const;
+
   /** Compute the spatial Jacobian of the transformation. */
   virtual void GetSpatialJacobian(
     const InputPointType & ipp,
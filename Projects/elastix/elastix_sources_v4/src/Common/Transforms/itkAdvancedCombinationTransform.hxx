@@ -1475,6 +1475,57 @@ AdvancedCombinationTransform<TScalarType, NDimensions>
 } // end TransformPoint()
 
 
+/**
+ * ****************** TransformPoints ****************************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  unsigned long numberOfPoints ) const
+{
+  if ( this->m_CurrentTransform.IsNull() )
+  {
+    this->NoCurrentTransformSet();
+  }
+  else if ( this->m_InitialTransform.IsNull() )
+  {
+    this->m_CurrentTransform->TransformPoints(
+      inputPoints, outputPoints, numberOfPoints );
+  }
+  else if ( numberOfPoints > 0 )
+  {
+    std::vector< OutputPointType > initialPoints( numberOfPoints );
+    this->m_InitialTransform->TransformPoints(
+      inputPoints, &( initialPoints[ 0 ] ), numberOfPoints );
+
+    if ( this->m_UseAddition )
+    {
+      /** Same as TransformPointUseAddition(). */
+      this->m_CurrentTransform->TransformPoints(
+        inputPoints, outputPoints, numberOfPoints );
+      for ( unsigned long i = 0; i < numberOfPoints; ++i )
+      {
+        for ( unsigned int d = 0; d < SpaceDimension; ++d )
+        {
+          outputPoints[ i ][ d ] += ( initialPoints[ i ][ d ] - inputPoints[ i ][ d ] );
+        }
+      }
+    }
+    else
+    {
+      /** Same as TransformPointUseComposition(). */
+      this->m_CurrentTransform->TransformPoints(
+        &( initialPoints[ 0 ] ), outputPoints, numberOfPoints );
+    }
+  }
+
+} // end TransformPoints()
+
+
 /**
  * ****************** GetJacobian ****************************
  */
@@ -1509,6 +1560,42 @@ AdvancedCombinationTransform<TScalarType, NDimensions>
 } // end GetJacobian()
 
 
+/**
+ * ****************** GetJacobians ****************************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>
+::GetJacobians(
+  const InputPointType * inputPoints,
+  JacobianType * jacobians,
+  NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+  unsigned long numberOfPoints ) const
+{
+  if ( this->m_CurrentTransform.IsNull() )
+  {
+    this->NoCurrentTransformSet();
+  }
+  else if ( this->m_InitialTransform.IsNull() || this->m_UseAddition )
+  {
+    /** The initial transform does not depend on the parameters. */
+    this->m_CurrentTransform->GetJacobians(
+      inputPoints, jacobians, nonZeroJacobianIndices, numberOfPoints );
+  }
+  else if ( numberOfPoints > 0 )
+  {
+    /** Composition: evaluate at the initially transformed points. */
+    std::vector< OutputPointType > initialPoints( numberOfPoints );
+    this->m_InitialTransform->TransformPoints(
+      inputPoints, &( initialPoints[ 0 ] ), numberOfPoints );
+    this->m_CurrentTransform->GetJacobians( &( initialPoints[ 0 ] ),
+      jacobians, nonZeroJacobianIndices, numberOfPoints );
+  }
+
+} // end GetJacobians()
+
+
 /**
  * ****************** GetSpatialJacobian ****************************
  */
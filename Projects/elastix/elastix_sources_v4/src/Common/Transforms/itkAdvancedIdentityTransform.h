@@ -193,6 +193,9 @@ public:
    */
   virtual bool IsLinear() const { return true; }
 
+  /** There is nothing to copy. */
+  virtual bool GetIsDefinedByParameters( void ) const { return true; }
+
   /** Get the Fixed Parameters. */
   virtual const ParametersType& GetFixedParameters(void) const
     {
@@ -331,6 +331,14 @@ public:
   OutputCovariantVectorType TransformCovariantVector(
     const InputCovariantVectorType & vector ) const;
 
+  /** Transform a batch of points. The matrix and offset are applied
+   * directly, without a function call per point.
+   */
+  virtual void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    unsigned long numberOfPoints ) const;
+
   /** Create inverse of an affine transformation
     *
     * This populates the parameters an affine transform such that
@@ -365,6 +373,12 @@ public:
     return true;
   }
 
+  /** The matrix, offset and center follow from the (fixed) parameters. */
+  virtual bool GetIsDefinedByParameters( void ) const
+  {
+    return true;
+  }
+
   /** Compute the Jacobian of the transformation */
   const JacobianType & GetJacobian( const InputPointType & point ) const;
 
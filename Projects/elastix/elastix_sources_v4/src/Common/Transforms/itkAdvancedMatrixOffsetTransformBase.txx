@@ -261,6 +261,36 @@ AdvancedMatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensio
 }
 
 
+// Transform a batch of points
+template<class TScalarType, unsigned int NInputDimensions,
+                            unsigned int NOutputDimensions>
+void
+AdvancedMatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensions>
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  unsigned long numberOfPoints ) const
+{
+  /** Same arithmetic as m_Matrix * point + m_Offset. */
+  const MatrixType & matrix = this->m_Matrix;
+  const OffsetType & offset = this->m_Offset;
+  for ( unsigned long i = 0; i < numberOfPoints; ++i )
+  {
+    const InputPointType & point = inputPoints[ i ];
+    OutputPointType & outputPoint = outputPoints[ i ];
+    for ( unsigned int r = 0; r < NOutputDimensions; ++r )
+    {
+      ScalarType sum = NumericTraits<ScalarType>::Zero;
+      for ( unsigned int c = 0; c < NInputDimensions; ++c )
+      {
+        sum += matrix( r, c ) * point[ c ];
+      }
+      outputPoint[ r ] = sum + offset[ r ];
+    }
+  }
+}
+
+
 // Transform a vector
 template<class TScalarType, unsigned int NInputDimensions,
                             unsigned int NOutputDimensions>
@@ -139,6 +139,16 @@ public:
   itkGetConstMacro( HasNonZeroSpatialHessian, bool );
   itkGetConstMacro( HasNonZeroJacobianOfSpatialHessian, bool );
 
+  /** Whether a transform of the same type, created with CreateAnother(),
+   * equals this transform once the fixed parameters and the parameters
+   * are copied. Only then can AdvancedImageToImageMetric::CreateConcurrentCopies()
+   * copy the transform. By default false.
+   */
+  virtual bool GetIsDefinedByParameters( void ) const
+  {
+    return false;
+  }
+
   /** This returns a sparse version of the Jacobian of the transformation.
    *
    * The Jacobian is expressed as a vector of partial derivatives of the
@@ -176,6 +186,30 @@ public:
    */
   virtual const JacobianType & GetJacobian( const InputPointType & ) const;
 
+  /** Transform a batch of points: outputPoints[ i ] = T( inputPoints[ i ] ),
+   * for i = 0, ..., numberOfPoints - 1. Both arrays should hold numberOfPoints
+   * points, and should not overlap.
+   *
+   * The default implementation calls TransformPoint() for each point.
+   * Subclasses may override it to avoid the per point overhead.
+   */
+  virtual void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    unsigned long numberOfPoints ) const;
+
+  /** Compute the sparse Jacobians of a batch of points, see GetJacobian().
+   * The arrays jacobians and nonZeroJacobianIndices should hold
+   * numberOfPoints elements.
+   *
+   * The default implementation calls GetJacobian() for each point.
+   */
+  virtual void GetJacobians(
+    const InputPointType * inputPoints,
+    JacobianType * jacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    unsigned long numberOfPoints ) const;
+
 	/** Compute the spatial Jacobian of the transformation.
    *
    * The spatial Jacobian is expressed as a vector of partial derivatives of the
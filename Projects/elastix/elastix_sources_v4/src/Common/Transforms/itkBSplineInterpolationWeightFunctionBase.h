@@ -153,6 +153,15 @@ protected:
     const IndexType & startIndex,
     OneDWeightsType & weights1D ) const = 0;
 
+  /** Compute the weights over the support region as the tensor product of
+   * the 1D weights. The first dimension runs fastest, as in the
+   * m_OffsetToIndexTable. For cubic splines vector instructions are used,
+   * when available.
+   */
+  void ComputeTensorProductOfWeights(
+    const OneDWeightsType & weights1D,
+    WeightsType & weights ) const;
+
   /** Print the member variables. */
   virtual void PrintSelf( std::ostream & os, Indent indent ) const;
 
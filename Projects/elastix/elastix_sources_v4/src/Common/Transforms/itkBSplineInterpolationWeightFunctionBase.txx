@@ -196,18 +196,77 @@ BSplineInterpolationWeightFunctionBase<TCoordRep,VSpaceDimension, VSplineOrder>
   this->Compute1DWeights( cindex, startIndex, weights1D );
 
   /** Compute the vector of weights. */
-  for ( unsigned int k = 0; k < this->m_NumberOfWeights; k++ )
+  this->ComputeTensorProductOfWeights( weights1D, weights );
+
+} // end Evaluate()
+
+
+/**
+ * ******************* ComputeTensorProductOfWeights *******************
+ */
+
+template<class TCoordRep, unsigned int VSpaceDimension, unsigned int VSplineOrder>
+void
+BSplineInterpolationWeightFunctionBase<TCoordRep,VSpaceDimension, VSplineOrder>
+::ComputeTensorProductOfWeights(
+  const OneDWeightsType & weights1D,
+  WeightsType & weights ) const
+{
+  const unsigned int supportSize = SplineOrder + 1;
+  double * weightsPointer = weights.data_block();
+
+  /** Start with the weights of the first dimension. */
+  for ( unsigned int k = 0; k < supportSize; ++k )
   {
-    double tmp1 = 1.0;
-    const unsigned long * tmp2 = this->m_OffsetToIndexTable[ k ];
-    for ( unsigned int j = 0; j < SpaceDimension; j++ )
+    weightsPointer[ k ] = weights1D[ 0 ][ k ];
+  }
+
+  /** Add the other dimensions one by one. Block k of the new weights equals
+   * the current weights multiplied by the k-th 1D weight. The blocks are
+   * filled backwards, so that block 0, which holds the current weights,
+   * is overwritten last. The products are evaluated in the same order as
+   * w0 * w1 * ... * wD, so the result does not depend on the implementation.
+   */
+  unsigned long blockSize = supportSize;
+  for ( unsigned int j = 1; j < SpaceDimension; ++j )
+  {
+    for ( unsigned int k = supportSize; k-- > 0; )
     {
-      tmp1 *= weights1D[ j ][ tmp2[ j ] ];
+      const double weight1D = weights1D[ j ][ k ];
+      double * block = weightsPointer + k * blockSize;
+      unsigned long i = 0;
+
+      /** For cubic splines the block size is a multiple of four. */
+#if defined( ELASTIX_BSPLINE_USE_AVX )
+      if ( SplineOrder == 3 )
+      {
+        const __m256d w = _mm256_set1_pd( weight1D );
+        for ( ; i < blockSize; i += 4 )
+        {
+          _mm256_storeu_pd( block + i,
+            _mm256_mul_pd( _mm256_loadu_pd( weightsPointer + i ), w ) );
+        }
+      }
+#elif defined( ELASTIX_BSPLINE_USE_SSE2 )
+      if ( SplineOrder == 3 )
+      {
+        const __m128d w = _mm_set1_pd( weight1D );
+        for ( ; i < blockSize; i += 2 )
+        {
+          _mm_storeu_pd( block + i,
+            _mm_mul_pd( _mm_loadu_pd( weightsPointer + i ), w ) );
+        }
+      }
+#endif
+      for ( ; i < blockSize; ++i )
+      {
+        block[ i ] = weightsPointer[ i ] * weight1D;
+      }
     }
-    weights[ k ] = tmp1;
+    blockSize *= supportSize;
   }
 
-} // end Evaluate()
+} // end ComputeTensorProductOfWeights()
 
 
 } // end namespace itk
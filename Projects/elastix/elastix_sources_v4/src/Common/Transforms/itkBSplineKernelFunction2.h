@@ -20,6 +20,19 @@
 #include "itkKernelFunction.h"
 #include "vnl/vnl_math.h"
 
+/** Select the vector instructions used for the cubic B-spline weights.
+ * They are only used when the compiler targets them, e.g. with -msse2 or
+ * -mavx for gcc, or /arch:AVX for Visual Studio.
+ */
+#if defined( __AVX__ )
+#define ELASTIX_BSPLINE_USE_AVX
+#include <immintrin.h>
+#elif defined( __SSE2__ ) || defined( _M_X64 ) \
+  || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define ELASTIX_BSPLINE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace itk
 {
 
@@ -34,6 +47,10 @@ namespace itk
  * This class is templated over the spline order.
  * \warning Evaluate is only implemented for spline order 0 to 3
  *
+ * For the third order spline the weights of the entire support are
+ * computed with AVX or SSE2 instructions, when available. The results
+ * are identical to the scalar implementation.
+ *
  * \sa KernelFunction
  *
  * \ingroup Functions
@@ -195,10 +212,44 @@ private:
     const double uu  = vnl_math_sqr( u );
     const double uuu = uu * u;
 
+#if defined( ELASTIX_BSPLINE_USE_AVX )
+    /** All four weights in one register: w = ( c0 + c1 u + c2 u^2 + c3 u^3 ) / 6. */
+    const __m256d c0 = _mm256_setr_pd(   8.0,  -5.0,   4.0, -1.0 );
+    const __m256d c1 = _mm256_setr_pd( -12.0,  21.0, -12.0,  3.0 );
+    const __m256d c2 = _mm256_setr_pd(   6.0, -15.0,  12.0, -3.0 );
+    const __m256d c3 = _mm256_setr_pd(  -1.0,   3.0,  -3.0,  1.0 );
+
+    __m256d w = _mm256_add_pd( c0, _mm256_mul_pd( c1, _mm256_set1_pd( u ) ) );
+    w = _mm256_add_pd( w, _mm256_mul_pd( c2, _mm256_set1_pd( uu ) ) );
+    w = _mm256_add_pd( w, _mm256_mul_pd( c3, _mm256_set1_pd( uuu ) ) );
+    _mm256_storeu_pd( weights.GetDataPointer(),
+      _mm256_div_pd( w, _mm256_set1_pd( 6.0 ) ) );
+#elif defined( ELASTIX_BSPLINE_USE_SSE2 )
+    /** Two weights per register: w = ( c0 + c1 u + c2 u^2 + c3 u^3 ) / 6. */
+    const __m128d vu   = _mm_set1_pd( u );
+    const __m128d vuu  = _mm_set1_pd( uu );
+    const __m128d vuuu = _mm_set1_pd( uuu );
+    const __m128d six  = _mm_set1_pd( 6.0 );
+
+    __m128d w01 = _mm_add_pd( _mm_setr_pd( 8.0, -5.0 ),
+      _mm_mul_pd( _mm_setr_pd( -12.0, 21.0 ), vu ) );
+    w01 = _mm_add_pd( w01, _mm_mul_pd( _mm_setr_pd( 6.0, -15.0 ), vuu ) );
+    w01 = _mm_add_pd( w01, _mm_mul_pd( _mm_setr_pd( -1.0, 3.0 ), vuuu ) );
+
+    __m128d w23 = _mm_add_pd( _mm_setr_pd( 4.0, -1.0 ),
+      _mm_mul_pd( _mm_setr_pd( -12.0, 3.0 ), vu ) );
+    w23 = _mm_add_pd( w23, _mm_mul_pd( _mm_setr_pd( 12.0, -3.0 ), vuu ) );
+    w23 = _mm_add_pd( w23, _mm_mul_pd( _mm_setr_pd( -3.0, 1.0 ), vuuu ) );
+
+    double * weightsPointer = weights.GetDataPointer();
+    _mm_storeu_pd( weightsPointer, _mm_div_pd( w01, six ) );
+    _mm_storeu_pd( weightsPointer + 2, _mm_div_pd( w23, six ) );
+#else
     weights[ 0 ] = ( 8.0 - 12 * u + 6.0 * uu - uuu ) / 6.0;
     weights[ 1 ] = ( -5.0 + 21.0 * u - 15.0 * uu + 3.0 * uuu ) / 6.0;
     weights[ 2 ] = ( 4.0 - 12.0 * u + 12.0 * uu - 3.0 * uuu ) / 6.0;
     weights[ 3 ] = ( -1.0 + 3.0 * u - 3.0 * uu + uuu ) / 6.0;
+#endif
   }
 
   /** Unimplemented spline order. */
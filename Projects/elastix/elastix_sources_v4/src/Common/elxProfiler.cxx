@@ -0,0 +1,658 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+#ifndef __elxProfiler_CXX_
+#define __elxProfiler_CXX_
+
+#include "elxProfiler.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <utility>
+#include <vector>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace tmr
+{
+
+/**
+ * \class ProfilerNode
+ * \brief A scope or counter in the tree of the Profiler.
+ */
+
+class ProfilerNode
+{
+public:
+
+  typedef std::vector< ProfilerNode * >   ChildrenType;
+
+  ProfilerNode( const char * name, ProfilerNode * parent, bool isCounter )
+  {
+    this->m_Name = name;
+    this->m_Parent = parent;
+    this->m_IsCounter = isCounter;
+    this->m_IsThreaded = false;
+    this->m_NumberOfCalls = 0;
+    this->m_TotalTime = 0.0;
+    this->m_Count = 0;
+  }
+
+  ~ProfilerNode()
+  {
+    for ( unsigned int i = 0; i < this->m_Children.size(); ++i )
+    {
+      delete this->m_Children[ i ];
+    }
+  }
+
+  /** Find the child with this name, or create it. Names are usually
+   * string literals, so comparing the pointers is mostly sufficient.
+   */
+  ProfilerNode * GetChild( const char * name, bool isCounter )
+  {
+    for ( unsigned int i = 0; i < this->m_Children.size(); ++i )
+    {
+      ProfilerNode * child = this->m_Children[ i ];
+      if ( child->m_IsCounter == isCounter
+        && ( child->m_Name == name || std::strcmp( child->m_Name, name ) == 0 ) )
+      {
+        return child;
+      }
+    }
+    ProfilerNode * child = new ProfilerNode( name, this, isCounter );
+    this->m_Children.push_back( child );
+    return child;
+  }
+
+  /** Set the statistics of this node and its children to zero. */
+  void Reset( void )
+  {
+    this->m_NumberOfCalls = 0;
+    this->m_TotalTime = 0.0;
+    this->m_Count = 0;
+    for ( unsigned int i = 0; i < this->m_Children.size(); ++i )
+    {
+      this->m_Children[ i ]->Reset();
+    }
+  }
+
+  /** Whether this node or one of its children was used since the last reset. */
+  bool IsActive( void ) const
+  {
+    if ( this->m_NumberOfCalls > 0 || this->m_Count > 0 ) return true;
+    for ( unsigned int i = 0; i < this->m_Children.size(); ++i )
+    {
+      if ( this->m_Children[ i ]->IsActive() ) return true;
+    }
+    return false;
+  }
+
+  const char *    m_Name;
+  ProfilerNode *  m_Parent;
+  ChildrenType    m_Children;
+  bool            m_IsCounter;
+  bool            m_IsThreaded;
+  unsigned long   m_NumberOfCalls;
+  double          m_TotalTime;
+  unsigned long   m_Count;
+
+}; // end class ProfilerNode
+
+
+/**
+ * \class ProfilerThreadRecord
+ * \brief The scopes of a thread other than the main thread.
+ *
+ * The scopes are kept in a separate tree for each scope of the main
+ * thread under which they were entered, the anchor. A record is used by
+ * one thread at a time, so it needs no lock.
+ */
+
+class ProfilerThreadRecord
+{
+public:
+
+  typedef std::pair< ProfilerNode *, ProfilerNode * >   AnchoredRootType;
+  typedef std::vector< AnchoredRootType >               RootsType;
+
+  ProfilerThreadRecord()
+  {
+    this->m_Current = 0;
+    this->m_Depth = 0;
+  }
+
+  ~ProfilerThreadRecord()
+  {
+    for ( unsigned int i = 0; i < this->m_Roots.size(); ++i )
+    {
+      delete this->m_Roots[ i ].second;
+    }
+  }
+
+  /** Get the root of the scopes under this anchor, or create it. */
+  ProfilerNode * GetRoot( ProfilerNode * anchor )
+  {
+    for ( unsigned int i = 0; i < this->m_Roots.size(); ++i )
+    {
+      if ( this->m_Roots[ i ].first == anchor )
+      {
+        return this->m_Roots[ i ].second;
+      }
+    }
+    ProfilerNode * root = new ProfilerNode( anchor->m_Name, 0, false );
+    this->m_Roots.push_back( AnchoredRootType( anchor, root ) );
+    return root;
+  }
+
+  /** Set the statistics of all scopes to zero. */
+  void Reset( void )
+  {
+    for ( unsigned int i = 0; i < this->m_Roots.size(); ++i )
+    {
+      this->m_Roots[ i ].second->Reset();
+    }
+  }
+
+  RootsType       m_Roots;
+  ProfilerNode *  m_Current;
+  unsigned int    m_Depth;
+
+}; // end class ProfilerThreadRecord
+
+
+/**
+ * ********************* Static variables ****************************
+ */
+
+bool Profiler::m_Enabled = false;
+
+namespace
+{
+
+#if defined( _WIN32 )
+typedef DWORD ThreadIdType;
+typedef DWORD ThreadKeyType;
+ThreadIdType GetCallingThreadId( void ) { return GetCurrentThreadId(); }
+bool IsSameThread( ThreadIdType a, ThreadIdType b ) { return a == b; }
+void CreateThreadKey( ThreadKeyType & key ) { key = TlsAlloc(); }
+void * GetThreadValue( ThreadKeyType key ) { return TlsGetValue( key ); }
+void SetThreadValue( ThreadKeyType key, void * value ) { TlsSetValue( key, value ); }
+#else
+typedef pthread_t ThreadIdType;
+typedef pthread_key_t ThreadKeyType;
+ThreadIdType GetCallingThreadId( void ) { return pthread_self(); }
+bool IsSameThread( ThreadIdType a, ThreadIdType b ) { return pthread_equal( a, b ) != 0; }
+void CreateThreadKey( ThreadKeyType & key ) { pthread_key_create( &key, 0 ); }
+void * GetThreadValue( ThreadKeyType key ) { return pthread_getspecific( key ); }
+void SetThreadValue( ThreadKeyType key, void * value ) { pthread_setspecific( key, value ); }
+#endif
+
+typedef std::vector< ProfilerThreadRecord * >   ThreadRecordContainerType;
+
+/** The tree of the main thread, its active scope, and the main thread.
+ * The main thread locks profilerMainMutex when it changes the active scope,
+ * which the other threads read when they enter their outermost scope.
+ */
+ProfilerNode            profilerRoot( "Total", 0, false );
+ProfilerNode *          profilerCurrentNode = &profilerRoot;
+ThreadIdType            profilerMainThread;
+itk::SimpleFastMutexLock profilerMainMutex;
+
+/** The records of the other threads, the records that are not in use,
+ * the lock that protects both, and the key of the record of a thread.
+ */
+ThreadRecordContainerType profilerRecords;
+ThreadRecordContainerType profilerFreeRecords;
+itk::SimpleFastMutexLock  profilerRecordsMutex;
+ThreadKeyType             profilerRecordKey;
+bool                      profilerRecordKeyCreated = false;
+
+
+/**
+ * ********************* IsMainThread ****************************
+ */
+
+bool IsMainThread( void )
+{
+  return IsSameThread( GetCallingThreadId(), profilerMainThread );
+
+} // end IsMainThread()
+
+
+/**
+ * ********************* AcquireRecord ****************************
+ *
+ * Take a record for the calling thread, which is not the main thread, and
+ * start its scopes under the active scope of the main thread. If the main
+ * thread is itself in a scope with this name, which happens when it runs
+ * the first thread of a multi-threader, the scopes are started next to it.
+ */
+
+ProfilerThreadRecord * AcquireRecord( const char * name )
+{
+  profilerMainMutex.Lock();
+  ProfilerNode * anchor = profilerCurrentNode;
+  profilerMainMutex.Unlock();
+
+  if ( name != 0 )
+  {
+    for ( ProfilerNode * node = anchor; node->m_Parent != 0; node = node->m_Parent )
+    {
+      if ( !node->m_IsCounter
+        && ( node->m_Name == name || std::strcmp( node->m_Name, name ) == 0 ) )
+      {
+        anchor = node->m_Parent;
+        break;
+      }
+    }
+  }
+
+  profilerRecordsMutex.Lock();
+  ProfilerThreadRecord * record = 0;
+  if ( profilerFreeRecords.empty() )
+  {
+    record = new ProfilerThreadRecord;
+    profilerRecords.push_back( record );
+  }
+  else
+  {
+    record = profilerFreeRecords.back();
+    profilerFreeRecords.pop_back();
+  }
+  profilerRecordsMutex.Unlock();
+
+  record->m_Current = record->GetRoot( anchor );
+  record->m_Depth = 0;
+  SetThreadValue( profilerRecordKey, record );
+  return record;
+
+} // end AcquireRecord()
+
+
+/**
+ * ********************* ReleaseRecord ****************************
+ */
+
+void ReleaseRecord( ProfilerThreadRecord * record )
+{
+  SetThreadValue( profilerRecordKey, 0 );
+  record->m_Current = 0;
+
+  profilerRecordsMutex.Lock();
+  profilerFreeRecords.push_back( record );
+  profilerRecordsMutex.Unlock();
+
+} // end ReleaseRecord()
+
+
+/**
+ * ********************* MergeNode ****************************
+ *
+ * Add the statistics of source and its children to target. If mainNodes
+ * is given, it maps each node of the source tree to its node in the
+ * target tree.
+ */
+
+typedef std::map< const ProfilerNode *, ProfilerNode * >   NodeMapType;
+
+void MergeNode( ProfilerNode * target, const ProfilerNode * source,
+  bool isThreaded, NodeMapType * mainNodes )
+{
+  if ( mainNodes != 0 )
+  {
+    ( *mainNodes )[ source ] = target;
+  }
+  else if ( !source->IsActive() )
+  {
+    return;
+  }
+
+  target->m_IsThreaded |= isThreaded || source->m_IsThreaded;
+  target->m_NumberOfCalls += source->m_NumberOfCalls;
+  target->m_TotalTime += source->m_TotalTime;
+  target->m_Count += source->m_Count;
+
+  for ( unsigned int i = 0; i < source->m_Children.size(); ++i )
+  {
+    const ProfilerNode * child = source->m_Children[ i ];
+    MergeNode( target->GetChild( child->m_Name, child->m_IsCounter ),
+      child, isThreaded, mainNodes );
+  }
+
+} // end MergeNode()
+
+
+/**
+ * ********************* CreateMergedTree ****************************
+ *
+ * Create a copy of the tree of the main thread, with the scopes of the
+ * other threads added under their anchors.
+ */
+
+ProfilerNode * CreateMergedTree( void )
+{
+  ProfilerNode * merged = new ProfilerNode( profilerRoot.m_Name, 0, false );
+  NodeMapType mainNodes;
+  MergeNode( merged, &profilerRoot, false, &mainNodes );
+
+  profilerRecordsMutex.Lock();
+  for ( unsigned int r = 0; r < profilerRecords.size(); ++r )
+  {
+    const ProfilerThreadRecord::RootsType & roots = profilerRecords[ r ]->m_Roots;
+    for ( unsigned int i = 0; i < roots.size(); ++i )
+    {
+      ProfilerNode * target = mainNodes[ roots[ i ].first ];
+      const ProfilerNode * root = roots[ i ].second;
+      for ( unsigned int c = 0; c < root->m_Children.size(); ++c )
+      {
+        const ProfilerNode * child = root->m_Children[ c ];
+        MergeNode( target->GetChild( child->m_Name, child->m_IsCounter ),
+          child, true, 0 );
+      }
+    }
+  }
+  profilerRecordsMutex.Unlock();
+
+  return merged;
+
+} // end CreateMergedTree()
+
+
+/**
+ * ********************* ResetAll ****************************
+ */
+
+void ResetAll( void )
+{
+  profilerRoot.Reset();
+
+  profilerRecordsMutex.Lock();
+  for ( unsigned int r = 0; r < profilerRecords.size(); ++r )
+  {
+    profilerRecords[ r ]->Reset();
+  }
+  profilerRecordsMutex.Unlock();
+
+} // end ResetAll()
+
+
+/**
+ * ********************* WriteReportNode ****************************
+ */
+
+void WriteReportNode( std::ostream & os, const ProfilerNode * node,
+  unsigned int depth, double totalTime )
+{
+  if ( !node->IsActive() ) return;
+
+  std::string name( 2 * depth, ' ' );
+  name += node->m_Name;
+  if ( node->m_IsThreaded ) name += " *";
+
+  os << "  " << std::left << std::setw( 56 ) << name << std::right;
+  if ( node->m_IsCounter )
+  {
+    os << std::setw( 10 ) << node->m_Count << "  (count)";
+  }
+  else
+  {
+    const double meanTime = node->m_NumberOfCalls > 0
+      ? node->m_TotalTime / static_cast<double>( node->m_NumberOfCalls ) : 0.0;
+    os << std::setw( 10 ) << node->m_NumberOfCalls
+      << std::setw( 12 ) << std::fixed << std::setprecision( 3 ) << node->m_TotalTime
+      << std::setw( 12 ) << meanTime * 1000.0;
+    if ( totalTime > 0.0 )
+    {
+      os << std::setw( 9 ) << std::setprecision( 1 )
+        << 100.0 * node->m_TotalTime / totalTime << "%";
+    }
+    os.unsetf( std::ios::floatfield );
+  }
+  os << "\n";
+
+  for ( unsigned int i = 0; i < node->m_Children.size(); ++i )
+  {
+    WriteReportNode( os, node->m_Children[ i ], depth + 1, totalTime );
+  }
+
+} // end WriteReportNode()
+
+
+/**
+ * ********************* WriteCSVNode ****************************
+ */
+
+void WriteCSVNode( std::ostream & os, const ProfilerNode * node,
+  const std::string & parentPath, unsigned int depth, double totalTime )
+{
+  if ( !node->IsActive() ) return;
+
+  const std::string path = parentPath.empty()
+    ? std::string( node->m_Name ) : parentPath + "/" + node->m_Name;
+
+  os << "\"" << path << "\"," << depth << ","
+    << ( node->m_IsCounter ? "counter" : "scope" ) << ","
+    << ( node->m_IsThreaded ? 1 : 0 ) << ","
+    << node->m_NumberOfCalls << ","
+    << node->m_TotalTime << ","
+    << ( node->m_NumberOfCalls > 0
+      ? node->m_TotalTime / static_cast<double>( node->m_NumberOfCalls ) : 0.0 ) << ","
+    << ( totalTime > 0.0 ? node->m_TotalTime / totalTime : 0.0 ) << ","
+    << node->m_Count << "\n";
+
+  for ( unsigned int i = 0; i < node->m_Children.size(); ++i )
+  {
+    WriteCSVNode( os, node->m_Children[ i ], path, depth + 1, totalTime );
+  }
+
+} // end WriteCSVNode()
+
+} // end namespace
+
+
+/**
+ * ********************* SetEnabled ****************************
+ */
+
+bool Profiler::SetEnabled( bool enabled )
+{
+  profilerMainMutex.Lock();
+  if ( m_Enabled && !IsMainThread() )
+  {
+    profilerMainMutex.Unlock();
+    return false;
+  }
+  if ( !profilerRecordKeyCreated )
+  {
+    CreateThreadKey( profilerRecordKey );
+    profilerRecordKeyCreated = true;
+  }
+  profilerMainThread = GetCallingThreadId();
+  profilerCurrentNode = &profilerRoot;
+  ResetAll();
+  m_Enabled = enabled;
+  profilerMainMutex.Unlock();
+  return true;
+
+} // end SetEnabled()
+
+
+/**
+ * ********************* Reset ****************************
+ */
+
+void Profiler::Reset( void )
+{
+  if ( !IsMainThread() ) return;
+  ResetAll();
+
+} // end Reset()
+
+
+/**
+ * ********************* BeginScope ****************************
+ */
+
+Profiler::NodeType * Profiler::BeginScope( const char * name )
+{
+  /** The main thread nests the scope in its own tree. */
+  if ( IsMainThread() )
+  {
+    NodeType * node = profilerCurrentNode->GetChild( name, false );
+    profilerMainMutex.Lock();
+    profilerCurrentNode = node;
+    profilerMainMutex.Unlock();
+    return node;
+  }
+
+  /** Other threads nest it in their record, without a lock. */
+  ProfilerThreadRecord * record
+    = static_cast<ProfilerThreadRecord *>( GetThreadValue( profilerRecordKey ) );
+  if ( record == 0 )
+  {
+    record = AcquireRecord( name );
+  }
+  NodeType * node = record->m_Current->GetChild( name, false );
+  record->m_Current = node;
+  ++record->m_Depth;
+  return node;
+
+} // end BeginScope()
+
+
+/**
+ * ********************* EndScope ****************************
+ */
+
+void Profiler::EndScope( NodeType * node, double elapsedTime )
+{
+  ++node->m_NumberOfCalls;
+  node->m_TotalTime += elapsedTime;
+
+  if ( IsMainThread() )
+  {
+    if ( node == profilerCurrentNode && node->m_Parent != 0 )
+    {
+      profilerMainMutex.Lock();
+      profilerCurrentNode = node->m_Parent;
+      profilerMainMutex.Unlock();
+    }
+    return;
+  }
+
+  /** Return the record when the outermost scope of the thread ends. */
+  ProfilerThreadRecord * record
+    = static_cast<ProfilerThreadRecord *>( GetThreadValue( profilerRecordKey ) );
+  if ( record == 0 ) return;
+  record->m_Current = node->m_Parent;
+  if ( --record->m_Depth == 0 )
+  {
+    ReleaseRecord( record );
+  }
+
+} // end EndScope()
+
+
+/**
+ * ********************* AddCount ****************************
+ */
+
+void Profiler::AddCount( const char * name, unsigned long n )
+{
+  if ( IsMainThread() )
+  {
+    profilerCurrentNode->GetChild( name, true )->m_Count += n;
+    return;
+  }
+
+  /** A thread that is not in a scope uses a record for this count only. */
+  ProfilerThreadRecord * record
+    = static_cast<ProfilerThreadRecord *>( GetThreadValue( profilerRecordKey ) );
+  const bool isInScope = ( record != 0 );
+  if ( !isInScope )
+  {
+    record = AcquireRecord( 0 );
+  }
+  record->m_Current->GetChild( name, true )->m_Count += n;
+  if ( !isInScope )
+  {
+    ReleaseRecord( record );
+  }
+
+} // end AddCount()
+
+
+/**
+ * ********************* Report ****************************
+ */
+
+void Profiler::Report( std::ostream & os, double totalTime )
+{
+  if ( !IsMainThread() ) return;
+
+  os << "  " << std::left << std::setw( 56 ) << "Scope" << std::right
+    << std::setw( 10 ) << "Calls"
+    << std::setw( 12 ) << "Total[s]"
+    << std::setw( 12 ) << "Mean[ms]";
+  if ( totalTime > 0.0 ) os << std::setw( 10 ) << "Share";
+  os << "\n";
+
+  ProfilerNode * merged = CreateMergedTree();
+  for ( unsigned int i = 0; i < merged->m_Children.size(); ++i )
+  {
+    WriteReportNode( os, merged->m_Children[ i ], 0, totalTime );
+  }
+  delete merged;
+  os << "  (*: summed over the threads)\n";
+
+} // end Report()
+
+
+/**
+ * ********************* WriteCSV ****************************
+ */
+
+bool Profiler::WriteCSV( const std::string & fileName, double totalTime )
+{
+  if ( !IsMainThread() ) return false;
+
+  std::ofstream file( fileName.c_str() );
+  if ( !file.is_open() ) return false;
+
+  file << std::setprecision( 9 );
+  file << "Scope,Depth,Kind,Threaded,Calls,TotalTime[s],MeanTime[s],Share,Count\n";
+
+  ProfilerNode * merged = CreateMergedTree();
+  for ( unsigned int i = 0; i < merged->m_Children.size(); ++i )
+  {
+    WriteCSVNode( file, merged->m_Children[ i ], "", 0, totalTime );
+  }
+  delete merged;
+
+  return true;
+
+} // end WriteCSV()
+
+
+} // end namespace tmr
+
+
+#endif // end #ifndef __elxProfiler_CXX_
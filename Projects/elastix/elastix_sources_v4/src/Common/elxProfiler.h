@@ -0,0 +1,187 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+#ifndef __elxProfiler_H_
+#define __elxProfiler_H_
+
+#include "elxTimer.h"
+#include <ostream>
+#include <string>
+
+namespace tmr
+{
+
+/**
+ * \class Profiler
+ * \brief Collects the time spent in named, nested scopes of the code.
+ *
+ * The profiler is a global, static registry of scopes, which are arranged
+ * in a tree: a scope that is entered while another scope is active becomes
+ * a child of that scope. For each scope the number of calls and the total
+ * wall-clock time are accumulated. Named counters can be added to the
+ * active scope with AddCount().
+ *
+ * Scopes are normally timed with the ScopedTimer class, through the
+ * tmrProfileScope() macro:
+ * \code
+ *   {
+ *     tmrProfileScope( "ComputePDFs" );
+ *     ...
+ *   }
+ * \endcode
+ * The name must be a string literal (or outlive the profiler), since only
+ * the pointer is stored.
+ *
+ * Profiling is disabled by default. A disabled profiler costs a test of a
+ * static boolean per scope, so the scopes can be left in the hot paths.
+ *
+ * The thread that enabled the profiler (the main thread) owns it: only
+ * that thread can reset, report, or disable it. Another thread can not
+ * enable the profiler while it is owned, so registrations that run in
+ * other threads of the same process do not reset or report each other's
+ * statistics.
+ *
+ * Each thread accumulates its statistics in its own record, without
+ * locks. Scopes that are entered in other threads, e.g. in the threads of
+ * an itk::MultiThreader, take a record from a pool when they enter their
+ * outermost scope, and return it when they leave it. Their scopes are
+ * nested in that record, under the active scope of the main thread at
+ * that moment. Report() and WriteCSV() merge the records, and sum the
+ * times over the threads. They should be called when no scopes are active
+ * in other threads. Note that the scopes of other threads of the process
+ * are always attributed to the owner, also when they belong to another
+ * registration that runs at the same time.
+ *
+ * ElastixTemplate enables the profiler with the EnableProfiling parameter,
+ * reports and resets it after each resolution, and disables it after the
+ * registration.
+ *
+ * \ingroup Timer
+ */
+
+class ProfilerNode;
+
+class Profiler
+{
+public:
+
+  /** Typedef's. */
+  typedef ProfilerNode    NodeType;
+
+  /** Enable or disable the profiler. Enabling it resets all statistics
+   * and makes the calling thread the main thread. Returns false, and does
+   * nothing, if the profiler is enabled and owned by another thread.
+   */
+  static bool SetEnabled( bool enabled );
+  static bool GetEnabled( void )
+  {
+    return m_Enabled;
+  }
+
+  /** Set all times and counts to zero. The scopes themselves are kept,
+   * so scopes that are active at the moment remain valid. Only has effect
+   * in the main thread.
+   */
+  static void Reset( void );
+
+  /** Enter a scope. Returns the node of the scope, which should be
+   * passed to EndScope() together with the elapsed time.
+   */
+  static NodeType * BeginScope( const char * name );
+  static void EndScope( NodeType * node, double elapsedTime );
+
+  /** Add n to the counter with this name in the active scope. */
+  static void AddCount( const char * name, unsigned long n );
+
+  /** Print the tree of scopes that were called since the last Reset().
+   * The percentages are relative to totalTime, when it is positive. Only
+   * has effect in the main thread.
+   */
+  static void Report( std::ostream & os, double totalTime );
+
+  /** Write the statistics as a table with comma separated values, one
+   * line per scope or counter. Returns false if the file can not be
+   * opened, or if it is not called in the main thread.
+   */
+  static bool WriteCSV( const std::string & fileName, double totalTime );
+
+private:
+
+  Profiler();                       // purposely not implemented
+  Profiler( const Profiler & );     // purposely not implemented
+  void operator=( const Profiler & ); // purposely not implemented
+
+  static bool m_Enabled;
+
+}; // end class Profiler
+
+
+/**
+ * \class ScopedTimer
+ * \brief Times the scope in which it is declared, if the Profiler is enabled.
+ *
+ * \ingroup Timer
+ */
+
+class ScopedTimer
+{
+public:
+
+  ScopedTimer( const char * name )
+  {
+    this->m_Node = 0;
+    if ( Profiler::GetEnabled() )
+    {
+      this->m_Node = Profiler::BeginScope( name );
+      this->m_StartTime = Timer::GetWallClockTime();
+    }
+  }
+
+  ~ScopedTimer()
+  {
+    if ( this->m_Node )
+    {
+      Profiler::EndScope( this->m_Node,
+        Timer::GetWallClockTime() - this->m_StartTime );
+    }
+  }
+
+private:
+
+  ScopedTimer( const ScopedTimer & );   // purposely not implemented
+  void operator=( const ScopedTimer & ); // purposely not implemented
+
+  Profiler::NodeType *  m_Node;
+  double                m_StartTime;
+
+}; // end class ScopedTimer
+
+
+} // end namespace tmr
+
+
+/** Time the rest of the enclosing scope under the given name. */
+#define tmrProfileScope( name ) \
+  tmr::ScopedTimer tmrProfileConcatMacro( tmrScopedTimer, __LINE__ )( name )
+
+/** Add n to the counter with the given name in the active scope. */
+#define tmrProfileCount( name, n ) \
+  do { \
+    if ( tmr::Profiler::GetEnabled() ) tmr::Profiler::AddCount( name, n ); \
+  } while ( 0 )
+
+#define tmrProfileConcatMacro( a, b ) tmrProfileConcatMacro2( a, b )
+#define tmrProfileConcatMacro2( a, b ) a##b
+
+
+#endif // end #ifndef __elxProfiler_H_
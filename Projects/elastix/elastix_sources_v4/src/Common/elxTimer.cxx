@@ -16,6 +16,14 @@
 
 #include "elxTimer.h"
 
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
 namespace tmr
 {
 using namespace itk;
@@ -33,6 +41,12 @@ Timer::Timer()
   this->m_StartClock = 0;
   this->m_StopTime = 0;
   this->m_StopClock = 0;
+  this->m_StartWallClock = 0.0;
+  this->m_StartProcessorTime = 0.0;
+  this->m_StartThreadTime = 0.0;
+  this->m_ElapsedWallClockSec = 0.0;
+  this->m_ElapsedProcessorTimeSec = 0.0;
+  this->m_ElapsedThreadTimeSec = 0.0;
 
 } // end Constructor
 
@@ -46,6 +60,9 @@ void Timer::StartTimer( void )
   /** Get the current time.*/
   this->m_StartTime = time( '\0' );
   this->m_StartClock = clock();
+  this->m_StartWallClock = GetWallClockTime();
+  this->m_StartProcessorTime = GetProcessorTime();
+  this->m_StartThreadTime = GetThreadProcessorTime();
 
 } // end StartTimer()
 
@@ -62,6 +79,9 @@ int Timer::StopTimer( void )
   /** Get the current time. */
   this->m_StopTime = time( '\0' );
   this->m_StopClock = clock();
+  this->m_ElapsedWallClockSec = GetWallClockTime() - this->m_StartWallClock;
+  this->m_ElapsedProcessorTimeSec = GetProcessorTime() - this->m_StartProcessorTime;
+  this->m_ElapsedThreadTimeSec = GetThreadProcessorTime() - this->m_StartThreadTime;
 
   /** Get the elapsed time. */
   this->ElapsedClockAndTime();
@@ -223,6 +243,144 @@ const std::string & Timer::PrintElapsedClockSec( void )
 } // end PrintElapsedClockSec()
 
 
+/**
+ * ******************* PrintElapsedWallClockSec ************************
+ */
+
+const std::string & Timer::PrintElapsedWallClockSec( void )
+{
+  /** Print m_ElapsedWallClockSec. */
+  std::ostringstream make_string( "" );
+  make_string << this->m_ElapsedWallClockSec;
+  this->m_ElapsedWallClockSecString = make_string.str();
+
+  return this->m_ElapsedWallClockSecString;
+
+} // end PrintElapsedWallClockSec()
+
+
+/**
+ * ******************* PrintElapsedProcessorTimeSec ************************
+ */
+
+const std::string & Timer::PrintElapsedProcessorTimeSec( void )
+{
+  /** Print m_ElapsedProcessorTimeSec. */
+  std::ostringstream make_string( "" );
+  make_string << this->m_ElapsedProcessorTimeSec;
+  this->m_ElapsedProcessorTimeSecString = make_string.str();
+
+  return this->m_ElapsedProcessorTimeSecString;
+
+} // end PrintElapsedProcessorTimeSec()
+
+
+/**
+ * ******************* GetCPUWallRatio ************************
+ */
+
+double Timer::GetCPUWallRatio( void ) const
+{
+  if ( this->m_ElapsedWallClockSec <= 0.0 ) return 0.0;
+  return this->m_ElapsedProcessorTimeSec / this->m_ElapsedWallClockSec;
+
+} // end GetCPUWallRatio()
+
+
+/**
+ * ******************* GetWallClockTime ************************
+ */
+
+double Timer::GetWallClockTime( void )
+{
+#if defined( _WIN32 )
+  /** The performance counter is monotonic. */
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  QueryPerformanceFrequency( &frequency );
+  QueryPerformanceCounter( &counter );
+  return static_cast<double>( counter.QuadPart )
+    / static_cast<double>( frequency.QuadPart );
+#elif defined( CLOCK_MONOTONIC )
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return static_cast<double>( ts.tv_sec )
+    + 1e-9 * static_cast<double>( ts.tv_nsec );
+#else
+  /** Not monotonic, but better than time(). */
+  struct timeval tv;
+  gettimeofday( &tv, 0 );
+  return static_cast<double>( tv.tv_sec )
+    + 1e-6 * static_cast<double>( tv.tv_usec );
+#endif
+
+} // end GetWallClockTime()
+
+
+/**
+ * ******************* GetProcessorTime ************************
+ */
+
+double Timer::GetProcessorTime( void )
+{
+#if defined( _WIN32 )
+  /** User and kernel time, in units of 100 ns. */
+  FILETIME creationTime, exitTime, kernelTime, userTime;
+  if ( !GetProcessTimes( GetCurrentProcess(),
+    &creationTime, &exitTime, &kernelTime, &userTime ) )
+  {
+    return 0.0;
+  }
+  ULARGE_INTEGER kernel, user;
+  kernel.LowPart = kernelTime.dwLowDateTime;
+  kernel.HighPart = kernelTime.dwHighDateTime;
+  user.LowPart = userTime.dwLowDateTime;
+  user.HighPart = userTime.dwHighDateTime;
+  return 1e-7 * static_cast<double>( kernel.QuadPart + user.QuadPart );
+#else
+  /** User and system time of all threads. Unlike clock(), this does not
+   * wrap around after some time.
+   */
+  struct rusage usage;
+  if ( getrusage( RUSAGE_SELF, &usage ) != 0 ) return 0.0;
+  return static_cast<double>( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec )
+    + 1e-6 * static_cast<double>( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec );
+#endif
+
+} // end GetProcessorTime()
+
+
+/**
+ * ******************* GetThreadProcessorTime ************************
+ */
+
+double Timer::GetThreadProcessorTime( void )
+{
+#if defined( _WIN32 )
+  FILETIME creationTime, exitTime, kernelTime, userTime;
+  if ( !GetThreadTimes( GetCurrentThread(),
+    &creationTime, &exitTime, &kernelTime, &userTime ) )
+  {
+    return 0.0;
+  }
+  ULARGE_INTEGER kernel, user;
+  kernel.LowPart = kernelTime.dwLowDateTime;
+  kernel.HighPart = kernelTime.dwHighDateTime;
+  user.LowPart = userTime.dwLowDateTime;
+  user.HighPart = userTime.dwHighDateTime;
+  return 1e-7 * static_cast<double>( kernel.QuadPart + user.QuadPart );
+#elif defined( CLOCK_THREAD_CPUTIME_ID )
+  struct timespec ts;
+  if ( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) != 0 ) return 0.0;
+  return static_cast<double>( ts.tv_sec )
+    + 1e-9 * static_cast<double>( ts.tv_nsec );
+#else
+  return 0.0;
+#endif
+
+} // end GetThreadProcessorTime()
+
+
 } // end namespace tmr
 
 #endif // end #ifndef __elxTimer_CXX_
@@ -39,6 +39,12 @@
  * A timer tick is approximately equal to 1/CLOCKS_PER_SEC second. In
  * versions of Microsoft C before 6.0, the CLOCKS_PER_SEC constant
  * was called CLK_TCK.
+ *
+ * NB: on Linux clock() adds the processor time of all threads, while with
+ * Microsoft C it returns the wall-clock time. The Timer therefore also
+ * measures the wall-clock time with a monotonic high-resolution clock, and
+ * the processor time of the process and of the calling thread with the
+ * functions of the operating system.
  */
 
 namespace tmr
@@ -52,6 +58,17 @@ using namespace itk;
  * This class is a wrap around ctime.h. It is used to time the registration,
  * to get the time per iteration, or whatever.
  *
+ * Besides the time() and clock() based measurements, the timer measures:
+ * \li the wall-clock time, with a monotonic clock of at least microsecond
+ *   resolution: GetElapsedWallClockSec().
+ * \li the processor time of the process, summed over all its threads:
+ *   GetElapsedProcessorTimeSec().
+ * \li the processor time of the thread that calls StartTimer() and
+ *   StopTimer(): GetElapsedThreadTimeSec().
+ * The ratio of the processor time and the wall-clock time,
+ * GetCPUWallRatio(), tells how many threads were busy on average. Divided
+ * by the number of threads it is the parallel efficiency.
+ *
  * \ingroup Timer
  */
 
@@ -87,6 +104,16 @@ public:
   const std::string & PrintElapsedTimeSec( void );
   const std::string & PrintElapsedClock( void );
   const std::string & PrintElapsedClockSec( void );
+  const std::string & PrintElapsedWallClockSec( void );
+  const std::string & PrintElapsedProcessorTimeSec( void );
+
+  /** The current time of the different clocks, in seconds. Only the
+   * differences of two calls are meaningful. GetThreadProcessorTime()
+   * returns 0 on systems that have no per-thread processor clock.
+   */
+  static double GetWallClockTime( void );
+  static double GetProcessorTime( void );
+  static double GetThreadProcessorTime( void );
 
   /** Communication with outside world.*/
   itkGetConstMacro( StartTime, time_t );
@@ -96,6 +123,12 @@ public:
   itkGetConstMacro( ElapsedTimeSec, std::size_t );
   itkGetConstMacro( ElapsedClock, double );
   itkGetConstMacro( ElapsedClockSec, double );
+  itkGetConstMacro( ElapsedWallClockSec, double );
+  itkGetConstMacro( ElapsedProcessorTimeSec, double );
+  itkGetConstMacro( ElapsedThreadTimeSec, double );
+
+  /** The processor time of the process divided by the wall-clock time. */
+  double GetCPUWallRatio( void ) const;
 
 protected:
 
@@ -112,6 +145,12 @@ protected:
   TimeDHMSType  m_ElapsedTimeDHMS;
   std::size_t   m_ElapsedTimeSec;
   double        m_ElapsedClockSec;
+  double        m_StartWallClock;
+  double        m_StartProcessorTime;
+  double        m_StartThreadTime;
+  double        m_ElapsedWallClockSec;
+  double        m_ElapsedProcessorTimeSec;
+  double        m_ElapsedThreadTimeSec;
 
   /** Strings that serve as output of the Formatted Output Functions */
   std::string m_StartTimeString;
@@ -120,6 +159,8 @@ protected:
   std::string m_ElapsedTimeSecString;
   std::string m_ElapsedClockString;
   std::string m_ElapsedClockSecString;
+  std::string m_ElapsedWallClockSecString;
+  std::string m_ElapsedProcessorTimeSecString;
 
 private:
 
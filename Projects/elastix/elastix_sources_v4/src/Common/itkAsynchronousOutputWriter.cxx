@@ -0,0 +1,717 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkAsynchronousOutputWriter_cxx
+#define __itkAsynchronousOutputWriter_cxx
+
+#include "itkAsynchronousOutputWriter.h"
+#include "itksys/SystemTools.hxx"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined( ITK_USE_PTHREADS )
+#include <pthread.h>
+#include <sys/time.h>
+#include <errno.h>
+#elif defined( ITK_USE_WIN32_THREADS )
+#include <windows.h>
+#endif
+
+namespace itk
+{
+
+/**
+ * ********************* ImplementationType ****************************
+ */
+
+#if defined( ITK_USE_PTHREADS )
+
+struct AsynchronousOutputCondition::ImplementationType
+{
+  pthread_mutex_t   m_Mutex;
+  pthread_cond_t    m_Condition;
+  bool              m_Flag;
+};
+
+#elif defined( ITK_USE_WIN32_THREADS )
+
+/** An auto-reset event is a flag that is cleared by the wait. */
+struct AsynchronousOutputCondition::ImplementationType
+{
+  HANDLE            m_Event;
+};
+
+#else
+
+/** Without threads nothing waits for the flag. */
+struct AsynchronousOutputCondition::ImplementationType
+{
+  bool              m_Flag;
+};
+
+#endif
+
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+AsynchronousOutputCondition
+::AsynchronousOutputCondition()
+{
+  this->m_Implementation = new ImplementationType;
+#if defined( ITK_USE_PTHREADS )
+  pthread_mutex_init( &this->m_Implementation->m_Mutex, 0 );
+  pthread_cond_init( &this->m_Implementation->m_Condition, 0 );
+  this->m_Implementation->m_Flag = false;
+#elif defined( ITK_USE_WIN32_THREADS )
+  this->m_Implementation->m_Event = CreateEvent( 0, FALSE, FALSE, 0 );
+#else
+  this->m_Implementation->m_Flag = false;
+#endif
+
+} // end Constructor
+
+
+/**
+ * ********************* Destructor ****************************
+ */
+
+AsynchronousOutputCondition
+::~AsynchronousOutputCondition()
+{
+#if defined( ITK_USE_PTHREADS )
+  pthread_cond_destroy( &this->m_Implementation->m_Condition );
+  pthread_mutex_destroy( &this->m_Implementation->m_Mutex );
+#elif defined( ITK_USE_WIN32_THREADS )
+  CloseHandle( this->m_Implementation->m_Event );
+#endif
+  delete this->m_Implementation;
+
+} // end Destructor
+
+
+/**
+ * ********************* Signal ****************************
+ */
+
+void
+AsynchronousOutputCondition
+::Signal( void )
+{
+#if defined( ITK_USE_PTHREADS )
+  pthread_mutex_lock( &this->m_Implementation->m_Mutex );
+  this->m_Implementation->m_Flag = true;
+  pthread_cond_signal( &this->m_Implementation->m_Condition );
+  pthread_mutex_unlock( &this->m_Implementation->m_Mutex );
+#elif defined( ITK_USE_WIN32_THREADS )
+  SetEvent( this->m_Implementation->m_Event );
+#else
+  this->m_Implementation->m_Flag = true;
+#endif
+
+} // end Signal()
+
+
+/**
+ * ********************* Wait ****************************
+ */
+
+bool
+AsynchronousOutputCondition
+::Wait( unsigned int timeout )
+{
+#if defined( ITK_USE_PTHREADS )
+  /** The absolute time at which the wait ends. */
+  struct timeval now;
+  gettimeofday( &now, 0 );
+  struct timespec end;
+  const unsigned long nanoseconds = now.tv_usec * 1000ul
+    + ( timeout % 1000 ) * 1000000ul;
+  end.tv_sec = now.tv_sec + timeout / 1000 + nanoseconds / 1000000000ul;
+  end.tv_nsec = nanoseconds % 1000000000ul;
+
+  pthread_mutex_lock( &this->m_Implementation->m_Mutex );
+  while ( !this->m_Implementation->m_Flag )
+  {
+    if ( pthread_cond_timedwait( &this->m_Implementation->m_Condition,
+      &this->m_Implementation->m_Mutex, &end ) == ETIMEDOUT )
+    {
+      break;
+    }
+  }
+  const bool flag = this->m_Implementation->m_Flag;
+  this->m_Implementation->m_Flag = false;
+  pthread_mutex_unlock( &this->m_Implementation->m_Mutex );
+  return flag;
+#elif defined( ITK_USE_WIN32_THREADS )
+  return WaitForSingleObject( this->m_Implementation->m_Event, timeout )
+    == WAIT_OBJECT_0;
+#else
+  const bool flag = this->m_Implementation->m_Flag;
+  this->m_Implementation->m_Flag = false;
+  if ( !flag )
+  {
+    itksys::SystemTools::Delay( timeout );
+  }
+  return flag;
+#endif
+
+} // end Wait()
+
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+AsynchronousOutputBuffer
+::AsynchronousOutputBuffer( OStreamType * target, char tabReplacement,
+  AsynchronousOutputCondition * queueCondition )
+{
+  this->m_Target = target;
+  this->m_TabReplacement = tabReplacement;
+  this->m_QueueCondition = queueCondition;
+  this->m_Asynchronous = false;
+  this->m_NumberOfCharacters = 0;
+
+  /** No put area: in synchronous mode each character goes to overflow()
+   * or xsputn(), and from there to the target.
+   */
+  this->setp( 0, 0 );
+
+  /** Remember the position of the target, to mimic its tellp(). */
+  this->m_StartPosition = pos_type( off_type( -1 ) );
+  if ( target->rdbuf() )
+  {
+    this->m_StartPosition = target->rdbuf()->pubseekoff(
+      0, std::ios_base::cur, std::ios_base::out );
+  }
+
+} // end Constructor
+
+
+/**
+ * ********************* Destructor ****************************
+ */
+
+AsynchronousOutputBuffer
+::~AsynchronousOutputBuffer()
+{
+  this->SetAsynchronous( false );
+
+} // end Destructor
+
+
+/**
+ * ********************* SetAsynchronous ****************************
+ */
+
+void
+AsynchronousOutputBuffer
+::SetAsynchronous( bool asynchronous )
+{
+  if ( asynchronous == this->m_Asynchronous ) return;
+
+  if ( asynchronous )
+  {
+    this->m_PutArea.resize( 4096 );
+    this->setp( &this->m_PutArea[ 0 ], &this->m_PutArea[ 0 ] + this->m_PutArea.size() );
+  }
+  else
+  {
+    /** Write everything that is still queued. */
+    this->MovePutAreaToQueue();
+    this->setp( 0, 0 );
+    this->WriteQueuedData();
+  }
+  this->m_Asynchronous = asynchronous;
+
+} // end SetAsynchronous()
+
+
+/**
+ * ********************* MovePutAreaToQueue ****************************
+ */
+
+void
+AsynchronousOutputBuffer
+::MovePutAreaToQueue( void )
+{
+  const std::streamsize n = this->pptr() - this->pbase();
+  if ( n > 0 )
+  {
+    this->AppendToQueue( this->pbase(), n );
+    this->setp( this->pbase(), this->epptr() );
+  }
+
+} // end MovePutAreaToQueue()
+
+
+/**
+ * ********************* AppendToQueue ****************************
+ */
+
+void
+AsynchronousOutputBuffer
+::AppendToQueue( const char_type * s, std::streamsize n )
+{
+  this->m_QueueLock.Lock();
+  this->m_Queue.append( s, n );
+  this->m_QueueLock.Unlock();
+  this->m_NumberOfCharacters += n;
+
+  /** Wake the writer thread. */
+  if ( this->m_QueueCondition )
+  {
+    this->m_QueueCondition->Signal();
+  }
+
+} // end AppendToQueue()
+
+
+/**
+ * ********************* WriteQueuedData ****************************
+ */
+
+void
+AsynchronousOutputBuffer
+::WriteQueuedData( void )
+{
+  /** The write lock keeps the order of the data if the writer thread and
+   * Flush() write at the same time. The queue lock is only held for the
+   * swap, so that the producer does not wait for the target.
+   */
+  this->m_WriteLock.Lock();
+
+  this->m_WriteBuffer.clear();
+  this->m_QueueLock.Lock();
+  this->m_Queue.swap( this->m_WriteBuffer );
+  this->m_QueueLock.Unlock();
+
+  if ( !this->m_WriteBuffer.empty() )
+  {
+    this->WriteToTarget( this->m_WriteBuffer.data(), this->m_WriteBuffer.size() );
+    this->m_Target->flush();
+  }
+
+  this->m_WriteLock.Unlock();
+
+} // end WriteQueuedData()
+
+
+/**
+ * ********************* WriteToTarget ****************************
+ */
+
+void
+AsynchronousOutputBuffer
+::WriteToTarget( const char_type * s, std::streamsize n )
+{
+  if ( this->m_TabReplacement == 0 )
+  {
+    this->m_Target->write( s, n );
+    return;
+  }
+
+  /** Write the parts between the tabs, and the replacements of the tabs. */
+  const char_type * end = s + n;
+  while ( s != end )
+  {
+    const char_type * tab = std::find( s, end, '\t' );
+    this->m_Target->write( s, tab - s );
+    if ( tab == end ) break;
+    this->m_Target->put( this->m_TabReplacement );
+    s = tab + 1;
+  }
+
+} // end WriteToTarget()
+
+
+/**
+ * ********************* overflow ****************************
+ */
+
+AsynchronousOutputBuffer::int_type
+AsynchronousOutputBuffer
+::overflow( int_type c )
+{
+  if ( traits_type::eq_int_type( c, traits_type::eof() ) )
+  {
+    return traits_type::not_eof( c );
+  }
+
+  const char_type ch = traits_type::to_char_type( c );
+  if ( this->m_Asynchronous )
+  {
+    /** The put area is full. */
+    this->MovePutAreaToQueue();
+    *this->pptr() = ch;
+    this->pbump( 1 );
+  }
+  else
+  {
+    this->WriteToTarget( &ch, 1 );
+    ++this->m_NumberOfCharacters;
+  }
+  return c;
+
+} // end overflow()
+
+
+/**
+ * ********************* xsputn ****************************
+ */
+
+std::streamsize
+AsynchronousOutputBuffer
+::xsputn( const char_type * s, std::streamsize n )
+{
+  if ( !this->m_Asynchronous )
+  {
+    this->WriteToTarget( s, n );
+    this->m_NumberOfCharacters += n;
+  }
+  else if ( this->epptr() - this->pptr() >= n )
+  {
+    std::memcpy( this->pptr(), s, n );
+    this->pbump( static_cast<int>( n ) );
+  }
+  else
+  {
+    /** Too long for the put area: append it to the queue directly. */
+    this->MovePutAreaToQueue();
+    this->AppendToQueue( s, n );
+  }
+  return n;
+
+} // end xsputn()
+
+
+/**
+ * ********************* sync ****************************
+ */
+
+int
+AsynchronousOutputBuffer
+::sync( void )
+{
+  if ( this->m_Asynchronous )
+  {
+    /** Make the data available to the writer thread. */
+    this->MovePutAreaToQueue();
+    return 0;
+  }
+
+  this->m_Target->flush();
+  return this->m_Target->bad() ? -1 : 0;
+
+} // end sync()
+
+
+/**
+ * ********************* seekoff ****************************
+ *
+ * Only supports tellp(), which elastix uses to find out if the
+ * target is a console.
+ */
+
+AsynchronousOutputBuffer::pos_type
+AsynchronousOutputBuffer
+::seekoff( off_type off, std::ios_base::seekdir dir,
+  std::ios_base::openmode which )
+{
+  const pos_type invalid = pos_type( off_type( -1 ) );
+  if ( off != 0 || dir != std::ios_base::cur
+    || !( which & std::ios_base::out ) || this->m_StartPosition == invalid )
+  {
+    return invalid;
+  }
+
+  return this->m_StartPosition + off_type( this->m_NumberOfCharacters
+    + ( this->pptr() - this->pbase() ) );
+
+} // end seekoff()
+
+
+/**
+ * ********************* Static variables ****************************
+ */
+
+AsynchronousOutputWriter * AsynchronousOutputWriter::m_GlobalWriter = 0;
+
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+AsynchronousOutputWriter
+::AsynchronousOutputWriter()
+{
+  this->m_Asynchronous = false;
+  this->m_FlushInterval = 500;
+  this->m_StopWriterThread = false;
+  this->m_Threader = MultiThreader::New();
+  this->m_ThreadID = -1;
+
+} // end Constructor
+
+
+/**
+ * ********************* Destructor ****************************
+ */
+
+AsynchronousOutputWriter
+::~AsynchronousOutputWriter()
+{
+  /** Stop the thread and write the remaining data. */
+  this->SetAsynchronous( false );
+
+  for ( unsigned int i = 0; i < this->m_Outputs.size(); ++i )
+  {
+    delete this->m_Outputs[ i ].m_Stream;
+    delete this->m_Outputs[ i ].m_Buffer;
+  }
+
+  if ( m_GlobalWriter == this )
+  {
+    m_GlobalWriter = 0;
+  }
+
+} // end Destructor
+
+
+/**
+ * ********************* AddOutput ****************************
+ */
+
+AsynchronousOutputWriter::OStreamType *
+AsynchronousOutputWriter
+::AddOutput( OStreamType * target, char tabReplacement )
+{
+  OutputType output;
+  output.m_Buffer = new AsynchronousOutputBuffer( target, tabReplacement,
+    &this->m_QueueCondition );
+  output.m_Buffer->SetAsynchronous( this->m_Asynchronous );
+  output.m_Stream = new OStreamType( output.m_Buffer );
+
+  this->m_OutputsLock.Lock();
+  this->m_Outputs.push_back( output );
+  this->m_OutputsLock.Unlock();
+
+  return output.m_Stream;
+
+} // end AddOutput()
+
+
+/**
+ * ********************* RemoveOutput ****************************
+ */
+
+void
+AsynchronousOutputWriter
+::RemoveOutput( OStreamType * stream )
+{
+  OutputType output;
+  output.m_Buffer = 0;
+
+  /** After removing it from the list, the writer thread does not touch
+   * the output anymore. */
+  this->m_OutputsLock.Lock();
+  for ( OutputVectorType::iterator it = this->m_Outputs.begin();
+    it != this->m_Outputs.end(); ++it )
+  {
+    if ( it->m_Stream == stream )
+    {
+      output = *it;
+      this->m_Outputs.erase( it );
+      break;
+    }
+  }
+  this->m_OutputsLock.Unlock();
+
+  /** The destructor of the buffer writes the remaining data. */
+  if ( output.m_Buffer )
+  {
+    delete output.m_Stream;
+    delete output.m_Buffer;
+  }
+
+} // end RemoveOutput()
+
+
+/**
+ * ********************* SetAsynchronous ****************************
+ */
+
+void
+AsynchronousOutputWriter
+::SetAsynchronous( bool asynchronous )
+{
+  if ( asynchronous == this->m_Asynchronous ) return;
+
+  if ( asynchronous )
+  {
+    for ( unsigned int i = 0; i < this->m_Outputs.size(); ++i )
+    {
+      this->m_Outputs[ i ].m_Buffer->SetAsynchronous( true );
+    }
+    this->m_StopWriterThread = false;
+    this->m_ThreadID = this->m_Threader->SpawnThread(
+      WriterThreadCallback, this );
+  }
+  else
+  {
+    /** Stop the thread first, then write the remaining data. The thread
+     * is woken, so that it does not finish its wait. */
+    this->m_OutputsLock.Lock();
+    this->m_StopWriterThread = true;
+    this->m_OutputsLock.Unlock();
+    this->m_QueueCondition.Signal();
+    this->m_Threader->TerminateThread( this->m_ThreadID );
+    this->m_ThreadID = -1;
+    for ( unsigned int i = 0; i < this->m_Outputs.size(); ++i )
+    {
+      this->m_Outputs[ i ].m_Buffer->SetAsynchronous( false );
+    }
+  }
+
+  this->m_Asynchronous = asynchronous;
+  this->Modified();
+
+} // end SetAsynchronous()
+
+
+/**
+ * ********************* Flush ****************************
+ */
+
+void
+AsynchronousOutputWriter
+::Flush( void )
+{
+  for ( unsigned int i = 0; i < this->m_Outputs.size(); ++i )
+  {
+    this->m_Outputs[ i ].m_Stream->flush();
+  }
+  this->WriteQueuedData();
+
+} // end Flush()
+
+
+/**
+ * ********************* WriteQueuedData ****************************
+ */
+
+void
+AsynchronousOutputWriter
+::WriteQueuedData( void )
+{
+  this->m_OutputsLock.Lock();
+  for ( unsigned int i = 0; i < this->m_Outputs.size(); ++i )
+  {
+    this->m_Outputs[ i ].m_Buffer->WriteQueuedData();
+  }
+  this->m_OutputsLock.Unlock();
+
+} // end WriteQueuedData()
+
+
+/**
+ * ********************* GetStopWriterThread ****************************
+ */
+
+bool
+AsynchronousOutputWriter
+::GetStopWriterThread( void )
+{
+  this->m_OutputsLock.Lock();
+  const bool stop = this->m_StopWriterThread;
+  this->m_OutputsLock.Unlock();
+  return stop;
+
+} // end GetStopWriterThread()
+
+
+/**
+ * ********************* WriterThreadCallback ****************************
+ */
+
+ITK_THREAD_RETURN_TYPE
+AsynchronousOutputWriter
+::WriterThreadCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  Self * writer = static_cast<Self *>( infoStruct->UserData );
+
+  /** Sleep until output is queued, or the thread is stopped, but at most
+   * the flush interval. */
+  while ( !writer->GetStopWriterThread() )
+  {
+    writer->WriteQueuedData();
+    writer->m_QueueCondition.Wait( writer->m_FlushInterval );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end WriterThreadCallback()
+
+
+/**
+ * ********************* SetGlobalWriter ****************************
+ */
+
+void
+AsynchronousOutputWriter
+::SetGlobalWriter( Self * writer )
+{
+  m_GlobalWriter = writer;
+
+} // end SetGlobalWriter()
+
+
+/**
+ * ********************* GetGlobalWriter ****************************
+ */
+
+AsynchronousOutputWriter *
+AsynchronousOutputWriter
+::GetGlobalWriter( void )
+{
+  return m_GlobalWriter;
+
+} // end GetGlobalWriter()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+void
+AsynchronousOutputWriter
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Asynchronous: " << this->m_Asynchronous << std::endl;
+  os << indent << "FlushInterval: " << this->m_FlushInterval << std::endl;
+  os << indent << "NumberOfOutputs: " << this->m_Outputs.size() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkAsynchronousOutputWriter_cxx
@@ -0,0 +1,285 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkAsynchronousOutputWriter_h
+#define __itkAsynchronousOutputWriter_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * \class AsynchronousOutputCondition
+ * \brief A flag on which a thread can wait, with a timeout.
+ *
+ * Signal() sets the flag and wakes the waiting thread. Wait() returns when
+ * the flag is set, or after the timeout, and clears the flag. A signal that
+ * comes before Wait() is not lost. It is implemented with a condition
+ * variable for pthreads, and with an event for Windows threads.
+ *
+ * \ingroup Common
+ * \sa AsynchronousOutputWriter
+ */
+
+class AsynchronousOutputCondition
+{
+public:
+
+  AsynchronousOutputCondition();
+  ~AsynchronousOutputCondition();
+
+  /** Set the flag, and wake the waiting thread. Thread safe. */
+  void Signal( void );
+
+  /** Wait until the flag is set, but at most timeout milliseconds, and
+   * clear the flag. Returns whether the flag was set.
+   */
+  bool Wait( unsigned int timeout );
+
+private:
+
+  AsynchronousOutputCondition( const AsynchronousOutputCondition & ); // purposely not implemented
+  void operator=( const AsynchronousOutputCondition & );            // purposely not implemented
+
+  /** The platform specific implementation. */
+  struct ImplementationType;
+  ImplementationType *    m_Implementation;
+
+}; // end class AsynchronousOutputCondition
+
+
+/**
+ * \class AsynchronousOutputBuffer
+ * \brief A stream buffer that passes its characters on to another stream,
+ * either directly or through an AsynchronousOutputWriter.
+ *
+ * In synchronous mode (the default) every character is passed on to the
+ * target stream immediately, and a flush flushes the target stream. In
+ * asynchronous mode the characters are collected in a put area, which is
+ * moved to a queue on a flush or when it is full. Then the queue condition
+ * is signalled, if it is given. The queue is written to the target stream
+ * by WriteQueuedData(), which the writer thread calls.
+ * The thread that produces the output then never waits for the disk or
+ * the terminal, only for a short lock of the queue.
+ *
+ * Optionally, tabs are replaced by another character, e.g. a comma to
+ * write a table as comma separated values.
+ *
+ * \ingroup Common
+ * \sa AsynchronousOutputWriter
+ */
+
+class AsynchronousOutputBuffer : public std::streambuf
+{
+public:
+
+  typedef std::streambuf        Superclass;
+  typedef std::ostream          OStreamType;
+
+  AsynchronousOutputBuffer( OStreamType * target, char tabReplacement,
+    AsynchronousOutputCondition * queueCondition = 0 );
+  virtual ~AsynchronousOutputBuffer();
+
+  /** Get the target stream. */
+  OStreamType * GetTarget( void ) const
+  {
+    return this->m_Target;
+  }
+
+  /** Switch between synchronous and asynchronous mode. Only the thread
+   * that writes to this buffer may call this. When switching back to
+   * synchronous mode, the queue should be written first.
+   */
+  void SetAsynchronous( bool asynchronous );
+
+  /** Write the queued characters to the target stream, and flush it.
+   * Thread safe.
+   */
+  void WriteQueuedData( void );
+
+protected:
+
+  /** Implementation of the std::streambuf interface. */
+  virtual int_type overflow( int_type c );
+  virtual std::streamsize xsputn( const char_type * s, std::streamsize n );
+  virtual int sync( void );
+  virtual pos_type seekoff( off_type off, std::ios_base::seekdir dir,
+    std::ios_base::openmode which );
+
+  /** Move the put area to the queue. */
+  void MovePutAreaToQueue( void );
+
+  /** Append to the queue, and signal the queue condition. */
+  void AppendToQueue( const char_type * s, std::streamsize n );
+
+  /** Write to the target, replacing the tabs if desired. */
+  void WriteToTarget( const char_type * s, std::streamsize n );
+
+private:
+
+  AsynchronousOutputBuffer( const AsynchronousOutputBuffer & ); // purposely not implemented
+  void operator=( const AsynchronousOutputBuffer & );         // purposely not implemented
+
+  OStreamType *           m_Target;
+  char                    m_TabReplacement;
+  AsynchronousOutputCondition * m_QueueCondition;
+  bool                    m_Asynchronous;
+  std::vector< char >     m_PutArea;
+  std::string             m_Queue;
+  std::string             m_WriteBuffer;
+  SimpleFastMutexLock     m_QueueLock;
+  SimpleFastMutexLock     m_WriteLock;
+
+  /** For tellp(): the position of the target at construction, or -1 if
+   * it is not seekable, like a console, and the number of characters
+   * written since.
+   */
+  pos_type                m_StartPosition;
+  std::streamsize         m_NumberOfCharacters;
+
+}; // end class AsynchronousOutputBuffer
+
+
+/**
+ * \class AsynchronousOutputWriter
+ * \brief Moves the writing of output streams to a background thread.
+ *
+ * AddOutput() wraps an output stream, such as std::cout or a log file, in
+ * an AsynchronousOutputBuffer, and returns a stream that writes to that
+ * buffer. The returned stream can be used instead of the target stream,
+ * e.g. as an output of xout. All writing to the target should go through
+ * the returned stream, since the target stream itself is not thread safe.
+ *
+ * As long as asynchronous writing is off (the default), the returned
+ * streams pass everything on to their targets immediately. After
+ * SetAsynchronous( true ), the output is queued, and a thread writes the
+ * queues to the targets. The thread sleeps until output is queued, which
+ * happens when a returned stream is flushed (e.g. by std::endl) or its
+ * buffer is full, or until the FlushInterval has passed. Flush() writes
+ * the queues immediately. SetAsynchronous( false ) stops the thread and
+ * writes the remaining output.
+ *
+ * Only one thread (the main thread) should write to the returned streams
+ * and call the methods of this class.
+ *
+ * elastix wraps std::cout and the log file in a global writer, see
+ * SetGlobalWriter(), and enables it with the UseAsynchronousLogging
+ * parameter.
+ *
+ * \ingroup Common
+ */
+
+class AsynchronousOutputWriter : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef AsynchronousOutputWriter    Self;
+  typedef Object                      Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( AsynchronousOutputWriter, Object );
+
+  /** Typedefs. */
+  typedef std::ostream                OStreamType;
+
+  /** Wrap a target stream. The returned stream is owned by this writer.
+   * If tabReplacement is not 0, tabs are replaced by that character.
+   */
+  virtual OStreamType * AddOutput( OStreamType * target, char tabReplacement = 0 );
+
+  /** Write the queued output of the stream returned by AddOutput(), and
+   * delete it. The target stream can be closed after this call.
+   */
+  virtual void RemoveOutput( OStreamType * output );
+
+  /** Switch asynchronous writing on or off. */
+  virtual void SetAsynchronous( bool asynchronous );
+  itkGetConstMacro( Asynchronous, bool );
+
+  /** The maximum time that the writer thread waits for queued output
+   * before it checks the queues anyway, in milliseconds. Default: 500. */
+  itkSetMacro( FlushInterval, unsigned int );
+  itkGetConstMacro( FlushInterval, unsigned int );
+
+  /** Write all queued output now. */
+  virtual void Flush( void );
+
+  /** A global writer, used by elastix for the log file and std::cout.
+   * Returns 0 if it is not set.
+   */
+  static void SetGlobalWriter( Self * writer );
+  static Self * GetGlobalWriter( void );
+
+protected:
+
+  AsynchronousOutputWriter();
+  virtual ~AsynchronousOutputWriter();
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** The function run by the writer thread. */
+  static ITK_THREAD_RETURN_TYPE WriterThreadCallback( void * arg );
+
+  /** Write the queues of all outputs. Called by the writer thread. */
+  virtual void WriteQueuedData( void );
+
+  /** Whether the writer thread should stop. Thread safe. */
+  bool GetStopWriterThread( void );
+
+  /** Typedefs for the outputs. */
+  struct OutputType
+  {
+    AsynchronousOutputBuffer *  m_Buffer;
+    OStreamType *               m_Stream;
+  };
+  typedef std::vector< OutputType >   OutputVectorType;
+
+private:
+
+  AsynchronousOutputWriter( const Self & ); // purposely not implemented
+  void operator=( const Self & );           // purposely not implemented
+
+  OutputVectorType              m_Outputs;
+  SimpleFastMutexLock           m_OutputsLock;
+  bool                          m_Asynchronous;
+  unsigned int                  m_FlushInterval;
+  AsynchronousOutputCondition   m_QueueCondition;
+  bool                          m_StopWriterThread;
+  MultiThreader::Pointer        m_Threader;
+  int                           m_ThreadID;
+
+  static Self *                 m_GlobalWriter;
+
+}; // end class AsynchronousOutputWriter
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkAsynchronousOutputWriter_h
@@ -0,0 +1,206 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkConcurrentCostFunctionEvaluator_cxx
+#define __itkConcurrentCostFunctionEvaluator_cxx
+
+#include "itkConcurrentCostFunctionEvaluator.h"
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+ConcurrentCostFunctionEvaluator
+::ConcurrentCostFunctionEvaluator()
+{
+  this->m_Threader = ThreaderType::New();
+
+} // end Constructor
+
+
+/**
+ * ********************* SetCostFunctions ****************************
+ */
+
+void
+ConcurrentCostFunctionEvaluator
+::SetCostFunctions( const CostFunctionContainerType & costFunctions )
+{
+  this->m_CostFunctions = costFunctions;
+  this->Modified();
+
+} // end SetCostFunctions()
+
+
+/**
+ * ********************* GetValues ****************************
+ */
+
+void
+ConcurrentCostFunctionEvaluator
+::GetValues( const ParametersContainerType & positions,
+  MeasureContainerType & values, FailedContainerType & failed ) const
+{
+  const unsigned int numberOfPositions
+    = static_cast<unsigned int>( positions.size() );
+  const unsigned int numberOfCostFunctions = this->GetNumberOfCostFunctions();
+  if ( numberOfCostFunctions == 0 )
+  {
+    itkExceptionMacro( << "No cost functions are set." );
+  }
+
+  values.assign( numberOfPositions, NumericTraits<MeasureType>::Zero );
+  failed.assign( numberOfPositions, 0 );
+  this->m_Exceptions.resize( numberOfPositions );
+
+  /** Evaluate in the calling thread if there is nothing to share. */
+  if ( numberOfCostFunctions == 1 || numberOfPositions <= 1 )
+  {
+    for ( unsigned int i = 0; i < numberOfPositions; ++i )
+    {
+      this->EvaluatePosition( 0, i, positions, values, failed );
+    }
+    return;
+  }
+
+  /** Update what the cost functions share, in this thread. */
+  if ( this->m_PrepareCommand.IsNotNull() )
+  {
+    this->m_PrepareCommand->Execute( this, StartEvent() );
+  }
+
+  /** All positions are evaluated concurrently, the first cost function
+   * included. */
+  const unsigned int numberOfThreads
+    = std::min( numberOfCostFunctions, numberOfPositions );
+
+  EvaluatorThreaderParameterType str;
+  str.st_Self = this;
+  str.st_Positions = &positions;
+  str.st_Values = &values;
+  str.st_Failed = &failed;
+
+  this->m_Threader->SetNumberOfThreads( numberOfThreads );
+  this->m_Threader->SetSingleMethod( GetValuesThreaderCallback, &str );
+  this->m_Threader->SingleMethodExecute();
+
+} // end GetValues()
+
+
+/**
+ * ********************* GetValues ****************************
+ */
+
+void
+ConcurrentCostFunctionEvaluator
+::GetValues( const ParametersContainerType & positions,
+  MeasureContainerType & values ) const
+{
+  FailedContainerType failed;
+  this->GetValues( positions, values, failed );
+
+  for ( unsigned int i = 0; i < failed.size(); ++i )
+  {
+    if ( failed[ i ] )
+    {
+      throw this->m_Exceptions[ i ];
+    }
+  }
+
+} // end GetValues()
+
+
+/**
+ * ********************* EvaluatePosition ****************************
+ */
+
+void
+ConcurrentCostFunctionEvaluator
+::EvaluatePosition( unsigned int t, unsigned int i,
+  const ParametersContainerType & positions,
+  MeasureContainerType & values, FailedContainerType & failed ) const
+{
+  try
+  {
+    values[ i ] = this->m_CostFunctions[ t ]->GetValue( positions[ i ] );
+  }
+  catch ( ExceptionObject & excp )
+  {
+    this->m_Exceptions[ i ] = excp;
+    failed[ i ] = 1;
+  }
+  catch ( std::exception & excp )
+  {
+    this->m_Exceptions[ i ] = ExceptionObject( __FILE__, __LINE__,
+      excp.what(), "ConcurrentCostFunctionEvaluator - GetValues()" );
+    failed[ i ] = 1;
+  }
+
+} // end EvaluatePosition()
+
+
+/**
+ * ***************** GetValuesThreaderCallback *******************
+ */
+
+ITK_THREAD_RETURN_TYPE
+ConcurrentCostFunctionEvaluator
+::GetValuesThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>( arg );
+  const unsigned int threadID = infoStruct->ThreadID;
+  const unsigned int numberOfThreads = infoStruct->NumberOfThreads;
+  EvaluatorThreaderParameterType * temp
+    = static_cast<EvaluatorThreaderParameterType *>( infoStruct->UserData );
+
+  /** Thread t evaluates positions t, t + numberOfThreads, ..., with cost
+   * function t. Each thread writes only its own entries.
+   */
+  const unsigned int numberOfPositions
+    = static_cast<unsigned int>( temp->st_Positions->size() );
+  for ( unsigned int i = threadID; i < numberOfPositions; i += numberOfThreads )
+  {
+    temp->st_Self->EvaluatePosition( threadID, i,
+      *( temp->st_Positions ), *( temp->st_Values ), *( temp->st_Failed ) );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end GetValuesThreaderCallback()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+void
+ConcurrentCostFunctionEvaluator
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfCostFunctions: "
+    << this->GetNumberOfCostFunctions() << std::endl;
+  os << indent << "PrepareCommand: "
+    << this->m_PrepareCommand.GetPointer() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkConcurrentCostFunctionEvaluator_cxx
@@ -0,0 +1,168 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkConcurrentCostFunctionEvaluator_h
+#define __itkConcurrentCostFunctionEvaluator_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkSingleValuedCostFunction.h"
+#include "itkMultiThreader.h"
+#include "itkCommand.h"
+#include "itkEventObject.h"
+#include <vector>
+#include <algorithm>
+
+namespace itk
+{
+
+/**
+ * \class ConcurrentCostFunctionEvaluator
+ * \brief Evaluates a cost function at a list of positions, concurrently.
+ *
+ * Optimizers such as CMAEvolutionStrategyOptimizer, FullSearchOptimizer and
+ * the finite difference optimizers evaluate the cost function at several
+ * positions that do not depend on each other. A cost function, such as an
+ * image metric, can in general not be evaluated by two threads at the same
+ * time, since it sets the transform parameters and keeps intermediate
+ * results in member variables. This class therefore needs independent
+ * copies of the cost function: one per thread.
+ *
+ * GetValues() first executes the PrepareCommand, if set, in the calling
+ * thread. It updates what the copies share with the first cost function
+ * and can not update themselves, such as the image samples of a metric,
+ * see AdvancedImageToImageMetric::PrepareConcurrentEvaluation(). Then all
+ * positions are evaluated by T = min( number of cost functions, number of
+ * positions ) threads: thread t uses cost function t and evaluates the
+ * positions t, t + T, ... The value at a position does not depend on the
+ * thread that computes it, so the results are the same as with a
+ * sequential evaluation, as long as the copies are equal. With a single
+ * cost function, or a single position, the positions are evaluated in the
+ * calling thread, and the PrepareCommand is not executed.
+ *
+ * Exceptions thrown by a cost function are stored per position, since they
+ * can not be thrown across threads.
+ *
+ * \ingroup Numerics Optimizers
+ */
+
+class ConcurrentCostFunctionEvaluator : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef ConcurrentCostFunctionEvaluator   Self;
+  typedef Object                            Superclass;
+  typedef SmartPointer<Self>                Pointer;
+  typedef SmartPointer<const Self>          ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ConcurrentCostFunctionEvaluator, Object );
+
+  /** Typedefs. */
+  typedef SingleValuedCostFunction                  CostFunctionType;
+  typedef CostFunctionType::Pointer                 CostFunctionPointer;
+  typedef CostFunctionType::ParametersType          ParametersType;
+  typedef CostFunctionType::MeasureType             MeasureType;
+  typedef std::vector< CostFunctionPointer >        CostFunctionContainerType;
+  typedef std::vector< ParametersType >             ParametersContainerType;
+  typedef std::vector< MeasureType >                MeasureContainerType;
+  typedef std::vector< unsigned char >              FailedContainerType;
+
+  /** Set/Get the cost function, followed by its independent copies, one per
+   * thread. */
+  virtual void SetCostFunctions( const CostFunctionContainerType & costFunctions );
+  virtual const CostFunctionContainerType & GetCostFunctions( void ) const
+  {
+    return this->m_CostFunctions;
+  }
+
+  /** The number of cost functions, which is the maximum number of threads. */
+  virtual unsigned int GetNumberOfCostFunctions( void ) const
+  {
+    return static_cast<unsigned int>( this->m_CostFunctions.size() );
+  }
+
+  /** Set/Get the command that is executed in the calling thread before
+   * the positions are evaluated concurrently. */
+  itkSetObjectMacro( PrepareCommand, Command );
+  itkGetObjectMacro( PrepareCommand, Command );
+
+  /** Compute the values at the positions. If the evaluation at position i
+   * throws an exception, failed[ i ] is set to 1, and the exception can be
+   * retrieved with GetException( i ).
+   */
+  virtual void GetValues( const ParametersContainerType & positions,
+    MeasureContainerType & values, FailedContainerType & failed ) const;
+
+  /** Compute the values at the positions. Rethrows the exception of the
+   * first position at which the evaluation failed.
+   */
+  virtual void GetValues( const ParametersContainerType & positions,
+    MeasureContainerType & values ) const;
+
+  /** The exception thrown at position i in the last call to GetValues(). */
+  virtual const ExceptionObject & GetException( unsigned int i ) const
+  {
+    return this->m_Exceptions[ i ];
+  }
+
+protected:
+
+  ConcurrentCostFunctionEvaluator();
+  virtual ~ConcurrentCostFunctionEvaluator() {}
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Typedefs for multi-threading. */
+  typedef MultiThreader                         ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct        ThreadInfoType;
+
+  /** The data that is passed to the threads. */
+  struct EvaluatorThreaderParameterType
+  {
+    const Self *                    st_Self;
+    const ParametersContainerType * st_Positions;
+    MeasureContainerType *          st_Values;
+    FailedContainerType *           st_Failed;
+  };
+
+  /** Evaluate position i with cost function t, and catch exceptions. */
+  virtual void EvaluatePosition( unsigned int t, unsigned int i,
+    const ParametersContainerType & positions,
+    MeasureContainerType & values, FailedContainerType & failed ) const;
+
+  /** The threader callback. */
+  static ITK_THREAD_RETURN_TYPE GetValuesThreaderCallback( void * arg );
+
+private:
+
+  ConcurrentCostFunctionEvaluator( const Self & ); // purposely not implemented
+  void operator=( const Self & );                  // purposely not implemented
+
+  CostFunctionContainerType                 m_CostFunctions;
+  ThreaderType::Pointer                     m_Threader;
+  Command::Pointer                          m_PrepareCommand;
+  mutable std::vector< ExceptionObject >    m_Exceptions;
+
+}; // end class ConcurrentCostFunctionEvaluator
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkConcurrentCostFunctionEvaluator_h
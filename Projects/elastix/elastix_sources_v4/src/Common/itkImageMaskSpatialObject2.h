@@ -81,6 +81,16 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro( ImageMaskSpatialObject2, ImageSpatialObject2 );
 
+  /** Set the image. Also computes the world to index transform that is
+   * used by IsInside(). */
+  void SetImage( const ImageType * image );
+
+  /** Compute the world to index transform that is used by IsInside().
+   * This is done by SetImage(); call it again after changing the object
+   * to parent transform. IsInside() does not modify the object, so that
+   * it can be called by several threads at the same time. */
+  void ComputeWorldToIndexTransform( void );
+
   /** Returns true if the point is inside, false otherwise. */
   bool IsInside( const PointType & point,
                  unsigned int depth, char *name) const;
@@ -116,6 +126,9 @@ protected:
 
   void PrintSelf( std::ostream& os, Indent indent ) const;
 
+  typename TransformType::Pointer m_WorldToIndexTransform;
+  bool                            m_WorldToIndexTransformIsValid;
+
 };
 
 } // end of namespace itk
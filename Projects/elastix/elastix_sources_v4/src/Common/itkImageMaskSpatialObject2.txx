@@ -48,6 +48,8 @@ ImageMaskSpatialObject2< TDimension>
 ::ImageMaskSpatialObject2()
 {
   this->SetTypeName("ImageMaskSpatialObject2");
+  this->m_WorldToIndexTransform = TransformType::New();
+  this->m_WorldToIndexTransformIsValid = false;
   this->ComputeBoundingBox();
 }
 
@@ -59,6 +61,30 @@ ImageMaskSpatialObject2< TDimension>
 }
 
 
+/** Set the image and compute the world to index transform. */
+template< unsigned int TDimension >
+void
+ImageMaskSpatialObject2< TDimension >
+::SetImage( const ImageType * image )
+{
+  this->Superclass::SetImage( image );
+  this->ComputeWorldToIndexTransform();
+}
+
+
+/** Compute the inverse of the index to world transform, once, instead of
+ * in every call to IsInside(). */
+template< unsigned int TDimension >
+void
+ImageMaskSpatialObject2< TDimension >
+::ComputeWorldToIndexTransform( void )
+{
+  this->m_WorldToIndexTransformIsValid
+    = this->GetIndexToWorldTransform()->GetInverse(
+    this->m_WorldToIndexTransform );
+}
+
+
 /** Test whether a point is inside or outside the object
 *  For computational speed purposes, it is faster if the method does not
 *  check the name of the class and the current depth */
@@ -71,12 +97,12 @@ ImageMaskSpatialObject2< TDimension >
   {
     return false;
   }
-  if( !this->SetInternalInverseTransformToWorldToIndexTransform() )
+  if( !this->m_WorldToIndexTransformIsValid )
   {
     return false;
   }
 
-  PointType p = this->GetInternalInverseTransform()->TransformPoint(point);
+  PointType p = this->m_WorldToIndexTransform->TransformPoint(point);
 
   IndexType index;
   for(unsigned int i=0; i<TDimension; i++)
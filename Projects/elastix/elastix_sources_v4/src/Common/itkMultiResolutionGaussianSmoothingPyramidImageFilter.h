@@ -114,6 +114,13 @@ namespace itk
  *
  * This filter supports streaming.
  *
+ * By default all levels are computed at once. After
+ * SetComputeOnlyForCurrentLevel( true ) only the output of the level
+ * set by SetCurrentLevel() is computed; the outputs of the other levels
+ * are left empty. Changing the current level makes the filter compute
+ * the new level on the next update, and releases the previous one. This
+ * way only one level of the pyramid is in memory at a time.
+ *
  * \ingroup PyramidImageFilter Multithreaded Streamed
  */
 template <
@@ -165,6 +172,17 @@ public:
    */
   void SetSchedule( const ScheduleType& schedule );
 
+  /** Set/Get the level that is computed when ComputeOnlyForCurrentLevel
+   * is true. */
+  itkSetMacro( CurrentLevel, unsigned int );
+  itkGetConstMacro( CurrentLevel, unsigned int );
+
+  /** Set/Get whether only the output of the current level is computed.
+   * Default: false, i.e. all levels are computed. */
+  itkSetMacro( ComputeOnlyForCurrentLevel, bool );
+  itkGetConstMacro( ComputeOnlyForCurrentLevel, bool );
+  itkBooleanMacro( ComputeOnlyForCurrentLevel );
+
   /** Set spacing etc. */
   virtual void GenerateOutputInformation();
 
@@ -194,6 +212,10 @@ protected:
    * because it uses internally a filter that does this. */
   virtual void EnlargeOutputRequestedRegion(DataObject *output);
 
+  /** Member variables. */
+  unsigned int  m_CurrentLevel;
+  bool          m_ComputeOnlyForCurrentLevel;
+
 
 private:
   MultiResolutionGaussianSmoothingPyramidImageFilter(const Self&); //purposely not implemented
@@ -51,6 +51,8 @@ template <class TInputImage, class TOutputImage>
 MultiResolutionGaussianSmoothingPyramidImageFilter<TInputImage, TOutputImage>
 ::MultiResolutionGaussianSmoothingPyramidImageFilter()
 {
+  this->m_CurrentLevel = 0;
+  this->m_ComputeOnlyForCurrentLevel = false;
 }
 
 
@@ -146,6 +148,12 @@ MultiResolutionGaussianSmoothingPyramidImageFilter<TInputImage, TOutputImage>
 
   for( ilevel = 0; ilevel < this->m_NumberOfLevels; ilevel++ )
   {
+    /** Skip the other levels if only the current level is needed.
+     * Their outputs have been released by PrepareOutputs(). */
+    if ( this->m_ComputeOnlyForCurrentLevel && ilevel != this->m_CurrentLevel )
+    {
+      continue;
+    }
 
     this->UpdateProgress( static_cast<float>( ilevel ) /
                           static_cast<float>( this->m_NumberOfLevels ) );
@@ -223,6 +231,10 @@ MultiResolutionGaussianSmoothingPyramidImageFilter<TInputImage, TOutputImage>
 ::PrintSelf(std::ostream& os, Indent indent) const
 {
   Superclass::PrintSelf(os,indent);
+
+  os << indent << "CurrentLevel: " << this->m_CurrentLevel << std::endl;
+  os << indent << "ComputeOnlyForCurrentLevel: "
+    << ( this->m_ComputeOnlyForCurrentLevel ? "true" : "false" ) << std::endl;
 }
 
 
@@ -294,7 +306,30 @@ MultiResolutionGaussianSmoothingPyramidImageFilter<TInputImage, TOutputImage>
 
   unsigned int ilevel;
 
-  if ( ptr->GetRequestedRegion() == ptr->GetLargestPossibleRegion() )
+  if ( this->m_ComputeOnlyForCurrentLevel )
+  {
+    /** Request the current level completely, and nothing of the other
+     * levels, whichever output triggered the update. The latter makes
+     * sure that an update of another output, such as the Update() of
+     * the metric on output 0, does not recompute the pyramid. */
+    for( ilevel = 0; ilevel < this->m_NumberOfLevels; ilevel++ )
+    {
+      if( !this->GetOutput(ilevel) ) { continue; }
+
+      if ( ilevel == this->m_CurrentLevel )
+      {
+        this->GetOutput(ilevel)->SetRequestedRegionToLargestPossibleRegion();
+      }
+      else
+      {
+        RegionType emptyRegion;
+        emptyRegion.SetIndex(
+          this->GetOutput(ilevel)->GetLargestPossibleRegion().GetIndex() );
+        this->GetOutput(ilevel)->SetRequestedRegion( emptyRegion );
+      }
+    }
+  }
+  else if ( ptr->GetRequestedRegion() == ptr->GetLargestPossibleRegion() )
   {
 
     // set the requested regions for the other outputs to their
@@ -195,7 +195,12 @@ MultiResolutionImageRegistrationMethod2<TFixedImage,TMovingImage>
     itkExceptionMacro(<<"Moving image pyramid is not present");
     }
 
-  // Setup the fixed image pyramid
+  // Setup the fixed image pyramid.
+  // Pyramids that compute only their current level (see for example
+  // MultiResolutionGaussianSmoothingPyramidImageFilter::
+  // SetComputeOnlyForCurrentLevel()) generate only that level here; the
+  // other levels are computed when the current level is changed before
+  // each resolution. The regions below only need the output information.
   this->m_FixedImagePyramid->SetNumberOfLevels( this->m_NumberOfLevels );
   this->m_FixedImagePyramid->SetInput( this->m_FixedImage );
   this->m_FixedImagePyramid->UpdateLargestPossibleRegion();
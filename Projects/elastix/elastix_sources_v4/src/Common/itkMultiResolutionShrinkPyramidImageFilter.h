@@ -28,6 +28,10 @@ namespace itk
  * No smoothing or any other operation is performed. This is useful for
  * example for registering binary images.
  *
+ * After SetComputeOnlyForCurrentLevel( true ) only the output of the level
+ * set by SetCurrentLevel() is computed, like in the
+ * MultiResolutionGaussianSmoothingPyramidImageFilter.
+ *
  * \sa ShrinkImageFilter
  *
  * \ingroup PyramidImageFilter Multithreaded Streamed
@@ -67,9 +71,25 @@ public:
   typedef typename Superclass::OutputImagePointer     OutputImagePointer;
   typedef typename Superclass::InputImageConstPointer InputImageConstPointer;
 
+  /** Set/Get the level that is computed when ComputeOnlyForCurrentLevel
+   * is true. */
+  itkSetMacro( CurrentLevel, unsigned int );
+  itkGetConstMacro( CurrentLevel, unsigned int );
+
+  /** Set/Get whether only the output of the current level is computed.
+   * Default: false, i.e. all levels are computed. */
+  itkSetMacro( ComputeOnlyForCurrentLevel, bool );
+  itkGetConstMacro( ComputeOnlyForCurrentLevel, bool );
+  itkBooleanMacro( ComputeOnlyForCurrentLevel );
+
   /** Overwrite the Superclass implementation: no padding required. */
   virtual void GenerateInputRequestedRegion( void );
 
+  /** When only the current level is computed, request the complete
+   * current level and nothing of the other levels. Otherwise the
+   * Superclass implementation is used. */
+  virtual void GenerateOutputRequestedRegion( DataObject * refOutput );
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro(SameDimensionCheck,
@@ -80,12 +100,19 @@ public:
 #endif
 
 protected:
-  MultiResolutionShrinkPyramidImageFilter() {};
+  MultiResolutionShrinkPyramidImageFilter();
   ~MultiResolutionShrinkPyramidImageFilter() {};
 
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
   /** Generate the output data. */
   virtual void GenerateData( void );
 
+  /** Member variables. */
+  unsigned int  m_CurrentLevel;
+  bool          m_ComputeOnlyForCurrentLevel;
+
 private:
   MultiResolutionShrinkPyramidImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
@@ -26,6 +26,18 @@
 namespace itk
 {
 
+/*
+ * Constructor
+ */
+template <class TInputImage, class TOutputImage>
+MultiResolutionShrinkPyramidImageFilter<TInputImage, TOutputImage>
+::MultiResolutionShrinkPyramidImageFilter()
+{
+  this->m_CurrentLevel = 0;
+  this->m_ComputeOnlyForCurrentLevel = false;
+} // end Constructor
+
+
 /*
  * GenerateData
  */
@@ -43,6 +55,12 @@ MultiResolutionShrinkPyramidImageFilter<TInputImage, TOutputImage>
   unsigned int factors[ ImageDimension ];
   for ( unsigned int ilevel = 0; ilevel < this->m_NumberOfLevels; ilevel++ )
   {
+    /** Skip the other levels if only the current level is needed. */
+    if ( this->m_ComputeOnlyForCurrentLevel && ilevel != this->m_CurrentLevel )
+    {
+      continue;
+    }
+
     this->UpdateProgress( static_cast<float>( ilevel )
       / static_cast<float>( this->m_NumberOfLevels ) );
 
@@ -77,9 +95,70 @@ MultiResolutionShrinkPyramidImageFilter<TInputImage, TOutputImage>
 {
   // call the superclass' implementation of this method
   Superclass::Superclass::GenerateInputRequestedRegion();
+
+  /** The shrinker of the current level may need any part of the input,
+   * since the requested region of output 0 may be empty. */
+  if ( this->m_ComputeOnlyForCurrentLevel )
+  {
+    InputImagePointer image = const_cast<InputImageType *>( this->GetInput() );
+    if ( image )
+    {
+      image->SetRequestedRegionToLargestPossibleRegion();
+    }
+  }
 }
 
 
+/**
+ * GenerateOutputRequestedRegion
+ */
+template <class TInputImage, class TOutputImage>
+void
+MultiResolutionShrinkPyramidImageFilter<TInputImage, TOutputImage>
+::GenerateOutputRequestedRegion( DataObject * refOutput )
+{
+  if ( !this->m_ComputeOnlyForCurrentLevel )
+  {
+    Superclass::GenerateOutputRequestedRegion( refOutput );
+    return;
+  }
+
+  typedef typename OutputImageType::RegionType  RegionType;
+  for ( unsigned int ilevel = 0; ilevel < this->m_NumberOfLevels; ilevel++ )
+  {
+    OutputImageType * outputPtr = this->GetOutput( ilevel );
+    if ( !outputPtr ) continue;
+
+    if ( ilevel == this->m_CurrentLevel )
+    {
+      outputPtr->SetRequestedRegionToLargestPossibleRegion();
+    }
+    else
+    {
+      RegionType emptyRegion;
+      emptyRegion.SetIndex( outputPtr->GetLargestPossibleRegion().GetIndex() );
+      outputPtr->SetRequestedRegion( emptyRegion );
+    }
+  }
+} // end GenerateOutputRequestedRegion()
+
+
+/**
+ * PrintSelf
+ */
+template <class TInputImage, class TOutputImage>
+void
+MultiResolutionShrinkPyramidImageFilter<TInputImage, TOutputImage>
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "CurrentLevel: " << this->m_CurrentLevel << std::endl;
+  os << indent << "ComputeOnlyForCurrentLevel: "
+    << ( this->m_ComputeOnlyForCurrentLevel ? "true" : "false" ) << std::endl;
+} // end PrintSelf()
+
+
 } // namespace itk
 
 #endif
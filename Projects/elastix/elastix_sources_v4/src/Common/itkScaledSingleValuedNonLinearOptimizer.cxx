@@ -29,6 +29,8 @@ namespace itk
   {
     this->m_Maximize = false;
     this->m_ScaledCostFunction = ScaledCostFunctionType::New();
+    this->m_ConcurrentEvaluator = ConcurrentEvaluatorType::New();
+    this->UpdateConcurrentEvaluator();
 
   } // end constructor
 
@@ -43,6 +45,7 @@ namespace itk
     /** NB: we assume the scales entered by the user are meant
      * as squared scales (following the ITK convention)! */
     this->m_ScaledCostFunction->SetSquaredScales( this->GetScales() );
+    this->UpdateConcurrentEvaluator();
     this->Modified();
   } // end InitializeScales
 
@@ -68,6 +71,7 @@ namespace itk
     ScaledSingleValuedNonLinearOptimizer::SetUseScales(bool arg)
   {
     this->m_ScaledCostFunction->SetUseScales(arg);
+    this->UpdateConcurrentEvaluator();
     this->Modified();
   } // end SetUseScales
 
@@ -214,11 +218,77 @@ namespace itk
     {
       this->m_Maximize = _arg;
       this->m_ScaledCostFunction->SetNegateCostFunction(_arg);
+      this->UpdateConcurrentEvaluator();
       this->Modified();
     }
   }  // end SetMaximize
 
 
+  /**
+   * ******************** SetConcurrentCostFunctions *****************
+   */
+
+  void
+    ScaledSingleValuedNonLinearOptimizer::
+    SetConcurrentCostFunctions( const CostFunctionContainerType & costFunctions )
+  {
+    this->m_ConcurrentCostFunctions = costFunctions;
+    this->UpdateConcurrentEvaluator();
+    this->Modified();
+
+  } // end SetConcurrentCostFunctions
+
+
+  /**
+   * ******************** UpdateConcurrentEvaluator *****************
+   */
+
+  void
+    ScaledSingleValuedNonLinearOptimizer::UpdateConcurrentEvaluator( void )
+  {
+    /** Without copies, the scaled cost function itself is evaluated. */
+    CostFunctionContainerType scaledCostFunctions;
+    if ( this->m_ConcurrentCostFunctions.size() == 0 )
+    {
+      scaledCostFunctions.push_back( this->m_ScaledCostFunction.GetPointer() );
+      this->m_ConcurrentEvaluator->SetCostFunctions( scaledCostFunctions );
+      return;
+    }
+
+    /** Wrap each copy in a scaled cost function with the same settings. */
+    for ( unsigned int i = 0; i < this->m_ConcurrentCostFunctions.size(); ++i )
+    {
+      ScaledCostFunctionPointer scaledCostFunction = ScaledCostFunctionType::New();
+      scaledCostFunction->SetUnscaledCostFunction(
+        this->m_ConcurrentCostFunctions[ i ] );
+      scaledCostFunction->SetSquaredScales(
+        this->m_ScaledCostFunction->GetSquaredScales() );
+      scaledCostFunction->SetUseScales(
+        this->m_ScaledCostFunction->GetUseScales() );
+      scaledCostFunction->SetNegateCostFunction(
+        this->m_ScaledCostFunction->GetNegateCostFunction() );
+      scaledCostFunctions.push_back( scaledCostFunction.GetPointer() );
+    }
+    this->m_ConcurrentEvaluator->SetCostFunctions( scaledCostFunctions );
+
+  } // end UpdateConcurrentEvaluator
+
+
+  /**
+   * ********************* GetScaledValues *****************************
+   */
+
+  void
+    ScaledSingleValuedNonLinearOptimizer::
+    GetScaledValues(
+      const ParametersContainerType & positions,
+      MeasureContainerType & values,
+      FailedContainerType & failed ) const
+  {
+    this->m_ConcurrentEvaluator->GetValues( positions, values, failed );
+  } // end GetScaledValues
+
+
 
 } // end namespace itk
 
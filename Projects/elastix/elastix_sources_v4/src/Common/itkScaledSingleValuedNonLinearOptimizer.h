@@ -17,6 +17,7 @@
 
 #include "itkSingleValuedNonLinearOptimizer.h"
 #include "itkScaledSingleValuedCostFunction.h"
+#include "itkConcurrentCostFunctionEvaluator.h"
 
 namespace itk
 {
@@ -54,6 +55,12 @@ namespace itk
    * So, if you want a scaling s, you must call SetScales(\f$s.*s\f$) (where .*
    * symbolises the element-wise product of \f$s\f$ with \f$s\f$)
    *
+   * Optimizers that need the value at several independent positions can
+   * use GetScaledValues(). If independent copies of the cost function are
+   * set with SetConcurrentCostFunctions(), the positions are evaluated
+   * concurrently, one thread per cost function. Otherwise they are evaluated
+   * one after the other.
+   *
    */
 
   class ScaledSingleValuedNonLinearOptimizer :
@@ -84,6 +91,16 @@ namespace itk
     typedef ScaledSingleValuedCostFunction        ScaledCostFunctionType;
     typedef ScaledCostFunctionType::Pointer       ScaledCostFunctionPointer;
 
+    typedef ConcurrentCostFunctionEvaluator       ConcurrentEvaluatorType;
+    typedef ConcurrentEvaluatorType::CostFunctionContainerType
+      CostFunctionContainerType;
+    typedef ConcurrentEvaluatorType::ParametersContainerType
+      ParametersContainerType;
+    typedef ConcurrentEvaluatorType::MeasureContainerType
+      MeasureContainerType;
+    typedef ConcurrentEvaluatorType::FailedContainerType
+      FailedContainerType;
+
     /** Configure the scaled cost function. This function
      * sets the current scales in the ScaledCostFunction.
      * NB: it assumes that the scales entered by the user
@@ -121,6 +138,25 @@ namespace itk
     virtual void SetMaximize( bool _arg );
     itkGetConstMacro( Maximize, bool );
 
+    /** Set/Get independent copies of the (unscaled) cost function, which
+     * are used by GetScaledValues() to evaluate several positions
+     * concurrently. The copies are scaled in the same way as the cost
+     * function. An empty container means sequential evaluation.
+     */
+    virtual void SetConcurrentCostFunctions(
+      const CostFunctionContainerType & costFunctions );
+    virtual const CostFunctionContainerType & GetConcurrentCostFunctions( void ) const
+    {
+      return this->m_ConcurrentCostFunctions;
+    }
+
+    /** Set the command that prepares the cost function and its copies for
+     * a concurrent evaluation, see ConcurrentCostFunctionEvaluator. */
+    virtual void SetConcurrentPrepareCommand( Command * command )
+    {
+      this->m_ConcurrentEvaluator->SetPrepareCommand( command );
+    }
+
   protected:
 
     /** The constructor. */
@@ -171,6 +207,22 @@ namespace itk
       MeasureType & value,
       DerivativeType & derivative ) const;
 
+    /** Compute the values at several (scaled) positions, concurrently if
+     * concurrent cost functions are set. If the evaluation at position i
+     * fails, failed[ i ] is set to 1; the exception can be retrieved with
+     * GetScaledValuesException( i ).
+     */
+    virtual void GetScaledValues(
+      const ParametersContainerType & positions,
+      MeasureContainerType & values,
+      FailedContainerType & failed ) const;
+
+    /** The exception thrown at position i in the last call to GetScaledValues(). */
+    virtual const ExceptionObject & GetScaledValuesException( unsigned int i ) const
+    {
+      return this->m_ConcurrentEvaluator->GetException( i );
+    }
+
   private:
 
     /** The private constructor. */
@@ -186,6 +238,14 @@ namespace itk
 
     bool                            m_Maximize;
 
+    /** Pass the scaled copies of the concurrent cost functions to the
+     * evaluator, with the current scales and settings.
+     */
+    void UpdateConcurrentEvaluator( void );
+
+    CostFunctionContainerType           m_ConcurrentCostFunctions;
+    ConcurrentEvaluatorType::Pointer    m_ConcurrentEvaluator;
+
   }; // end class ScaledSingleValuedNonLinearOptimizer
 
 
@@ -87,6 +87,17 @@ using namespace itk;
 
   protected:
 
+    /** Reuse the images of the previous registration, if possible.
+     * Otherwise compute them, and keep them if desired. */
+    virtual void GenerateData( void )
+    {
+      if ( !this->GraftCachedPyramidImages() )
+      {
+        this->Superclass1::GenerateData();
+        this->StorePyramidImagesInCache();
+      }
+    }
+
     /** The constructor. */
     FixedRecursivePyramid() {}
     /** The destructor. */
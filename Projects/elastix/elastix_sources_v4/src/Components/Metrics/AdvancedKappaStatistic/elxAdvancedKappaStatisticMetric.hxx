@@ -36,7 +36,7 @@ AdvancedKappaStatisticMetric<TElastix>
   this->Superclass1::Initialize();
   timer->StopTimer();
   elxout << "Initialization of AdvancedKappaStatistic metric took: "
-    << static_cast<long>( timer->GetElapsedClockSec() * 1000 )
+    << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 )
     << " ms." << std::endl;
 
 } // end Initialize()
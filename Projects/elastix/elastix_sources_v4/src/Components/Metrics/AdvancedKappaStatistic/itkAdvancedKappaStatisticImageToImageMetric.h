@@ -175,6 +175,7 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType  CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType          MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType         NonZeroJacobianIndicesType;
+  typedef typename Superclass::AdvancedImageToImageMetricType     AdvancedImageToImageMetricType;
 
   /** Computes the inner product of transform Jacobian with moving image gradient.
    * The results are stored in the imageJacobian, which is supposed
@@ -199,6 +200,9 @@ protected:
     DerivativeType & sum1,
     DerivativeType & sum2 ) const;
 
+  /** Copy the foreground settings to the concurrent copy. */
+  virtual void InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const;
+
 private:
   AdvancedKappaStatisticImageToImageMetric(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
@@ -32,6 +32,7 @@ AdvancedKappaStatisticImageToImageMetric<TFixedImage,TMovingImage>
   this->SetUseImageSampler( true );
   this->SetUseFixedImageLimiter( false );
   this->SetUseMovingImageLimiter( false );
+  this->m_SupportsConcurrentCopies = true;
 
   this->m_ForegroundValue = 1.0;
   this->m_Epsilon = 1e-3;
@@ -58,6 +59,30 @@ AdvancedKappaStatisticImageToImageMetric<TFixedImage,TMovingImage>
 } // end PrintSelf()
 
 
+/**
+ * ******************* InitializeConcurrentCopy *******************
+ */
+
+template < class TFixedImage, class TMovingImage>
+void
+AdvancedKappaStatisticImageToImageMetric<TFixedImage,TMovingImage>
+::InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const
+{
+  /** Call the superclass' implementation. */
+  this->Superclass::InitializeConcurrentCopy( copy );
+
+  Self * thisCopy = dynamic_cast<Self *>( copy );
+  if ( thisCopy == 0 )
+  {
+    itkExceptionMacro( << "The concurrent copy is not a " << this->GetNameOfClass() );
+  }
+  thisCopy->m_ForegroundValue = this->m_ForegroundValue;
+  thisCopy->m_Epsilon = this->m_Epsilon;
+  thisCopy->m_Complement = this->m_Complement;
+
+} // end InitializeConcurrentCopy()
+
+
 /**
  * *************** EvaluateMovingImageAndTransformJacobianInnerProduct ****************
  */
@@ -111,10 +136,8 @@ AdvancedKappaStatisticImageToImageMetric<TFixedImage,TMovingImage>
   this->GetImageSampler()->Update();
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+  /** Get the number of samples in the sample container. */
+  const unsigned long numberOfSamples = sampleContainer->Size();
 
   /** Some variables. */
   RealType movingImageValue;
@@ -124,10 +147,10 @@ AdvancedKappaStatisticImageToImageMetric<TFixedImage,TMovingImage>
   std::size_t intersection         = 0;
 
   /** Loop over the fixed image samples to calculate the kappa statistic. */
-  for ( fiter = fbegin; fiter != fend; ++fiter )
+  for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
   {
     /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    const FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
 
     /** Transform point and check if it is inside the B-spline support region. */
     bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
@@ -154,7 +177,7 @@ AdvancedKappaStatisticImageToImageMetric<TFixedImage,TMovingImage>
 
       /** Get the fixed image value. */
       const RealType & fixedImageValue
-        = static_cast<RealType>( (*fiter).Value().m_ImageValue );
+        = static_cast<RealType>( sampleContainer->GetImageValue( pos ) );
 
       /** Update the intermediate values. */
       const RealType diffFixed = vnl_math_abs( fixedImageValue - this->m_ForegroundValue );
@@ -252,16 +275,14 @@ AdvancedKappaStatisticImageToImageMetric<TFixedImage,TMovingImage>
   vecSum1.Fill( NumericTraits< DerivativeValueType >::Zero );
   vecSum2.Fill( NumericTraits< DerivativeValueType >::Zero );
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+  /** Get the number of samples in the sample container. */
+  const unsigned long numberOfSamples = sampleContainer->Size();
 
   /** Loop over the fixed image to calculate the kappa statistic. */
-  for ( fiter = fbegin; fiter != fend; ++fiter )
+  for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
   {
     /** Read fixed coordinates. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    const FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
 
     /** Transform point and check if it is inside the B-spline support region. */
     bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
@@ -289,7 +310,7 @@ AdvancedKappaStatisticImageToImageMetric<TFixedImage,TMovingImage>
 
       /** Get the fixed image value. */
       const RealType & fixedImageValue
-        = static_cast<RealType>( (*fiter).Value().m_ImageValue );
+        = static_cast<RealType>( sampleContainer->GetImageValue( pos ) );
 
       /** Get the TransformJacobian dT/dmu. */
       this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
@@ -91,6 +91,14 @@ using namespace itk;
    *    B-spline grids.
    *    example: <tt>(UseFastAndLowMemoryVersion "false")</tt> \n
    *    The default is "true".
+   * \parameter MaximumDenseJointPDFDerivativesSize: Only used when
+   *    UseFastAndLowMemoryVersion is "false". The maximum number of elements
+   *    of the 3D matrix described above. If it would be larger, and the
+   *    transform is a B-spline like transform, only the nonzero parts of the
+   *    matrix are stored. Can be given for each resolution, or for all
+   *    resolutions at once. \n
+   *    example: <tt>(MaximumDenseJointPDFDerivativesSize 1000000)</tt> \n
+   *    The default is 16777216 (2^24).
    *
    * \sa ParzenWindowMutualInformationImageToImageMetric
    * \ingroup Metrics
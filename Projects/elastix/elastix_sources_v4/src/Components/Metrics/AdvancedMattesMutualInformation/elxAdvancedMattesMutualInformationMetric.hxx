@@ -53,7 +53,7 @@ using namespace itk;
     this->Superclass1::Initialize();
     timer->StopTimer();
     elxout << "Initialization of AdvancedMattesMutualInformation metric took: "
-      << static_cast<long>( timer->GetElapsedClockSec() * 1000 ) << " ms." << std::endl;
+      << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 ) << " ms." << std::endl;
 
   } // end Initialize()
 
@@ -118,6 +118,12 @@ using namespace itk;
       "UseFastAndLowMemoryVersion", this->GetComponentLabel(), level, 0 );
     this->SetUseExplicitPDFDerivatives( !useFastAndLowMemoryVersion );
 
+    /** Set above which size the explicit pdf derivatives are stored sparsely. */
+    unsigned long maximumDenseJointPDFDerivativesSize = 1UL << 24;
+    this->GetConfiguration()->ReadParameter( maximumDenseJointPDFDerivativesSize,
+      "MaximumDenseJointPDFDerivativesSize", this->GetComponentLabel(), level, 0 );
+    this->SetMaximumDenseJointPDFDerivativesSize( maximumDenseJointPDFDerivativesSize );
+
     /** Set whether to use Nick Tustison's preconditioning technique. */
     bool useJacobianPreconditioning = false;
     this->GetConfiguration()->ReadParameter( useJacobianPreconditioning,
@@ -185,6 +185,7 @@ namespace itk
     typedef typename Superclass::ParzenValueContainerType           ParzenValueContainerType;
     typedef typename Superclass::KernelFunctionType                 KernelFunctionType;
     typedef typename Superclass::NonZeroJacobianIndicesType         NonZeroJacobianIndicesType;
+    typedef typename Superclass::AdvancedImageToImageMetricType     AdvancedImageToImageMetricType;
 
     /**  Get the value and analytic derivatives for single valued optimizers.
      * Called by GetValueAndDerivative if UseFiniteDifferenceDerivative == false.
@@ -217,6 +218,9 @@ namespace itk
     /** Some initialization functions, called by Initialize. */
     virtual void InitializeHistograms( void );
 
+    /** Copy the preconditioning setting to the concurrent copy. */
+    virtual void InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const;
+
   private:
 
     /** The private constructor. */
@@ -61,6 +61,28 @@ namespace itk
   } // end InitializeHistograms()
 
 
+ /**
+  * ********************* InitializeConcurrentCopy ******************************
+  */
+
+  template < class TFixedImage, class TMovingImage >
+  void
+    ParzenWindowMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
+    ::InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const
+  {
+    /** Call Superclass implementation. */
+    this->Superclass::InitializeConcurrentCopy( copy );
+
+    Self * thisCopy = dynamic_cast<Self *>( copy );
+    if ( thisCopy == 0 )
+    {
+      itkExceptionMacro( << "The concurrent copy is not a " << this->GetNameOfClass() );
+    }
+    thisCopy->m_UseJacobianPreconditioning = this->m_UseJacobianPreconditioning;
+
+  } // end InitializeConcurrentCopy()
+
+
   /**
    * ************************** GetValue **************************
    * Get the match Measure.
@@ -164,6 +186,43 @@ namespace itk
     this->ComputeMarginalPDF( this->m_JointPDF, this->m_FixedImageMarginalPDF, 0 );
     this->ComputeMarginalPDF( this->m_JointPDF, this->m_MovingImageMarginalPDF, 1 );
 
+    /** With sparsely stored pdf derivatives, first compute the weight of each
+     * histogram bin, and then let the sparse container add the weighted
+     * pdf derivatives to the derivative.
+     */
+    if ( this->GetUseSparseJointPDFDerivatives() )
+    {
+      std::vector<double> binWeights( this->m_JointPDF->GetPixelContainer()->Size(), 0.0 );
+      const PDFValueType * jointPDFPtr = this->m_JointPDF->GetBufferPointer();
+      double MI = 0.0;
+      unsigned long bin = 0;
+      for ( unsigned int f = 0; f < this->m_FixedImageMarginalPDF.GetSize(); ++f )
+      {
+        const double fixedImagePDFValue = this->m_FixedImageMarginalPDF[ f ];
+        for ( unsigned int m = 0; m < this->m_MovingImageMarginalPDF.GetSize(); ++m, ++bin )
+        {
+          const double movingImagePDFValue = this->m_MovingImageMarginalPDF[ m ];
+          const double fixPDFmovPDF = fixedImagePDFValue * movingImagePDFValue;
+          const double jointPDFValue = jointPDFPtr[ bin ];
+
+          /** Check for non-zero bin contribution. */
+          if( jointPDFValue > 1e-16 && fixPDFmovPDF > 1e-16 )
+          {
+            const double pRatio = vcl_log( jointPDFValue / fixPDFmovPDF );
+            MI += jointPDFValue * pRatio;
+
+            /**  Ref: eq 23 of Thevenaz & Unser paper [3]. */
+            binWeights[ bin ] = -this->m_Alpha * pRatio;
+          }
+        }
+      }
+
+      this->m_SparseJointPDFDerivatives->AddWeightedSum(
+        &( binWeights[ 0 ] ), derivative.data_block() );
+      value = static_cast<MeasureType>( -1.0 * MI );
+      return;
+    }
+
     /** Compute the metric and derivatives by double summation over histogram. */
 
     /** Setup iterators .*/
@@ -295,16 +354,14 @@ namespace itk
     /** Get a handle to the sample container. */
     ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-    /** Create iterator over the sample container. */
-    typename ImageSampleContainerType::ConstIterator fiter;
-    typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-    typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+    /** Get the number of samples in the sample container. */
+    const unsigned long numberOfSamples = sampleContainer->Size();
 
     /** Loop over sample container and compute contribution of each sample to pdfs. */
-    for ( fiter = fbegin; fiter != fend; ++fiter )
+    for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
     {
       /** Read fixed coordinates and create some variables. */
-      const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+      const FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
       RealType movingImageValue;
       MovingImageDerivativeType movingImageDerivative;
       MovingImagePointType mappedPoint;
@@ -330,7 +387,7 @@ namespace itk
       if ( sampleOk )
       {
         /** Get the fixed image value. */
-        RealType fixedImageValue = static_cast<RealType>( (*fiter).Value().m_ImageValue );
+        RealType fixedImageValue = static_cast<RealType>( sampleContainer->GetImageValue( pos ) );
 
         /** Make sure the values fall within the histogram range. */
         fixedImageValue = this->GetFixedImageLimiter()
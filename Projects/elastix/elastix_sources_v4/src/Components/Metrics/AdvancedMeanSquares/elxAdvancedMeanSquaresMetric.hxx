@@ -35,7 +35,7 @@ using namespace itk;
     this->Superclass1::Initialize();
     timer->StopTimer();
     elxout << "Initialization of AdvancedMeanSquares metric took: "
-      << static_cast<long>( timer->GetElapsedClockSec() * 1000 ) << " ms." << std::endl;
+      << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 ) << " ms." << std::endl;
 
   } // end Initialize
 
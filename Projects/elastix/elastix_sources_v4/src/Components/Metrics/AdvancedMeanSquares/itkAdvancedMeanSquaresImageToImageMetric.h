@@ -133,10 +133,16 @@ public:
   virtual void GetDerivative( const TransformParametersType & parameters,
     DerivativeType & derivative ) const;
 
-  /** Get value and derivatives for multiple valued optimizers. */
+  /** Get value and derivatives for multiple valued optimizers.
+   * Dispatches to the single- or multi-threaded implementation,
+   * depending on GetUseMultiThread(). */
   virtual void GetValueAndDerivative( const TransformParametersType & parameters,
     MeasureType& Value, DerivativeType& Derivative ) const;
 
+  /** Get value and derivatives single-threaded. */
+  void GetValueAndDerivativeSingleThreaded( const TransformParametersType & parameters,
+    MeasureType& Value, DerivativeType& Derivative ) const;
+
   /** Experimental feature: compute SelfHessian */
   virtual void GetSelfHessian( const TransformParametersType & parameters, HessianType & H ) const;
 
@@ -186,6 +192,9 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType          MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType         NonZeroJacobianIndicesType;
+  typedef typename Superclass::GetValueAndDerivativePerThreadStruct
+    GetValueAndDerivativePerThreadStruct;
+  typedef typename Superclass::AdvancedImageToImageMetricType     AdvancedImageToImageMetricType;
 
   /** Protected typedefs for SelfHessian */
   typedef SmoothingRecursiveGaussianImageFilter<
@@ -216,6 +225,14 @@ protected:
     MeasureType & measure,
     DerivativeType & deriv ) const;
 
+  /** Compute the value and derivative contribution of the samples
+   * assigned to one thread. */
+  virtual void ThreadedGetValueAndDerivative( unsigned int threadID ) const;
+
+  /** Gather the results of all threads and normalize. */
+  virtual void AfterThreadedGetValueAndDerivative(
+    MeasureType & value, DerivativeType & derivative ) const;
+
   /** Compute a pixel's contribution to the SelfHessian;
    * Called by GetSelfHessian(). */
   void UpdateSelfHessianTerms(
@@ -223,6 +240,9 @@ protected:
     const NonZeroJacobianIndicesType & nzji,
     HessianType & H) const;
 
+  /** Copy the normalization settings to the concurrent copy. */
+  virtual void InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const;
+
 private:
   AdvancedMeanSquaresImageToImageMetric(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
@@ -33,6 +33,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
   this->SetUseImageSampler( true );
   this->SetUseFixedImageLimiter( false );
   this->SetUseMovingImageLimiter( false );
+  this->m_SupportsConcurrentCopies = true;
 
   this->m_UseNormalization = false;
   this->m_NormalizationFactor = 1.0;
@@ -89,6 +90,34 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
 } // end Initialize()
 
 
+/**
+ * ******************* InitializeConcurrentCopy *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
+::InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const
+{
+  /** Call the superclass' implementation. */
+  this->Superclass::InitializeConcurrentCopy( copy );
+
+  Self * thisCopy = dynamic_cast<Self *>( copy );
+  if ( thisCopy == 0 )
+  {
+    itkExceptionMacro( << "The concurrent copy is not a " << this->GetNameOfClass() );
+  }
+
+  /** The normalization factor is computed by Initialize(), so copy it. */
+  thisCopy->m_UseNormalization = this->m_UseNormalization;
+  thisCopy->m_NormalizationFactor = this->m_NormalizationFactor;
+  thisCopy->m_SelfHessianSmoothingSigma = this->m_SelfHessianSmoothingSigma;
+  thisCopy->m_SelfHessianNoiseRange = this->m_SelfHessianNoiseRange;
+  thisCopy->m_NumberOfSamplesForSelfHessian = this->m_NumberOfSamplesForSelfHessian;
+
+} // end InitializeConcurrentCopy()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -162,21 +191,34 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
   this->GetImageSampler()->Update();
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+  /** Get the number of samples in the sample container. */
+  const unsigned long numberOfSamples = sampleContainer->Size();
+
+  /** The samples are transformed in batches, with the batch
+   * TransformPoints() of the transform. */
+  const unsigned long batchSize = 256;
+  std::vector< FixedImagePointType > fixedPoints;
+  std::vector< MovingImagePointType > mappedPoints;
+  unsigned long batchBegin = 0;
+  unsigned long batchEnd = 0;
+  bool batchOk = true;
 
   /** Loop over the fixed image samples to calculate the mean squares. */
-  for ( fiter = fbegin; fiter != fend; ++fiter )
+  for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    /** Transform the next batch of points. */
+    if ( pos == batchEnd )
+    {
+      batchBegin = pos;
+      batchEnd = vnl_math_min( pos + batchSize, numberOfSamples );
+      batchOk = this->TransformPoints( sampleContainer,
+        batchBegin, batchEnd, fixedPoints, mappedPoints );
+    }
     RealType movingImageValue;
-    MovingImagePointType mappedPoint;
+    const MovingImagePointType & mappedPoint = mappedPoints[ pos - batchBegin ];
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    /** Check if the point is inside the B-spline support region. */
+    bool sampleOk = batchOk;
 
     /** Check if point is inside mask. */
     if ( sampleOk )
@@ -198,7 +240,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
       this->m_NumberOfPixelsCounted++;
 
       /** Get the fixed image value. */
-      const RealType & fixedImageValue = static_cast<double>( (*fiter).Value().m_ImageValue );
+      const RealType & fixedImageValue = static_cast<double>( sampleContainer->GetImageValue( pos ) );
 
       /** The difference squared. */
       const RealType diff = movingImageValue - fixedImageValue;
@@ -250,13 +292,13 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
 
 
 /**
- * ******************* GetValueAndDerivative *******************
+ * ******************* GetValueAndDerivativeSingleThreaded *******************
  */
 
 template <class TFixedImage, class TMovingImage>
 void
 AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
-::GetValueAndDerivative(
+::GetValueAndDerivativeSingleThreaded(
   const TransformParametersType & parameters,
   MeasureType & value, DerivativeType & derivative ) const
 {
@@ -284,16 +326,14 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
   this->GetImageSampler()->Update();
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+  /** Get the number of samples in the sample container. */
+  const unsigned long numberOfSamples = sampleContainer->Size();
 
   /** Loop over the fixed image to calculate the mean squares. */
-  for ( fiter = fbegin; fiter != fend; ++fiter )
+  for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
   {
     /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    const FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
     RealType movingImageValue;
     MovingImagePointType mappedPoint;
     MovingImageDerivativeType movingImageDerivative;
@@ -322,7 +362,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
 
       /** Get the fixed image value. */
       const RealType & fixedImageValue
-        = static_cast<RealType>( (*fiter).Value().m_ImageValue );
+        = static_cast<RealType>( sampleContainer->GetImageValue( pos ) );
 
       /** Get the TransformJacobian dT/dmu. */
       this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
@@ -358,9 +398,173 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
   /** The return value. */
   value = measure;
 
+} // end GetValueAndDerivativeSingleThreaded()
+
+
+/**
+ * ******************* GetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
+::GetValueAndDerivative(
+  const TransformParametersType & parameters,
+  MeasureType & value, DerivativeType & derivative ) const
+{
+  /** Option for now to still use the single threaded code. */
+  if ( !this->GetUseMultiThread() )
+  {
+    return this->GetValueAndDerivativeSingleThreaded(
+      parameters, value, derivative );
+  }
+
+  itkDebugMacro("GetValueAndDerivative( " << parameters << " ) ");
+
+  /** Make sure the transform parameters are up to date. */
+  this->SetTransformParameters( parameters );
+
+  /** Update the imageSampler. This is not thread safe, so it is done
+   * before launching the threads. */
+  this->GetImageSampler()->Update();
+
+  /** Reset the per-thread measure, derivative and pixel count. */
+  this->InitializeThreadingParameters();
+
+  /** Launch multi-threading metric. */
+  this->LaunchGetValueAndDerivativeThreaderCallback();
+
+  /** Gather the metric values and derivatives from all threads. */
+  this->AfterThreadedGetValueAndDerivative( value, derivative );
+
 } // end GetValueAndDerivative()
 
 
+/**
+ * ******************* ThreadedGetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
+::ThreadedGetValueAndDerivative( unsigned int threadID ) const
+{
+  /** Get handles to the per-thread variables. */
+  GetValueAndDerivativePerThreadStruct & threadVariables
+    = this->m_GetValueAndDerivativePerThreadVariables[ threadID ];
+  MeasureType & measure = threadVariables.st_Value;
+  DerivativeType & derivative = threadVariables.st_Derivative;
+  unsigned long numberOfPixelsCounted = 0;
+
+  /** Array that stores dM(x)/dmu, and the sparse jacobian+indices. */
+  NonZeroJacobianIndicesType nzji(
+    this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
+  DerivativeType imageJacobian( nzji.size() );
+  TransformJacobianType jacobian;
+
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+
+  /** Get the samples for this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end = 0;
+  this->GetThreadSampleRange( threadID, sampleContainer->Size(),
+    pos_begin, pos_end );
+
+  /** Loop over the fixed image samples of this thread. */
+  for ( unsigned long pos = pos_begin; pos < pos_end; ++pos )
+  {
+    /** Read fixed coordinates and initialize some variables. */
+    const FixedImagePointType fixedPoint
+      = sampleContainer->GetImageCoordinates( pos );
+    RealType movingImageValue;
+    MovingImagePointType mappedPoint;
+    MovingImageDerivativeType movingImageDerivative;
+
+    /** Transform point and check if it is inside the B-spline support region. */
+    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+
+    /** Check if point is inside mask. */
+    if ( sampleOk )
+    {
+      sampleOk = this->IsInsideMovingMask( mappedPoint );
+    }
+
+    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
+     * the point is inside the moving image buffer.
+     */
+    if ( sampleOk )
+    {
+      sampleOk = this->EvaluateMovingImageValueAndDerivative(
+        mappedPoint, movingImageValue, &movingImageDerivative );
+    }
+
+    if ( sampleOk )
+    {
+      numberOfPixelsCounted++;
+
+      /** Get the fixed image value. */
+      const RealType & fixedImageValue
+        = static_cast<RealType>( sampleContainer->GetImageValue( pos ) );
+
+      /** Get the TransformJacobian dT/dmu. */
+      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+
+      /** Compute the innerproducts (dM/dx)^T (dT/dmu). */
+      this->EvaluateTransformJacobianInnerProduct(
+        jacobian, movingImageDerivative, imageJacobian );
+
+      /** Compute this pixel's contribution to the measure and derivatives. */
+      this->UpdateValueAndDerivativeTerms(
+        fixedImageValue, movingImageValue,
+        imageJacobian, nzji,
+        measure, derivative );
+
+    } // end if sampleOk
+
+  } // end for loop over the image sample container
+
+  /** Only update the member variable once, to avoid false sharing. */
+  threadVariables.st_NumberOfPixelsCounted = numberOfPixelsCounted;
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* AfterThreadedGetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
+::AfterThreadedGetValueAndDerivative(
+  MeasureType & value, DerivativeType & derivative ) const
+{
+  /** Sum the measure, derivative and number of pixels counted of all threads. */
+  MeasureType measure = NumericTraits< MeasureType >::Zero;
+  this->AccumulateThreadedValueAndDerivative( measure, derivative );
+
+  /** Check if enough samples were valid. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  this->CheckNumberOfSamples(
+    sampleContainer->Size(), this->m_NumberOfPixelsCounted );
+
+  /** Compute the measure value and derivative. */
+  double normal_sum = 0.0;
+  if ( this->m_NumberOfPixelsCounted > 0 )
+  {
+    normal_sum = this->m_NormalizationFactor /
+      static_cast<double>( this->m_NumberOfPixelsCounted );
+  }
+  measure *= normal_sum;
+  derivative *= normal_sum;
+
+  /** The return value. */
+  value = measure;
+
+} // end AfterThreadedGetValueAndDerivative()
+
+
 /**
  * *************** UpdateValueAndDerivativeTerms ***************************
  */
@@ -477,16 +681,14 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage,TMovingImage>
   sampler->Update();
   ImageSampleContainerPointer sampleContainer = sampler->GetOutput();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+  /** Get the number of samples in the sample container. */
+  const unsigned long numberOfSamples = sampleContainer->Size();
 
   /** Loop over the fixed image to calculate the mean squares. */
-  for ( fiter = fbegin; fiter != fend; ++fiter )
+  for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
   {
     /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    const FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
     MovingImagePointType mappedPoint;
     MovingImageDerivativeType movingImageDerivative;
 
@@ -189,6 +189,7 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType          MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType         NonZeroJacobianIndicesType;
+  typedef typename Superclass::AdvancedImageToImageMetricType     AdvancedImageToImageMetricType;
 
   /** Computes the innerproduct of transform Jacobian with moving image gradient.
    * The results are stored in imageJacobian, which is supposed
@@ -209,6 +210,9 @@ protected:
     DerivativeType & derivativeM,
     DerivativeType & differential ) const;
 
+  /** Copy the SubtractMean setting to the concurrent copy. */
+  virtual void InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const;
+
 private:
   AdvancedNormalizedCorrelationImageToImageMetric(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
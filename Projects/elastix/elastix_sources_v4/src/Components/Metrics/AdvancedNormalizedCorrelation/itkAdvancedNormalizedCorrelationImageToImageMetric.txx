@@ -34,6 +34,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage,TMovingImage>
   this->SetUseImageSampler( true );
   this->SetUseFixedImageLimiter( false );
   this->SetUseMovingImageLimiter( false );
+  this->m_SupportsConcurrentCopies = true;
 
 } // end constructor
 
@@ -53,6 +54,28 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage,TMovingImage>
 } // end PrintSelf()
 
 
+/**
+ * ******************* InitializeConcurrentCopy *******************
+ */
+
+template < class TFixedImage, class TMovingImage>
+void
+AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage,TMovingImage>
+::InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const
+{
+  /** Call the superclass' implementation. */
+  this->Superclass::InitializeConcurrentCopy( copy );
+
+  Self * thisCopy = dynamic_cast<Self *>( copy );
+  if ( thisCopy == 0 )
+  {
+    itkExceptionMacro( << "The concurrent copy is not a " << this->GetNameOfClass() );
+  }
+  thisCopy->m_SubtractMean = this->m_SubtractMean;
+
+} // end InitializeConcurrentCopy()
+
+
 /**
  * *************** EvaluateTransformJacobianInnerProduct ****************
  */
@@ -161,10 +184,8 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage,TMovingImage>
   this->GetImageSampler()->Update();
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+  /** Get the number of samples in the sample container. */
+  const unsigned long numberOfSamples = sampleContainer->Size();
 
   /** Create variables to store intermediate results. */
   typedef typename NumericTraits< MeasureType >::AccumulateType   AccumulateType;
@@ -175,10 +196,10 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage,TMovingImage>
   AccumulateType sm  = NumericTraits< AccumulateType >::Zero;
 
   /** Loop over the fixed image samples to calculate the mean squares. */
-  for ( fiter = fbegin; fiter != fend; ++fiter )
+  for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
   {
     /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    const FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
     RealType movingImageValue;
     MovingImagePointType mappedPoint;
 
@@ -204,7 +225,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage,TMovingImage>
       this->m_NumberOfPixelsCounted++;
 
       /** Get the fixed image value. */
-      const RealType & fixedImageValue = static_cast<double>( (*fiter).Value().m_ImageValue );
+      const RealType & fixedImageValue = static_cast<double>( sampleContainer->GetImageValue( pos ) );
 
       /** Update some sums needed to calculate NC. */
       sff += fixedImageValue  * fixedImageValue;
@@ -319,16 +340,14 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage,TMovingImage>
   this->GetImageSampler()->Update();
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+  /** Get the number of samples in the sample container. */
+  const unsigned long numberOfSamples = sampleContainer->Size();
 
   /** Loop over the fixed image to calculate the correlation. */
-  for ( fiter = fbegin; fiter != fend; ++fiter )
+  for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
   {
     /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    const FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
     RealType movingImageValue;
     MovingImagePointType mappedPoint;
     MovingImageDerivativeType movingImageDerivative;
@@ -356,7 +375,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage,TMovingImage>
       this->m_NumberOfPixelsCounted++;
 
       /** Get the fixed image value. */
-      const RealType & fixedImageValue = static_cast<RealType>( (*fiter).Value().m_ImageValue );
+      const RealType & fixedImageValue = static_cast<RealType>( sampleContainer->GetImageValue( pos ) );
 
       /** Get the TransformJacobian dT/dmu. */
       this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
@@ -33,7 +33,7 @@ void TransformBendingEnergyPenalty<TElastix>
   this->Superclass1::Initialize();
   timer->StopTimer();
   elxout << "Initialization of TransformBendingEnergy penalty term took: "
-    << static_cast<long>( timer->GetElapsedClockSec() * 1000 )
+    << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 )
     << " ms." << std::endl;
 
 } // end Initialize()
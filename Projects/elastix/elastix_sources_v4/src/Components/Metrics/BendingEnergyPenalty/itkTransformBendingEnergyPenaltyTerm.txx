@@ -65,16 +65,14 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
   this->GetImageSampler()->Update();
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+  /** Get the number of samples in the sample container. */
+  const unsigned long numberOfSamples = sampleContainer->Size();
 
   /** Loop over the fixed image samples to calculate the penalty term. */
-  for ( fiter = fbegin; fiter != fend; ++fiter )
+  for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
   {
     /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    const FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
     MovingImagePointType mappedPoint;
 
     /** Transform point and check if it is inside the B-spline support region. */
@@ -183,16 +181,14 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
   this->GetImageSampler()->Update();
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+  /** Get the number of samples in the sample container. */
+  const unsigned long numberOfSamples = sampleContainer->Size();
 
   /** Loop over the fixed image to calculate the penalty term and its derivative. */
-  for ( fiter = fbegin; fiter != fend; ++fiter )
+  for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
   {
     /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    const FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
     MovingImagePointType mappedPoint;
 
     /** Although the mapped point is not needed to compute the penalty term,
@@ -373,16 +369,14 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
   sampler->Update();
   ImageSampleContainerPointer sampleContainer = sampler->GetOutput();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+  /** Get the number of samples in the sample container. */
+  const unsigned long numberOfSamples = sampleContainer->Size();
 
   /** Loop over the fixed image to calculate the d/dmu dT/dxdx terms. */
-  for ( fiter = fbegin; fiter != fend; ++fiter )
+  for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
   {
     /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    const FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
     MovingImagePointType mappedPoint;
 
     /** Although the mapped point is not needed to compute the penalty term,
@@ -37,7 +37,7 @@ CorrespondingPointsEuclideanDistanceMetric<TElastix>
   this->Superclass1::Initialize();
   timer->StopTimer();
   elxout << "Initialization of CorrespondingPointsEuclideanDistance metric took: "
-    << static_cast<long>( timer->GetElapsedClockSec() * 1000 )
+    << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 )
     << " ms." << std::endl;
 
 } // end Initialize()
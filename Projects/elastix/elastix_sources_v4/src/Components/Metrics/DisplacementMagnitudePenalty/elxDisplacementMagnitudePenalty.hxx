@@ -33,7 +33,7 @@ void DisplacementMagnitudePenalty<TElastix>
   this->Superclass1::Initialize();
   timer->StopTimer();
   elxout << "Initialization of DisplacementMagnitude penalty term took: "
-    << static_cast<long>( timer->GetElapsedClockSec() * 1000 )
+    << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 )
     << " ms." << std::endl;
 
 } // end Initialize()
@@ -65,6 +65,11 @@ namespace itk
  * IEEE Transactions on Medical Imaging, vol. 28, no. 9, pp. 1412 - 1421,
  * September 2009.
  *
+ * If multi-threading is enabled for the metric (SetUseMultiThread()),
+ * the kD-trees are built and searched with GetNumberOfThreads() threads.
+ * The contributions of the query points are still summed in a single
+ * thread, so the result does not depend on the number of threads.
+ *
  * \ingroup RegistrationMetrics
  */
 
@@ -167,6 +172,8 @@ public:
 
   typedef typename BinaryKNNTreeSearchType::IndexArrayType      IndexArrayType;
   typedef typename BinaryKNNTreeSearchType::DistanceArrayType   DistanceArrayType;
+  typedef typename BinaryKNNTreeSearchType::IndexMatrixType     IndexMatrixType;
+  typedef typename BinaryKNNTreeSearchType::DistanceMatrixType  DistanceMatrixType;
 
   typedef typename DerivativeType::ValueType          DerivativeValueType;
   typedef typename TransformJacobianType::ValueType   TransformJacobianValueType;
@@ -301,6 +308,18 @@ private:
     TransformJacobianIndicesContainerType & jacobiansIndices,
     SpatialDerivativeContainerType & spatialDerivatives ) const;
 
+  /** This function generates the three trees from the list samples,
+   * connects them to the searchers, and searches the nearest neighbours
+   * of all m_NumberOfPixelsCounted query points in each of them.
+   */
+  virtual void ComputeNearestNeighbours(
+    const ListSamplePointer & listSampleFixed,
+    const ListSamplePointer & listSampleMoving,
+    const ListSamplePointer & listSampleJoint,
+    IndexMatrixType & indices_F, IndexMatrixType & indices_M,
+    IndexMatrixType & indices_J, DistanceMatrixType & distances_F,
+    DistanceMatrixType & distances_M, DistanceMatrixType & distances_J ) const;
+
   /** This function calculates the spatial derivative of the
    * featureNr feature image at the point mappedPoint.
    * \todo move this to base class.
@@ -331,28 +331,13 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
   /**
    * *************** Generate the three trees ******************
    *
-   * and connect them to the searchers.
+   * and search the nearest neighbours of all query points.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample( listSampleFixed );
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample( listSampleMoving );
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample( listSampleJoint );
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed
-    ->SetBinaryTree( this->m_BinaryKNNTreeFixed );
-  this->m_BinaryKNNTreeSearcherMoving
-    ->SetBinaryTree( this->m_BinaryKNNTreeMoving );
-  this->m_BinaryKNNTreeSearcherJoint
-    ->SetBinaryTree( this->m_BinaryKNNTreeJoint );
+  IndexMatrixType    indices_F,   indices_M,   indices_J;
+  DistanceMatrixType distances_F, distances_M, distances_J;
+  this->ComputeNearestNeighbours( listSampleFixed, listSampleMoving, listSampleJoint,
+    indices_F, indices_M, indices_J, distances_F, distances_M, distances_J );
 
   /**
    * *************** Estimate the \alpha MI ******************
@@ -389,10 +374,6 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
 
   /** Temporary variables. */
   typedef typename NumericTraits< MeasureType >::AccumulateType AccumulateType;
-  MeasurementVectorType z_F, z_M, z_J;
-  IndexArrayType indices_F, indices_M, indices_J;
-  DistanceArrayType distances_F, distances_M, distances_J;
-
   MeasureType H, G;
   AccumulateType sumG = NumericTraits< AccumulateType >::Zero;
 
@@ -408,15 +389,10 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
   /** Loop over all query points, i.e. all samples. */
   for ( unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++ )
   {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(  i, z_F );
-    listSampleMoving->GetMeasurementVector( i, z_M );
-    listSampleJoint->GetMeasurementVector(  i, z_J );
-
-    /** Search for the K nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(  z_F, indices_F, distances_F );
-    this->m_BinaryKNNTreeSearcherMoving->Search( z_M, indices_M, distances_M );
-    this->m_BinaryKNNTreeSearcherJoint->Search(  z_J, indices_J, distances_J );
+    /** Get the distances to the K nearest neighbours of the current query point. */
+    const double * dists_F = distances_F[ i ];
+    const double * dists_M = distances_M[ i ];
+    const double * dists_J = distances_J[ i ];
 
     /** Add the distances between the points to get the total graph length.
      * The outcommented implementation calculates: sum J/sqrt(F*M)
@@ -444,9 +420,9 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
     /** Loop over the neighbours. */
     for ( unsigned int p = 0; p < k; p++ )
     {
-      Gamma_F += vcl_sqrt( distances_F[ p ] );
-      Gamma_M += vcl_sqrt( distances_M[ p ] );
-      Gamma_J += vcl_sqrt( distances_J[ p ] );
+      Gamma_F += vcl_sqrt( dists_F[ p ] );
+      Gamma_M += vcl_sqrt( dists_M[ p ] );
+      Gamma_J += vcl_sqrt( dists_J[ p ] );
     } // end loop over the k neighbours
 
     /** Calculate the contribution of this query point. */
@@ -544,28 +520,13 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
   /**
    * *************** Generate the three trees ******************
    *
-   * and connect them to the searchers.
+   * and search the nearest neighbours of all query points.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample( listSampleFixed );
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample( listSampleMoving );
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample( listSampleJoint );
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed
-    ->SetBinaryTree( this->m_BinaryKNNTreeFixed );
-  this->m_BinaryKNNTreeSearcherMoving
-    ->SetBinaryTree( this->m_BinaryKNNTreeMoving );
-  this->m_BinaryKNNTreeSearcherJoint
-    ->SetBinaryTree( this->m_BinaryKNNTreeJoint );
+  IndexMatrixType    indices_F,   indices_M,   indices_J;
+  DistanceMatrixType distances_F, distances_M, distances_J;
+  this->ComputeNearestNeighbours( listSampleFixed, listSampleMoving, listSampleJoint,
+    indices_F, indices_M, indices_J, distances_F, distances_M, distances_J );
 
   /**
    * *************** Estimate the \alpha MI and its derivatives ******************
@@ -602,9 +563,7 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
 
   /** Temporary variables. */
   typedef typename NumericTraits< MeasureType >::AccumulateType AccumulateType;
-  MeasurementVectorType z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
-  IndexArrayType    indices_F,   indices_M,   indices_J;
-  DistanceArrayType distances_F, distances_M, distances_J;
+  MeasurementVectorType z_M, z_M_ip, z_J_ip, diff_M, diff_J;
   MeasureType       distance_F,  distance_M,  distance_J;
 
   MeasureType H, G, Gpow;
@@ -628,14 +587,14 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
   for ( unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++ )
   {
     /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(  i, z_F );
     listSampleMoving->GetMeasurementVector( i, z_M );
-    listSampleJoint->GetMeasurementVector(  i, z_J );
 
-    /** Search for the k nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(  z_F, indices_F, distances_F );
-    this->m_BinaryKNNTreeSearcherMoving->Search( z_M, indices_M, distances_M );
-    this->m_BinaryKNNTreeSearcherJoint->Search(  z_J, indices_J, distances_J );
+    /** Get the k nearest neighbours of the current query point. */
+    const int * ind_M = indices_M[ i ];
+    const int * ind_J = indices_J[ i ];
+    const double * dists_F = distances_F[ i ];
+    const double * dists_M = distances_M[ i ];
+    const double * dists_J = distances_J[ i ];
 
     /** Variables to compute the measure and its derivative. */
     AccumulateType Gamma_F = NumericTraits< AccumulateType >::Zero;
@@ -652,13 +611,13 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
     for ( unsigned int p = 0; p < k; p++ )
     {
       /** Get the neighbour point z_ip^M. */
-      listSampleMoving->GetMeasurementVector( indices_M[ p ], z_M_ip );
-      listSampleMoving->GetMeasurementVector( indices_J[ p ], z_J_ip );
+      listSampleMoving->GetMeasurementVector( ind_M[ p ], z_M_ip );
+      listSampleMoving->GetMeasurementVector( ind_J[ p ], z_J_ip );
 
       /** Get the distances. */
-      distance_F = vcl_sqrt( distances_F[ p ] );
-      distance_M = vcl_sqrt( distances_M[ p ] );
-      distance_J = vcl_sqrt( distances_J[ p ] );
+      distance_F = vcl_sqrt( dists_F[ p ] );
+      distance_M = vcl_sqrt( dists_M[ p ] );
+      distance_J = vcl_sqrt( dists_J[ p ] );
 
       /** Compute Gamma's. */
       Gamma_F += distance_F;
@@ -670,17 +629,17 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
       diff_J = z_M - z_J_ip;
 
       /** Compute derivatives. */
-      D2sparse_M = spatialDerivativesContainer[ indices_M[ p ] ]
-      * jacobianContainer[ indices_M[ p ] ];
-      D2sparse_J = spatialDerivativesContainer[ indices_J[ p ] ]
-      * jacobianContainer[ indices_J[ p ] ];
+      D2sparse_M = spatialDerivativesContainer[ ind_M[ p ] ]
+      * jacobianContainer[ ind_M[ p ] ];
+      D2sparse_J = spatialDerivativesContainer[ ind_J[ p ] ]
+      * jacobianContainer[ ind_J[ p ] ];
 
       /** Update the dGamma's. */
       this->UpdateDerivativeOfGammas(
         D1sparse, D2sparse_M, D2sparse_J,
         jacobianIndicesContainer[ i ],
-        jacobianIndicesContainer[ indices_M[ p ] ],
-        jacobianIndicesContainer[ indices_J[ p ] ],
+        jacobianIndicesContainer[ ind_M[ p ] ],
+        jacobianIndicesContainer[ ind_J[ p ] ],
         diff_M, diff_J,
         distance_M, distance_J,
         dGamma_M, dGamma_J );
@@ -723,6 +682,77 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
 } // end GetValueAndDerivative()
 
 
+/**
+ * ************************ ComputeNearestNeighbours *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
+::ComputeNearestNeighbours(
+  const ListSamplePointer & listSampleFixed,
+  const ListSamplePointer & listSampleMoving,
+  const ListSamplePointer & listSampleJoint,
+  IndexMatrixType & indices_F, IndexMatrixType & indices_M,
+  IndexMatrixType & indices_J, DistanceMatrixType & distances_F,
+  DistanceMatrixType & distances_M, DistanceMatrixType & distances_J ) const
+{
+  /** Get the number of threads for the trees and the searches. */
+  unsigned int numberOfThreads = 1;
+  if ( this->GetUseMultiThread() )
+  {
+    numberOfThreads = this->GetNumberOfThreads();
+  }
+
+  /** Only the kD-tree (and the bD-tree, which ignores it) supports
+   * multi-threaded construction.
+   */
+  BinaryKNNTreeType * trees[ 3 ] = { this->m_BinaryKNNTreeFixed,
+    this->m_BinaryKNNTreeMoving, this->m_BinaryKNNTreeJoint };
+  for ( unsigned int t = 0; t < 3; ++t )
+  {
+    ANNkDTreeType * kDTree = dynamic_cast<ANNkDTreeType *>( trees[ t ] );
+    if ( kDTree )
+    {
+      kDTree->SetNumberOfThreads( numberOfThreads );
+    }
+  }
+
+  /** Generate the tree for the fixed image samples. */
+  this->m_BinaryKNNTreeFixed->SetSample( listSampleFixed );
+  this->m_BinaryKNNTreeFixed->GenerateTree();
+
+  /** Generate the tree for the moving image samples. */
+  this->m_BinaryKNNTreeMoving->SetSample( listSampleMoving );
+  this->m_BinaryKNNTreeMoving->GenerateTree();
+
+  /** Generate the tree for the joint image samples. */
+  this->m_BinaryKNNTreeJoint->SetSample( listSampleJoint );
+  this->m_BinaryKNNTreeJoint->GenerateTree();
+
+  /** Initialize tree searchers. */
+  this->m_BinaryKNNTreeSearcherFixed
+    ->SetBinaryTree( this->m_BinaryKNNTreeFixed );
+  this->m_BinaryKNNTreeSearcherMoving
+    ->SetBinaryTree( this->m_BinaryKNNTreeMoving );
+  this->m_BinaryKNNTreeSearcherJoint
+    ->SetBinaryTree( this->m_BinaryKNNTreeJoint );
+
+  /** Search for the k nearest neighbours of all query points. */
+  const unsigned long n = this->m_NumberOfPixelsCounted;
+  this->m_BinaryKNNTreeSearcherFixed->SetNumberOfThreads( numberOfThreads );
+  this->m_BinaryKNNTreeSearcherFixed->BatchSearch(
+    listSampleFixed, n, indices_F, distances_F );
+  this->m_BinaryKNNTreeSearcherMoving->SetNumberOfThreads( numberOfThreads );
+  this->m_BinaryKNNTreeSearcherMoving->BatchSearch(
+    listSampleMoving, n, indices_M, distances_M );
+  this->m_BinaryKNNTreeSearcherJoint->SetNumberOfThreads( numberOfThreads );
+  this->m_BinaryKNNTreeSearcherJoint->BatchSearch(
+    listSampleJoint, n, indices_J, distances_J );
+
+} // end ComputeNearestNeighbours()
+
+
 /**
  * ************************ ComputeListSampleValuesAndDerivativePlusJacobian *************************
  */
@@ -750,11 +780,6 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   const unsigned long nrOfRequestedSamples = sampleContainer->Size();
 
-  /** Create an iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
-
   /** Get the size of the feature vectors. */
   const unsigned int fixedSize  = this->GetNumberOfFixedImages();
   const unsigned int movingSize = this->GetNumberOfMovingImages();
@@ -786,10 +811,10 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
 
   /** Loop over the fixed image samples to calculate the list samples. */
   unsigned int ii = 0;
-  for ( fiter = fbegin; fiter != fend; ++fiter )
+  for ( unsigned long pos = 0; pos < nrOfRequestedSamples; ++pos )
   {
     /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    const FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
 
     /** Transform point and check if it is inside the B-spline support region. */
     bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
@@ -826,7 +851,7 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,TMovingImage>
     {
       /** Get the fixed image value. */
       const RealType & fixedImageValue = static_cast<RealType>(
-        (*fiter).Value().m_ImageValue );
+        sampleContainer->GetImageValue( pos ) );
 
       /** Add the samples to the ListSampleCarrays. */
       listSampleFixed->SetMeasurement(  this->m_NumberOfPixelsCounted, 0,
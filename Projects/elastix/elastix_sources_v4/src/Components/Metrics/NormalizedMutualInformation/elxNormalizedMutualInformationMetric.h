@@ -64,6 +64,12 @@ using namespace itk;
    *    usefull if you use high order bspline interpolator for the moving image.\n
    *    example: <tt>(MovingLimitRangeRatio 0.001 0.01 0.01)</tt> \n
    *    The default value is 0.01. Can be given for each resolution, or for all resolutions at once.
+   * \parameter MaximumDenseJointPDFDerivativesSize: The maximum number of elements of the
+   *    derivative of the joint histogram (number of parameters * number of fixed bins * number of
+   *    moving bins). If it would be larger, and the transform is a B-spline like transform,
+   *    only its nonzero parts are stored. Can be given for each resolution, or for all resolutions at once.\n
+   *    example: <tt>(MaximumDenseJointPDFDerivativesSize 1000000)</tt> \n
+   *    The default value is 16777216 (2^24).
    *
    * \sa ParzenWindowNormalizedMutualInformationImageToImageMetric
    * \ingroup Metrics
@@ -37,7 +37,7 @@ using namespace itk;
     this->Superclass1::Initialize();
     timer->StopTimer();
     elxout << "Initialization of NormalizedMutualInformation metric took: "
-      << static_cast<long>( timer->GetElapsedClockSec() * 1000 ) << " ms." << std::endl;
+      << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 ) << " ms." << std::endl;
 
   } // end Initialize
 
@@ -96,6 +96,12 @@ using namespace itk;
     this->SetFixedKernelBSplineOrder( fixedKernelBSplineOrder );
     this->SetMovingKernelBSplineOrder( movingKernelBSplineOrder );
 
+    /** Set above which size the pdf derivatives are stored sparsely. */
+    unsigned long maximumDenseJointPDFDerivativesSize = 1UL << 24;
+    this->GetConfiguration()->ReadParameter( maximumDenseJointPDFDerivativesSize,
+      "MaximumDenseJointPDFDerivativesSize", this->GetComponentLabel(), level, 0 );
+    this->SetMaximumDenseJointPDFDerivativesSize( maximumDenseJointPDFDerivativesSize );
+
     /** Set moving image derivative scales. */
     this->SetUseMovingImageDerivativeScales( false );
     MovingImageDerivativeScalesType movingImageDerivativeScales;
@@ -215,6 +215,36 @@ namespace itk
      * -dNMI/dmu = - sum_k sum_i dhdmu(i,k) alpha*pRatio/Ej
      **/
 
+    /** With sparsely stored pdf derivatives, first compute the weight of each
+     * histogram bin, and then let the sparse container add the weighted
+     * pdf derivatives to the derivative.
+     */
+    if ( this->GetUseSparseJointPDFDerivatives() )
+    {
+      std::vector<double> binWeights( this->m_JointPDF->GetPixelContainer()->Size(), 0.0 );
+      const PDFValueType * jointPDFPtr = this->m_JointPDF->GetBufferPointer();
+      unsigned long bin = 0;
+      for ( unsigned int f = 0; f < this->m_FixedImageMarginalPDF.GetSize(); ++f )
+      {
+        const double logFixedImagePDFValue = this->m_FixedImageMarginalPDF[ f ];
+        for ( unsigned int m = 0; m < this->m_MovingImageMarginalPDF.GetSize(); ++m, ++bin )
+        {
+          const double logMovingImagePDFValue = this->m_MovingImageMarginalPDF[ m ];
+          const double jointPDFValue = jointPDFPtr[ bin ];
+          if ( jointPDFValue > 1e-16 )
+          {
+            const double pRatio = ( nMI * vcl_log( jointPDFValue )
+              - logFixedImagePDFValue - logMovingImagePDFValue ) / jointEntropy;
+            binWeights[ bin ] = -this->m_Alpha * pRatio;
+          }
+        }
+      }
+
+      this->m_SparseJointPDFDerivatives->AddWeightedSum(
+        &( binWeights[ 0 ] ), derivative.data_block() );
+      return;
+    }
+
     /** Typedefs for iterators */
     typedef ImageLinearConstIteratorWithIndex<
       JointPDFDerivativesType>                              JointPDFDerivativesConstIteratorType;
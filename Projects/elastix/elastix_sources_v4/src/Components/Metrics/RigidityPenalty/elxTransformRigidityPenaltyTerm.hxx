@@ -187,7 +187,7 @@ TransformRigidityPenalty<TElastix>
   /** Stop and print the timer. */
   timer->StopTimer();
   elxout << "Initialization of TransformRigidityPenalty term took: "
-    << static_cast<long>( timer->GetElapsedClockSec() * 1000 )
+    << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 )
     << " ms." << std::endl;
 
 } // end Initialize()
@@ -343,7 +343,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   }
 
   /** Make sure that the transform is up to date. */
-  this->m_Transform->SetParameters( parameters );
+  this->SetTransformParameters( parameters );
 
   /** Create and reset an iterator over m_RigidityCoefficientImage. */
   RigidityImageIteratorType it( this->m_RigidityCoefficientImage,
@@ -457,7 +457,10 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   /** Set the parameters in the transform.
    * In this function, also the coefficient images are created.
    */
-  this->m_BSplineTransform->SetParameters( parameters );
+  if ( !this->GetTransformParametersAreSetExternally() )
+  {
+    this->m_BSplineTransform->SetParameters( parameters );
+  }
 
   /** Sanity check. */
   if ( ImageDimension != 2 && ImageDimension != 3 )
@@ -907,7 +910,10 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   /** Set the parameters in the transform.
    * In this function, also the B-spline coefficient images are created.
    */
-  this->m_BSplineTransform->SetParameters( parameters );
+  if ( !this->GetTransformParametersAreSetExternally() )
+  {
+    this->m_BSplineTransform->SetParameters( parameters );
+  }
 
   /** Sanity check. */
   if ( ImageDimension != 2 && ImageDimension != 3 )
@@ -80,6 +80,13 @@ public:
   itkGetConstMacro(SampleLastDimensionRandomly, bool);
   itkGetConstMacro(NumSamplesLastDimension, int);
 
+  /** Copies draw their own random samples in the last dimension, so they
+   * are only supported without SampleLastDimensionRandomly. */
+  virtual bool GetSupportsConcurrentCopies( void ) const
+  {
+    return this->m_SupportsConcurrentCopies && !this->m_SampleLastDimensionRandomly;
+  }
+
   /** Typedefs from the superclass. */
   typedef typename
     Superclass::CoordinateRepresentationType              CoordinateRepresentationType;
@@ -169,6 +176,7 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType          MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType         NonZeroJacobianIndicesType;
+  typedef typename Superclass::AdvancedImageToImageMetricType     AdvancedImageToImageMetricType;
 
   /** Computes the innerproduct of transform Jacobian with moving image gradient.
    * The results are stored in imageJacobian, which is supposed
@@ -178,6 +186,9 @@ protected:
     const MovingImageDerivativeType & movingImageDerivative,
     DerivativeType & imageJacobian) const;
 
+  /** Copy the settings and the initial variance to the concurrent copy. */
+  virtual void InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const;
+
 private:
   VarianceOverLastDimensionImageMetric(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
@@ -37,6 +37,7 @@ namespace itk
   {
     this->SetUseImageSampler( true );
     this->SetUseFixedImageLimiter( false );
+    this->m_SupportsConcurrentCopies = true;
     this->SetUseMovingImageLimiter( false );
 
   } // end constructor
@@ -113,6 +114,37 @@ namespace itk
 
   } // end PrintSelf
 
+
+  /**
+   * ******************* InitializeConcurrentCopy *******************
+   */
+
+  template < class TFixedImage, class TMovingImage>
+    void
+    VarianceOverLastDimensionImageMetric<TFixedImage,TMovingImage>
+    ::InitializeConcurrentCopy( AdvancedImageToImageMetricType * copy ) const
+  {
+    /** Call the superclass' implementation. */
+    this->Superclass::InitializeConcurrentCopy( copy );
+
+    Self * thisCopy = dynamic_cast<Self *>( copy );
+    if ( thisCopy == 0 )
+    {
+      itkExceptionMacro( << "The concurrent copy is not a " << this->GetNameOfClass() );
+    }
+
+    /** The initial variance is computed by Initialize(), so copy it. */
+    thisCopy->m_SampleLastDimensionRandomly = this->m_SampleLastDimensionRandomly;
+    thisCopy->m_NumSamplesLastDimension = this->m_NumSamplesLastDimension;
+    thisCopy->m_NumAdditionalSamplesFixed = this->m_NumAdditionalSamplesFixed;
+    thisCopy->m_ReducedDimensionIndex = this->m_ReducedDimensionIndex;
+    thisCopy->m_SubtractMean = this->m_SubtractMean;
+    thisCopy->m_InitialVariance = this->m_InitialVariance;
+    thisCopy->m_GridSize = this->m_GridSize;
+    thisCopy->m_TransformIsStackTransform = this->m_TransformIsStackTransform;
+
+  } // end InitializeConcurrentCopy()
+
   /**
   * ******************* SampleRandom *******************
   */
@@ -199,10 +231,8 @@ namespace itk
     this->GetImageSampler()->Update();
     ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-    /** Create iterator over the sample container. */
-    typename ImageSampleContainerType::ConstIterator fiter;
-    typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-    typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+    /** Get the number of samples in the sample container. */
+    const unsigned long numberOfSamples = sampleContainer->Size();
 
     /** Retrieve slowest varying dimension and its size. */
     const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
@@ -219,10 +249,10 @@ namespace itk
     }
 
     /** Loop over the fixed image samples to calculate the variance over time for every sample position. */
-    for ( fiter = fbegin; fiter != fend; ++fiter )
+    for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
     {
       /** Read fixed coordinates. */
-      FixedImagePointType fixedPoint = (*fiter).Value().m_ImageCoordinates;
+      FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
 
       /** Determine random last dimension positions if needed. */
       if ( this->m_SampleLastDimensionRandomly )
@@ -352,10 +382,8 @@ namespace itk
     this->GetImageSampler()->Update();
     ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-    /** Create iterator over the sample container. */
-    typename ImageSampleContainerType::ConstIterator fiter;
-    typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-    typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+    /** Get the number of samples in the sample container. */
+    const unsigned long numberOfSamples = sampleContainer->Size();
 
     /** Retrieve slowest varying dimension and its size. */
     const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
@@ -386,10 +414,10 @@ namespace itk
     std::vector< DerivativeType > dMTdmu ( realNumLastDimPositions );
 
     /** Loop over the fixed image samples to calculate the variance over time for every sample position. */
-    for ( fiter = fbegin; fiter != fend; ++fiter )
+    for ( unsigned long pos = 0; pos < numberOfSamples; ++pos )
     {
       /** Read fixed coordinates. */
-      FixedImagePointType fixedPoint = (*fiter).Value().m_ImageCoordinates;
+      FixedImagePointType fixedPoint = sampleContainer->GetImageCoordinates( pos );
 
       /** Determine random last dimension positions if needed. */
       if ( this->m_SampleLastDimensionRandomly )
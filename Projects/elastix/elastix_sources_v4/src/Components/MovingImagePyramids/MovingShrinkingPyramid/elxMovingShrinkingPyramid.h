@@ -86,8 +86,32 @@ using namespace itk;
     typedef typename Superclass2::RegistrationPointer   RegistrationPointer;
     typedef typename Superclass2::ITKBaseType           ITKBaseType;
 
+    /** This pyramid can compute the images of one resolution level. */
+    virtual bool ComputingPerResolutionSupported( void ) const
+    {
+      return true;
+    }
+
+    /** Let the pyramid compute only the images of the given level. */
+    virtual void SetComputePerResolution( bool perResolution, unsigned int level )
+    {
+      this->SetComputeOnlyForCurrentLevel( perResolution );
+      this->SetCurrentLevel( level );
+    }
+
   protected:
 
+    /** Reuse the images of the previous registration, if possible.
+     * Otherwise compute them, and keep them if desired. */
+    virtual void GenerateData( void )
+    {
+      if ( !this->GraftCachedPyramidImages() )
+      {
+        this->Superclass1::GenerateData();
+        this->StorePyramidImagesInCache();
+      }
+    }
+
     /** The constructor. */
     MovingShrinkingPyramid() {}
     /** The destructor. */
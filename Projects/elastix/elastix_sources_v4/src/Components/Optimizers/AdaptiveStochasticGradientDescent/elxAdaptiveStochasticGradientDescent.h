@@ -22,6 +22,8 @@
 #include "elxProgressCommand.h"
 #include "itkAdvancedTransform.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkMultiThreader.h"
+#include "itkBlockSparseSymmetricMatrix.h"
 
 namespace elastix
 {
@@ -145,6 +147,19 @@ namespace elastix
   *   Default/recommended: 100000. This works in general. If the image is smaller, the number
   *   of samples is automatically reduced. In principle, the more the better, but the slower.
   *   The parameter has only influence when AutomaticParameterEstimation is used.
+  * \parameter UseMultiThreadingForAutomaticParameterEstimation: Whether the Jacobian terms
+  *   of the automatic parameter estimation are computed multi-threaded, and the grid
+  *   samplers it uses sample multi-threaded. The number of threads is determined by
+  *   the -threads command line argument. The gradients are not measured concurrently:
+  *   they are measured one after the other, and only use the multi-threading of the
+  *   metric (see UseMultiThreadingForMetrics).
+  *   The parameter can be specified for each resolution, or for all resolutions at once.\n
+  *   example: <tt>(UseMultiThreadingForAutomaticParameterEstimation "true")</tt>\n
+  *   Default value: "false".
+  *   The parameter has only influence when AutomaticParameterEstimation is used.
+  * \parameter MaxBandCovSize and NumberOfBandStructureSamples: deprecated. They
+  *   set the band structure of the covariance matrix, which is now stored
+  *   block-sparse, without a band. They are ignored, with a warning.
   *
   * \todo: this class contains a lot of functional code, which actually does not belong here.
   *
@@ -289,6 +304,64 @@ protected:
   typedef typename
     AdvancedTransformType::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
 
+  /** Typedefs for the covariance matrix of the Jacobian terms. */
+  typedef double                                      CovarianceValueType;
+  typedef Array2D<CovarianceValueType>                CovarianceMatrixType;
+  typedef itk::BlockSparseSymmetricMatrix<
+    CovarianceValueType >                             BlockSparseCovarianceMatrixType;
+  typedef typename
+    BlockSparseCovarianceMatrixType::Pointer          BlockSparseCovarianceMatrixPointer;
+
+  /** Typedefs for multi-threading. */
+  typedef itk::MultiThreader                          ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct              ThreadInfoType;
+
+  /** The jobs that ComputeJacobianTerms() divides over the threads. */
+  enum JacobianTermsJobType {
+    ComputeJacobianProductsJob,
+    UpdateCovarianceJob,
+    FinalizeCovarianceJob,
+    ComputeMaximumJacobianTermsJob };
+
+  /** The products J^T J that one thread computes for a batch of samples.
+   * Consecutive samples with the same nonzero Jacobian indices are summed
+   * in one run. Only the first st_NumberOfRuns entries are used.
+   */
+  struct JacobianProductsType
+  {
+    std::vector< NonZeroJacobianIndicesType >   st_Indices;
+    std::vector< CovarianceMatrixType >         st_Products;
+    unsigned long                               st_NumberOfRuns;
+  };
+
+  /** The data that the threads of ComputeJacobianTerms() share. The
+   * covariance matrix is divided over the threads by row of blocks: block
+   * row r is owned by thread r % st_NumberOfThreads. Only that thread
+   * writes to it.
+   */
+  struct JacobianTermsThreaderParameterType
+  {
+    Self *                                st_Self;
+    JacobianTermsJobType                  st_Job;
+    unsigned int                          st_NumberOfThreads;
+    const ImageSampleContainerType *      st_SampleContainer;
+    unsigned long                         st_BatchBegin;
+    unsigned long                         st_BatchEnd;
+    double                                st_NumberOfSamples;
+    BlockSparseCovarianceMatrixType *     st_Covariance;
+    const ScalesType *                    st_Scales;
+    bool                                  st_UseScales;
+
+    /** Per thread. */
+    std::vector< JacobianProductsType >   st_JacobianProducts;
+    std::vector< double >                 st_TrC;
+    std::vector< double >                 st_TrCC;
+    std::vector< double >                 st_MaxJJ;
+    std::vector< double >                 st_MaxJCJ;
+    std::vector< ExceptionObject >        st_Exceptions;
+    std::vector< unsigned char >          st_Failed;
+  };
+
   AdaptiveStochasticGradientDescent();
   virtual ~AdaptiveStochasticGradientDescent() {};
 
@@ -306,6 +379,10 @@ protected:
   /** RandomGenerator for AddRandomPerturbation. */
   typename RandomGeneratorType::Pointer             m_RandomGenerator;
 
+  /** Multi-threading of the automatic parameter estimation. */
+  bool                                              m_UseMultiThread;
+  ThreaderType::Pointer                             m_Threader;
+
   /** Check if the transform is an advanced transform. Called by Initialize. */
   virtual void CheckForAdvancedTransform( void );
 
@@ -345,6 +422,28 @@ protected:
   virtual void ComputeJacobianTerms( double & TrC, double & TrCC,
     double & maxJJ, double & maxJCJ );
 
+  /** Run one job of ComputeJacobianTerms() in all threads. Exceptions of
+   * the threads are rethrown afterwards. */
+  virtual void LaunchJacobianTermsThreads(
+    JacobianTermsThreaderParameterType & parameters, JacobianTermsJobType job );
+
+  /** The part of a job of ComputeJacobianTerms() of one thread. */
+  virtual void ThreadedComputeJacobianTerms( unsigned int threadID,
+    JacobianTermsThreaderParameterType & parameters );
+
+  /** The jobs of ComputeJacobianTerms(), see ThreadedComputeJacobianTerms(). */
+  void ThreadedComputeJacobianProducts( unsigned int threadID,
+    JacobianTermsThreaderParameterType & parameters );
+  void ThreadedUpdateCovariance( unsigned int threadID,
+    JacobianTermsThreaderParameterType & parameters );
+  void ThreadedFinalizeCovariance( unsigned int threadID,
+    JacobianTermsThreaderParameterType & parameters );
+  void ThreadedComputeMaximumJacobianTerms( unsigned int threadID,
+    JacobianTermsThreaderParameterType & parameters );
+
+  /** The function that is called by the threader. */
+  static ITK_THREAD_RETURN_TYPE JacobianTermsThreaderCallback( void * arg );
+
   /** Helper function, which calls GetScaledValueAndDerivative and does
    * some exception handling. Used by SampleGradients.
    */
@@ -370,10 +469,6 @@ private:
   unsigned long m_PreviousErrorAtIteration;
   bool          m_AutomaticParameterEstimationDone;
 
-  /** Private variables for band size estimation of covariance matrix. */
-  unsigned long m_MaxBandCovSize;
-  unsigned long m_NumberOfBandStructureSamples;
-
 }; // end class AdaptiveStochasticGradientDescent
 
 
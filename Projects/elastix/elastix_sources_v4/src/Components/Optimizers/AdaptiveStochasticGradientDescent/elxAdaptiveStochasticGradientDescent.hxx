@@ -24,8 +24,6 @@
 #include <utility>
 #include "vnl/vnl_math.h"
 #include "vnl/vnl_fastops.h"
-#include "vnl/vnl_diag_matrix.h"
-#include "vnl/vnl_sparse_matrix.h"
 #include "vnl/vnl_matlab_filewrite.h"
 #include "itkAdvancedImageToImageMetric.h"
 #include "elxTimer.h"
@@ -57,6 +55,9 @@ AdaptiveStochasticGradientDescent<TElastix>
   this->m_RandomGenerator = RandomGeneratorType::New();
   this->m_AdvancedTransform = 0;
 
+  this->m_UseMultiThread = false;
+  this->m_Threader = ThreaderType::New();
+
 } // Constructor
 
 
@@ -125,16 +126,6 @@ void AdaptiveStochasticGradientDescent<TElastix>
     "SigmoidInitialTime", this->GetComponentLabel(), level, 0 );
   this->SetInitialTime( initialTime );
 
-  /** Set the maximum band size of the covariance matrix. */
-  this->m_MaxBandCovSize = 192;
-  this->GetConfiguration()->ReadParameter( this->m_MaxBandCovSize,
-    "MaxBandCovSize", this->GetComponentLabel(), level, 0 );
-
-  /** Set the number of random samples used to estimate the structure of the covariance matrix. */
-  this->m_NumberOfBandStructureSamples = 10;
-  this->GetConfiguration()->ReadParameter( this->m_NumberOfBandStructureSamples,
-    "NumberOfBandStructureSamples", this->GetComponentLabel(), level, 0 );
-
   /** Set/Get whether the adaptive step size mechanism is desired. Default: true
    * NB: the setting is turned of in case of UseRandomSampleRegion=true.
    * Deprecated alias UseCruzAcceleration is also still supported.
@@ -182,6 +173,32 @@ void AdaptiveStochasticGradientDescent<TElastix>
       "NumberOfGradientMeasurements",
       this->GetComponentLabel(), level, 0 );
 
+    /** Set whether the Jacobian terms are computed multi-threaded. */
+    this->m_UseMultiThread = false;
+    this->GetConfiguration()->ReadParameter( this->m_UseMultiThread,
+      "UseMultiThreadingForAutomaticParameterEstimation",
+      this->GetComponentLabel(), level, 0 );
+
+    /** The band structure of the covariance matrix is not estimated anymore,
+     * so these deprecated parameters are ignored.
+     */
+    if ( level == 0 )
+    {
+      const char * deprecatedParameters[ 2 ]
+        = { "MaxBandCovSize", "NumberOfBandStructureSamples" };
+      for ( unsigned int i = 0; i < 2; ++i )
+      {
+        if ( this->GetConfiguration()->CountNumberOfParameterEntries(
+          deprecatedParameters[ i ] ) > 0 )
+        {
+          xl::xout["warning"] << "WARNING: the parameter "
+            << deprecatedParameters[ i ] << " is deprecated and ignored. "
+            << "The covariance matrix is stored block-sparse, without a band."
+            << std::endl;
+        }
+      }
+    }
+
     /** Set the number of Jacobian measurements M.
      * By default, if nothing specified by the user, M is determined as:
      * M = max( 1000, nrofparams );
@@ -454,7 +471,9 @@ void
 AdaptiveStochasticGradientDescent<TElastix>
 ::AutomaticParameterEstimation( void )
 {
-  /** Setup timers. */
+  /** Setup timers. The phases are timed in wall-clock time, since they
+   * run multi-threaded.
+   */
   tmr::Timer::Pointer timer1 = tmr::Timer::New();
   tmr::Timer::Pointer timer2 = tmr::Timer::New();
   tmr::Timer::Pointer timer3 = tmr::Timer::New();
@@ -477,8 +496,8 @@ AdaptiveStochasticGradientDescent<TElastix>
   this->ComputeJacobianTerms( TrC, TrCC, maxJJ, maxJCJ );
   timer2->StopTimer();
   elxout << "  Computing the Jacobian terms took "
-    << timer2->PrintElapsedTimeDHMS()
-    << std::endl;
+    << static_cast<long>( timer2->GetElapsedWallClockSec() * 1000 )
+    << " ms." << std::endl;
 
   /** Determine number of gradient measurements such that
    * E + 2\sqrt(Var) < K E
@@ -521,8 +540,8 @@ AdaptiveStochasticGradientDescent<TElastix>
     this->GetScaledCurrentPosition(), sigma4, gg, ee );
   timer3->StopTimer();
   elxout << "  Sampling the gradients took "
-    << timer3->PrintElapsedTimeDHMS()
-    << std::endl;
+    << static_cast<long>( timer3->GetElapsedWallClockSec() * 1000 )
+    << " ms." << std::endl;
 
   /** Determine parameter settings. */
   double sigma1 = 0.0;
@@ -565,8 +584,8 @@ AdaptiveStochasticGradientDescent<TElastix>
   /** Print the elapsed time. */
   timer1->StopTimer();
   elxout << "Automatic parameter estimation took "
-    << timer1->PrintElapsedTimeDHMS()
-    << std::endl;
+    << static_cast<long>( timer1->GetElapsedWallClockSec() * 1000 )
+    << " ms." << std::endl;
 
 } // end AutomaticParameterEstimation()
 
@@ -650,6 +669,7 @@ AdaptiveStochasticGradientDescent<TElastix>
         gridSamplerVec[ m ]->SetInputImageRegion( randomSamplerVec[ m ]->GetInputImageRegion() );
         gridSamplerVec[ m ]->SetMask( randomSamplerVec[ m ]->GetMask() );
         gridSamplerVec[ m ]->SetNumberOfSamples( this->m_NumberOfSamplesForExactGradient );
+        gridSamplerVec[ m ]->SetUseMultiThread( this->m_UseMultiThread );
         gridSamplerVec[ m ]->Update();
 
       } // end if random sampler
@@ -671,7 +691,11 @@ AdaptiveStochasticGradientDescent<TElastix>
   double exactgg = 0.0;
   double diffgg = 0.0;
 
-  /** Compute gg for some random parameters. */
+  /** Compute gg for some random parameters. The measurements are done one
+   * after the other; they are not distributed over concurrent copies of
+   * the metric (see AdvancedImageToImageMetric::CreateConcurrentCopies()),
+   * since every measurement switches the samplers of the metrics and
+   * selects new samples, which can only be done in this thread. */
   for ( unsigned int i = 0 ; i < this->m_NumberOfGradientMeasurements; ++i )
   {
     /** Show progress 0-100% */
@@ -778,27 +802,31 @@ AdaptiveStochasticGradientDescent<TElastix>
    *    D: || J_j J_j^T ||_F     in (54)
    * Term 3: maxJJ, see (47)
    * Term 4: maxJCJ, see (54)
+   *
+   * The samples are processed in batches. In each batch the threads first
+   * compute the products J_j^T J_j of a part of the samples, and then add
+   * all products to the rows of blocks of the covariance matrix that they
+   * own. Only the entries at the nonzero Jacobian indices of the samples
+   * are visited, so for a B-spline transform the work is linear in the
+   * number of samples, and independent of the number of parameters.
    */
 
-  typedef double                                      CovarianceValueType;
-  typedef Array2D<CovarianceValueType>                CovarianceMatrixType;
-  typedef vnl_sparse_matrix<CovarianceValueType>      SparseCovarianceMatrixType;
-  typedef typename SparseCovarianceMatrixType::row    SparseRowType;
-  typedef typename SparseCovarianceMatrixType::pair_t SparseCovarianceElementType;
-  typedef Array<unsigned int>           NonZeroJacobianIndicesExpandedType;
-  typedef vnl_diag_matrix<CovarianceValueType>        DiagCovarianceMatrixType;
-  typedef vnl_vector<CovarianceValueType>             JacobianColumnType;
-
   /** Initialize. */
   TrC = TrCC = maxJJ = maxJCJ = 0.0;
 
   this->CheckForAdvancedTransform();
 
   /** Get samples. */
+  tmr::Timer::Pointer samplingTimer = tmr::Timer::New();
+  samplingTimer->StartTimer();
   ImageSampleContainerPointer sampleContainer = 0;
   this->SampleFixedImageForJacobianTerms( sampleContainer );
   const unsigned int nrofsamples = sampleContainer->Size();
   const double n = static_cast<double>( nrofsamples );
+  samplingTimer->StopTimer();
+  elxout << "  Sampling the fixed image for the Jacobian terms took "
+    << static_cast<long>( samplingTimer->GetElapsedWallClockSec() * 1000 )
+    << " ms." << std::endl;
 
   /** Get the number of parameters. */
   const unsigned int P = static_cast<unsigned int>(
@@ -808,35 +836,16 @@ AdaptiveStochasticGradientDescent<TElastix>
   typename TransformType::Pointer transform = this->GetRegistration()
     ->GetAsITKBaseType()->GetTransform();
   transform->SetParameters( this->GetCurrentPosition() );
-  const unsigned int outdim = transform->GetOutputSpaceDimension();
 
   /** Get scales vector */
   const ScalesType & scales = this->m_ScaledCostFunction->GetScales();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
-  unsigned int samplenr = 0;
-
-  /** Variables for nonzerojacobian indices and the Jacobian. */
-  const unsigned int sizejacind
-    = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
-  JacobianType jacj( outdim, sizejacind );
-  jacj.Fill( 0.0 );
-  NonZeroJacobianIndicesType jacind( sizejacind );
-  jacind[ 0 ] = 0;
-  if ( sizejacind > 1 ) jacind[ 1 ] = 0;
-  NonZeroJacobianIndicesType prevjacind = jacind;
-
-  /** Initialize covariance matrix. Sparse, diagonal, and band form. */
-  SparseCovarianceMatrixType cov( P, P );
-  DiagCovarianceMatrixType diagcov( P, 0.0 );
-  CovarianceMatrixType bandcov;
-
-  /** For temporary storage of J'J. */
-  CovarianceMatrixType jactjac( sizejacind, sizejacind );
-  jactjac.Fill( 0.0 );
+  /** Initialize the covariance matrix. Only the upper triangular part is
+   * stored, in blocks that are allocated when they are updated. So only
+   * the entries of parameters that share a sample are stored.
+   */
+  BlockSparseCovarianceMatrixPointer cov = BlockSparseCovarianceMatrixType::New();
+  cov->SetSize( P );
 
   /** Prepare for progress printing. */
   ProgressCommandPointer progressObserver = ProgressCommandType::New();
@@ -844,125 +853,223 @@ AdaptiveStochasticGradientDescent<TElastix>
   progressObserver->SetStartString( "  Progress: " );
   elxout << "  Computing JacobianTerms ..." << std::endl;
 
-  /** Variables for the band cov matrix. */
-  const unsigned int maxbandcovsize = m_MaxBandCovSize;
-  const unsigned int nrOfBandStructureSamples = m_NumberOfBandStructureSamples;
+  /** Set up the data that is shared by the threads. */
+  const unsigned int numberOfThreads = this->m_UseMultiThread
+    ? static_cast<unsigned int>( this->m_Threader->GetNumberOfThreads() ) : 1;
+  JacobianTermsThreaderParameterType parameters;
+  parameters.st_Self = this;
+  parameters.st_NumberOfThreads = numberOfThreads;
+  parameters.st_SampleContainer = sampleContainer.GetPointer();
+  parameters.st_NumberOfSamples = n;
+  parameters.st_Covariance = cov.GetPointer();
+  parameters.st_Scales = &scales;
+  parameters.st_UseScales = this->GetUseScales();
+  parameters.st_JacobianProducts.resize( numberOfThreads );
+  parameters.st_TrC.resize( numberOfThreads, 0.0 );
+  parameters.st_TrCC.resize( numberOfThreads, 0.0 );
+  parameters.st_MaxJJ.resize( numberOfThreads, 0.0 );
+  parameters.st_MaxJCJ.resize( numberOfThreads, 0.0 );
+
+  /** The number of samples of a batch. The products of a batch are kept in
+   * memory, so keep the batches small.
+   */
+  const unsigned long batchSize = 32 * numberOfThreads;
 
-  /** DifHist is a histogram of absolute parameterNrDifferences that
-   * occur in the nonzerojacobianindex vectors.
-   * DifHist2 is another way of storing the histogram, as a vector
-   * of pairs. pair.first = Frequency, pair.second = parameterNrDifference.
-   * This is useful for sorting.
+  /**
+   *    TERM 1
+   *
+   * Loop over image and compute Jacobian.
+   * Compute C = 1/n \sum_i J_i^T J_i
+   * Only the upper triangular part of C is stored.
    */
-  typedef std::vector<unsigned int>             DifHistType;
-  typedef std::pair<unsigned int, unsigned int> FreqPairType;
-  typedef std::vector<FreqPairType>             DifHist2Type;
-  DifHistType difHist( P, 0 );
-  DifHist2Type difHist2;
-
-  /** Try to guess the band structure of the covariance matrix.
-   * A 'band' is a series of elements cov(p,q) with constant q-p.
-   * In the loop below, on a few positions in the image the Jacobian
-   * is computed. The nonzerojacobianindices are inspected to figure out
-   * which values of q-p occur often. This is done by making a histogram.
-   * The histogram is then sorted and the most occurring bands
-   * are determined. The covariance elements in these bands will not
-   * be stored in the sparse matrix structure 'cov', but in the band
-   * matrix 'bandcov', which is much faster.
-   * Only after the bandcov and cov have been filled (by looping over
-   * all Jacobian measurements in the sample container, the bandcov
-   * matrix is injected in the cov matrix, for easy further calculations,
-   * and the bandcov matrix is deleted.
+  for ( unsigned long batchBegin = 0; batchBegin < nrofsamples; batchBegin += batchSize )
+  {
+    parameters.st_BatchBegin = batchBegin;
+    parameters.st_BatchEnd = std::min(
+      batchBegin + batchSize, static_cast<unsigned long>( nrofsamples ) );
+
+    this->LaunchJacobianTermsThreads( parameters, ComputeJacobianProductsJob );
+    this->LaunchJacobianTermsThreads( parameters, UpdateCovarianceJob );
+
+    /** Print progress 0-50%. */
+    progressObserver->UpdateAndPrintProgress( parameters.st_BatchEnd );
+  }
+  parameters.st_JacobianProducts.clear();
+
+  /** Apply the scales, and compute TrC = trace(C) and TrCC = ||C||_F^2.
+   * These loops are linear in the number of allocated blocks.
    */
-  unsigned int onezero = 0;
-  for ( unsigned int s = 0; s < nrOfBandStructureSamples; ++s )
+  this->LaunchJacobianTermsThreads( parameters, FinalizeCovarianceJob );
+  for ( unsigned int t = 0; t < numberOfThreads; ++t )
   {
-    /** Semi-randomly get some samples from the sample container. */
-    const unsigned int samplenr = ( s + 1 ) * nrofsamples
-      / ( nrOfBandStructureSamples + 2 + onezero );
-    onezero = 1 - onezero; // introduces semi-randomness
+    TrC += parameters.st_TrC[ t ];
+    TrCC += parameters.st_TrCC[ t ];
+  }
+  elxout << "  The covariance matrix uses "
+    << cov->GetNumberOfAllocatedBlocks() << " blocks of "
+    << BlockSparseCovarianceMatrixType::BlockSize << "x"
+    << BlockSparseCovarianceMatrixType::BlockSize << " entries." << std::endl;
 
-    /** Read fixed coordinates and get Jacobian J_j. */
-    const FixedImagePointType & point
-      = sampleContainer->GetElement(samplenr).m_ImageCoordinates;
-    this->m_AdvancedTransform->GetJacobian( point, jacj, jacind );
+  /**
+   *    TERM 3 and 4
+   *
+   * Compute maxJJ and maxJCJ
+   * \li maxJJ = max_j [ ||J_j||_F^2 + 2\sqrt{2} || J_j J_j^T ||_F ]
+   * \li maxJCJ = max_j [ Tr( J_j C J_j^T ) + 2\sqrt{2} || J_j C J_j^T ||_F ]
+   */
+  for ( unsigned long batchBegin = 0; batchBegin < nrofsamples; batchBegin += batchSize )
+  {
+    parameters.st_BatchBegin = batchBegin;
+    parameters.st_BatchEnd = std::min(
+      batchBegin + batchSize, static_cast<unsigned long>( nrofsamples ) );
 
-    /** Skip invalid Jacobians in the beginning, if any. */
-    if ( sizejacind > 1 )
-    {
-      if ( jacind[ 0 ] == jacind[ 1 ] )
-      {
-        continue;
-      }
-    }
+    this->LaunchJacobianTermsThreads( parameters, ComputeMaximumJacobianTermsJob );
 
-    /** Fill the histogram of parameter nr differences. */
-    for ( unsigned int i = 0; i < sizejacind; ++i )
-    {
-      const int jacindi = static_cast<int>( jacind[ i ] );
-      for ( unsigned int j = i; j < sizejacind; ++j )
-      {
-        const int jacindj = static_cast<int>( jacind[ j ] );
-        difHist[ static_cast<unsigned int>( vcl_abs( jacindj - jacindi ) ) ]++;
-      }
-    }
+    /** Show progress 50-100%. */
+    progressObserver->UpdateAndPrintProgress( parameters.st_BatchEnd + nrofsamples );
+  }
+  for ( unsigned int t = 0; t < numberOfThreads; ++t )
+  {
+    maxJJ = vnl_math_max( maxJJ, parameters.st_MaxJJ[ t ] );
+    maxJCJ = vnl_math_max( maxJCJ, parameters.st_MaxJCJ[ t ] );
+  }
+
+  /** Finalize progress information. */
+  progressObserver->PrintProgress( 1.0 );
+
+} // end ComputeJacobianTerms()
+
+
+/**
+ * ******************** LaunchJacobianTermsThreads **********************
+ */
+
+template <class TElastix>
+void
+AdaptiveStochasticGradientDescent<TElastix>
+::LaunchJacobianTermsThreads(
+  JacobianTermsThreaderParameterType & parameters, JacobianTermsJobType job )
+{
+  const unsigned int numberOfThreads = parameters.st_NumberOfThreads;
+  parameters.st_Job = job;
+  parameters.st_Exceptions.resize( numberOfThreads );
+  parameters.st_Failed.assign( numberOfThreads, 0 );
+
+  /** Run the job, without the threader if there is only one thread. */
+  if ( numberOfThreads == 1 )
+  {
+    this->ThreadedComputeJacobianTerms( 0, parameters );
+    return;
   }
 
-  /** Copy the nonzero elements of the difHist to a vector pairs. */
-  for ( unsigned int p = 0; p < P; ++p )
+  this->m_Threader->SetNumberOfThreads( numberOfThreads );
+  this->m_Threader->SetSingleMethod( JacobianTermsThreaderCallback, &parameters );
+  this->m_Threader->SingleMethodExecute();
+
+  /** Pass on the exception of the first thread that failed. */
+  for ( unsigned int t = 0; t < numberOfThreads; ++t )
   {
-    const unsigned int freq = difHist[ p ];
-    if ( freq != 0 )
+    if ( parameters.st_Failed[ t ] )
     {
-      difHist2.push_back( FreqPairType( freq, p ) );
+      throw parameters.st_Exceptions[ t ];
     }
   }
-  difHist.resize( 0 );
-
-  /** Compute the number of bands. */
-  elxout << "  Estimated band size covariance matrix: " << difHist2.size() << std::endl;
-  const unsigned int bandcovsize = vnl_math_min( maxbandcovsize,
-    static_cast<unsigned int>(difHist2.size()) );
-  elxout << "  Used band size covariance matrix: " << bandcovsize << std::endl;
-  /** Maps parameterNrDifference (q-p) to colnr in bandcov. */
-  std::vector<unsigned int> bandcovMap( P, bandcovsize );
-  /** Maps colnr in bandcov to parameterNrDifference (q-p). */
-  std::vector<unsigned int> bandcovMap2( bandcovsize, P );
-
-  /** Sort the difHist2 based on the frequencies. */
-  std::sort( difHist2.begin(), difHist2.end() );
-
-  /** Determine the bands that are expected to be most dominant. */
-  DifHist2Type::iterator difHist2It = difHist2.end();
-  for ( unsigned int b = 0; b < bandcovsize; ++b )
+
+} // end LaunchJacobianTermsThreads()
+
+
+/**
+ * ******************** JacobianTermsThreaderCallback **********************
+ */
+
+template <class TElastix>
+ITK_THREAD_RETURN_TYPE
+AdaptiveStochasticGradientDescent<TElastix>
+::JacobianTermsThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>( arg );
+  const unsigned int threadID = infoStruct->ThreadID;
+  JacobianTermsThreaderParameterType * parameters
+    = static_cast<JacobianTermsThreaderParameterType *>( infoStruct->UserData );
+
+  /** Exceptions can not be passed on from a thread. Store it instead. */
+  try
+  {
+    parameters->st_Self->ThreadedComputeJacobianTerms( threadID, *parameters );
+  }
+  catch ( ExceptionObject & err )
   {
-    --difHist2It;
-    bandcovMap[ difHist2It->second ] = b;
-    bandcovMap2[ b ] = difHist2It->second;
+    parameters->st_Exceptions[ threadID ] = err;
+    parameters->st_Failed[ threadID ] = 1;
   }
 
-  /** Initialize band matrix. */
-  bandcov = CovarianceMatrixType( P, bandcovsize );
-  bandcov.Fill( 0.0 );
+  return ITK_THREAD_RETURN_VALUE;
 
-  /**
-   *    TERM 1
-   *
-   * Loop over image and compute Jacobian.
-   * Compute C = 1/n \sum_i J_i^T J_i
-   * Possibly apply scaling afterwards.
-   */
-  jacind[ 0 ] = 0;
-  if ( sizejacind > 1 ) jacind[ 1 ] = 0;
-  for ( iter = begin; iter != end; ++iter )
+} // end JacobianTermsThreaderCallback()
+
+
+/**
+ * ******************** ThreadedComputeJacobianTerms **********************
+ */
+
+template <class TElastix>
+void
+AdaptiveStochasticGradientDescent<TElastix>
+::ThreadedComputeJacobianTerms( unsigned int threadID,
+  JacobianTermsThreaderParameterType & parameters )
+{
+  switch ( parameters.st_Job )
   {
-    /** Print progress 0-50%. */
-    progressObserver->UpdateAndPrintProgress( samplenr );
-    ++samplenr;
+    case ComputeJacobianProductsJob:
+      this->ThreadedComputeJacobianProducts( threadID, parameters );
+      break;
+    case UpdateCovarianceJob:
+      this->ThreadedUpdateCovariance( threadID, parameters );
+      break;
+    case FinalizeCovarianceJob:
+      this->ThreadedFinalizeCovariance( threadID, parameters );
+      break;
+    case ComputeMaximumJacobianTermsJob:
+      this->ThreadedComputeMaximumJacobianTerms( threadID, parameters );
+      break;
+  }
+
+} // end ThreadedComputeJacobianTerms()
+
+
+/**
+ * ******************** ThreadedComputeJacobianProducts **********************
+ * Compute the products J_j^T J_j of this thread's part of the batch.
+ */
+
+template <class TElastix>
+void
+AdaptiveStochasticGradientDescent<TElastix>
+::ThreadedComputeJacobianProducts( unsigned int threadID,
+  JacobianTermsThreaderParameterType & parameters )
+{
+  /** This thread's part of the batch. */
+  const unsigned long batchSize = parameters.st_BatchEnd - parameters.st_BatchBegin;
+  const unsigned long posBegin = parameters.st_BatchBegin
+    + batchSize * threadID / parameters.st_NumberOfThreads;
+  const unsigned long posEnd = parameters.st_BatchBegin
+    + batchSize * ( threadID + 1 ) / parameters.st_NumberOfThreads;
 
+  JacobianProductsType & products = parameters.st_JacobianProducts[ threadID ];
+  products.st_NumberOfRuns = 0;
+
+  const unsigned int outdim = this->m_AdvancedTransform->GetOutputSpaceDimension();
+  const unsigned int sizejacind
+    = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  JacobianType jacj( outdim, sizejacind );
+  NonZeroJacobianIndicesType jacind( sizejacind );
+
+  for ( unsigned long pos = posBegin; pos < posEnd; ++pos )
+  {
     /** Read fixed coordinates and get Jacobian J_j. */
-    const FixedImagePointType & point = (*iter).Value().m_ImageCoordinates;
-    this->m_AdvancedTransform->GetJacobian( point, jacj, jacind  );
+    const FixedImagePointType point
+      = parameters.st_SampleContainer->GetImageCoordinates( pos );
+    this->m_AdvancedTransform->GetJacobian( point, jacj, jacind );
 
     /** Skip invalid Jacobians in the beginning, if any. */
     if ( sizejacind > 1 )
@@ -973,173 +1080,217 @@ AdaptiveStochasticGradientDescent<TElastix>
       }
     }
 
-    if ( jacind == prevjacind )
+    const unsigned long run = products.st_NumberOfRuns;
+    if ( run > 0 && jacind == products.st_Indices[ run - 1 ] )
     {
       /** Update sum of J_j^T J_j. */
-      vnl_fastops::inc_X_by_AtA( jactjac, jacj );
+      vnl_fastops::inc_X_by_AtA( products.st_Products[ run - 1 ], jacj );
     }
     else
     {
-      /** The following should only be done after the first sample. */
-      if ( iter != begin )
+      /** Start a new run with J_j^T J_j. */
+      if ( run == products.st_Indices.size() )
       {
-        /** Update covariance matrix. */
-        for ( unsigned int pi = 0; pi < sizejacind; ++pi )
-        {
-          const unsigned int p = prevjacind[ pi ];
+        products.st_Indices.push_back( jacind );
+        products.st_Products.push_back( CovarianceMatrixType() );
+      }
+      products.st_Indices[ run ] = jacind;
+      vnl_fastops::AtA( products.st_Products[ run ], jacj );
+      ++products.st_NumberOfRuns;
+    }
+  }
 
-          for ( unsigned int qi = 0; qi < sizejacind; ++qi )
-          {
-            const unsigned int q = prevjacind[ qi ];
-            /** Exploit symmetry: only fill upper triangular part. */
-            if ( q >= p )
-            {
-              const double tempval = jactjac( pi, qi ) / n;
-              if ( vcl_abs( tempval ) > 1e-14 )
-              {
-                const unsigned int bandindex = bandcovMap[ q - p ];
-                if ( bandindex < bandcovsize )
-                {
-                  bandcov( p, bandindex ) +=tempval;
-                }
-                else
-                {
-                  cov( p, q ) += tempval;
-                }
-              }
-            }
-          } // qi
-        } // pi
-      } // end if
+} // end ThreadedComputeJacobianProducts()
 
-      /** Initialize jactjac by J_j^T J_j. */
-      vnl_fastops::AtA( jactjac, jacj );
 
-      /** Remember nonzerojacobian indices. */
-      prevjacind = jacind;
-    } // end else
+/**
+ * ******************** ThreadedUpdateCovariance **********************
+ * Add the products of all threads to the rows of blocks of the
+ * covariance matrix that are owned by this thread.
+ */
 
-  } // end iter loop: end computation of covariance matrix
+template <class TElastix>
+void
+AdaptiveStochasticGradientDescent<TElastix>
+::ThreadedUpdateCovariance( unsigned int threadID,
+  JacobianTermsThreaderParameterType & parameters )
+{
+  typedef typename BlockSparseCovarianceMatrixType::SizeValueType SizeValueType;
+  const unsigned int blockSizeLog2 = BlockSparseCovarianceMatrixType::BlockSizeLog2;
 
-  /** Update covariance matrix once again to include last jactjac updates
-   * \todo: a bit ugly that this loop is copied from above.
-   */
-  for ( unsigned int pi = 0; pi < sizejacind; ++pi )
+  const unsigned int numberOfThreads = parameters.st_NumberOfThreads;
+  const double n = parameters.st_NumberOfSamples;
+  BlockSparseCovarianceMatrixType & cov = *parameters.st_Covariance;
+
+  for ( unsigned int t = 0; t < numberOfThreads; ++t )
   {
-    const unsigned int p = prevjacind[ pi ];
-    for ( unsigned int qi = 0; qi < sizejacind; ++qi )
+    const JacobianProductsType & products = parameters.st_JacobianProducts[ t ];
+    for ( unsigned long run = 0; run < products.st_NumberOfRuns; ++run )
     {
-      const unsigned int q = prevjacind[ qi ];
-      if ( q >= p )
+      const NonZeroJacobianIndicesType & jacind = products.st_Indices[ run ];
+      const CovarianceMatrixType & jactjac = products.st_Products[ run ];
+      const unsigned int sizejacind = jacind.size();
+
+      for ( unsigned int pi = 0; pi < sizejacind; ++pi )
       {
-        const double tempval = jactjac( pi, qi ) / n;
-        if ( vcl_abs( tempval ) > 1e-14 )
+        const SizeValueType p = jacind[ pi ];
+        const SizeValueType blockRow = p >> blockSizeLog2;
+        if ( blockRow % numberOfThreads != threadID ) continue;
+
+        /** The nonzero indices come in runs, so remember the last block. */
+        SizeValueType blockColumn = 0;
+        CovarianceValueType * block = 0;
+        for ( unsigned int qi = 0; qi < sizejacind; ++qi )
         {
-           const unsigned int bandindex  = bandcovMap[ q - p ];
-           if ( bandindex < bandcovsize )
-           {
-             bandcov( p, bandindex ) +=tempval;
-           }
-           else
-           {
-             cov( p, q ) += tempval;
-           }
-        }
-      }
-    } // qi
-  } // pi
+          const SizeValueType q = jacind[ qi ];
+          /** Exploit symmetry: only fill upper triangular part. */
+          if ( q >= p )
+          {
+            /** Small entries are dropped after the reduction, in
+             * ThreadedFinalizeCovariance(), not per run, so that the result
+             * does not depend on how the samples are grouped in runs.
+             */
+            if ( block == 0 || ( q >> blockSizeLog2 ) != blockColumn )
+            {
+              blockColumn = q >> blockSizeLog2;
+              block = cov.GetBlock( blockRow, blockColumn );
+            }
+            block[ BlockSparseCovarianceMatrixType::GetOffsetInBlock( p, q ) ]
+              += jactjac( pi, qi ) / n;
+          }
+        } // qi
+      } // pi
+    } // run
+  } // t
 
-  /** Copy the bandmatrix into the sparse matrix and empty the bandcov matrix.
-   * \todo: perhaps work further with this bandmatrix instead.
-   */
-  for( unsigned int p = 0; p < P; ++p )
+} // end ThreadedUpdateCovariance()
+
+
+/**
+ * ******************** ThreadedFinalizeCovariance **********************
+ * Drop the negligible entries of the covariance matrix, apply the scales,
+ * and compute this thread's part of TrC and TrCC, for the rows of blocks
+ * owned by this thread.
+ */
+
+template <class TElastix>
+void
+AdaptiveStochasticGradientDescent<TElastix>
+::ThreadedFinalizeCovariance( unsigned int threadID,
+  JacobianTermsThreaderParameterType & parameters )
+{
+  typedef typename BlockSparseCovarianceMatrixType::SizeValueType SizeValueType;
+  const unsigned int blockSize = BlockSparseCovarianceMatrixType::BlockSize;
+
+  const unsigned int numberOfThreads = parameters.st_NumberOfThreads;
+  BlockSparseCovarianceMatrixType & cov = *parameters.st_Covariance;
+  const ScalesType & scales = *parameters.st_Scales;
+  const SizeValueType P = cov.GetSize();
+  const SizeValueType numberOfBlockRows = cov.GetNumberOfBlockRows();
+
+  double TrC = 0.0;
+  double TrCC = 0.0;
+  for ( SizeValueType blockRow = threadID; blockRow < numberOfBlockRows;
+    blockRow += numberOfThreads )
   {
-    for ( unsigned int b = 0; b < bandcovsize; ++b )
+    const SizeValueType numberOfBlocks = cov.GetNumberOfBlocksInRow( blockRow );
+    for ( SizeValueType i = 0; i < numberOfBlocks; ++i )
     {
-      const double tempval = bandcov( p, b );
-      if ( vcl_abs( tempval ) > 1e-14 )
+      SizeValueType blockColumn;
+      CovarianceValueType * block = cov.GetBlockInRow( blockRow, i, blockColumn );
+
+      for ( unsigned int r = 0; r < blockSize; ++r )
       {
-        const unsigned int q = p + bandcovMap2[ b ];
-        cov( p, q ) = tempval;
-      }
-    }
-  }
-  bandcov.set_size( 0, 0 );
+        const SizeValueType p = blockRow * blockSize + r;
+        for ( unsigned int c = 0; c < blockSize; ++c )
+        {
+          const SizeValueType q = blockColumn * blockSize + c;
+          CovarianceValueType & covpq = block[ r * blockSize + c ];
+          if ( q < p || q >= P ) continue;
 
-  /** Apply scales. */
-  if ( this->GetUseScales() )
-  {
-    for ( unsigned int p = 0; p < P; ++p )
-    {
-      cov.scale_row( p, 1.0 / scales[ p ] );
-    }
-    /**  \todo: this might be faster with get_row instead of the iterator */
-    cov.reset();
-    bool notfinished = cov.next();
-    while ( notfinished )
-    {
-      const int col = cov.getcolumn();
-      cov( cov.getrow(), col ) /= scales[ col ];
-      notfinished = cov.next();
-    }
-  }
+          /** Drop negligible entries, now that all samples are summed. */
+          if ( vcl_abs( covpq ) <= 1e-14 )
+          {
+            covpq = 0.0;
+            continue;
+          }
 
-  /** Compute TrC = trace(C), and diagcov. */
-  for ( unsigned int p = 0; p < P; ++p )
-  {
-    if ( !cov.empty_row( p ) )
-    {
-      //avoid creation of element if the row is empty
-      CovarianceValueType & covpp = cov( p, p );
-      TrC += covpp;
-      diagcov[ p ] = covpp;
-    }
-  }
+          /** Apply scales. */
+          if ( parameters.st_UseScales )
+          {
+            covpq /= scales[ p ] * scales[ q ];
+          }
 
-  /**
-   *    TERM 2
-   *
-   * Compute TrCC = ||C||_F^2.
-   */
-  cov.reset();
-  bool notfinished2 = cov.next();
-  while ( notfinished2 )
-  {
-    TrCC += vnl_math_sqr( cov.value() );
-    notfinished2 = cov.next();
-  }
+          /** Compute TrC = trace(C), and TrCC = ||C||_F^2, using the
+           * symmetry for the off-diagonal elements.
+           */
+          const double sqr = vnl_math_sqr( covpq );
+          if ( p == q )
+          {
+            TrC += covpq;
+            TrCC += sqr;
+          }
+          else
+          {
+            TrCC += 2.0 * sqr;
+          }
+        } // c
+      } // r
+    } // i
+  } // blockRow
 
-  /** Symmetry: multiply by 2 and subtract sumsqr(diagcov). */
-  TrCC *= 2.0;
-  TrCC -= diagcov.diagonal().squared_magnitude();
+  parameters.st_TrC[ threadID ] = TrC;
+  parameters.st_TrCC[ threadID ] = TrCC;
 
-  /**
-   *    TERM 3 and 4
-   *
-   * Compute maxJJ and maxJCJ
-   * \li maxJJ = max_j [ ||J_j||_F^2 + 2\sqrt{2} || J_j J_j^T ||_F ]
-   * \li maxJCJ = max_j [ Tr( J_j C J_j^T ) + 2\sqrt{2} || J_j C J_j^T ||_F ]
-   */
-  maxJJ = 0.0;
-  maxJCJ = 0.0;
+} // end ThreadedFinalizeCovariance()
+
+
+/**
+ * ******************** ThreadedComputeMaximumJacobianTerms **********************
+ * Compute maxJJ and maxJCJ over this thread's part of the batch.
+ */
+
+template <class TElastix>
+void
+AdaptiveStochasticGradientDescent<TElastix>
+::ThreadedComputeMaximumJacobianTerms( unsigned int threadID,
+  JacobianTermsThreaderParameterType & parameters )
+{
+  typedef typename BlockSparseCovarianceMatrixType::SizeValueType SizeValueType;
+  const unsigned int blockSizeLog2 = BlockSparseCovarianceMatrixType::BlockSizeLog2;
+
+  /** This thread's part of the batch. */
+  const unsigned long batchSize = parameters.st_BatchEnd - parameters.st_BatchBegin;
+  const unsigned long posBegin = parameters.st_BatchBegin
+    + batchSize * threadID / parameters.st_NumberOfThreads;
+  const unsigned long posEnd = parameters.st_BatchBegin
+    + batchSize * ( threadID + 1 ) / parameters.st_NumberOfThreads;
+  if ( posBegin == posEnd ) return;
+
+  const BlockSparseCovarianceMatrixType & cov = *parameters.st_Covariance;
+  const ScalesType & scales = *parameters.st_Scales;
+  const unsigned int outdim = this->m_AdvancedTransform->GetOutputSpaceDimension();
+  const unsigned int sizejacind
+    = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+
+  double maxJJ = parameters.st_MaxJJ[ threadID ];
+  double maxJCJ = parameters.st_MaxJCJ[ threadID ];
   const double sqrt2 = vcl_sqrt( static_cast<double>( 2.0 ) );
+  JacobianType jacj( outdim, sizejacind );
+  NonZeroJacobianIndicesType jacind( sizejacind );
   JacobianType jacjjacj( outdim, outdim );
   JacobianType jacjcov( outdim, sizejacind );
-  DiagCovarianceMatrixType diagcovsparse( sizejacind );
-  JacobianType jacjdiagcov( outdim, sizejacind );
-  JacobianType jacjdiagcovjacj( outdim, outdim );
   JacobianType jacjcovjacj( outdim, outdim );
-  NonZeroJacobianIndicesExpandedType jacindExpanded( P );
 
-  samplenr = 0;
-  for ( iter = begin; iter != end; ++iter )
+  for ( unsigned long pos = posBegin; pos < posEnd; ++pos )
   {
     /** Read fixed coordinates and get Jacobian. */
-    const FixedImagePointType & point = (*iter).Value().m_ImageCoordinates;
+    const FixedImagePointType point
+      = parameters.st_SampleContainer->GetImageCoordinates( pos );
     this->m_AdvancedTransform->GetJacobian( point, jacj, jacind  );
 
     /** Apply scales, if necessary. */
-    if ( this->GetUseScales() )
+    if ( parameters.st_UseScales )
     {
       for ( unsigned int pi = 0; pi < sizejacind; ++pi )
       {
@@ -1164,61 +1315,54 @@ AdaptiveStochasticGradientDescent<TElastix>
     /** J_j C = jacjC. */
     jacjcov.Fill( 0.0 );
 
-    /** Store the nonzero Jacobian indices in a different format
-     * and create the sparse diagcov.
+    /** Only the entries C(p,q) with p and q in the nonzero Jacobian indices
+     * of this sample are needed. They are looked up in the upper triangular
+     * part of C, and each is used for both (p,q) and (q,p).
      */
-    jacindExpanded.Fill( sizejacind );
     for ( unsigned int pi = 0; pi < sizejacind; ++pi )
     {
-      const unsigned int p = jacind[ pi ];
-      jacindExpanded[ p ] = pi;
-      diagcovsparse[ pi ] = diagcov[ p ];
-    }
-
-    /** We below calculate jacjC = J_j cov^T, but later we will correct
-     * for this using:
-     * J C J' = J (cov + cov' - diag(cov')) J'.
-     * (NB: cov now still contains only the upper triangular part of C)
-     */
-    for ( unsigned int pi = 0; pi < sizejacind; ++pi )
-    {
-      const unsigned int p = jacind[ pi ];
-      if ( !cov.empty_row( p ) )
+      const SizeValueType p = jacind[ pi ];
+      const SizeValueType blockRow = p >> blockSizeLog2;
+
+      /** The nonzero indices come in runs, so remember the last block. */
+      SizeValueType blockColumn = 0;
+      const CovarianceValueType * block = 0;
+      bool blockFound = false;
+      for ( unsigned int qi = 0; qi < sizejacind; ++qi )
       {
-        SparseRowType & covrowp = cov.get_row( p );
-        typename SparseRowType::iterator covrowpit;
+        const SizeValueType q = jacind[ qi ];
+        if ( q < p || ( q == p && qi != pi ) ) continue;
 
-        /** Loop over row p of the sparse cov matrix. */
-        for ( covrowpit = covrowp.begin(); covrowpit != covrowp.end(); ++covrowpit )
+        if ( !blockFound || ( q >> blockSizeLog2 ) != blockColumn )
         {
-          const unsigned int q = (*covrowpit).first;
-          const unsigned int qi = jacindExpanded[ q ];
+          blockColumn = q >> blockSizeLog2;
+          block = cov.FindBlock( blockRow, blockColumn );
+          blockFound = true;
+        }
+        if ( block == 0 ) continue;
 
-          if ( qi < sizejacind )
-          {
-            /** If found, update the jacjC matrix. */
-            const CovarianceValueType covElement = (*covrowpit).second;
-            for ( unsigned int dx = 0; dx < outdim; ++dx )
-            {
-              jacjcov[ dx ][ pi ] += jacj[ dx ][ qi ] * covElement;
-            } //dx
-          } // if qi < sizejacind
-        } // for covrow
+        const CovarianceValueType covElement
+          = block[ BlockSparseCovarianceMatrixType::GetOffsetInBlock( p, q ) ];
+        if ( covElement == 0.0 ) continue;
 
-      } // if not empty row
+        /** Update the jacjC matrix. */
+        for ( unsigned int dx = 0; dx < outdim; ++dx )
+        {
+          jacjcov[ dx ][ pi ] += jacj[ dx ][ qi ] * covElement;
+        }
+        if ( q != p )
+        {
+          for ( unsigned int dx = 0; dx < outdim; ++dx )
+          {
+            jacjcov[ dx ][ qi ] += jacj[ dx ][ pi ] * covElement;
+          }
+        }
+      } // qi
     } // pi
 
-    /** J_j C J_j^T  = jacjCjacj.
-     * But note that we actually compute J_j cov' J_j^T
-     */
+    /** J_j C J_j^T  = jacjCjacj. */
     vnl_fastops::ABt( jacjcovjacj, jacjcov, jacj );
 
-    /** jacjCjacj = jacjCjacj+ jacjCjacj' - jacjdiagcovjacj */
-    jacjdiagcov = jacj * diagcovsparse;
-    vnl_fastops::ABt( jacjdiagcovjacj, jacjdiagcov, jacj );
-    jacjcovjacj += jacjcovjacj.transpose();
-    jacjcovjacj -= jacjdiagcovjacj;
-
     /** Compute 1st part of JCJ: Tr( J_j C J_j^T ). */
     for ( unsigned int d = 0; d < outdim; ++d )
     {
@@ -1231,16 +1375,12 @@ AdaptiveStochasticGradientDescent<TElastix>
     /** Max_j [JCJ_j]. */
     maxJCJ = vnl_math_max( maxJCJ, JCJ_j );
 
-    /** Show progress 50-100%. */
-    progressObserver->UpdateAndPrintProgress( samplenr + nrofsamples );
-    ++samplenr;
-
   } // end loop over sample container
 
-  /** Finalize progress information. */
-  progressObserver->PrintProgress( 1.0 );
+  parameters.st_MaxJJ[ threadID ] = maxJJ;
+  parameters.st_MaxJCJ[ threadID ] = maxJCJ;
 
-} // end ComputeJacobianTerms()
+} // end ThreadedComputeMaximumJacobianTerms()
 
 
 /**
@@ -1267,6 +1407,7 @@ AdaptiveStochasticGradientDescent<TElastix>
   sampler->SetInput( testPtr->GetFixedImage() );
   sampler->SetInputImageRegion( testPtr->GetFixedImageRegion() );
   sampler->SetMask( testPtr->GetFixedImageMask() );
+  sampler->SetUseMultiThread( this->m_UseMultiThread );
 
   /** Determine grid spacing of sampler such that the desired
    * NumberOfJacobianMeasurements is achieved approximately.
@@ -0,0 +1,192 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkBlockSparseSymmetricMatrix_h
+#define __itkBlockSparseSymmetricMatrix_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include <vector>
+#include <utility>
+
+
+namespace itk
+{
+
+/**
+ * \class BlockSparseSymmetricMatrix
+ * \brief A compact storage of a large, sparse, symmetric matrix, such as
+ * the covariance matrix of the Jacobian of a B-spline transform.
+ *
+ * Only the upper triangular part is stored. It is divided in square blocks
+ * of BlockSize x BlockSize entries, and a block is only allocated when one
+ * of its entries is updated. The nonzero Jacobian indices of a B-spline
+ * transform come in runs of consecutive parameters, so the product
+ * J^T J of a sample updates a few blocks only, and entries of parameters
+ * that never share a sample are not stored at all. The memory thus grows
+ * with the number of samples instead of with the square of the number of
+ * parameters.
+ *
+ * The blocks of a row of blocks are stored in a pool of that row, in the
+ * order of allocation. A sorted table per row of blocks gives the slot of
+ * each block column. Different threads may update different rows of blocks
+ * at the same time.
+ *
+ * \warning The pointers returned by GetBlock() and FindBlock() are
+ * invalidated by the next allocation of a block in the same row of blocks.
+ *
+ * \ingroup Optimizers
+ * \sa AdaptiveStochasticGradientDescent
+ */
+
+template < class TValue >
+class BlockSparseSymmetricMatrix : public Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef BlockSparseSymmetricMatrix  Self;
+  typedef Object                      Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BlockSparseSymmetricMatrix, Object );
+
+  /** Typedefs. */
+  typedef TValue          ValueType;
+  typedef unsigned long   SizeValueType;
+  typedef unsigned int    SlotType;
+
+  /** The number of rows and columns of a block. Must be a power of two. */
+  itkStaticConstMacro( BlockSize, unsigned int, 4 );
+  itkStaticConstMacro( BlockSizeLog2, unsigned int, 2 );
+
+  /** The number of entries of a block, which are stored row by row. */
+  itkStaticConstMacro( NumberOfBlockEntries, unsigned int, 16 );
+
+  /** Set the number of rows (and columns) and remove all entries. */
+  virtual void SetSize( SizeValueType size );
+
+  /** Get the number of rows (and columns). */
+  itkGetConstMacro( Size, SizeValueType );
+
+  /** The number of rows (and columns) of blocks. */
+  SizeValueType GetNumberOfBlockRows( void ) const
+  {
+    return this->m_BlockRows.size();
+  }
+
+  /** The number of allocated blocks, and the memory they use in bytes. */
+  virtual SizeValueType GetNumberOfAllocatedBlocks( void ) const;
+  virtual SizeValueType GetMemoryUsage( void ) const;
+
+  /** Get a pointer to the first entry of block (blockRow, blockColumn),
+   * with blockRow <= blockColumn. The block is allocated (and zeroed) if
+   * it does not exist yet.
+   */
+  ValueType * GetBlock( SizeValueType blockRow, SizeValueType blockColumn );
+
+  /** Get a pointer to the first entry of block (blockRow, blockColumn),
+   * or 0 if that block is not allocated.
+   */
+  const ValueType * FindBlock( SizeValueType blockRow, SizeValueType blockColumn ) const;
+
+  /** Get entry (p,q), for any p and q. Returns zero for entries that are
+   * not stored.
+   */
+  ValueType GetValue( SizeValueType p, SizeValueType q ) const;
+
+  /** The position of entry (p,q) in its block. */
+  static unsigned int GetOffsetInBlock( SizeValueType p, SizeValueType q )
+  {
+    return static_cast<unsigned int>(
+      ( ( p & ( BlockSize - 1 ) ) << BlockSizeLog2 ) + ( q & ( BlockSize - 1 ) ) );
+  }
+
+  /** Add value to entry (p,q), with p <= q. */
+  void AddValue( SizeValueType p, SizeValueType q, ValueType value )
+  {
+    this->GetBlock( p >> BlockSizeLog2, q >> BlockSizeLog2 )[
+      GetOffsetInBlock( p, q ) ] += value;
+  }
+
+  /** Access to the allocated blocks of a row of blocks, in the order of
+   * allocation, e.g.:
+   * \code
+   *   for ( SizeValueType i = 0; i < matrix->GetNumberOfBlocksInRow( r ); ++i )
+   *   {
+   *     SizeValueType c;
+   *     ValueType * block = matrix->GetBlockInRow( r, i, c );
+   *   }
+   * \endcode
+   * The entries of a block on the diagonal below the diagonal are zero.
+   */
+  SizeValueType GetNumberOfBlocksInRow( SizeValueType blockRow ) const
+  {
+    return this->m_BlockRows[ blockRow ].m_BlockColumns.size();
+  }
+  ValueType * GetBlockInRow( SizeValueType blockRow, SizeValueType i,
+    SizeValueType & blockColumn )
+  {
+    BlockRowType & row = this->m_BlockRows[ blockRow ];
+    blockColumn = row.m_BlockColumns[ i ];
+    return &( row.m_Pool[ i * NumberOfBlockEntries ] );
+  }
+
+protected:
+
+  BlockSparseSymmetricMatrix();
+  virtual ~BlockSparseSymmetricMatrix() {};
+
+  /** Print Self. */
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  /** Typedefs for the storage. The table maps a block column to a slot in
+   * the pool, and is sorted on the block column. The block column of each
+   * slot is also stored, in the order of the pool.
+   */
+  typedef std::pair< SizeValueType, SlotType >    TableEntryType;
+  typedef std::vector< TableEntryType >           TableType;
+  typedef std::vector< ValueType >                PoolType;
+
+  struct BlockRowType
+  {
+    TableType                     m_Table;
+    std::vector< SizeValueType >  m_BlockColumns;
+    PoolType                      m_Pool;
+  };
+
+  /** The rows of blocks. */
+  std::vector< BlockRowType >     m_BlockRows;
+
+private:
+
+  BlockSparseSymmetricMatrix( const Self& );  // purposely not implemented
+  void operator=( const Self& );              // purposely not implemented
+
+  SizeValueType m_Size;
+
+}; // end class BlockSparseSymmetricMatrix
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBlockSparseSymmetricMatrix.hxx"
+#endif
+
+#endif // end #ifndef __itkBlockSparseSymmetricMatrix_h
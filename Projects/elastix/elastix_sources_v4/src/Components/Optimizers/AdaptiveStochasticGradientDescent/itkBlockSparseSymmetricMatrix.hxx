@@ -0,0 +1,197 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkBlockSparseSymmetricMatrix_hxx
+#define __itkBlockSparseSymmetricMatrix_hxx
+
+#include "itkBlockSparseSymmetricMatrix.h"
+#include "itkNumericTraits.h"
+#include <algorithm>
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template < class TValue >
+BlockSparseSymmetricMatrix<TValue>
+::BlockSparseSymmetricMatrix()
+{
+  this->m_Size = 0;
+
+} // end Constructor
+
+
+/**
+ * ********************* SetSize ****************************
+ */
+
+template < class TValue >
+void
+BlockSparseSymmetricMatrix<TValue>
+::SetSize( SizeValueType size )
+{
+  this->m_Size = size;
+
+  /** Release all memory. */
+  std::vector< BlockRowType >().swap( this->m_BlockRows );
+  this->m_BlockRows.resize( ( size + BlockSize - 1 ) >> BlockSizeLog2 );
+
+  this->Modified();
+
+} // end SetSize()
+
+
+/**
+ * ********************* GetBlock ****************************
+ */
+
+template < class TValue >
+typename BlockSparseSymmetricMatrix<TValue>::ValueType *
+BlockSparseSymmetricMatrix<TValue>
+::GetBlock( SizeValueType blockRow, SizeValueType blockColumn )
+{
+  BlockRowType & row = this->m_BlockRows[ blockRow ];
+
+  /** Find the block column in the sorted table. Since the slots are
+   * not negative, the search key comes before any entry of that column.
+   */
+  typename TableType::iterator it = std::lower_bound(
+    row.m_Table.begin(), row.m_Table.end(), TableEntryType( blockColumn, 0 ) );
+  if ( it != row.m_Table.end() && it->first == blockColumn )
+  {
+    return &( row.m_Pool[ it->second * NumberOfBlockEntries ] );
+  }
+
+  /** Allocate a zeroed block. */
+  const SlotType slot = static_cast<SlotType>( row.m_BlockColumns.size() );
+  row.m_Table.insert( it, TableEntryType( blockColumn, slot ) );
+  row.m_BlockColumns.push_back( blockColumn );
+  row.m_Pool.resize( row.m_Pool.size() + NumberOfBlockEntries,
+    NumericTraits<ValueType>::Zero );
+  return &( row.m_Pool[ slot * NumberOfBlockEntries ] );
+
+} // end GetBlock()
+
+
+/**
+ * ********************* FindBlock ****************************
+ */
+
+template < class TValue >
+const typename BlockSparseSymmetricMatrix<TValue>::ValueType *
+BlockSparseSymmetricMatrix<TValue>
+::FindBlock( SizeValueType blockRow, SizeValueType blockColumn ) const
+{
+  const BlockRowType & row = this->m_BlockRows[ blockRow ];
+  typename TableType::const_iterator it = std::lower_bound(
+    row.m_Table.begin(), row.m_Table.end(), TableEntryType( blockColumn, 0 ) );
+  if ( it != row.m_Table.end() && it->first == blockColumn )
+  {
+    return &( row.m_Pool[ it->second * NumberOfBlockEntries ] );
+  }
+  return 0;
+
+} // end FindBlock()
+
+
+/**
+ * ********************* GetValue ****************************
+ */
+
+template < class TValue >
+typename BlockSparseSymmetricMatrix<TValue>::ValueType
+BlockSparseSymmetricMatrix<TValue>
+::GetValue( SizeValueType p, SizeValueType q ) const
+{
+  /** Only the upper triangular part is stored. */
+  if ( q < p ) std::swap( p, q );
+
+  const ValueType * block = this->FindBlock( p >> BlockSizeLog2, q >> BlockSizeLog2 );
+  if ( block == 0 )
+  {
+    return NumericTraits<ValueType>::Zero;
+  }
+  return block[ GetOffsetInBlock( p, q ) ];
+
+} // end GetValue()
+
+
+/**
+ * ********************* GetNumberOfAllocatedBlocks ****************************
+ */
+
+template < class TValue >
+typename BlockSparseSymmetricMatrix<TValue>::SizeValueType
+BlockSparseSymmetricMatrix<TValue>
+::GetNumberOfAllocatedBlocks( void ) const
+{
+  SizeValueType numberOfBlocks = 0;
+  for ( SizeValueType r = 0; r < this->m_BlockRows.size(); ++r )
+  {
+    numberOfBlocks += this->m_BlockRows[ r ].m_BlockColumns.size();
+  }
+  return numberOfBlocks;
+
+} // end GetNumberOfAllocatedBlocks()
+
+
+/**
+ * ********************* GetMemoryUsage ****************************
+ */
+
+template < class TValue >
+typename BlockSparseSymmetricMatrix<TValue>::SizeValueType
+BlockSparseSymmetricMatrix<TValue>
+::GetMemoryUsage( void ) const
+{
+  SizeValueType memory = this->m_BlockRows.capacity() * sizeof( BlockRowType );
+  for ( SizeValueType r = 0; r < this->m_BlockRows.size(); ++r )
+  {
+    const BlockRowType & row = this->m_BlockRows[ r ];
+    memory += row.m_Table.capacity() * sizeof( TableEntryType )
+      + row.m_BlockColumns.capacity() * sizeof( SizeValueType )
+      + row.m_Pool.capacity() * sizeof( ValueType );
+  }
+  return memory;
+
+} // end GetMemoryUsage()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+template < class TValue >
+void
+BlockSparseSymmetricMatrix<TValue>
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Size: " << this->m_Size << std::endl;
+  os << indent << "BlockSize: " << BlockSize << std::endl;
+  os << indent << "NumberOfAllocatedBlocks: "
+    << this->GetNumberOfAllocatedBlocks() << std::endl;
+  os << indent << "MemoryUsage: " << this->GetMemoryUsage() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+
+#endif // end #ifndef __itkBlockSparseSymmetricMatrix_hxx
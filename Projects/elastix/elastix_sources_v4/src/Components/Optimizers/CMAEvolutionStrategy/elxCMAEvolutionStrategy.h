@@ -107,6 +107,12 @@ using namespace itk;
    *    example: <tt>(UpdateBDPeriod 0 0 50)</tt> \n
    *    Default: 0 (so, automatically determined).
    *
+   * The members of the population are evaluated concurrently when the
+   * NumberOfConcurrentEvaluations parameter is larger than 1 and the metric
+   * and transform support copies; see the documentation of the
+   * elx::OptimizerBase and AdvancedImageToImageMetric::CreateConcurrentCopies().
+   * The result does not depend on this setting.
+   *
    * \ingroup Optimizers
    */
 
@@ -145,6 +151,7 @@ using namespace itk;
     typedef Superclass1::ParametersType                     ParametersType;
     typedef Superclass1::DerivativeType                     DerivativeType;
     typedef Superclass1::ScalesType                         ScalesType;
+    typedef Superclass1::CostFunctionContainerType          CostFunctionContainerType;
 
     /** Typedef's inherited from Elastix.*/
     typedef typename Superclass2::ElastixType           ElastixType;
@@ -48,6 +48,14 @@ using namespace itk;
       }
     }
 
+    /** Evaluate the population concurrently, if asked for. */
+    CostFunctionContainerType concurrentCostFunctions;
+    Command::Pointer prepareCommand;
+    this->CreateConcurrentCostFunctions(
+      this->GetCostFunction(), concurrentCostFunctions, prepareCommand );
+    this->SetConcurrentCostFunctions( concurrentCostFunctions );
+    this->SetConcurrentPrepareCommand( prepareCommand );
+
     /** Call the superclass */
     this->Superclass1::StartOptimization();
 
@@ -520,67 +520,105 @@ namespace itk
     /** Clear the old values */
     this->m_CostFunctionValues.clear();
 
-    /** Fill the m_NormalizedSearchDirs and SearchDirs */
-    unsigned int lam = 0;
+    /** The members do not depend on each other's cost function values, so
+     * all members that still need a search direction are drawn in this
+     * thread, in the order of the members, and evaluated together;
+     * concurrently if the superclass has copies of the cost function.
+     * The successful draws are given to the members in the order in which
+     * they were drawn, so a failed draw is replaced by the next draw of the
+     * random sequence, as in a sequential evaluation. Only the members that
+     * are left after a failure are drawn again, in one new batch. So the
+     * result does not depend on the number of threads, also when
+     * evaluations fail. */
+    ParametersContainerType positions;
+    MeasureContainerType values;
+    FailedContainerType failed;
     unsigned int nrOfFails = 0;
-    while ( lam < lambda )
+    while ( this->m_CostFunctionValues.size() < lambda )
     {
-      /** draw from distribution N(0,I) */
-      for (unsigned int par = 0; par < N; ++par )
+      const unsigned int firstLam
+        = static_cast<unsigned int>( this->m_CostFunctionValues.size() );
+      positions.resize( lambda - firstLam );
+      for ( unsigned int lam = firstLam; lam < lambda; ++lam )
       {
-        this->m_NormalizedSearchDirs[lam][par] =
-          this->m_RandomGenerator->GetNormalVariate();
-      }
-      /** Make like it was drawn from N(0,C) */
-      if ( this->GetUseCovarianceMatrixAdaptation() )
-      {
-        this->m_SearchDirs[lam] = this->m_B * ( this->m_D * this->m_NormalizedSearchDirs[lam] );
-      }
-      else
-      {
-        this->m_SearchDirs[lam] = this->m_NormalizedSearchDirs[lam];
-      }
-      /** Make like it was drawn from N( 0, sigma^2 C ) */
-      this->m_SearchDirs[lam] *= this->m_CurrentSigma;
-
-      /** Compute the cost function */
-      MeasureType costFunctionValue = 0.0;
-      /** x_lam = m + d_lam */
-      ParametersType x_lam = this->GetScaledCurrentPosition();
-      x_lam += this->m_SearchDirs[lam];
-      try
-      {
-        costFunctionValue = this->GetScaledValue( x_lam );
+        this->DrawSearchDirection( lam, N );
+
+        /** x_lam = m + d_lam */
+        positions[ lam - firstLam ] = this->GetScaledCurrentPosition();
+        positions[ lam - firstLam ] += this->m_SearchDirs[ lam ];
       }
-      catch ( ExceptionObject& err )
+
+      /** Compute the cost function values */
+      this->GetScaledValues( positions, values, failed );
+
+      /** Give the successful draws to the members, in the order of drawing. */
+      unsigned int lam = firstLam;
+      for ( unsigned int i = 0; i < positions.size(); ++i )
       {
-        ++nrOfFails;
-        /** try another parameter vector if we haven't tried that for 10 times already */
-        if ( nrOfFails <= 10 )
+        if ( failed[ i ] )
         {
+          /** try another parameter vector if we haven't tried that for 10 times already */
+          ++nrOfFails;
+          if ( nrOfFails > 10 )
+          {
+            this->m_StopCondition = MetricError;
+            this->StopOptimization();
+            throw this->GetScaledValuesException( i );
+          }
           continue;
         }
-        else
+
+        /** Move the draw to the first member without one. */
+        if ( lam != firstLam + i )
         {
-          this->m_StopCondition = MetricError;
-          this->StopOptimization();
-          throw err;
+          this->m_NormalizedSearchDirs[ lam ] = this->m_NormalizedSearchDirs[ firstLam + i ];
+          this->m_SearchDirs[ lam ] = this->m_SearchDirs[ firstLam + i ];
         }
-      }
-      /** Successfull cost function evaluation */
-      this->m_CostFunctionValues.push_back(
-        MeasureIndexPairType( costFunctionValue, lam ) );
 
-      /** Reset the number of failed cost function evaluations */
-      nrOfFails = 0;
+        /** Successfull cost function evaluation */
+        this->m_CostFunctionValues.push_back(
+          MeasureIndexPairType( values[ i ], lam ) );
+
+        /** Reset the number of failed cost function evaluations */
+        nrOfFails = 0;
 
-      /** next offspring member */
-      ++lam;
+        /** next offspring member */
+        ++lam;
+      }
     }
 
   } // end GenerateOffspring
 
 
+  /**
+   * ****************** DrawSearchDirection *********************
+   */
+
+  void
+    CMAEvolutionStrategyOptimizer::
+    DrawSearchDirection( unsigned int lam, unsigned int N )
+  {
+    /** draw from distribution N(0,I) */
+    for (unsigned int par = 0; par < N; ++par )
+    {
+      this->m_NormalizedSearchDirs[lam][par] =
+        this->m_RandomGenerator->GetNormalVariate();
+    }
+    /** Make like it was drawn from N(0,C) */
+    if ( this->GetUseCovarianceMatrixAdaptation() )
+    {
+      this->m_SearchDirs[lam] = this->m_B * ( this->m_D * this->m_NormalizedSearchDirs[lam] );
+    }
+    else
+    {
+      this->m_SearchDirs[lam] = this->m_NormalizedSearchDirs[lam];
+    }
+    /** Make like it was drawn from N( 0, sigma^2 C ) */
+    this->m_SearchDirs[lam] *= this->m_CurrentSigma;
+
+  } // end DrawSearchDirection
+
+
   /**
    * ****************** SortCostFunctionValues *********************
    */
@@ -350,9 +350,15 @@ namespace itk
     virtual void InitializeBCD(void);
 
     /** GenerateOffspring: Fill m_SearchDirs, m_NormalizedSearchDirs,
-     * and m_CostFunctionValues */
+     * and m_CostFunctionValues. The members of the population are
+     * evaluated with GetScaledValues(), so concurrently if concurrent
+     * cost functions are set. */
     virtual void GenerateOffspring(void);
 
+    /** Draw m_NormalizedSearchDirs[lam] from N(0,I) and compute
+     * m_SearchDirs[lam], which is drawn from N(0, sigma^2 C). */
+    virtual void DrawSearchDirection( unsigned int lam, unsigned int N );
+
     /** Sort the m_CostFunctionValues vector and update m_MeasureHistory */
     virtual void SortCostFunctionValues(void);
 
@@ -18,6 +18,7 @@
 
 #include "itkGenericConjugateGradientOptimizer.h"
 #include "vnl/vnl_math.h"
+#include "elxProfiler.h"
 
 namespace itk
 {
@@ -269,6 +270,7 @@ namespace itk
       ParametersType & searchDir)
   {
     itkDebugMacro("ComputeSearchDirection");
+    tmrProfileScope( "Optimizer::ComputeSearchDirection" );
 
     const unsigned int numberOfParameters = gradient.GetSize();
 
@@ -317,6 +319,7 @@ namespace itk
   {
 
     itkDebugMacro("LineSearch");
+    tmrProfileScope( "Optimizer::LineSearch" );
 
     LineSearchOptimizerPointer LSO = this->GetLineSearchOptimizer();
 
@@ -68,7 +68,11 @@ using namespace itk;
    *   This flag can NOT be defined for each resolution. \n
    *   example: <tt>(ShowMetricValues "true" )</tt> \n
    *   Default value: "false". Note that turning this flag on increases computation time.
-
+   *
+   * The perturbed metric values are computed concurrently when the
+   * NumberOfConcurrentEvaluations parameter is larger than 1 and the metric
+   * supports copies; see the documentation of the elx::OptimizerBase. The
+   * result does not depend on this setting.
    *
    * \ingroup Optimizers
    * \sa FiniteDifferenceGradientDescentOptimizer
@@ -106,6 +110,7 @@ using namespace itk;
     typedef Superclass1::CostFunctionType     CostFunctionType;
     typedef Superclass1::CostFunctionPointer  CostFunctionPointer;
     typedef Superclass1::StopConditionType    StopConditionType;
+    typedef Superclass1::CostFunctionContainerType  CostFunctionContainerType;
 
     /** Typedef's inherited from Elastix.*/
     typedef typename Superclass2::ElastixType           ElastixType;
@@ -127,6 +132,7 @@ using namespace itk;
     virtual void AfterRegistration(void);
 
     /** Check if any scales are set, and set the UseScales flag on or off;
+     * create the copies of the metric for the concurrent evaluation;
      * after that call the superclass' implementation */
     virtual void StartOptimization(void);
 
@@ -238,6 +238,14 @@ using namespace itk;
       }
     }
 
+    /** Compute the perturbed values concurrently, if asked for. */
+    CostFunctionContainerType concurrentCostFunctions;
+    Command::Pointer prepareCommand;
+    this->CreateConcurrentCostFunctions(
+      this->GetCostFunction(), concurrentCostFunctions, prepareCommand );
+    this->SetConcurrentCostFunctions( concurrentCostFunctions );
+    this->SetConcurrentPrepareCommand( prepareCommand );
+
     this->Superclass1::StartOptimization();
 
   } //end StartOptimization
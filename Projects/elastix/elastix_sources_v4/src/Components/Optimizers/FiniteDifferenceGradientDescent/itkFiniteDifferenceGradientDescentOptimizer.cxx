@@ -124,8 +124,6 @@ namespace itk
     unsigned int spaceDimension = 1;
 
     ParametersType param;
-    double valueplus;
-    double valuemin;
 
     InvokeEvent( StartEvent() );
     while( ! this->m_Stop )
@@ -166,20 +164,7 @@ namespace itk
       /** Calculate the derivative; this may take a while... */
       try
       {
-        for ( unsigned int j = 0; j < spaceDimension; j++ )
-        {
-          param[j] += ck;
-          valueplus = this->GetScaledValue( param );
-          param[j] -= 2.0*ck;
-          valuemin = this->GetScaledValue( param );
-          param[j] += ck;
-
-          const double gradient = (valueplus - valuemin) / (2.0 * ck);
-          this->m_Gradient[j] = gradient;
-
-          sumOfSquaredGradients += ( gradient * gradient );
-
-        } // for j = 0 .. spaceDimension
+        sumOfSquaredGradients = this->ComputeFiniteDifferenceGradient( param, ck );
       }
       catch( ExceptionObject& err )
       {
@@ -268,6 +253,66 @@ namespace itk
   } // end AdvanceOneStep
 
 
+  /**
+   * ****************** ComputeFiniteDifferenceGradient ****************
+   */
+
+  double
+    FiniteDifferenceGradientDescentOptimizer
+    ::ComputeFiniteDifferenceGradient( const ParametersType & param, const double ck )
+  {
+    const unsigned int spaceDimension = param.GetSize();
+
+    /** The two perturbed positions of a number of parameters are computed
+     * at once. The block size limits the memory needed for the positions.
+     */
+    const unsigned int numberOfCostFunctions = vnl_math_max(
+      static_cast<unsigned int>( this->GetConcurrentCostFunctions().size() ), 1u );
+    const unsigned int blockSize = vnl_math_min( 8 * numberOfCostFunctions, spaceDimension );
+
+    ParametersContainerType positions;
+    MeasureContainerType values;
+    FailedContainerType failed;
+    double sumOfSquaredGradients = 0.0;
+
+    for ( unsigned int begin = 0; begin < spaceDimension; begin += blockSize )
+    {
+      const unsigned int end = vnl_math_min( begin + blockSize, spaceDimension );
+
+      /** Positions 2*i and 2*i+1 are perturbed in parameter begin+i. */
+      positions.assign( 2 * ( end - begin ), param );
+      for ( unsigned int j = begin; j < end; ++j )
+      {
+        positions[ 2 * ( j - begin ) ][ j ] += ck;
+        positions[ 2 * ( j - begin ) + 1 ][ j ] -= ck;
+      }
+
+      this->GetScaledValues( positions, values, failed );
+
+      for ( unsigned int j = begin; j < end; ++j )
+      {
+        for ( unsigned int k = 0; k < 2; ++k )
+        {
+          if ( failed[ 2 * ( j - begin ) + k ] )
+          {
+            throw this->GetScaledValuesException( 2 * ( j - begin ) + k );
+          }
+        }
+        const double valueplus = values[ 2 * ( j - begin ) ];
+        const double valuemin = values[ 2 * ( j - begin ) + 1 ];
+
+        const double gradient = (valueplus - valuemin) / (2.0 * ck);
+        this->m_Gradient[j] = gradient;
+
+        sumOfSquaredGradients += ( gradient * gradient );
+      }
+    }
+
+    return sumOfSquaredGradients;
+
+  } // end ComputeFiniteDifferenceGradient
+
+
 
 
   /**
@@ -45,6 +45,10 @@ namespace itk
    * Note the similarities to the SimultaneousPerturbation optimizer and
    * the StandardGradientDescent optimizer.
    *
+   * The perturbed cost function values are independent, so they are computed
+   * concurrently when copies of the cost function are set with
+   * SetConcurrentCostFunctions().
+   *
    * \ingroup Optimizers
    * \sa FiniteDifferenceGradientDescent
    */
@@ -154,6 +158,14 @@ namespace itk
     virtual double Compute_a( unsigned long k ) const;
     virtual double Compute_c( unsigned long k ) const;
 
+    /** Compute the finite difference approximation of the gradient at the
+     * scaled position param, with perturbation ck. The positions are
+     * evaluated in blocks, concurrently if possible. Returns the sum of
+     * the squared gradient elements.
+     */
+    virtual double ComputeFiniteDifferenceGradient(
+      const ParametersType & param, const double ck );
+
   private:
 
     FiniteDifferenceGradientDescentOptimizer( const Self& );  // purposely not implemented
@@ -48,6 +48,21 @@ using namespace itk;
    *   This varies the second transform parameter in the range [-4.0 3.0] with steps of 1.0
    *   and the third parameter in the range [-1.0 1.0] with steps of 0.5. The names are used
    *   as column headers in the screen output.
+   * \parameter FullSearchCoarseGridStep: Searches only every n'th point of the search
+   *   space in each dimension first, and then the full search space around the best
+   *   points found. The optimization surface is then filled with the value of the
+   *   coarse point in the block of points that has not been refined. Can be given for
+   *   each resolution.\n
+   *   example: <tt>(FullSearchCoarseGridStep 4 2)</tt> \n
+   *   Default: 1, which searches the full search space.
+   * \parameter FullSearchNumberOfCandidates: The number of best coarse points around
+   *   which the full search space is searched, when FullSearchCoarseGridStep is larger
+   *   than 1. Can be given for each resolution.\n
+   *   example: <tt>(FullSearchNumberOfCandidates 5 3)</tt> \n
+   *   Default: 1.
+   *
+   * The points are evaluated concurrently when the NumberOfConcurrentEvaluations
+   * parameter is larger than 1; see the elx::OptimizerBase.
    *
    * \ingroup Optimizers
    * \sa FullSearchOptimizer
@@ -95,6 +110,7 @@ using namespace itk;
     typedef Superclass1::SearchSpacePointType           SearchSpacePointType;
     typedef Superclass1::SearchSpaceIndexType           SearchSpaceIndexType;
     typedef Superclass1::SearchSpaceSizeType            SearchSpaceSizeType;
+    typedef Superclass1::CostFunctionContainerType      CostFunctionContainerType;
 
     /** Typedef's inherited from Elastix.*/
     typedef typename Superclass2::ElastixType           ElastixType;
@@ -121,6 +137,10 @@ using namespace itk;
     virtual void AfterRegistration(void);
     /** \todo BeforeAll, checking parameters. */
 
+    /** Create the copies of the metric for the concurrent evaluation,
+     * and call the Superclass' implementation. */
+    virtual void StartOptimization(void);
+
     /** Get a pointer to the image containing the optimization surface. */
     itkGetObjectMacro(OptimizationSurface, NDImageType);
 
@@ -141,6 +161,11 @@ using namespace itk;
     virtual bool CheckSearchSpaceRangeDefinition( const std::string & fullFieldName,
       const bool found, const unsigned int entry_nr ) const;
 
+    /** Set the value of a coarse grid point in the optimization surface,
+     * for all points of its block. */
+    virtual void FillOptimizationSurfaceBlock(
+      const SearchSpaceIndexType & index, const double value );
+
   private:
 
     FullSearch( const Self& );      // purposely not implemented
@@ -19,6 +19,7 @@
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <algorithm>
 #include "vnl/vnl_math.h"
 
 namespace elastix
@@ -57,6 +58,29 @@ FullSearch<TElastix>
 } // end BeforeRegistration
 
 
+/**
+ * ***************** StartOptimization ***********************
+ */
+
+template <class TElastix>
+void
+FullSearch<TElastix>
+::StartOptimization( void )
+{
+  /** Evaluate the grid points concurrently, if asked for. */
+  CostFunctionContainerType concurrentCostFunctions;
+  Command::Pointer prepareCommand;
+  this->CreateConcurrentCostFunctions(
+    this->GetCostFunction(), concurrentCostFunctions, prepareCommand );
+  this->SetConcurrentCostFunctions( concurrentCostFunctions );
+  this->SetConcurrentPrepareCommand( prepareCommand );
+
+  /** Call the superclass */
+  this->Superclass1::StartOptimization();
+
+} // end StartOptimization
+
+
 /**
  * ***************** BeforeEachResolution ***********************
  */
@@ -162,6 +186,17 @@ FullSearch<TElastix>
     }
   } // end while
 
+  /** Read the settings of the coarse-to-fine search. */
+  unsigned int coarseGridStep = 1;
+  this->GetConfiguration()->ReadParameter( coarseGridStep,
+    "FullSearchCoarseGridStep", this->GetComponentLabel(), level, 0 );
+  this->SetCoarseGridStep( coarseGridStep );
+
+  unsigned int numberOfCandidates = 1;
+  this->GetConfiguration()->ReadParameter( numberOfCandidates,
+    "FullSearchNumberOfCandidates", this->GetComponentLabel(), level, 0 );
+  this->SetNumberOfCandidates( numberOfCandidates );
+
   if ( realGood )
   {
     /** The number of dimensions. */
@@ -192,10 +227,21 @@ FullSearch<TElastix>
       << "." << resultImageFormat;
     this->m_OptimizationSurface->SetOutputFileName( makeString.str().c_str() );
 
-    elxout
-      << "Total number of iterations needed in this resolution: "
-      << this->GetNumberOfIterations()
-      << "." << std::endl;
+    if ( this->GetCoarseGridStep() > 1 )
+    {
+      elxout
+        << "Number of iterations needed for the coarse grid in this resolution: "
+        << this->GetNumberOfCoarseIterations()
+        << " (of " << this->GetNumberOfIterations() << ")."
+        << std::endl;
+    }
+    else
+    {
+      elxout
+        << "Total number of iterations needed in this resolution: "
+        << this->GetNumberOfIterations()
+        << "." << std::endl;
+    }
 
   }
   else
@@ -219,8 +265,17 @@ FullSearch<TElastix>
   /** Print some information. */
   xl::xout["iteration"]["2:Metric"] << this->GetValue();
 
-  this->m_OptimizationSurface->SetPixel(
-    this->GetCurrentIndexInSearchSpace(), this->GetValue() );
+  if ( this->GetCoarseSearch() )
+  {
+    /** Fill the block of points that this coarse point represents. */
+    this->FillOptimizationSurfaceBlock(
+      this->GetCurrentIndexInSearchSpace(), this->GetValue() );
+  }
+  else
+  {
+    this->m_OptimizationSurface->SetPixel(
+      this->GetCurrentIndexInSearchSpace(), this->GetValue() );
+  }
 
   SearchSpacePointType currentPoint = this->GetCurrentPointInSearchSpace();
   unsigned int nrOfSSDims = currentPoint.GetSize();
@@ -257,6 +312,10 @@ FullSearch<TElastix>
     stopcondition = "Error in metric";
     break;
 
+  case CandidatesRefined :
+    stopcondition = "The coarse grid and the range around the best candidates have been searched";
+    break;
+
   default:
     stopcondition = "Unknown";
     break;
@@ -374,6 +433,45 @@ FullSearch<TElastix>
 } // end CheckSearchSpaceRangeDefinition()
 
 
+/**
+ * ************ FillOptimizationSurfaceBlock *****************
+ */
+
+template <class TElastix>
+void
+FullSearch<TElastix>
+::FillOptimizationSurfaceBlock( const SearchSpaceIndexType & index,
+  const double value )
+{
+  const unsigned int nrOfSSDims = index.GetSize();
+  const SearchSpaceSizeType & searchSpaceSize = this->GetSearchSpaceSize();
+  const unsigned long step = this->GetCoarseGridStep();
+
+  /** The block ranges from index to index + step - 1, within the surface. */
+  SearchSpaceIndexType blockSize( nrOfSSDims );
+  unsigned long numberOfPoints = 1;
+  for ( unsigned int dim = 0; dim < nrOfSSDims; dim++ )
+  {
+    blockSize[ dim ] = std::min( static_cast<long>( step ),
+      static_cast<long>( searchSpaceSize[ dim ] ) - index[ dim ] );
+    numberOfPoints *= blockSize[ dim ];
+  }
+
+  SearchSpaceIndexType pointIndex( nrOfSSDims );
+  for ( unsigned long p = 0; p < numberOfPoints; ++p )
+  {
+    unsigned long rest = p;
+    for ( unsigned int dim = 0; dim < nrOfSSDims; dim++ )
+    {
+      pointIndex[ dim ] = index[ dim ] + static_cast<long>( rest % blockSize[ dim ] );
+      rest /= blockSize[ dim ];
+    }
+    this->m_OptimizationSurface->SetPixel( pointIndex, value );
+  }
+
+} // end FillOptimizationSurfaceBlock()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef __elxFullSearchOptimizer_hxx
@@ -20,6 +20,9 @@
 #include "itkEventObject.h"
 #include "itkExceptionObject.h"
 #include "itkNumericTraits.h"
+#include <algorithm>
+#include <utility>
+#include <set>
 
 namespace itk
 {
@@ -41,6 +44,10 @@ namespace itk
     m_NumberOfSearchSpaceDimensions = 0;
     m_SearchSpace = 0;
     m_LastSearchSpaceChanges = 0;
+    m_CoarseGridStep = 1;
+    m_NumberOfCandidates = 1;
+    m_CoarseSearch = false;
+    m_ConcurrentEvaluator = ConcurrentEvaluatorType::New();
 
   } //end constructor
 
@@ -95,57 +102,244 @@ namespace itk
 
     m_Stop = false;
 
+    /** Without copies, the cost function itself is evaluated. */
+    CostFunctionContainerType costFunctions = this->m_ConcurrentCostFunctions;
+    if ( costFunctions.size() == 0 )
+    {
+      costFunctions.push_back( this->m_CostFunction.GetPointer() );
+    }
+    this->m_ConcurrentEvaluator->SetCostFunctions( costFunctions );
+
     InvokeEvent( StartEvent() );
-    while( !m_Stop )
+
+    if ( this->m_CoarseGridStep > 1 )
     {
+      this->SearchCoarseToFine();
+    }
+    else
+    {
+      this->SearchFullGrid();
+    }
+
+  } //end function ResumeOptimization
+
 
-      try
+  /**
+   * ********************** SearchFullGrid *************************
+   */
+  void
+    FullSearchOptimizer
+    ::SearchFullGrid( void )
+  {
+    const unsigned long numberOfIterations = this->GetNumberOfIterations();
+    const unsigned long numberOfIndicesPerCall = 1024;
+
+    SearchSpaceIndexContainerType indices;
+    MeasureContainerType values;
+    while ( !m_Stop && m_CurrentIteration < numberOfIterations )
+    {
+      /** The next part of the grid. */
+      const unsigned long end = std::min(
+        m_CurrentIteration + numberOfIndicesPerCall, numberOfIterations );
+      indices.clear();
+      for ( unsigned long it = m_CurrentIteration; it < end; ++it )
       {
-        m_Value = m_CostFunction->GetValue( this->GetCurrentPosition() );
+        indices.push_back( this->IterationToIndex( it ) );
       }
-      catch( ExceptionObject& err )
-      {
-        // An exception has occurred.
-        // Terminate immediately.
-        m_StopCondition = MetricError;
-        StopOptimization();
 
-        // Pass exception to caller
-        throw err;
-      }
+      this->EvaluateIndices( indices, values );
+    }
 
-      if( m_Stop )
+    if ( !m_Stop )
+    {
+      m_StopCondition = FullRangeSearched;
+      StopOptimization();
+    }
+
+  } // end SearchFullGrid
+
+
+  /**
+   * ********************** SearchCoarseToFine *********************
+   */
+  void
+    FullSearchOptimizer
+    ::SearchCoarseToFine( void )
+  {
+    const unsigned int searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+    const SearchSpaceSizeType & searchSpaceSize = this->GetSearchSpaceSize();
+    const unsigned long step = this->m_CoarseGridStep;
+
+    /** The coarse grid contains the indices that are a multiple of the step. */
+    SearchSpaceSizeType coarseSize( searchSpaceDimension );
+    for ( unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++ )
+    {
+      coarseSize[ ssdim ] = ( searchSpaceSize[ ssdim ] - 1 ) / step + 1;
+    }
+    const unsigned long numberOfCoarseIterations = this->GetNumberOfCoarseIterations();
+    SearchSpaceIndexContainerType coarseIndices( numberOfCoarseIterations );
+    for ( unsigned long it = 0; it < numberOfCoarseIterations; ++it )
+    {
+      SearchSpaceIndexType index( searchSpaceDimension );
+      unsigned long rest = it;
+      for ( unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++ )
       {
-        break;
+        index[ ssdim ] = static_cast<long>( ( rest % coarseSize[ ssdim ] ) * step );
+        rest /= coarseSize[ ssdim ];
       }
+      coarseIndices[ it ] = index;
+    }
 
-      /** Check if the value is a minimum or maximum */
-      if (   ( m_Value < m_BestValue )  ^  m_Maximize   )  // ^ = xor, yields true if only one of the expressions is true
+    /** Evaluate the coarse grid. */
+    MeasureContainerType values;
+    m_CoarseSearch = true;
+    this->EvaluateIndices( coarseIndices, values );
+    m_CoarseSearch = false;
+    if ( m_Stop )
+    {
+      return;
+    }
+
+    /** Select the best coarse points. Equal values are ranked in grid order. */
+    typedef std::pair<MeasureType, unsigned long>   ValueIndexPairType;
+    std::vector<ValueIndexPairType> ranking( values.size() );
+    for ( unsigned long i = 0; i < values.size(); ++i )
+    {
+      ranking[ i ] = ValueIndexPairType( m_Maximize ? -values[ i ] : values[ i ], i );
+    }
+    const unsigned long numberOfCandidates = std::min(
+      static_cast<unsigned long>( this->m_NumberOfCandidates ),
+      static_cast<unsigned long>( ranking.size() ) );
+    std::partial_sort( ranking.begin(), ranking.begin() + numberOfCandidates,
+      ranking.end() );
+
+    /** Collect the grid points around the candidates that have not been
+     * evaluated yet. */
+    std::set<unsigned long> evaluated;
+    for ( unsigned long i = 0; i < coarseIndices.size(); ++i )
+    {
+      evaluated.insert( this->IndexToIteration( coarseIndices[ i ] ) );
+    }
+    const long radius = static_cast<long>( step ) - 1;
+    const unsigned long width = 2 * step - 1;
+    unsigned long numberOfOffsets = 1;
+    for ( unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++ )
+    {
+      numberOfOffsets *= width;
+    }
+
+    SearchSpaceIndexContainerType fineIndices;
+    for ( unsigned long c = 0; c < numberOfCandidates; ++c )
+    {
+      const SearchSpaceIndexType & center = coarseIndices[ ranking[ c ].second ];
+      for ( unsigned long offset = 0; offset < numberOfOffsets; ++offset )
       {
-        m_BestValue = m_Value;
-        m_BestPointInSearchSpace = m_CurrentPointInSearchSpace;
-        m_BestIndexInSearchSpace = m_CurrentIndexInSearchSpace;
+        SearchSpaceIndexType index( searchSpaceDimension );
+        unsigned long rest = offset;
+        bool inside = true;
+        for ( unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++ )
+        {
+          const long value = center[ ssdim ]
+            + static_cast<long>( rest % width ) - radius;
+          rest /= width;
+          if ( value < 0 || value >= static_cast<long>( searchSpaceSize[ ssdim ] ) )
+          {
+            inside = false;
+            break;
+          }
+          index[ ssdim ] = value;
+        }
+        if ( inside && evaluated.insert( this->IndexToIteration( index ) ).second )
+        {
+          fineIndices.push_back( index );
+        }
       }
+    }
+
+    /** Evaluate the full grid around the candidates. */
+    this->EvaluateIndices( fineIndices, values );
 
-      this->InvokeEvent( IterationEvent() );
+    if ( !m_Stop )
+    {
+      m_StopCondition = CandidatesRefined;
+      StopOptimization();
+    }
 
-      /** Prepare for next step */
-      m_CurrentIteration++;
+  } // end SearchCoarseToFine
 
-      if( m_CurrentIteration >= this->GetNumberOfIterations() )
+
+  /**
+   * ********************** EvaluateIndices ************************
+   */
+  void
+    FullSearchOptimizer
+    ::EvaluateIndices( const SearchSpaceIndexContainerType & indices,
+      MeasureContainerType & values )
+  {
+    values.clear();
+
+    /** Give each thread a few points per block. */
+    const unsigned long blockSize
+      = 16 * this->m_ConcurrentEvaluator->GetNumberOfCostFunctions();
+
+    ParametersContainerType positions;
+    MeasureContainerType blockValues;
+    FailedContainerType failed;
+    for ( unsigned long begin = 0; begin < indices.size(); begin += blockSize )
+    {
+      const unsigned long end = std::min(
+        begin + blockSize, static_cast<unsigned long>( indices.size() ) );
+
+      /** Compute the values of this block. */
+      positions.resize( end - begin );
+      for ( unsigned long i = begin; i < end; ++i )
       {
-        m_StopCondition = FullRangeSearched;
-        StopOptimization();
-        break;
+        positions[ i - begin ] = this->IndexToPosition( indices[ i ] );
       }
+      this->m_ConcurrentEvaluator->GetValues( positions, blockValues, failed );
 
-      /** Set the next position in search space. */
-      this->UpdateCurrentPosition();
+      /** Process them one by one, in order. */
+      for ( unsigned long i = begin; i < end; ++i )
+      {
+        m_CurrentIndexInSearchSpace = indices[ i ];
+        m_CurrentPointInSearchSpace = this->IndexToPoint( indices[ i ] );
+        this->SetCurrentPosition( positions[ i - begin ] );
 
-    } // end while
+        if ( failed[ i - begin ] )
+        {
+          // An exception has occurred.
+          // Terminate immediately.
+          m_StopCondition = MetricError;
+          StopOptimization();
 
+          // Pass exception to caller
+          throw this->m_ConcurrentEvaluator->GetException( i - begin );
+        }
 
-  } //end function ResumeOptimization
+        m_Value = blockValues[ i - begin ];
+        values.push_back( m_Value );
+
+        /** Check if the value is a minimum or maximum */
+        if (   ( m_Value < m_BestValue )  ^  m_Maximize   )  // ^ = xor, yields true if only one of the expressions is true
+        {
+          m_BestValue = m_Value;
+          m_BestPointInSearchSpace = m_CurrentPointInSearchSpace;
+          m_BestIndexInSearchSpace = m_CurrentIndexInSearchSpace;
+        }
+
+        this->InvokeEvent( IterationEvent() );
+
+        /** Prepare for next step */
+        m_CurrentIteration++;
+
+        if ( m_Stop )
+        {
+          return;
+        }
+      } // end for points in block
+    } // end for blocks
+
+  } // end EvaluateIndices
 
 
   /**
@@ -362,6 +556,44 @@ namespace itk
   }
 
 
+  /**
+   * ***************** GetNumberOfCoarseIterations ****************
+   *
+   * Get the number of points in the coarse grid.
+   */
+  const unsigned long
+    FullSearchOptimizer
+    ::GetNumberOfCoarseIterations(void)
+  {
+    SearchSpaceSizeType sssize = this->GetSearchSpaceSize();
+    unsigned int maxssdim = this->GetNumberOfSearchSpaceDimensions();
+    unsigned long nr_it = 0;
+
+    if ( maxssdim>0 )
+    {
+      nr_it = 1;
+      for (unsigned int ssdim = 0; ssdim < maxssdim; ssdim++)
+      {
+        nr_it *= ( sssize[ssdim] - 1 ) / m_CoarseGridStep + 1;
+      }
+    } // end if
+
+    return nr_it;
+  }
+
+
+  /**
+   * ******************** SetConcurrentCostFunctions **************
+   */
+  void
+    FullSearchOptimizer
+    ::SetConcurrentCostFunctions( const CostFunctionContainerType & costFunctions )
+  {
+    this->m_ConcurrentCostFunctions = costFunctions;
+    this->Modified();
+  }
+
+
   /**
    * ******************** GetNumberOfSearchSpaceDimensions ********
    *
@@ -465,6 +697,54 @@ namespace itk
 
 
 
+  /**
+   * ********************* IterationToIndex ***********************
+   *
+   * The inverse of the order in which UpdateCurrentPosition
+   * steps through the search space.
+   */
+  FullSearchOptimizer::SearchSpaceIndexType
+    FullSearchOptimizer
+    ::IterationToIndex( unsigned long iteration )
+  {
+    const unsigned int searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+    const SearchSpaceSizeType & searchSpaceSize = this->GetSearchSpaceSize();
+    SearchSpaceIndexType index( searchSpaceDimension );
+
+    for (unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++)
+    {
+      index[ssdim] = static_cast<long>( iteration % searchSpaceSize[ssdim] );
+      iteration /= searchSpaceSize[ssdim];
+    }
+
+    return index;
+
+  } // end IterationToIndex
+
+
+  /**
+   * ********************* IndexToIteration ***********************
+   */
+  unsigned long
+    FullSearchOptimizer
+    ::IndexToIteration( const SearchSpaceIndexType & index )
+  {
+    const unsigned int searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+    const SearchSpaceSizeType & searchSpaceSize = this->GetSearchSpaceSize();
+    unsigned long iteration = 0;
+
+    for (unsigned int ssdim = searchSpaceDimension; ssdim > 0; ssdim--)
+    {
+      iteration = iteration * searchSpaceSize[ssdim-1]
+        + static_cast<unsigned long>( index[ssdim-1] );
+    }
+
+    return iteration;
+
+  } // end IndexToIteration
+
+
+
 } // end namespace itk
 
 #endif // #ifndef __itkFullSearchOptimizer_cxx
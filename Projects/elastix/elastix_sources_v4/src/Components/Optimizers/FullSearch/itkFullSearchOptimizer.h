@@ -20,6 +20,9 @@
 #include "itkImage.h"
 #include "itkArray.h"
 #include "itkFixedArray.h"
+#include "itkNumericTraits.h"
+#include "itkConcurrentCostFunctionEvaluator.h"
+#include <vector>
 
 
 namespace itk
@@ -36,6 +39,17 @@ namespace itk
    * itkExhaustiveOptimizer. See if we can replace it by that optimizer,
    * or inherit from it.
    *
+   * The grid points are evaluated in blocks. If independent copies of the
+   * cost function are set with SetConcurrentCostFunctions(), the points of
+   * a block are evaluated concurrently, one thread per cost function. The
+   * IterationEvents are still invoked for each point, in grid order.
+   *
+   * If the CoarseGridStep is larger than 1, only every CoarseGridStep'th
+   * grid point in each dimension is evaluated first. Then all grid points
+   * within CoarseGridStep - 1 of the best NumberOfCandidates coarse points
+   * are evaluated. GetCoarseSearch() tells which of the two is running.
+   * ResumeOptimization() then restarts the coarse-to-fine search.
+   *
    * \ingroup Optimizers
    * \sa FullSearch
    */
@@ -58,7 +72,8 @@ namespace itk
     /** Codes of stopping conditions */
     typedef enum {
       FullRangeSearched,
-        MetricError
+        MetricError,
+        CandidatesRefined
     } StopConditionType;
 
     /* Typedefs inherited from superclass */
@@ -85,6 +100,18 @@ namespace itk
     /** The size of each dimension to be searched ((max-min)/step)) */
     typedef Array<unsigned long>                      SearchSpaceSizeType;
 
+    /** Typedefs for the concurrent evaluation of the cost function. */
+    typedef ConcurrentCostFunctionEvaluator           ConcurrentEvaluatorType;
+    typedef ConcurrentEvaluatorType::CostFunctionContainerType
+      CostFunctionContainerType;
+    typedef ConcurrentEvaluatorType::ParametersContainerType
+      ParametersContainerType;
+    typedef ConcurrentEvaluatorType::MeasureContainerType
+      MeasureContainerType;
+    typedef ConcurrentEvaluatorType::FailedContainerType
+      FailedContainerType;
+    typedef std::vector<SearchSpaceIndexType>         SearchSpaceIndexContainerType;
+
 
     /** NB: The methods SetScales has no influence! */
 
@@ -182,6 +209,46 @@ namespace itk
     /** Get Stop condition. */
     itkGetConstMacro( StopCondition, StopConditionType );
 
+    /** Set/Get independent copies of the cost function, which are used to
+     * evaluate several grid points concurrently. An empty container (the
+     * default) means that the cost function is evaluated sequentially.
+     */
+    virtual void SetConcurrentCostFunctions(
+      const CostFunctionContainerType & costFunctions );
+    virtual const CostFunctionContainerType & GetConcurrentCostFunctions( void ) const
+    {
+      return this->m_ConcurrentCostFunctions;
+    }
+
+    /** Set the command that prepares the cost function and its copies for
+     * a concurrent evaluation, see ConcurrentCostFunctionEvaluator. */
+    virtual void SetConcurrentPrepareCommand( Command * command )
+    {
+      this->m_ConcurrentEvaluator->SetPrepareCommand( command );
+    }
+
+    /** Set/Get the step between the grid points of the coarse search.
+     * 1, the default, searches the full grid. */
+    itkSetClampMacro( CoarseGridStep, unsigned int,
+      1, NumericTraits<unsigned int>::max() );
+    itkGetConstMacro( CoarseGridStep, unsigned int );
+
+    /** Set/Get the number of best coarse grid points around which the
+     * full grid is searched. Default: 1. */
+    itkSetClampMacro( NumberOfCandidates, unsigned int,
+      1, NumericTraits<unsigned int>::max() );
+    itkGetConstMacro( NumberOfCandidates, unsigned int );
+
+    /** True while the coarse grid is searched. */
+    itkGetConstMacro( CoarseSearch, bool );
+
+    /** Get the number of points in the coarse grid. */
+    virtual const unsigned long GetNumberOfCoarseIterations(void);
+
+    /** Convert an iteration number to an index in the full grid, and back. */
+    virtual SearchSpaceIndexType IterationToIndex( unsigned long iteration );
+    virtual unsigned long IndexToIteration( const SearchSpaceIndexType & index );
+
 
   protected:
     FullSearchOptimizer();
@@ -206,12 +273,31 @@ namespace itk
     unsigned long                 m_LastSearchSpaceChanges;
     virtual void ProcessSearchSpaceChanges(void);
 
+    /** Evaluate the full grid, from the current iteration on. */
+    virtual void SearchFullGrid(void);
+
+    /** Evaluate the coarse grid, and then the full grid around the best
+     * coarse points. */
+    virtual void SearchCoarseToFine(void);
+
+    /** Evaluate the grid points, in blocks, and invoke an IterationEvent
+     * for each of them. Returns the values in values. */
+    virtual void EvaluateIndices( const SearchSpaceIndexContainerType & indices,
+      MeasureContainerType & values );
+
   private:
     FullSearchOptimizer(const Self&); //purposely not implemented
     void operator=(const Self&); //purposely not implemented
 
     unsigned long                 m_CurrentIteration;
 
+    unsigned int                  m_CoarseGridStep;
+    unsigned int                  m_NumberOfCandidates;
+    bool                          m_CoarseSearch;
+
+    CostFunctionContainerType         m_ConcurrentCostFunctions;
+    ConcurrentEvaluatorType::Pointer  m_ConcurrentEvaluator;
+
   }; // end class
 
 } // end namespace itk
@@ -18,6 +18,7 @@
 #include "itkQuasiNewtonLBFGSOptimizer.h"
 #include "itkArray.h"
 #include "vnl/vnl_math.h"
+#include "elxProfiler.h"
 
 namespace itk
 {
@@ -274,6 +275,7 @@ namespace itk
       ParametersType & searchDir)
   {
     itkDebugMacro("ComputeSearchDirection");
+    tmrProfileScope( "Optimizer::ComputeSearchDirection" );
 
     /** Assumes m_Rho, m_S, and m_Y are up-to-date at m_PreviousPoint */
 
@@ -355,6 +357,7 @@ namespace itk
   {
 
     itkDebugMacro("LineSearch");
+    tmrProfileScope( "Optimizer::LineSearch" );
 
     LineSearchOptimizerPointer LSO = this->GetLineSearchOptimizer();
 
@@ -15,7 +15,7 @@
 #ifndef __elxSimultaneousPerturbation_h
 #define __elxSimultaneousPerturbation_h
 
-#include "itkSPSAOptimizer.h"
+#include "itkSimultaneousPerturbationOptimizer.h"
 #include "elxIncludes.h"
 
 namespace elastix
@@ -42,7 +42,11 @@ using namespace itk;
    *    \f$g_k = 1/q \sum_{j = 1..q} g^(j)_k\f$ \n
    *    This parameter can be defined for each resolution. \n
    *    example: <tt>(NumberOfPerturbations 1 1 2)</tt> \n
-   *    Default value: 1.
+   *    Default value: 1. \n
+   *    Averaging more perturbations reduces the noise in the gradient estimate. With
+   *    NumberOfConcurrentEvaluations set to 2q, and a metric that supports copies, the
+   *    2q perturbed values are computed at the same time, so q perturbations take about
+   *    as long as one.
    * \parameter SP_a: The gain \f$a(k)\f$ at each iteration \f$k\f$ is defined by \n
    *   \f$a(k) =  SP\_a / (SP\_A + k + 1)^{SP\_alpha}\f$. \n
    *   SP_a can be defined for each resolution. \n
@@ -73,6 +77,10 @@ using namespace itk;
    *   example: <tt>(ShowMetricValues "true" )</tt> \n
    *   Default value: "false". Note that turning this flag on increases computation time.
    *
+   * The perturbed metric values are computed concurrently when the
+   * NumberOfConcurrentEvaluations parameter is larger than 1 and the metric
+   * supports copies; see the documentation of the elx::OptimizerBase and
+   * the itk::SimultaneousPerturbationOptimizer.
    *
    * \ingroup Optimizers
    */
@@ -80,7 +88,7 @@ using namespace itk;
   template <class TElastix>
     class SimultaneousPerturbation :
     public
-      itk::SPSAOptimizer,
+      itk::SimultaneousPerturbationOptimizer,
     public
       OptimizerBase<TElastix>
   {
@@ -88,7 +96,7 @@ using namespace itk;
 
     /** Standard ITK.*/
     typedef SimultaneousPerturbation            Self;
-    typedef SPSAOptimizer                       Superclass1;
+    typedef SimultaneousPerturbationOptimizer   Superclass1;
     typedef OptimizerBase<TElastix>             Superclass2;
     typedef SmartPointer<Self>                  Pointer;
     typedef SmartPointer<const Self>            ConstPointer;
@@ -97,7 +105,7 @@ using namespace itk;
     itkNewMacro( Self );
 
     /** Run-time type information (and related methods). */
-    itkTypeMacro( SimultaneousPerturbation, SPSAOptimizer );
+    itkTypeMacro( SimultaneousPerturbation, SimultaneousPerturbationOptimizer );
 
     /** Name of this class.
      * Use this name in the parameter file to select this specific optimizer. \n
@@ -109,6 +117,9 @@ using namespace itk;
     typedef Superclass1::CostFunctionType     CostFunctionType;
     typedef Superclass1::CostFunctionPointer  CostFunctionPointer;
     typedef Superclass1::StopConditionType    StopConditionType;
+    typedef Superclass1::DerivativeType       DerivativeType;
+
+    typedef typename Superclass2::CostFunctionContainerType   CostFunctionContainerType;
 
     /** Typedef's inherited from Elastix.*/
     typedef typename Superclass2::ElastixType           ElastixType;
@@ -135,6 +146,10 @@ using namespace itk;
      * array have the same size. */
     virtual void SetInitialPosition( const ParametersType & param );
 
+    /** Create the copies of the metric for the concurrent evaluation,
+     * and call the Superclass' implementation. */
+    virtual void StartOptimization(void);
+
   protected:
 
       SimultaneousPerturbation();
@@ -245,6 +245,28 @@ using namespace itk;
   } // end SetInitialPosition
 
 
+  /**
+   * ******************* StartOptimization ***********************
+   */
+
+  template <class TElastix>
+    void SimultaneousPerturbation<TElastix>
+    ::StartOptimization(void)
+  {
+    /** Compute the perturbed values concurrently, if asked for. */
+    CostFunctionContainerType concurrentCostFunctions;
+    Command::Pointer prepareCommand;
+    this->CreateConcurrentCostFunctions(
+      this->m_CostFunction.GetPointer(), concurrentCostFunctions, prepareCommand );
+    this->SetConcurrentCostFunctions( concurrentCostFunctions );
+    this->SetConcurrentPrepareCommand( prepareCommand );
+
+    /** Call the superclass. */
+    this->Superclass1::StartOptimization();
+
+  } // end StartOptimization
+
+
 } // end namespace elastix
 
 #endif // end #ifndef __elxSimultaneousPerturbation_hxx
@@ -0,0 +1,142 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkSimultaneousPerturbationOptimizer_cxx
+#define __itkSimultaneousPerturbationOptimizer_cxx
+
+#include "itkSimultaneousPerturbationOptimizer.h"
+#include "vnl/vnl_math.h"
+#include <vector>
+
+namespace itk
+{
+
+  /**
+   * ********************* Constructor ****************************
+   */
+
+  SimultaneousPerturbationOptimizer
+    ::SimultaneousPerturbationOptimizer()
+  {
+    this->m_ConcurrentEvaluator = ConcurrentEvaluatorType::New();
+
+  } // end Constructor
+
+
+  /**
+   * ******************* SetCostFunction ***********************
+   */
+
+  void
+    SimultaneousPerturbationOptimizer
+    ::SetCostFunction( CostFunctionType * costFunction )
+  {
+    this->Superclass::SetCostFunction( costFunction );
+    this->UpdateConcurrentEvaluator();
+
+  } // end SetCostFunction
+
+
+  /**
+   * ******************** SetConcurrentCostFunctions **************
+   */
+
+  void
+    SimultaneousPerturbationOptimizer
+    ::SetConcurrentCostFunctions( const CostFunctionContainerType & costFunctions )
+  {
+    this->m_ConcurrentCostFunctions = costFunctions;
+    this->UpdateConcurrentEvaluator();
+    this->Modified();
+
+  } // end SetConcurrentCostFunctions
+
+
+  /**
+   * ******************** UpdateConcurrentEvaluator **************
+   */
+
+  void
+    SimultaneousPerturbationOptimizer
+    ::UpdateConcurrentEvaluator( void )
+  {
+    CostFunctionContainerType costFunctions = this->m_ConcurrentCostFunctions;
+    if ( costFunctions.size() == 0 && this->m_CostFunction.IsNotNull() )
+    {
+      costFunctions.push_back( this->m_CostFunction.GetPointer() );
+    }
+    this->m_ConcurrentEvaluator->SetCostFunctions( costFunctions );
+
+  } // end UpdateConcurrentEvaluator
+
+
+  /**
+   * ******************* ComputeGradient ***********************
+   */
+
+  void
+    SimultaneousPerturbationOptimizer
+    ::ComputeGradient( const ParametersType & parameters, DerivativeType & gradient )
+  {
+    const unsigned int spaceDimension = parameters.GetSize();
+    const unsigned int numberOfPerturbations = this->GetNumberOfPerturbations();
+    const double ck = this->Compute_c( this->GetCurrentIteration() );
+    const ScalesType & scales = this->GetScales();
+
+    /** Draw the perturbations. Positions 2*p and 2*p+1 are the positive
+     * and negative perturbation p.
+     */
+    std::vector< DerivativeType > deltas( numberOfPerturbations );
+    ParametersContainerType positions( 2 * numberOfPerturbations, parameters );
+    for ( unsigned int p = 0; p < numberOfPerturbations; ++p )
+    {
+      this->GenerateDelta( spaceDimension );
+      deltas[ p ] = this->m_Delta;
+      for ( unsigned int j = 0; j < spaceDimension; ++j )
+      {
+        positions[ 2 * p ][ j ] += ck * this->m_Delta[ j ];
+        positions[ 2 * p + 1 ][ j ] -= ck * this->m_Delta[ j ];
+      }
+    }
+
+    /** Compute the values; exceptions are passed on to the superclass. */
+    MeasureContainerType values;
+    this->m_ConcurrentEvaluator->GetValues( positions, values );
+
+    /** Sum the gradient estimates of the perturbations. */
+    gradient = DerivativeType( spaceDimension );
+    gradient.Fill( 0.0 );
+    for ( unsigned int p = 0; p < numberOfPerturbations; ++p )
+    {
+      const double valuediff = ( values[ 2 * p ] - values[ 2 * p + 1 ] ) / ( 2.0 * ck );
+      for ( unsigned int j = 0; j < spaceDimension; ++j )
+      {
+        gradient[ j ] += valuediff / deltas[ p ][ j ];
+      }
+    }
+
+    /** Apply the scaling, as GenerateDelta divides the perturbation by
+     * the scales, and average over the perturbations. */
+    for ( unsigned int j = 0; j < spaceDimension; ++j )
+    {
+      gradient[ j ] /= ( vnl_math_sqr( scales[ j ] )
+        * static_cast<double>( numberOfPerturbations ) );
+    }
+
+  } // end ComputeGradient
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkSimultaneousPerturbationOptimizer_cxx
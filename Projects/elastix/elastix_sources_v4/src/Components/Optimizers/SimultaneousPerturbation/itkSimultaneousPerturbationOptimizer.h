@@ -0,0 +1,122 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __itkSimultaneousPerturbationOptimizer_h
+#define __itkSimultaneousPerturbationOptimizer_h
+
+#include "itkSPSAOptimizer.h"
+#include "itkConcurrentCostFunctionEvaluator.h"
+
+
+namespace itk
+{
+
+  /**
+   * \class SimultaneousPerturbationOptimizer
+   * \brief An SPSAOptimizer that evaluates the perturbations concurrently.
+   *
+   * The gradient estimate is the same as that of the itk::SPSAOptimizer:
+   * the perturbations are drawn in the same order, and the estimate is
+   * divided by the squared scales and the NumberOfPerturbations. The values
+   * at the positive and negative perturbations are however computed all at
+   * once, by a ConcurrentCostFunctionEvaluator. If independent copies of the
+   * cost function are set with SetConcurrentCostFunctions(), the positions
+   * are evaluated concurrently, one thread per cost function.
+   *
+   * \ingroup Optimizers
+   * \sa SimultaneousPerturbation
+   */
+
+  class SimultaneousPerturbationOptimizer : public SPSAOptimizer
+  {
+  public:
+
+    /** Standard ITK.*/
+    typedef SimultaneousPerturbationOptimizer   Self;
+    typedef SPSAOptimizer                       Superclass;
+    typedef SmartPointer<Self>                  Pointer;
+    typedef SmartPointer<const Self>            ConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro( Self );
+
+    /** Run-time type information (and related methods). */
+    itkTypeMacro( SimultaneousPerturbationOptimizer, SPSAOptimizer );
+
+    /** Typedefs inherited from the superclass. */
+    typedef Superclass::ParametersType          ParametersType;
+    typedef Superclass::DerivativeType          DerivativeType;
+    typedef Superclass::ScalesType              ScalesType;
+    typedef Superclass::CostFunctionType        CostFunctionType;
+
+    /** Typedef's for the concurrent evaluation of the perturbations. */
+    typedef ConcurrentCostFunctionEvaluator               ConcurrentEvaluatorType;
+    typedef ConcurrentEvaluatorType::CostFunctionContainerType
+      CostFunctionContainerType;
+    typedef ConcurrentEvaluatorType::ParametersContainerType
+      ParametersContainerType;
+    typedef ConcurrentEvaluatorType::MeasureContainerType
+      MeasureContainerType;
+
+    /** Set the cost function; also used by the evaluator. */
+    virtual void SetCostFunction( CostFunctionType * costFunction );
+
+    /** Set/Get the cost function, followed by its independent copies. An
+     * empty container means that the cost function itself is used, in the
+     * calling thread.
+     */
+    virtual void SetConcurrentCostFunctions(
+      const CostFunctionContainerType & costFunctions );
+    virtual const CostFunctionContainerType & GetConcurrentCostFunctions( void ) const
+    {
+      return this->m_ConcurrentCostFunctions;
+    }
+
+    /** Set the command that prepares the cost function and its copies for
+     * a concurrent evaluation, see ConcurrentCostFunctionEvaluator. */
+    virtual void SetConcurrentPrepareCommand( Command * command )
+    {
+      this->m_ConcurrentEvaluator->SetPrepareCommand( command );
+    }
+
+  protected:
+
+    SimultaneousPerturbationOptimizer();
+    virtual ~SimultaneousPerturbationOptimizer() {};
+
+    /** Override the superclass' implementation, to evaluate the perturbed
+     * positions of all perturbations at once.
+     */
+    virtual void ComputeGradient(
+      const ParametersType & parameters, DerivativeType & gradient );
+
+  private:
+
+    SimultaneousPerturbationOptimizer( const Self& ); // purposely not implemented
+    void operator=( const Self& );                    // purposely not implemented
+
+    /** Pass the cost function copies to the evaluator. Without copies, the
+     * cost function itself is evaluated. */
+    void UpdateConcurrentEvaluator( void );
+
+    CostFunctionContainerType         m_ConcurrentCostFunctions;
+    ConcurrentEvaluatorType::Pointer  m_ConcurrentEvaluator;
+
+  }; // end class SimultaneousPerturbationOptimizer
+
+
+} // end namespace itk
+
+
+#endif // end #ifndef __itkSimultaneousPerturbationOptimizer_h
@@ -19,6 +19,7 @@
 #include "itkCommand.h"
 #include "itkEventObject.h"
 #include "itkExceptionObject.h"
+#include "elxProfiler.h"
 
 namespace itk
 {
@@ -111,6 +112,7 @@ namespace itk
 
       try
       {
+        tmrProfileScope( "Optimizer::GetValueAndDerivative" );
         this->GetScaledValueAndDerivative(
           this->GetScaledCurrentPosition(), m_Value, m_Gradient );
       }
@@ -125,7 +127,10 @@ namespace itk
         break;
       }
 
-      this->AdvanceOneStep();
+      {
+        tmrProfileScope( "Optimizer::AdvanceOneStep" );
+        this->AdvanceOneStep();
+      }
 
       /** StopOptimization may have been called. */
       if ( this->m_Stop )
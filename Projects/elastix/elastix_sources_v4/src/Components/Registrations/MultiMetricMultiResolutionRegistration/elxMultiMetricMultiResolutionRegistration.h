@@ -70,6 +70,16 @@ using namespace itk;
  *    example: <tt>(Metric0Use "false" "true")</tt> \n
  *    example: <tt>(Metric1Use "true" "false")</tt> \n
  *    The default is "true".
+ * \parameter UseConcurrentMetricEvaluation: Whether the metrics are evaluated
+ *    concurrently, each in a thread of its own, in each resolution. This pays off
+ *    when the metrics are independent and comparably expensive, for example an
+ *    image metric and a penalty term. \n
+ *    example: <tt>(UseConcurrentMetricEvaluation "true")</tt> \n
+ *    The default is "false".
+ *
+ * The value, the gradient magnitude and the computation time in ms of each
+ * metric are printed in the iteration info, in the columns Metric\<i\>,
+ * ||Gradient\<i\>|| and Time\<i\>[ms].
  *
  * \ingroup Registrations
  */
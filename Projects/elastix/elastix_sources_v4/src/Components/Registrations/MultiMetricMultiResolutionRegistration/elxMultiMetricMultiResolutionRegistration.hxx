@@ -64,7 +64,7 @@ MultiMetricMultiResolutionRegistration<TElastix>
   }
 
   /** Add the target cells "Metric<i>" and "||Gradient<i>||" to xout["iteration"]
-   * and format as floats.
+   * and format as floats. Also add "Time<i>[ms]".
    */
   const unsigned int nrOfMetrics = this->GetCombinationMetric()->GetNumberOfMetrics();
   for ( unsigned int i = 0; i < nrOfMetrics; ++i )
@@ -78,6 +78,10 @@ MultiMetricMultiResolutionRegistration<TElastix>
     makestring2 << "||Gradient" << i << "||";
     xout["iteration"].AddTargetCell( makestring2.str().c_str() );
     xl::xout["iteration"][ makestring2.str().c_str() ] << std::showpoint << std::fixed;
+
+    std::ostringstream makestring3;
+    makestring3 << "Time" << i << "[ms]";
+    xout["iteration"].AddTargetCell( makestring3.str().c_str() );
   }
 
 } // end BeforeRegistration()
@@ -92,7 +96,7 @@ void
 MultiMetricMultiResolutionRegistration<TElastix>
 ::AfterEachIteration( void )
 {
-  /** Print the submetric values and gradients to xout["iteration"]. */
+  /** Print the submetric values, gradients and times to xout["iteration"]. */
   const unsigned int nrOfMetrics = this->GetCombinationMetric()->GetNumberOfMetrics();
   for ( unsigned int i = 0; i < nrOfMetrics; ++i )
   {
@@ -105,6 +109,11 @@ MultiMetricMultiResolutionRegistration<TElastix>
     makestring2 << "||Gradient" << i << "||";
     xl::xout["iteration"][ makestring2.str().c_str() ] <<
       this->GetCombinationMetric()->GetMetricDerivative(i).magnitude();
+
+    std::ostringstream makestring3;
+    makestring3 << "Time" << i << "[ms]";
+    xl::xout["iteration"][ makestring3.str().c_str() ] << static_cast<unsigned long>(
+      this->GetCombinationMetric()->GetMetricComputationTime(i) * 1000 );
   }
 
 } // end AfterEachIteration()
@@ -150,6 +159,13 @@ MultiMetricMultiResolutionRegistration<TElastix>
     this->GetCombinationMetric()->SetUseMetric( use, metricnr );
   }
 
+  /** Set whether the metrics are evaluated concurrently. */
+  bool useConcurrentMetricEvaluation = false;
+  this->GetConfiguration()->ReadParameter( useConcurrentMetricEvaluation,
+    "UseConcurrentMetricEvaluation", "", level, 0 );
+  this->GetCombinationMetric()->SetUseConcurrentMetricEvaluation(
+    useConcurrentMetricEvaluation );
+
 } // end BeforeEachResolution()
 
 
@@ -343,7 +359,7 @@ MultiMetricMultiResolutionRegistration<TElastix>
   /** Stop timer and print the elapsed time. */
   timer->StopTimer();
   elxout << "Setting the fixed masks took: "
-    << static_cast<long>( timer->GetElapsedClockSec() * 1000 )
+    << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 )
     << " ms." << std::endl;
 
 } // end UpdateFixedMasks()
@@ -441,7 +457,7 @@ MultiMetricMultiResolutionRegistration<TElastix>
   /** Stop timer and print the elapsed time. */
   timer->StopTimer();
   elxout << "Setting the moving masks took: "
-    << static_cast<long>( timer->GetElapsedClockSec() * 1000 )
+    << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 )
     << " ms." << std::endl;
 
 } // end UpdateMovingMasks()
@@ -17,6 +17,7 @@
 
 #include "itkAdvancedImageToImageMetric.h"
 #include "itkSingleValuedPointSetToPointSetMetric.h"
+#include "elxTimer.h"
 
 namespace itk
 {
@@ -49,6 +50,24 @@ namespace itk
  * why we chose to reimplement the Get{Transform,Interpolator}()
  * methods.
  *
+ * With SetUseConcurrentMetricEvaluation( true ) the sub metrics are
+ * evaluated concurrently, each in a thread of its own, and the weighted sum
+ * of their derivatives is computed multi-threaded. The sub metrics share the
+ * transform and possibly the image sampler, so before launching the threads
+ * the transform parameters are set and all image samplers are updated.
+ * During the concurrent evaluation the sub metrics do not set the transform
+ * parameters themselves (see SetTransformParametersAreSetExternally()),
+ * since that is not thread-safe. Neither do they update the sampler they
+ * may share: each sub metric temporarily gets a ReadOnlyImageSampler, which
+ * copies the samples of its own sampler, as the concurrent copies of
+ * AdvancedImageToImageMetric::CreateConcurrentCopies() do.
+ * Sub metrics of another type than the image and point set metrics are
+ * always evaluated sequentially. Sub metrics that are multi-threaded themselves still
+ * launch their own threads. The results are the same as with the sequential
+ * evaluation.
+ *
+ * For each sub metric the wall clock time of its last evaluation is stored,
+ * see GetMetricComputationTime().
  *
  * \ingroup RegistrationMetrics
  *
@@ -108,7 +127,7 @@ public:
   typedef typename Superclass::MovingImageMaskPointer     MovingImageMaskPointer;
   typedef typename Superclass::MeasureType                MeasureType;
   typedef typename Superclass::DerivativeType             DerivativeType;
-  //typedef typename Superclass::DerivativeValueType        DerivativeValueType;
+  typedef typename Superclass::DerivativeValueType        DerivativeValueType;
   typedef typename Superclass::ParametersType             ParametersType;
 
   /** Some typedefs for computing the SelfHessian */
@@ -132,6 +151,10 @@ public:
   /** Typedefs for the metrics. */
   typedef Superclass                                      ImageMetricType;
   typedef typename ImageMetricType::Pointer               ImageMetricPointer;
+  typedef typename ImageMetricType::ImageSamplerType      SubMetricImageSamplerType;
+  typedef typename SubMetricImageSamplerType::Pointer     SubMetricImageSamplerPointer;
+  typedef ReadOnlyImageSampler< FixedImageType >          ReadOnlyImageSamplerType;
+  typedef typename ReadOnlyImageSamplerType::Pointer      ReadOnlyImageSamplerPointer;
   typedef SingleValuedCostFunction                        SingleValuedCostFunctionType;
   typedef typename SingleValuedCostFunctionType::Pointer  SingleValuedCostFunctionPointer;
 
@@ -204,6 +227,13 @@ public:
   /** Get the last computed derivative for metric i. */
   const DerivativeType & GetMetricDerivative( unsigned int pos ) const;
 
+  /** Get the wall clock time in seconds of the last evaluation of metric i. */
+  double GetMetricComputationTime( unsigned int pos ) const;
+
+  /** Set/Get whether the sub metrics are evaluated concurrently; default false. */
+  itkSetMacro( UseConcurrentMetricEvaluation, bool );
+  itkGetConstMacro( UseConcurrentMetricEvaluation, bool );
+
   /**
    * Set/Get functions for the metric components
    **/
@@ -382,15 +412,82 @@ protected:
   std::vector< bool >                               m_UseMetric;
   mutable std::vector< MeasureType >                m_MetricValues;
   mutable std::vector< DerivativeType >             m_MetricDerivatives;
+  mutable std::vector< double >                     m_MetricComputationTimes;
 
   /** dummy image region and derivatives */
   FixedImageRegionType        m_NullFixedImageRegion;
   DerivativeType              m_NullDerivative;
 
+  /** Typedefs for the concurrent evaluation of the sub metrics. */
+  typedef typename Superclass::ThreaderType               ThreaderType;
+  typedef typename Superclass::ThreadInfoType             ThreadInfoType;
+
+  /** What to compute of the sub metrics. */
+  enum EvaluationType {
+    EvaluateValue,
+    EvaluateDerivative,
+    EvaluateValueAndDerivative,
+    EvaluateSelfHessian };
+
+  /** The data that is passed to the threads. */
+  struct CombinationThreaderParameterType
+  {
+    const Self *              st_Metric;
+    const ParametersType *    st_Parameters;
+    EvaluationType            st_Evaluation;
+    DerivativeValueType *     st_DerivativePointer;
+    HessianType *             st_Hessian;
+  };
+
+  /** Evaluate sub metric pos and store the result in m_MetricValues,
+   * m_MetricDerivatives, or m_MetricSelfHessians. Also stores the time.
+   * Only the self hessians of used image metrics are computed.
+   */
+  virtual void EvaluateMetric( unsigned int pos,
+    const ParametersType & parameters, EvaluationType evaluation ) const;
+
+  /** Evaluate all sub metrics, sequentially or concurrently. Exceptions
+   * that are thrown by a sub metric in a thread are rethrown afterwards.
+   */
+  virtual void EvaluateMetrics( const ParametersType & parameters,
+    EvaluationType evaluation ) const;
+
+  /** Set the transform parameters of all sub metrics, and let them skip
+   * setting the parameters themselves until this function is called with
+   * 0, which restores the default. Returns false if a sub metric does not
+   * support this. */
+  bool PrepareSubMetricTransformParameters( const ParametersType * parameters ) const;
+
+  /** With true, update the image samplers of the sub metrics, and replace
+   * each by a ReadOnlyImageSampler that copies its samples, so that the sub
+   * metrics can update their sampler in their own thread. With false,
+   * restore the original samplers. */
+  void PrepareSubMetricImageSamplers( bool readOnly ) const;
+
+  /** Compute derivative = sum_i w_i m_MetricDerivatives[ i ], for the
+   * used metrics. */
+  virtual void AccumulateMetricDerivatives( DerivativeType & derivative ) const;
+
+  /** The threader callbacks. */
+  static ITK_THREAD_RETURN_TYPE EvaluateMetricsThreaderCallback( void * arg );
+  static ITK_THREAD_RETURN_TYPE AccumulateMetricDerivativesThreaderCallback( void * arg );
+  static ITK_THREAD_RETURN_TYPE AccumulateMetricSelfHessiansThreaderCallback( void * arg );
+
+  /** Variables for the concurrent evaluation. */
+  typename ThreaderType::Pointer                    m_MetricThreader;
+  mutable std::vector< HessianType >                m_MetricSelfHessians;
+  mutable std::vector< unsigned char >              m_MetricSelfHessianComputed;
+  mutable std::vector< ExceptionObject >            m_MetricExceptions;
+  mutable std::vector< unsigned char >              m_MetricFailed;
+  mutable std::vector< SubMetricImageSamplerPointer > m_SubMetricImageSamplers;
+  mutable std::vector< ReadOnlyImageSamplerPointer >  m_ReadOnlyImageSamplers;
+
 private:
   CombinationImageToImageMetric(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
 
+  bool m_UseConcurrentMetricEvaluation;
+
 }; // end class CombinationImageToImageMetric
 
 } // end namespace itk
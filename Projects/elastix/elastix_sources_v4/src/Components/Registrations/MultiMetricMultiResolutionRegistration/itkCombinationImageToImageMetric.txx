@@ -160,6 +160,8 @@ CombinationImageToImageMetric<TFixedImage,TMovingImage>
 {
   this->m_NumberOfMetrics = 0;
   this->ComputeGradientOff();
+  this->m_UseConcurrentMetricEvaluation = false;
+  this->m_MetricThreader = ThreaderType::New();
 
 } // end Constructor
 
@@ -195,6 +197,8 @@ CombinationImageToImageMetric<TFixedImage,TMovingImage>
       os << "not used" << std::endl;
     }
   }
+  os << indent << "UseConcurrentMetricEvaluation: "
+    << this->m_UseConcurrentMetricEvaluation << std::endl;
 
 } // end PrintSelf()
 
@@ -280,6 +284,13 @@ CombinationImageToImageMetric<TFixedImage,TMovingImage>
     this->m_UseMetric.resize( count );
     this->m_MetricValues.resize( count );
     this->m_MetricDerivatives.resize( count );
+    this->m_MetricComputationTimes.resize( count, 0.0 );
+    this->m_MetricSelfHessians.resize( count );
+    this->m_MetricSelfHessianComputed.resize( count, 0 );
+    this->m_MetricExceptions.resize( count );
+    this->m_MetricFailed.resize( count, 0 );
+    this->m_SubMetricImageSamplers.resize( count );
+    this->m_ReadOnlyImageSamplers.resize( count );
     this->Modified();
   }
 
@@ -483,6 +494,27 @@ CombinationImageToImageMetric<TFixedImage,TMovingImage>
 } // end GetMetricValue()
 
 
+/**
+ * ********************* GetMetricComputationTime ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+double
+CombinationImageToImageMetric<TFixedImage,TMovingImage>
+::GetMetricComputationTime( unsigned int pos ) const
+{
+  if ( pos >= this->GetNumberOfMetrics() )
+  {
+    return 0.0;
+  }
+  else
+  {
+    return this->m_MetricComputationTimes[ pos ];
+  }
+
+} // end GetMetricComputationTime()
+
+
 /**
  * **************** GetNumberOfPixelsCounted ************************
  */
@@ -572,21 +604,17 @@ typename CombinationImageToImageMetric<TFixedImage,TMovingImage>::MeasureType
 CombinationImageToImageMetric<TFixedImage,TMovingImage>
 ::GetValue( const ParametersType & parameters ) const
 {
-  /** Initialise. */
-  MeasureType measure = NumericTraits< MeasureType >::Zero;
+  /** Compute all metric values, which are stored in m_MetricValues. */
+  this->EvaluateMetrics( parameters, EvaluateValue );
 
   /** Add all metric values. */
+  MeasureType measure = NumericTraits< MeasureType >::Zero;
   for ( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
   {
-    MeasureType tmpValue = this->m_Metrics[ i ]->GetValue( parameters );
-
     if ( this->m_UseMetric[ i ] )
     {
-      measure += this->m_MetricWeights[ i ] * tmpValue;
+      measure += this->m_MetricWeights[ i ] * this->m_MetricValues[ i ];
     }
-
-    /** Store for later, for interested users. */
-    this->m_MetricValues[ i ] = tmpValue;
   }
 
   /** Return a value. */
@@ -605,25 +633,11 @@ CombinationImageToImageMetric<TFixedImage,TMovingImage>
 ::GetDerivative( const ParametersType & parameters,
   DerivativeType & derivative ) const
 {
-  /** Initialise. */
-  DerivativeType tmpDerivative = DerivativeType( this->GetNumberOfParameters() );
-  derivative = DerivativeType( this->GetNumberOfParameters() );
-  derivative.Fill( NumericTraits< MeasureType >::Zero );
+  /** Compute all metric derivatives, which are stored in m_MetricDerivatives. */
+  this->EvaluateMetrics( parameters, EvaluateDerivative );
 
   /** Add all metric derivatives. */
-  for ( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
-  {
-    tmpDerivative.Fill( NumericTraits< MeasureType >::Zero );
-    this->m_Metrics[ i ]->GetDerivative( parameters, tmpDerivative );
-
-    if ( this->m_UseMetric[ i ] )
-    {
-      derivative += this->m_MetricWeights[ i ] * tmpDerivative;
-    }
-
-    /** Store for later, for interested users. */
-    this->m_MetricDerivatives[ i ] = tmpDerivative;
-  }
+  this->AccumulateMetricDerivatives( derivative );
 
 } // end GetDerivative()
 
@@ -640,35 +654,27 @@ CombinationImageToImageMetric<TFixedImage,TMovingImage>
   MeasureType & value,
   DerivativeType & derivative ) const
 {
-  /** Initialise. */
-  MeasureType tmpValue = NumericTraits< MeasureType >::Zero;
-  value = NumericTraits< MeasureType >::Zero;
-
-  DerivativeType tmpDerivative = DerivativeType( this->GetNumberOfParameters() );
-  derivative = DerivativeType( this->GetNumberOfParameters() );
-  derivative.Fill( NumericTraits< MeasureType >::Zero );
+  /** Compute all metric values and derivatives, which are stored in
+   * m_MetricValues and m_MetricDerivatives.
+   */
+  this->EvaluateMetrics( parameters, EvaluateValueAndDerivative );
 
-  /** Add all metric values and derivatives. */
+  /** Add all metric values. */
+  value = NumericTraits< MeasureType >::Zero;
   for ( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
   {
-    tmpValue = NumericTraits< MeasureType >::Zero;
-    tmpDerivative.Fill( NumericTraits< MeasureType >::Zero );
-    this->m_Metrics[ i ]->GetValueAndDerivative( parameters, tmpValue, tmpDerivative );
-
     if ( this->m_UseMetric[ i ] )
     {
-      value += this->m_MetricWeights[ i ] * tmpValue;
-      derivative += this->m_MetricWeights[ i ] * tmpDerivative;
+      value += this->m_MetricWeights[ i ] * this->m_MetricValues[ i ];
     }
-
-    /** Store for later, for interested users. */
-    this->m_MetricValues[ i ] = tmpValue;
-    this->m_MetricDerivatives[ i ] = tmpDerivative;
-
   }
 
+  /** Add all metric derivatives. */
+  this->AccumulateMetricDerivatives( derivative );
+
 } // end GetValueAndDerivative()
 
+
 /**
  * ********************* GetSelfHessian ****************************
  */
@@ -683,21 +689,46 @@ CombinationImageToImageMetric<TFixedImage,TMovingImage>
   H.SetSize( this->GetNumberOfParameters(),
     this->GetNumberOfParameters() );
   H.Fill(0.0);
-  HessianType tmpH( this->GetNumberOfParameters(),
-    this->GetNumberOfParameters() );
 
   /** Add all metrics' selfhessians. */
   bool initialized = false;
-  for ( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
+  if ( !this->m_UseConcurrentMetricEvaluation )
   {
-    if ( this->m_UseMetric[ i ] )
+    /** Compute them one by one, so that only one extra matrix is in memory. */
+    for ( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
+    {
+      this->EvaluateMetric( i, parameters, EvaluateSelfHessian );
+      if ( this->m_MetricSelfHessianComputed[ i ] )
+      {
+        initialized = true;
+        H += this->m_MetricWeights[ i ] * this->m_MetricSelfHessians[ i ];
+        this->m_MetricSelfHessians[ i ].SetSize( 0, 0 );
+      }
+    }
+  }
+  else
+  {
+    /** Compute them concurrently, and sum them multi-threaded, each thread
+     * taking a chunk of rows.
+     */
+    this->EvaluateMetrics( parameters, EvaluateSelfHessian );
+
+    CombinationThreaderParameterType str;
+    str.st_Metric = this;
+    str.st_Parameters = &parameters;
+    str.st_Evaluation = EvaluateSelfHessian;
+    str.st_DerivativePointer = 0;
+    str.st_Hessian = &H;
+    this->m_Threader->SetSingleMethod(
+      AccumulateMetricSelfHessiansThreaderCallback, &str );
+    this->m_Threader->SingleMethodExecute();
+
+    for ( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
     {
-      ImageMetricType * metric = dynamic_cast<ImageMetricType *>( this->GetMetric( i ) );
-      if ( metric )
+      if ( this->m_MetricSelfHessianComputed[ i ] )
       {
         initialized = true;
-        metric->GetSelfHessian( parameters, tmpH );
-        H += this->m_MetricWeights[ i ] * tmpH;
+        this->m_MetricSelfHessians[ i ].SetSize( 0, 0 );
       }
     }
   }
@@ -712,6 +743,400 @@ CombinationImageToImageMetric<TFixedImage,TMovingImage>
 } // end GetSelfHessian()
 
 
+/**
+ * ********************* EvaluateMetric ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage,TMovingImage>
+::EvaluateMetric( unsigned int pos, const ParametersType & parameters,
+  EvaluationType evaluation ) const
+{
+  /** Wall-clock time, like the other timings. */
+  tmr::Timer::Pointer timer = tmr::Timer::New();
+  timer->StartTimer();
+
+  const unsigned int numberOfParameters = this->GetNumberOfParameters();
+  SingleValuedCostFunctionType * costfunc = this->m_Metrics[ pos ];
+
+  if ( evaluation == EvaluateValue )
+  {
+    this->m_MetricValues[ pos ] = costfunc->GetValue( parameters );
+  }
+  else if ( evaluation == EvaluateDerivative )
+  {
+    DerivativeType & derivative = this->m_MetricDerivatives[ pos ];
+    derivative.SetSize( numberOfParameters );
+    derivative.Fill( NumericTraits< DerivativeValueType >::Zero );
+    costfunc->GetDerivative( parameters, derivative );
+  }
+  else if ( evaluation == EvaluateValueAndDerivative )
+  {
+    MeasureType value = NumericTraits< MeasureType >::Zero;
+    DerivativeType & derivative = this->m_MetricDerivatives[ pos ];
+    derivative.SetSize( numberOfParameters );
+    derivative.Fill( NumericTraits< DerivativeValueType >::Zero );
+    costfunc->GetValueAndDerivative( parameters, value, derivative );
+    this->m_MetricValues[ pos ] = value;
+  }
+  else if ( evaluation == EvaluateSelfHessian )
+  {
+    /** Only used image metrics provide a self hessian. */
+    this->m_MetricSelfHessianComputed[ pos ] = 0;
+    ImageMetricType * metric = dynamic_cast<ImageMetricType *>( costfunc );
+    if ( this->m_UseMetric[ pos ] && metric )
+    {
+      HessianType & hessian = this->m_MetricSelfHessians[ pos ];
+      hessian.SetSize( numberOfParameters, numberOfParameters );
+      metric->GetSelfHessian( parameters, hessian );
+      this->m_MetricSelfHessianComputed[ pos ] = 1;
+    }
+  }
+
+  timer->StopTimer();
+  this->m_MetricComputationTimes[ pos ] = timer->GetElapsedWallClockSec();
+
+} // end EvaluateMetric()
+
+
+/**
+ * ********************* EvaluateMetrics ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage,TMovingImage>
+::EvaluateMetrics( const ParametersType & parameters,
+  EvaluationType evaluation ) const
+{
+  const unsigned int nrOfMetrics = this->m_NumberOfMetrics;
+
+  /** Let the sub metrics set the transform parameters and update their
+   * samplers themselves, which also cleans up after an exception in a
+   * previous concurrent evaluation.
+   */
+  this->PrepareSubMetricImageSamplers( false );
+  const bool supported = this->PrepareSubMetricTransformParameters( 0 );
+
+  /** Evaluate the metrics one after another. */
+  if ( !this->m_UseConcurrentMetricEvaluation || nrOfMetrics < 2 || !supported )
+  {
+    for ( unsigned int i = 0; i < nrOfMetrics; i++ )
+    {
+      this->EvaluateMetric( i, parameters, evaluation );
+    }
+    return;
+  }
+
+  /** Prepare what the metrics share: update the image samplers and set
+   * the transform parameters, before launching the threads. Doing that from
+   * the threads would be a race, so the sub metrics skip setting the
+   * parameters, and update a read-only sampler instead.
+   */
+  this->PrepareSubMetricImageSamplers( true );
+  this->PrepareSubMetricTransformParameters( &parameters );
+
+  /** Evaluate the metrics concurrently. */
+  for ( unsigned int i = 0; i < nrOfMetrics; i++ )
+  {
+    this->m_MetricFailed[ i ] = 0;
+  }
+  CombinationThreaderParameterType str;
+  str.st_Metric = this;
+  str.st_Parameters = &parameters;
+  str.st_Evaluation = evaluation;
+  str.st_DerivativePointer = 0;
+  str.st_Hessian = 0;
+  this->m_MetricThreader->SetNumberOfThreads( nrOfMetrics );
+  this->m_MetricThreader->SetSingleMethod( EvaluateMetricsThreaderCallback, &str );
+  this->m_MetricThreader->SingleMethodExecute();
+  this->PrepareSubMetricTransformParameters( 0 );
+  this->PrepareSubMetricImageSamplers( false );
+
+  /** Pass on the exception of the first metric that failed. */
+  for ( unsigned int i = 0; i < nrOfMetrics; i++ )
+  {
+    if ( this->m_MetricFailed[ i ] )
+    {
+      throw this->m_MetricExceptions[ i ];
+    }
+  }
+
+} // end EvaluateMetrics()
+
+
+/**
+ * ************* PrepareSubMetricTransformParameters ******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+CombinationImageToImageMetric<TFixedImage,TMovingImage>
+::PrepareSubMetricTransformParameters( const ParametersType * parameters ) const
+{
+  /** The sub metrics may have different transforms, see SetTransform(),
+   * so the parameters are set through each sub metric. */
+  bool supported = true;
+  for ( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
+  {
+    ImageMetricType * testPtr1
+      = dynamic_cast<ImageMetricType *>( this->GetMetric( i ) );
+    PointSetMetricType * testPtr2
+      = dynamic_cast<PointSetMetricType *>( this->GetMetric( i ) );
+    if ( testPtr1 )
+    {
+      testPtr1->SetTransformParametersAreSetExternally( false );
+      if ( parameters )
+      {
+        testPtr1->SetTransformParameters( *parameters );
+        testPtr1->SetTransformParametersAreSetExternally( true );
+      }
+    }
+    else if ( testPtr2 )
+    {
+      testPtr2->SetTransformParametersAreSetExternally( false );
+      if ( parameters )
+      {
+        testPtr2->SetTransformParameters( *parameters );
+        testPtr2->SetTransformParametersAreSetExternally( true );
+      }
+    }
+    else
+    {
+      supported = false;
+    }
+  }
+
+  return supported;
+
+} // end PrepareSubMetricTransformParameters()
+
+
+/**
+ * ***************** PrepareSubMetricImageSamplers ********************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage,TMovingImage>
+::PrepareSubMetricImageSamplers( bool readOnly ) const
+{
+  for ( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
+  {
+    ImageMetricType * metric
+      = dynamic_cast<ImageMetricType *>( this->GetMetric( i ) );
+    if ( !metric )
+    {
+      continue;
+    }
+
+    /** Restore the original sampler. */
+    if ( !readOnly )
+    {
+      if ( this->m_SubMetricImageSamplers[ i ].IsNotNull() )
+      {
+        metric->SetImageSampler( this->m_SubMetricImageSamplers[ i ] );
+        this->m_SubMetricImageSamplers[ i ] = 0;
+      }
+      continue;
+    }
+
+    SubMetricImageSamplerType * sampler = metric->GetImageSampler();
+    if ( !metric->GetUseImageSampler() || !sampler )
+    {
+      continue;
+    }
+
+    /** Update the sampler, which may be shared by several sub metrics,
+     * in this thread, and copy its samples to the read-only sampler. */
+    sampler->Update();
+    if ( this->m_ReadOnlyImageSamplers[ i ].IsNull() )
+    {
+      this->m_ReadOnlyImageSamplers[ i ] = ReadOnlyImageSamplerType::New();
+    }
+    ReadOnlyImageSamplerType * readOnlySampler
+      = this->m_ReadOnlyImageSamplers[ i ].GetPointer();
+    if ( readOnlySampler->GetSourceSampleContainer() != sampler->GetOutput() )
+    {
+      readOnlySampler->SetSourceSampleContainer( sampler->GetOutput() );
+    }
+    readOnlySampler->SetInputImageRegion( sampler->GetInputImageRegion() );
+    readOnlySampler->SetMask( sampler->GetMask() );
+    readOnlySampler->Update();
+
+    this->m_SubMetricImageSamplers[ i ] = sampler;
+    metric->SetImageSampler( readOnlySampler );
+  }
+
+} // end PrepareSubMetricImageSamplers()
+
+
+/**
+ * ***************** EvaluateMetricsThreaderCallback *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+CombinationImageToImageMetric<TFixedImage,TMovingImage>
+::EvaluateMetricsThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>( arg );
+  const unsigned int threadID = infoStruct->ThreadID;
+  const unsigned int numberOfThreads = infoStruct->NumberOfThreads;
+  CombinationThreaderParameterType * temp
+    = static_cast<CombinationThreaderParameterType *>( infoStruct->UserData );
+  const Self * self = temp->st_Metric;
+
+  /** Thread t evaluates metrics t, t + numberOfThreads, ... Exceptions
+   * can not be thrown across threads, so they are stored.
+   */
+  for ( unsigned int i = threadID; i < self->m_NumberOfMetrics; i += numberOfThreads )
+  {
+    try
+    {
+      self->EvaluateMetric( i, *( temp->st_Parameters ), temp->st_Evaluation );
+    }
+    catch ( ExceptionObject & excp )
+    {
+      self->m_MetricExceptions[ i ] = excp;
+      self->m_MetricFailed[ i ] = 1;
+    }
+    catch ( std::exception & excp )
+    {
+      self->m_MetricExceptions[ i ] = ExceptionObject( __FILE__, __LINE__,
+        excp.what(), "CombinationImageToImageMetric - EvaluateMetrics()" );
+      self->m_MetricFailed[ i ] = 1;
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end EvaluateMetricsThreaderCallback()
+
+
+/**
+ * ********************* AccumulateMetricDerivatives ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage,TMovingImage>
+::AccumulateMetricDerivatives( DerivativeType & derivative ) const
+{
+  derivative = DerivativeType( this->GetNumberOfParameters() );
+  derivative.Fill( NumericTraits< DerivativeValueType >::Zero );
+
+  if ( !this->m_UseConcurrentMetricEvaluation )
+  {
+    for ( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
+    {
+      if ( this->m_UseMetric[ i ] )
+      {
+        derivative += this->m_MetricWeights[ i ] * this->m_MetricDerivatives[ i ];
+      }
+    }
+    return;
+  }
+
+  /** Each thread sums a chunk of the parameters. */
+  CombinationThreaderParameterType str;
+  str.st_Metric = this;
+  str.st_Parameters = 0;
+  str.st_Evaluation = EvaluateDerivative;
+  str.st_DerivativePointer = derivative.begin();
+  str.st_Hessian = 0;
+  this->m_Threader->SetSingleMethod(
+    AccumulateMetricDerivativesThreaderCallback, &str );
+  this->m_Threader->SingleMethodExecute();
+
+} // end AccumulateMetricDerivatives()
+
+
+/**
+ * ************* AccumulateMetricDerivativesThreaderCallback ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+CombinationImageToImageMetric<TFixedImage,TMovingImage>
+::AccumulateMetricDerivativesThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>( arg );
+  const unsigned int threadID = infoStruct->ThreadID;
+  CombinationThreaderParameterType * temp
+    = static_cast<CombinationThreaderParameterType *>( infoStruct->UserData );
+  const Self * self = temp->st_Metric;
+
+  unsigned long jmin = 0;
+  unsigned long jmax = 0;
+  self->GetThreadSampleRange( threadID,
+    self->GetNumberOfParameters(), jmin, jmax );
+
+  /** Sum in the order of the metrics, as in the sequential case. */
+  DerivativeValueType * derivative = temp->st_DerivativePointer;
+  for ( unsigned long j = jmin; j < jmax; ++j )
+  {
+    DerivativeValueType sum = NumericTraits<DerivativeValueType>::Zero;
+    for ( unsigned int i = 0; i < self->m_NumberOfMetrics; ++i )
+    {
+      if ( self->m_UseMetric[ i ] )
+      {
+        sum += self->m_MetricWeights[ i ] * self->m_MetricDerivatives[ i ][ j ];
+      }
+    }
+    derivative[ j ] = sum;
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end AccumulateMetricDerivativesThreaderCallback()
+
+
+/**
+ * ************* AccumulateMetricSelfHessiansThreaderCallback ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+CombinationImageToImageMetric<TFixedImage,TMovingImage>
+::AccumulateMetricSelfHessiansThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>( arg );
+  const unsigned int threadID = infoStruct->ThreadID;
+  CombinationThreaderParameterType * temp
+    = static_cast<CombinationThreaderParameterType *>( infoStruct->UserData );
+  const Self * self = temp->st_Metric;
+  HessianType & H = *( temp->st_Hessian );
+
+  const unsigned long numberOfParameters = self->GetNumberOfParameters();
+  unsigned long rmin = 0;
+  unsigned long rmax = 0;
+  self->GetThreadSampleRange( threadID, numberOfParameters, rmin, rmax );
+
+  /** Add the rows of this thread, in the order of the metrics. */
+  for ( unsigned int i = 0; i < self->m_NumberOfMetrics; ++i )
+  {
+    if ( !self->m_MetricSelfHessianComputed[ i ] ) continue;
+    const HessianValueType weight
+      = static_cast<HessianValueType>( self->m_MetricWeights[ i ] );
+    const HessianType & Hi = self->m_MetricSelfHessians[ i ];
+    for ( unsigned long r = rmin; r < rmax; ++r )
+    {
+      HessianValueType * row = H[ r ];
+      const HessianValueType * row_i = Hi[ r ];
+      for ( unsigned long c = 0; c < numberOfParameters; ++c )
+      {
+        row[ c ] += weight * row_i[ c ];
+      }
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end AccumulateMetricSelfHessiansThreaderCallback()
+
+
 /**
  * ********************* GetMTime ****************************
  */
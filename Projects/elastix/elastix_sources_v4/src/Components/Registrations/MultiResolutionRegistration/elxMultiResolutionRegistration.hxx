@@ -187,7 +187,7 @@ using namespace itk;
     /** Stop timer and print the elapsed time. */
     timer->StopTimer();
     elxout << "Setting the fixed masks took: "
-      << static_cast<long>( timer->GetElapsedClockSec() * 1000 )
+      << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 )
       << " ms." << std::endl;
 
     /** start timer, to time the whole moving mask configuration procedure. */
@@ -201,7 +201,7 @@ using namespace itk;
     /** Stop timer and print the elapsed time. */
     timer->StopTimer();
     elxout << "Setting the moving masks took: "
-      << static_cast<long>( timer->GetElapsedClockSec() * 1000 )
+      << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 )
       << " ms." << std::endl;
 
   } // end UpdateMasks
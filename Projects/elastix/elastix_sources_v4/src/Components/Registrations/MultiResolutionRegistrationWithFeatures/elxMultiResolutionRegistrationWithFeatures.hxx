@@ -253,7 +253,7 @@ using namespace itk;
     /** Stop timer and print the elapsed time. */
     timer->StopTimer();
     elxout << "Setting the fixed masks took: "
-      << static_cast<long>( timer->GetElapsedClockSec() * 1000 )
+      << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 )
       << " ms." << std::endl;
 
   } // end UpdateFixedMasks()
@@ -295,7 +295,7 @@ using namespace itk;
     /** Stop timer and print the elapsed time. */
     timer->StopTimer();
     elxout << "Setting the moving masks took: "
-      << static_cast<long>( timer->GetElapsedClockSec() * 1000 )
+      << static_cast<long>( timer->GetElapsedWallClockSec() * 1000 )
       << " ms." << std::endl;
 
   } // end UpdateMovingMasks()
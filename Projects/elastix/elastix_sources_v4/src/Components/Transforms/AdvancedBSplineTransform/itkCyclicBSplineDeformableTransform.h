@@ -123,6 +123,14 @@ public:
     ParameterIndexArrayType & indices,
     bool & inside ) const;
 
+  /** Transform a batch of points with TransformPoint() above. The batch
+   * implementation of the superclass does not handle the cyclic grid.
+   */
+  virtual void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    unsigned long numberOfPoints ) const;
+
   /** Compute the Jacobian matrix of the transformation at one point. */
   virtual const JacobianType & GetJacobian( const InputPointType & point ) const;
 
@@ -249,6 +249,30 @@ CyclicBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>
   }
 }
 
+/** Transform a batch of points. */
+template<class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+CyclicBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  unsigned long numberOfPoints ) const
+{
+  /** Allocate memory on the stack, once for all points. */
+  const unsigned long numberOfWeights = WeightsFunctionType::NumberOfWeights;
+  typename WeightsType::ValueType weightsArray[ numberOfWeights ];
+  typename ParameterIndexArrayType::ValueType indicesArray[ numberOfWeights ];
+  WeightsType weights( weightsArray, numberOfWeights, false );
+  ParameterIndexArrayType indices( indicesArray, numberOfWeights, false );
+
+  bool inside;
+  for ( unsigned long i = 0; i < numberOfPoints; ++i )
+  {
+    this->TransformPoint( inputPoints[ i ], outputPoints[ i ],
+      weights, indices, inside );
+  }
+}
+
 /** Compute the Jacobian in one position. */
 template<class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
 const
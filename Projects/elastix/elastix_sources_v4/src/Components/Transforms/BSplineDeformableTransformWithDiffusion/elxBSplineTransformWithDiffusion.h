@@ -304,6 +304,7 @@ public:
 
   /** Execute stuff before each new pyramid resolution:
    * \li upsample the B-spline grid.
+   * \li read the diffusion schedule of this resolution.
    */
   virtual void BeforeEachResolution( void );
 
@@ -399,6 +400,16 @@ private:
   bool m_UseMovingSegmentation;
   bool m_UseFixedSegmentation;
 
+  /** The diffusion schedule of the current resolution. These parameters
+   * are read in BeforeEachResolution(), so that AfterEachIteration() does
+   * not need to access the configuration.
+   */
+  unsigned int m_FilterPattern;
+  unsigned int m_DiffusionEachNIterations;
+  unsigned int m_AfterIterations[ 2 ];
+  unsigned int m_HowManyIterations[ 3 ];
+  unsigned int m_MaximumNumberOfIterations;
+
   /** The B-spline parameters, which is going to be filled with zeros. */
   ParametersType m_BSplineParameters;
 
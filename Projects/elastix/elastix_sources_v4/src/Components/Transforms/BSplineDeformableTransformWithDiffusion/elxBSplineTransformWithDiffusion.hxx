@@ -64,6 +64,16 @@ BSplineTransformWithDiffusion<TElastix>
   this->m_UseMovingSegmentation = false;
   this->m_UseFixedSegmentation = false;
 
+  /** Initialize the diffusion schedule. */
+  this->m_FilterPattern = 1;
+  this->m_DiffusionEachNIterations = 1;
+  this->m_AfterIterations[ 0 ] = 50;
+  this->m_AfterIterations[ 1 ] = 100;
+  this->m_HowManyIterations[ 0 ] = 1;
+  this->m_HowManyIterations[ 1 ] = 5;
+  this->m_HowManyIterations[ 2 ] = 10;
+  this->m_MaximumNumberOfIterations = 0;
+
   /** Make sure that the TransformBase::WriteToFile() does
    * not write the transformParameters in the file.
    */
@@ -433,6 +443,52 @@ BSplineTransformWithDiffusion<TElastix>
     /** Otherwise, nothing is done with the BSpline-Grid. */
   }
 
+  /** Find out filter pattern. */
+  this->m_FilterPattern = 1;
+  this->m_Configuration->ReadParameter( this->m_FilterPattern, "FilterPattern", 0 );
+  if ( this->m_FilterPattern != 1 && this->m_FilterPattern != 2 )
+  {
+    this->m_FilterPattern = 1;
+    xout["warning"] << "WARNING: filterPattern set to 1" << std::endl;
+  }
+
+  /** Get the MaximumNumberOfIterations of this resolution level. */
+  this->m_MaximumNumberOfIterations = 0;
+  this->m_Configuration->ReadParameter( this->m_MaximumNumberOfIterations,
+    "MaximumNumberOfIterations", level );
+
+  if ( this->m_FilterPattern == 1 )
+  {
+    /** Find out after how many iterations a diffusion is wanted. */
+    this->m_DiffusionEachNIterations = 0;
+    this->m_Configuration->ReadParameter( this->m_DiffusionEachNIterations,
+      "DiffusionEachNIterations", 0 );
+
+    /** Checking DiffusionEachNIterations. */
+    if ( this->m_DiffusionEachNIterations < 1 )
+    {
+      xout["warning"] << "WARNING: DiffusionEachNIterations < 1" << std::endl;
+      xout["warning"] << "\t\tDiffusionEachNIterations is set to 1" << std::endl;
+      this->m_DiffusionEachNIterations = 1;
+    }
+  }
+  else
+  {
+    /** Find out after how many iterations a change in n_i is needed. */
+    this->m_AfterIterations[ 0 ] = 50;
+    this->m_AfterIterations[ 1 ] = 100;
+    this->m_Configuration->ReadParameter( this->m_AfterIterations[ 0 ], "AfterIterations", 0 );
+    this->m_Configuration->ReadParameter( this->m_AfterIterations[ 1 ], "AfterIterations", 1 );
+
+    /** Find out n1, n2 and n3. */
+    this->m_HowManyIterations[ 0 ] = 1;
+    this->m_HowManyIterations[ 1 ] = 5;
+    this->m_HowManyIterations[ 2 ] = 10;
+    this->m_Configuration->ReadParameter( this->m_HowManyIterations[ 0 ], "HowManyIterations", 0 );
+    this->m_Configuration->ReadParameter( this->m_HowManyIterations[ 1 ], "HowManyIterations", 1 );
+    this->m_Configuration->ReadParameter( this->m_HowManyIterations[ 2 ], "HowManyIterations", 2 );
+  }
+
 } // end BeforeEachResolution()
 
 
@@ -448,70 +504,28 @@ BSplineTransformWithDiffusion<TElastix>
   /** Declare boolean. */
   bool DiffusionNow = false;
 
-  /** Find out filter pattern. */
-  unsigned int filterPattern = 1;
-  this->m_Configuration->ReadParameter( filterPattern, "FilterPattern", 0 );
-  if ( filterPattern != 1 && filterPattern != 2 )
-  {
-    filterPattern = 1;
-    xout["warning"] << "WARNING: filterPattern set to 1" << std::endl;
-  }
-
   /** Get the current iteration number. */
   unsigned int CurrentIterationNumber = this->m_Elastix->GetIterationCounter();
 
-  /** Get the MaximumNumberOfIterations of this resolution level. */
-  unsigned int ResNr = this->m_Elastix->GetElxRegistrationBase()
-    ->GetAsITKBaseType()->GetCurrentLevel();
-  unsigned int maximumNumberOfIterations = 0;
-  this->m_Configuration->ReadParameter( maximumNumberOfIterations,
-    "MaximumNumberOfIterations", ResNr );
-
-  /** Find out if we have to filter now.
+  /** Find out if we have to filter now. The schedule of this resolution
+   * was read in BeforeEachResolution().
    * FilterPattern1: diffusion every n iterations
    * FilterPattern2: start with diffusion every n1 iterations,
    *    followed by diffusion every n2 iterations, and ended
    *    by by diffusion every n3 iterations.
    */
-  if ( filterPattern == 1 )
+  if ( this->m_FilterPattern == 1 )
   {
-    /** Find out after how many iterations a diffusion is wanted. */
-    unsigned int diffusionEachNIterations = 0;
-    this->m_Configuration->ReadParameter( diffusionEachNIterations,
-      "DiffusionEachNIterations", 0 );
-
-    /** Checking DiffusionEachNIterations. */
-    if ( diffusionEachNIterations < 1 )
-    {
-      xout["warning"] << "WARNING: DiffusionEachNIterations < 1" << std::endl;
-      xout["warning"] << "\t\tDiffusionEachNIterations is set to 1" << std::endl;
-      diffusionEachNIterations = 1;
-    }
-
     /** Determine if diffusion is wanted after this iteration:
      * Do it every n iterations, but not at the first iteration
      * of a resolution, and also at the last iteration.
      */
-    DiffusionNow = ( ( CurrentIterationNumber + 1 ) % diffusionEachNIterations == 0 );
+    DiffusionNow = ( ( CurrentIterationNumber + 1 ) % this->m_DiffusionEachNIterations == 0 );
     DiffusionNow &= ( CurrentIterationNumber != 0 );
-    DiffusionNow |= ( CurrentIterationNumber == ( maximumNumberOfIterations - 1 ) );
+    DiffusionNow |= ( CurrentIterationNumber == ( this->m_MaximumNumberOfIterations - 1 ) );
   }
-  else if ( filterPattern == 2 )
+  else if ( this->m_FilterPattern == 2 )
   {
-    /** Find out after how many iterations a change in n_i is needed. */
-    unsigned int afterIterations0 = 50;
-    unsigned int afterIterations1 = 100;
-    this->m_Configuration->ReadParameter( afterIterations0, "AfterIterations", 0 );
-    this->m_Configuration->ReadParameter( afterIterations1, "AfterIterations", 1 );
-
-    /** Find out n1, n2 and n3. */
-    unsigned int howManyIterations0 = 1;
-    unsigned int howManyIterations1 = 5;
-    unsigned int howManyIterations2 = 10;
-    this->m_Configuration->ReadParameter( howManyIterations0, "HowManyIterations", 0 );
-    this->m_Configuration->ReadParameter( howManyIterations1, "HowManyIterations", 1 );
-    this->m_Configuration->ReadParameter( howManyIterations2, "HowManyIterations", 2 );
-
     /** The first afterIterations0 the deformationField is filtered
      * every howManyIterations0 iterations. Then, for iterations between
      * afterIterations0 and afterIterations1 , the deformationField
@@ -519,23 +533,23 @@ BSplineTransformWithDiffusion<TElastix>
      * the deformationField is filtered every howManyIterations2 iterations.
      */
     unsigned int diffusionEachNIterations;
-    if ( CurrentIterationNumber < afterIterations0 )
+    if ( CurrentIterationNumber < this->m_AfterIterations[ 0 ] )
     {
-      diffusionEachNIterations = howManyIterations0;
+      diffusionEachNIterations = this->m_HowManyIterations[ 0 ];
     }
-    else if ( CurrentIterationNumber >= afterIterations0
-      && CurrentIterationNumber < afterIterations1 )
+    else if ( CurrentIterationNumber >= this->m_AfterIterations[ 0 ]
+      && CurrentIterationNumber < this->m_AfterIterations[ 1 ] )
     {
-      diffusionEachNIterations = howManyIterations1;
+      diffusionEachNIterations = this->m_HowManyIterations[ 1 ];
     }
     else
     {
-      diffusionEachNIterations = howManyIterations2;
+      diffusionEachNIterations = this->m_HowManyIterations[ 2 ];
     }
 
     /** Filter the current iteration? Also filter after the last iteration. */
     DiffusionNow = ( ( CurrentIterationNumber + 1 ) % diffusionEachNIterations == 0 );
-    DiffusionNow |= ( CurrentIterationNumber == ( maximumNumberOfIterations - 1 ) );
+    DiffusionNow |= ( CurrentIterationNumber == ( this->m_MaximumNumberOfIterations - 1 ) );
 
   } // end if filterpattern
 
@@ -107,6 +107,21 @@ namespace itk
     /** Method to transform a point. */
     virtual OutputPointType TransformPoint( const InputPointType & inputPoint ) const;
 
+    /** Method to transform a batch of points. Calls the batch TransformPoints()
+     * of the superclass and of the intermediary deformation field transform,
+     * so that the result equals that of TransformPoint().
+     */
+    virtual void TransformPoints(
+      const InputPointType * inputPoints,
+      OutputPointType * outputPoints,
+      unsigned long numberOfPoints ) const;
+
+    /** The intermediary deformation field is not a parameter. */
+    virtual bool GetIsDefinedByParameters( void ) const
+    {
+      return false;
+    }
+
   protected:
 
     /** The constructor. */
@@ -16,6 +16,7 @@
 #define __itkDeformationFieldRegulizer_HXX__
 
 #include "itkDeformationFieldRegulizer.h"
+#include <vector>
 
 
 namespace itk
@@ -114,6 +115,41 @@ DeformationFieldRegulizer<TAnyITKTransform>
 } // end TransformPoint()
 
 
+/**
+ * *********************** TransformPoints ***********************
+ */
+
+template <class TAnyITKTransform>
+void
+DeformationFieldRegulizer<TAnyITKTransform>
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  unsigned long numberOfPoints ) const
+{
+  if ( numberOfPoints == 0 )
+  {
+    return;
+  }
+
+  /** Get the outputpoints of any ITK Transform and the deformation field. */
+  std::vector< OutputPointType > oppDF( numberOfPoints );
+  this->Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+  this->m_IntermediaryDeformationFieldTransform->TransformPoints(
+    inputPoints, &( oppDF[ 0 ] ), numberOfPoints );
+
+  /** Add them: don't forget to subtract ipp. */
+  for ( unsigned long i = 0; i < numberOfPoints; ++i )
+  {
+    for ( unsigned int j = 0; j < OutputSpaceDimension; j++ )
+    {
+      outputPoints[ i ][ j ] += oppDF[ i ][ j ] - inputPoints[ i ][ j ];
+    }
+  }
+
+} // end TransformPoints()
+
+
 /**
  * ******** UpdateIntermediaryDeformationFieldTransform *********
  */
@@ -117,6 +117,12 @@ public:
   itkSetMacro(ComputeZYX,bool);
   itkGetConstMacro(ComputeZYX,bool);
 
+  /** The ComputeZYX setting is not a parameter. */
+  virtual bool GetIsDefinedByParameters( void ) const
+  {
+    return !this->m_ComputeZYX;
+  }
+
   virtual void SetIdentity(void);
 
 
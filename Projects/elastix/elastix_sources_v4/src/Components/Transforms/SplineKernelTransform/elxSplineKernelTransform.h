@@ -68,6 +68,11 @@ namespace elastix
    * Default: 0.3. You cannot specify this parameter for each resolution differently.\n
    * Valid values are withing -1.0 and 0.5. 0.5 means incompressible.
    * Negative values are a bit odd, but possible. See Wikipedia on PoissonRatio.
+   * \parameter SplineMatrixInversionMethod: The method to invert the landmark
+   * system matrix, SVD or QR. QR is faster, but fails if the landmarks are
+   * degenerate, e.g. all lie in one plane in 3D.\n
+   *   example: <tt>(SplineMatrixInversionMethod "QR")</tt>\n
+   * Default: SVD. You cannot specify this parameter for each resolution differently.
    *
    * \commandlinearg -ipp: a file specifying a set of points that will serve
    * as fixed image landmarks.\n
@@ -95,6 +100,19 @@ namespace elastix
    *   example: <tt>(SplinePoissonRatio 0.3 )</tt>\n
    * Valid values are withing -1.0 and 0.5. 0.5 means incompressible.
    * Negative values are a bit odd, but possible. See Wikipedia on PoissonRatio.
+   * \transformparameter SplineMatrixInversionMethod: The method to invert the
+   * landmark system matrix, SVD or QR.\n
+   *   example: <tt>(SplineMatrixInversionMethod "QR")</tt>\n
+   * Default: SVD.
+   * \transformparameter SplineResampleGridSpacing: If larger than 0, the
+   * transform is approximated by a cubic B-spline, which interpolates the
+   * transform on a grid over the image given by Size, Index, Spacing, Origin
+   * and Direction. The grid spacing is given in voxels of this image, and
+   * can be given for each dimension. Points outside the image are transformed
+   * exactly. This makes resampling with many landmarks much faster.\n
+   *   example: <tt>(SplineResampleGridSpacing 2.0)</tt>\n
+   * Default: 0.0, which transforms all points exactly. This parameter is not
+   * written by elastix; add it to the transform parameter file for transformix.
    * \transformparameter FixedImageLandmarks: The landmark positions in the
    * fixed image, in world coordinates. Positions written as x1 y1 [z1] x2 y2 [z2] etc.\n
    *   example: <tt>(FixedImageLandmarks 10.0 11.0 12.0 4.0 4.0 4.0 6.0 6.0 6.0 )</tt>
@@ -218,6 +236,11 @@ protected:
    */
   virtual void DetermineSourceLandmarks( void );
 
+  /** Read the SplineResampleGridSpacing, and if given, approximate the
+   * kernel transform on a grid over the image to be resampled.
+   */
+  virtual void ComputeResampleGrid( void );
+
   KernelTransformPointer m_KernelTransform;
 
 private:
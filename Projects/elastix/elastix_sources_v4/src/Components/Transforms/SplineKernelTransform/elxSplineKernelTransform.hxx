@@ -165,6 +165,12 @@ SplineKernelTransform<TElastix>
     this->m_KernelTransform->SetPoissonRatio( poissonRatio );
   }
 
+  /** The method to invert the L matrix. */
+  std::string matrixInversionMethod = "SVD";
+  this->GetConfiguration()->ReadParameter( matrixInversionMethod,
+    "SplineMatrixInversionMethod", this->GetComponentLabel(), 0, -1 );
+  this->m_KernelTransform->SetMatrixInversionMethod( matrixInversionMethod );
+
   /** Load source landmark positions. */
   this->DetermineSourceLandmarks();
 
@@ -313,6 +319,12 @@ SplineKernelTransform<TElastix>
     poissonRatio, "SplinePoissonRatio", this->GetComponentLabel(), 0, -1 );
   this->m_KernelTransform->SetPoissonRatio( poissonRatio );
 
+  /** The method to invert the L matrix. */
+  std::string matrixInversionMethod = "SVD";
+  this->GetConfiguration()->ReadParameter( matrixInversionMethod,
+    "SplineMatrixInversionMethod", this->GetComponentLabel(), 0, -1 );
+  this->m_KernelTransform->SetMatrixInversionMethod( matrixInversionMethod );
+
   /** Read number of parameters. */
   unsigned int numberOfParameters = 0;
   this->GetConfiguration()->ReadParameter(
@@ -345,9 +357,103 @@ SplineKernelTransform<TElastix>
    */
   this->Superclass2::ReadFromFile();
 
+  /** Approximate the transform for resampling, if asked for. */
+  this->ComputeResampleGrid();
+
 } // ReadFromFile()
 
 
+/**
+ * ************************* ComputeResampleGrid ************************
+ */
+
+template <class TElastix>
+void
+SplineKernelTransform<TElastix>
+::ComputeResampleGrid( void )
+{
+  typedef typename KernelTransformType::GridSizeType      GridSizeType;
+  typedef typename KernelTransformType::GridSpacingType   GridSpacingType;
+  typedef typename KernelTransformType::GridOriginType    GridOriginType;
+  typedef typename KernelTransformType::GridDirectionType GridDirectionType;
+
+  /** Read the grid spacing, in voxels; 0 means no grid. */
+  double gridSpacingFactor[ SpaceDimension ];
+  bool useGrid = false;
+  for ( unsigned int i = 0; i < SpaceDimension; ++i )
+  {
+    gridSpacingFactor[ i ] = 0.0;
+    this->GetConfiguration()->ReadParameter( gridSpacingFactor[ i ],
+      "SplineResampleGridSpacing", i, false );
+    if ( i > 0 && gridSpacingFactor[ i ] == 0.0 )
+    {
+      gridSpacingFactor[ i ] = gridSpacingFactor[ 0 ];
+    }
+    useGrid |= ( gridSpacingFactor[ i ] > 0.0 );
+  }
+  if ( !useGrid )
+  {
+    return;
+  }
+
+  /** Read the image to be resampled, as the ResamplerBase does. */
+  GridSizeType size;
+  GridSpacingType spacing;
+  GridOriginType origin;
+  GridDirectionType direction;
+  direction.SetIdentity();
+  long index[ SpaceDimension ];
+  for ( unsigned int i = 0; i < SpaceDimension; ++i )
+  {
+    size[ i ] = 0;
+    this->GetConfiguration()->ReadParameter( size[ i ], "Size", i );
+    index[ i ] = 0;
+    this->GetConfiguration()->ReadParameter( index[ i ], "Index", i );
+    spacing[ i ] = 1.0;
+    this->GetConfiguration()->ReadParameter( spacing[ i ], "Spacing", i );
+    origin[ i ] = 0.0;
+    this->GetConfiguration()->ReadParameter( origin[ i ], "Origin", i );
+    for ( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      this->GetConfiguration()->ReadParameter( direction( j, i ),
+        "Direction", i * SpaceDimension + j );
+    }
+  }
+  if ( ! this->GetElastix()->GetUseDirectionCosines() )
+  {
+    direction.SetIdentity();
+  }
+
+  /** The grid starts at the first voxel, and covers the last one. */
+  GridSizeType gridSize;
+  GridSpacingType gridSpacing;
+  GridOriginType gridOrigin = origin;
+  for ( unsigned int i = 0; i < SpaceDimension; ++i )
+  {
+    if ( size[ i ] == 0 )
+    {
+      xl::xout["warning"] << "WARNING: SplineResampleGridSpacing is ignored, "
+        << "since the image Size is not given." << std::endl;
+      return;
+    }
+    const double factor = gridSpacingFactor[ i ] > 0.0 ? gridSpacingFactor[ i ] : 1.0;
+    gridSpacing[ i ] = spacing[ i ] * factor;
+    gridSize[ i ] = static_cast<unsigned long>(
+      vcl_ceil( static_cast<double>( size[ i ] - 1 ) / factor ) ) + 1;
+    for ( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      gridOrigin[ i ] += direction( i, j ) * spacing[ j ] * index[ j ];
+    }
+  }
+
+  elxout << "Approximating the SplineKernelTransform on a grid of "
+    << gridSize << " points ..." << std::endl;
+  this->m_KernelTransform->ComputeDisplacementGrid(
+    gridOrigin, gridSpacing, gridSize, direction );
+
+} // end ComputeResampleGrid()
+
+
 /**
  * ************************* WriteToFile ************************
  * Save the kernel type and the source landmarks
@@ -373,6 +479,8 @@ SplineKernelTransform<TElastix>
     << this->m_KernelTransform->GetPoissonRatio() << ")" << std::endl;
   xl::xout["transpar"] << "(SplineRelaxationFactor "
     << this->m_KernelTransform->GetStiffness() << ")" << std::endl;
+  xl::xout["transpar"] << "(SplineMatrixInversionMethod \""
+    << this->m_KernelTransform->GetMatrixInversionMethod() << "\")" << std::endl;
 
   /** Write the fixed image landmarks. */
   const ParametersType & fixedParams = this->m_KernelTransform->GetFixedParameters();
@@ -121,6 +121,7 @@ protected:
    * \f$\alpha = 12 ( 1 - \nu ) - 1\f$, \f$\nu\f$ is Poisson's Ratio,
    * \f$ r(x) = \sqrt{ x_1^2 + x_2^2 + x_3^2 } \f$ and
    * \f$I\f$ is the identity matrix.
+   * Reentrant: only reads m_Alpha.
    */
   void ComputeG(const InputVectorType& x, GMatrixType & GMatrix) const;
 
@@ -18,17 +18,22 @@ PURPOSE.  See the above copyright notices for more information.
 #define __itkKernelTransform2_h
 
 #include "itkAdvancedTransform.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkMultiThreader.h"
 #include "itkPoint.h"
 #include "itkVector.h"
 #include "itkMatrix.h"
 #include "itkPointSet.h"
 #include <deque>
+#include <vector>
+#include <string>
 #include <math.h>
 #include "vnl/vnl_matrix_fixed.h"
 #include "vnl/vnl_matrix.h"
 #include "vnl/vnl_vector.h"
 #include "vnl/vnl_vector_fixed.h"
 #include "vnl/algo/vnl_svd.h"
+#include "vnl/algo/vnl_qr.h"
 #include "vnl/vnl_sample.h"
 
 namespace itk
@@ -66,6 +71,31 @@ namespace itk
   * - make it inherit from AdvancedTransform
   * - make it threadsafe, like was done in the itk as well.
   *
+  * The inverse of the L matrix is computed once, when the source landmarks
+  * are set, and is reused to compute W when the target landmarks (the
+  * parameters) change. The inverse is computed with an SVD, which is robust
+  * to degenerate landmark configurations, or with a faster QR decomposition;
+  * see SetMatrixInversionMethod(). L is symmetric, but not positive definite,
+  * so a Cholesky decomposition can not be used. The K matrix is computed
+  * multi-threaded.
+  *
+  * Transforming a point costs a kernel evaluation per landmark. For resampling
+  * large images with many landmarks, ComputeDisplacementGrid() approximates
+  * the transform by a cubic B-spline, which interpolates the displacements
+  * at the points of a regular grid.
+  *
+  * TransformPoints() is used for point sets: by transformix -def, and by
+  * ComputeDisplacementGrid(). The resampler (an itk::ResampleImageFilter)
+  * and the deformation field of transformix call TransformPoint() for each
+  * voxel, from their own threads. For them only the grid approximation
+  * helps; in elastix it is enabled with the SplineResampleGridSpacing
+  * transform parameter.
+  *
+  * ComputeK() and TransformPoints() call ComputeG() and
+  * ComputeDeformationContribution() from several threads at the same time.
+  * Subclasses must therefore implement them reentrantly: they may read the
+  * members, but not modify them or any other shared state.
+  *
   * \ingroup Transforms
   *
   */
@@ -174,6 +204,14 @@ public:
   /** Compute the position of point in the new space */
   virtual OutputPointType TransformPoint( const InputPointType & thisPoint ) const;
 
+  /** Transform a batch of points, multi-threaded. Not used by the
+   * resampler, which calls TransformPoint(); see the class description.
+   */
+  virtual void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    unsigned long numberOfPoints ) const;
+
   /** Compute the Jacobian of the transformation at one point. */
   virtual const JacobianType & GetJacobian( const InputPointType & point ) const;
 
@@ -225,9 +263,66 @@ public:
     this->m_LMatrixComputed = false;
     this->m_LInverseComputed = false;
     this->m_WMatrixComputed = false;
+    this->m_DisplacementGridTransform = 0;
   }
   itkGetMacro( Stiffness, double );
 
+  /** The method to compute the inverse of the L matrix: "SVD" (default) or
+   * "QR". The QR decomposition is several times faster, but fails for
+   * degenerate landmark configurations, such as landmarks that all lie in
+   * one plane in 3D, for which the SVD computes a pseudo-inverse.
+   */
+  virtual void SetMatrixInversionMethod( const std::string & method )
+  {
+    if ( this->m_MatrixInversionMethod != method )
+    {
+      this->m_MatrixInversionMethod = method;
+      this->m_LInverseComputed = false;
+      this->m_WMatrixComputed = false;
+      this->m_DisplacementGridTransform = 0;
+      this->Modified();
+    }
+  }
+  itkGetStringMacro( MatrixInversionMethod );
+
+  /** Typedefs for the approximation of the transform on a grid. */
+  typedef AdvancedBSplineDeformableTransform<
+    TScalarType, NDimensions, 3 >                           DisplacementGridTransformType;
+  typedef typename DisplacementGridTransformType::Pointer   DisplacementGridTransformPointer;
+  typedef typename DisplacementGridTransformType::ImageType GridImageType;
+  typedef typename DisplacementGridTransformType::ImagePointer GridImagePointer;
+  typedef typename DisplacementGridTransformType::RegionType GridRegionType;
+  typedef typename DisplacementGridTransformType::SizeType  GridSizeType;
+  typedef typename DisplacementGridTransformType::SpacingType GridSpacingType;
+  typedef typename DisplacementGridTransformType::OriginType GridOriginType;
+  typedef typename DisplacementGridTransformType::DirectionType GridDirectionType;
+
+  /** Approximate the transform on a domain, given by the origin, size,
+   * spacing and direction of a grid, for example that of an image to be
+   * resampled. The transform is computed at the grid points, and a cubic
+   * B-spline that interpolates these displacements is used by TransformPoint()
+   * for points within the domain. Points outside the domain are transformed
+   * exactly. The approximation is removed when the landmarks or settings
+   * change, and by ClearDisplacementGrid().
+   */
+  virtual void ComputeDisplacementGrid(
+    const GridOriginType & origin,
+    const GridSpacingType & spacing,
+    const GridSizeType & size,
+    const GridDirectionType & direction );
+
+  /** Remove the approximation of the transform on a grid. */
+  virtual void ClearDisplacementGrid( void )
+  {
+    this->m_DisplacementGridTransform = 0;
+  }
+
+  /** Get the B-spline that approximates the transform; 0 if not computed. */
+  virtual const DisplacementGridTransformType * GetDisplacementGridTransform( void ) const
+  {
+    return this->m_DisplacementGridTransform.GetPointer();
+  }
+
   /** This method makes only sense for the ElasticBody splines.
    * Declare here, so that you can always call it if you don't know
    * the type of kernel beforehand. It will be overridden in the
@@ -302,6 +397,8 @@ protected:
    *    Elastic body spline
    *    Thin plate spline
    *    Volume spline.
+   * Must be reentrant, since ComputeK() and TransformPoints() call it
+   * concurrently.
    */
   virtual void ComputeG( const InputVectorType & landmarkVector,
     GMatrixType & GMatrix ) const;
@@ -316,15 +413,46 @@ protected:
   virtual void ComputeReflexiveG( PointsIterator, GMatrixType & GMatrix ) const;
 
   /** Compute the contribution of the landmarks weighted by the kernel
-   * function to the global deformation of the space.
+   * function to the global deformation of the space. Must be reentrant,
+   * since TransformPoints() calls it concurrently.
    */
   virtual void ComputeDeformationContribution(
     const InputPointType & inputPoint,
     OutputPointType & result ) const;
 
-  /** Compute K matrix. */
+  /** Compute K matrix. The off-diagonal blocks are computed multi-threaded. */
   void ComputeK( void );
 
+  /** Typedefs for multi-threading. */
+  typedef MultiThreader                     ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct    ThreadInfoType;
+
+  /** The data that is passed to the threads of ComputeK(). */
+  struct ComputeKThreaderParameterType
+  {
+    Self *                                st_Self;
+    const std::vector<InputPointType> *   st_Landmarks;
+  };
+
+  /** The data that is passed to the threads of TransformPoints(). */
+  struct TransformPointsThreaderParameterType
+  {
+    const Self *          st_Self;
+    const InputPointType * st_InputPoints;
+    OutputPointType *     st_OutputPoints;
+    unsigned long         st_NumberOfPoints;
+  };
+
+  /** Compute the off-diagonal blocks of the rows threadID,
+   * threadID + numberOfThreads, ... of the K matrix.
+   */
+  void ThreadedComputeK( unsigned int threadID, unsigned int numberOfThreads,
+    const std::vector<InputPointType> & landmarks );
+
+  /** The threader callbacks. */
+  static ITK_THREAD_RETURN_TYPE ComputeKThreaderCallback( void * arg );
+  static ITK_THREAD_RETURN_TYPE TransformPointsThreaderCallback( void * arg );
+
   /** Compute L matrix. */
   void ComputeL( void );
 
@@ -405,6 +533,12 @@ protected:
   /** for old GetJacobian() method: */
   mutable NonZeroJacobianIndicesType m_NonZeroJacobianIndicesTemp;
 
+  /** The method to compute the inverse of L. */
+  std::string m_MatrixInversionMethod;
+
+  /** The B-spline that approximates the transform, if computed. */
+  DisplacementGridTransformPointer m_DisplacementGridTransform;
+
 private:
   KernelTransform2(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
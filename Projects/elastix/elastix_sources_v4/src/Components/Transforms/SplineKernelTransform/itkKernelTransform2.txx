@@ -17,6 +17,8 @@ PURPOSE.  See the above copyright notices for more information.
 #ifndef _itkKernelTransform2_txx
 #define _itkKernelTransform2_txx
 #include "itkKernelTransform2.h"
+#include "itkBSplineDecompositionImageFilter.h"
+#include "vnl/vnl_math.h"
 
 namespace itk
 {
@@ -43,6 +45,8 @@ KernelTransform2<TScalarType, NDimensions>
   this->m_LInverseComputed = false;
 
   this->m_Stiffness = 0.0;
+  this->m_MatrixInversionMethod = "SVD";
+  this->m_DisplacementGridTransform = 0;
 
   // dummy value:
   this->m_PoissonRatio = 0.3;
@@ -61,6 +65,7 @@ KernelTransform2<TScalarType, NDimensions>
   if ( this->m_SourceLandmarks != landmarks )
   {
     this->m_SourceLandmarks = landmarks;
+    this->m_DisplacementGridTransform = 0;
     this->UpdateParameters();
     this->Modified();
 
@@ -96,6 +101,7 @@ KernelTransform2<TScalarType, NDimensions>
   if ( this->m_TargetLandmarks != landmarks )
   {
     this->m_TargetLandmarks = landmarks;
+    this->m_DisplacementGridTransform = 0;
 
     // this is invalidated when the target landmarks change
     this->m_WMatrixComputed = false;
@@ -204,15 +210,16 @@ void
 KernelTransform2<TScalarType, NDimensions>
 ::ComputeWMatrix( void )
 {
-  typedef vnl_svd<TScalarType>  SVDSolverType;
-  if ( !this->m_LMatrixComputed )
+  /** The inverse of L only depends on the source landmarks, so it is
+   * computed once, and W = L^-1 Y is then a matrix-vector product.
+   */
+  if ( !this->m_LInverseComputed )
   {
-    this->ComputeL();
+    this->ComputeLInverse();
   }
 
   this->ComputeY();
-  SVDSolverType svd( this->m_LMatrix, 1e-8 );
-  this->m_WMatrix = svd.solve( this->m_YMatrix );
+  this->m_WMatrix = this->m_LMatrixInverse * this->m_YMatrix;
   this->ReorganizeW();
   this->m_WMatrixComputed = true;
 
@@ -229,7 +236,23 @@ KernelTransform2<TScalarType, NDimensions>
 ::ComputeLInverse( void )
 {
   if ( !this->m_LMatrixComputed ) this->ComputeL();
-  this->m_LMatrixInverse = vnl_matrix_inverse<TScalarType>( this->m_LMatrix );
+
+  if ( this->m_MatrixInversionMethod == "QR" )
+  {
+    vnl_qr<TScalarType> qr( this->m_LMatrix );
+    this->m_LMatrixInverse = qr.inverse();
+  }
+  else if ( this->m_MatrixInversionMethod == "SVD" )
+  {
+    /** Singular values smaller than 1e-8 are ignored. */
+    vnl_svd<TScalarType> svd( this->m_LMatrix, 1e-8 );
+    this->m_LMatrixInverse = svd.inverse();
+  }
+  else
+  {
+    itkExceptionMacro( << "Unknown MatrixInversionMethod: "
+      << this->m_MatrixInversionMethod << ". Choose SVD or QR." );
+  }
   this->m_LInverseComputed = true;
 
 } // end ComputeLInverse()
@@ -282,33 +305,82 @@ KernelTransform2<TScalarType, NDimensions>
   PointsIterator p1  = this->m_SourceLandmarks->GetPoints()->Begin();
   PointsIterator end = this->m_SourceLandmarks->GetPoints()->End();
 
-  // K matrix is symmetric, so only evaluate the upper triangle and
-  // store the values in bot the upper and lower triangle
+  // Compute the block diagonal elements, i.e. kernel for pi->pi,
+  // and copy the landmarks for random access by the threads
+  std::vector<InputPointType> landmarks( numberOfLandmarks );
   unsigned int i = 0;
   while ( p1 != end )
   {
-    PointsIterator p2 = p1; // start at the diagonal element
-    unsigned int j = i;
-
-    // Compute the block diagonal element, i.e. kernel for pi->pi
     this->ComputeReflexiveG( p1, G );
     this->m_KMatrix.update( G, i * NDimensions, i * NDimensions );
-    p2++; j++;
+    landmarks[ i ] = p1.Value();
+    p1++; i++;
+  }
+
+  // Compute the off-diagonal blocks multi-threaded
+  ComputeKThreaderParameterType temp;
+  temp.st_Self = this;
+  temp.st_Landmarks = &landmarks;
+
+  typename ThreaderType::Pointer threader = ThreaderType::New();
+  threader->SetNumberOfThreads( vnl_math_max( 1UL, vnl_math_min(
+    static_cast<unsigned long>( threader->GetNumberOfThreads() ), numberOfLandmarks ) ) );
+  threader->SetSingleMethod( ComputeKThreaderCallback, &temp );
+  threader->SingleMethodExecute();
+
+} // end ComputeK()
+
+
+/**
+ * ******************* ThreadedComputeK *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>
+::ThreadedComputeK( unsigned int threadID, unsigned int numberOfThreads,
+  const std::vector<InputPointType> & landmarks )
+{
+  const unsigned long numberOfLandmarks = landmarks.size();
+  GMatrixType G;
 
-    // Compute the upper (and copy into lower) triangular part of K
-    while ( p2 != end )
+  // K matrix is symmetric, so only evaluate the upper triangle and
+  // store the values in both the upper and lower triangle. The rows are
+  // interleaved over the threads, which balances the work, and each
+  // block is written by one thread only.
+  for ( unsigned long i = threadID; i < numberOfLandmarks; i += numberOfThreads )
+  {
+    for ( unsigned long j = i + 1; j < numberOfLandmarks; ++j )
     {
-      const InputVectorType s = p1.Value() - p2.Value();
+      const InputVectorType s = landmarks[ i ] - landmarks[ j ];
       this->ComputeG( s, G );
-      // write value in upper and lower triangle of matrix
       this->m_KMatrix.update( G, i * NDimensions, j * NDimensions );
       this->m_KMatrix.update( G, j * NDimensions, i * NDimensions );
-      p2++; j++;
     }
-    p1++; i++;
   }
 
-} // end ComputeK()
+} // end ThreadedComputeK()
+
+
+/**
+ * ******************* ComputeKThreaderCallback *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+ITK_THREAD_RETURN_TYPE
+KernelTransform2<TScalarType, NDimensions>
+::ComputeKThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ComputeKThreaderParameterType * temp
+    = static_cast< ComputeKThreaderParameterType * >( infoStruct->UserData );
+
+  temp->st_Self->ThreadedComputeK( infoStruct->ThreadID,
+    infoStruct->NumberOfThreads, *temp->st_Landmarks );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeKThreaderCallback()
 
 
 /**
@@ -431,6 +503,28 @@ typename KernelTransform2<TScalarType, NDimensions>::OutputPointType
 KernelTransform2<TScalarType, NDimensions>
 ::TransformPoint( const InputPointType & thisPoint ) const
 {
+  /** Use the approximation on the grid, if the point lies within it. */
+  if ( this->m_DisplacementGridTransform.IsNotNull() )
+  {
+    typedef typename DisplacementGridTransformType::WeightsType             WeightsType;
+    typedef typename DisplacementGridTransformType::ParameterIndexArrayType IndicesType;
+    const unsigned long numberOfWeights
+      = DisplacementGridTransformType::WeightsFunctionType::NumberOfWeights;
+    typename WeightsType::ValueType weightsArray[ numberOfWeights ];
+    typename IndicesType::ValueType indicesArray[ numberOfWeights ];
+    WeightsType weights( weightsArray, numberOfWeights, false );
+    IndicesType indices( indicesArray, numberOfWeights, false );
+
+    OutputPointType gridPoint;
+    bool inside = false;
+    this->m_DisplacementGridTransform->TransformPoint(
+      thisPoint, gridPoint, weights, indices, inside );
+    if ( inside )
+    {
+      return gridPoint;
+    }
+  }
+
   OutputPointType opp;
   opp.Fill( NumericTraits<typename OutputPointType::ValueType>::Zero );
   this->ComputeDeformationContribution( thisPoint, opp );
@@ -455,6 +549,149 @@ KernelTransform2<TScalarType, NDimensions>
 } // end TransformPoint()
 
 
+/**
+ * ******************* TransformPoints *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  unsigned long numberOfPoints ) const
+{
+  /** Each point costs a kernel evaluation per landmark, so the points are
+   * divided over the threads in contiguous chunks. A chunk should at least
+   * contain a few points, to be worth the thread.
+   */
+  TransformPointsThreaderParameterType temp;
+  temp.st_Self = this;
+  temp.st_InputPoints = inputPoints;
+  temp.st_OutputPoints = outputPoints;
+  temp.st_NumberOfPoints = numberOfPoints;
+
+  typename ThreaderType::Pointer threader = ThreaderType::New();
+  threader->SetNumberOfThreads( vnl_math_max( 1UL, vnl_math_min(
+    static_cast<unsigned long>( threader->GetNumberOfThreads() ), numberOfPoints / 16 ) ) );
+  threader->SetSingleMethod( TransformPointsThreaderCallback, &temp );
+  threader->SingleMethodExecute();
+
+} // end TransformPoints()
+
+
+/**
+ * ******************* TransformPointsThreaderCallback *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+ITK_THREAD_RETURN_TYPE
+KernelTransform2<TScalarType, NDimensions>
+::TransformPointsThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  const unsigned long threadID = infoStruct->ThreadID;
+  const unsigned long numberOfThreads = infoStruct->NumberOfThreads;
+  TransformPointsThreaderParameterType * temp
+    = static_cast< TransformPointsThreaderParameterType * >( infoStruct->UserData );
+
+  /** The chunk of this thread. */
+  const unsigned long chunkSize
+    = ( temp->st_NumberOfPoints + numberOfThreads - 1 ) / numberOfThreads;
+  const unsigned long begin = vnl_math_min( threadID * chunkSize, temp->st_NumberOfPoints );
+  const unsigned long end = vnl_math_min( begin + chunkSize, temp->st_NumberOfPoints );
+
+  for ( unsigned long i = begin; i < end; ++i )
+  {
+    temp->st_OutputPoints[ i ] = temp->st_Self->TransformPoint( temp->st_InputPoints[ i ] );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end TransformPointsThreaderCallback()
+
+
+/**
+ * ******************* ComputeDisplacementGrid *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>
+::ComputeDisplacementGrid(
+  const GridOriginType & origin,
+  const GridSpacingType & spacing,
+  const GridSizeType & size,
+  const GridDirectionType & direction )
+{
+  /** The grid points are transformed exactly. */
+  this->m_DisplacementGridTransform = 0;
+
+  /** Extend the grid by two points on each side, such that the support
+   * of the cubic B-spline lies within the grid for the whole domain.
+   */
+  GridSizeType gridSize;
+  GridOriginType gridOrigin = origin;
+  for ( unsigned int i = 0; i < NDimensions; ++i )
+  {
+    gridSize[ i ] = size[ i ] + 4;
+    for ( unsigned int j = 0; j < NDimensions; ++j )
+    {
+      gridOrigin[ i ] -= direction( i, j ) * 2.0 * spacing[ j ];
+    }
+  }
+  GridRegionType gridRegion;
+  gridRegion.SetSize( gridSize );
+
+  /** Create the displacement images, one per dimension. */
+  GridImagePointer images[ NDimensions ];
+  for ( unsigned int d = 0; d < NDimensions; ++d )
+  {
+    images[ d ] = GridImageType::New();
+    images[ d ]->SetRegions( gridRegion );
+    images[ d ]->SetOrigin( gridOrigin );
+    images[ d ]->SetSpacing( spacing );
+    images[ d ]->SetDirection( direction );
+    images[ d ]->Allocate();
+  }
+
+  /** Transform the grid points, in the order of the image buffer. */
+  const unsigned long numberOfGridPoints = gridRegion.GetNumberOfPixels();
+  std::vector<InputPointType> gridPoints( numberOfGridPoints );
+  std::vector<OutputPointType> transformedGridPoints( numberOfGridPoints );
+  for ( unsigned long i = 0; i < numberOfGridPoints; ++i )
+  {
+    images[ 0 ]->TransformIndexToPhysicalPoint(
+      images[ 0 ]->ComputeIndex( i ), gridPoints[ i ] );
+  }
+  this->TransformPoints( &gridPoints[ 0 ], &transformedGridPoints[ 0 ], numberOfGridPoints );
+
+  /** Compute the B-spline coefficients that interpolate the displacements. */
+  typedef BSplineDecompositionImageFilter<
+    GridImageType, GridImageType >                      DecompositionFilterType;
+  for ( unsigned int d = 0; d < NDimensions; ++d )
+  {
+    typename GridImageType::PixelType * displacements = images[ d ]->GetBufferPointer();
+    for ( unsigned long i = 0; i < numberOfGridPoints; ++i )
+    {
+      displacements[ i ] = transformedGridPoints[ i ][ d ] - gridPoints[ i ][ d ];
+    }
+
+    typename DecompositionFilterType::Pointer decomposition
+      = DecompositionFilterType::New();
+    decomposition->SetSplineOrder( 3 );
+    decomposition->SetInput( images[ d ] );
+    decomposition->Update();
+    images[ d ] = decomposition->GetOutput();
+  }
+
+  DisplacementGridTransformPointer gridTransform = DisplacementGridTransformType::New();
+  gridTransform->SetCoefficientImage( images );
+  this->m_DisplacementGridTransform = gridTransform;
+
+} // end ComputeDisplacementGrid()
+
+
 // Compute the Jacobian in one position
 
 template <class TScalarType, unsigned int NDimensions>
@@ -512,6 +749,7 @@ KernelTransform2<TScalarType, NDimensions>
   }
 
   this->m_TargetLandmarks->SetPoints( landmarks );
+  this->m_DisplacementGridTransform = 0;
 
   // W MUST be recomputed if the target lms are set
   this->ComputeWMatrix();
@@ -555,6 +793,7 @@ KernelTransform2<TScalarType, NDimensions>
   }
 
   this->m_SourceLandmarks->SetPoints( landmarks );
+  this->m_DisplacementGridTransform = 0;
 
   // these are invalidated when the source lms change
   this->m_WMatrixComputed = false;
@@ -711,6 +950,9 @@ KernelTransform2<TScalarType, NDimensions>
     this->m_Displacements->Print( os, indent.GetNextIndent() );
   }
   os << indent << "Stiffness: " << m_Stiffness << std::endl;
+  os << indent << "MatrixInversionMethod: " << this->m_MatrixInversionMethod << std::endl;
+  os << indent << "DisplacementGridTransform: "
+    << this->m_DisplacementGridTransform.GetPointer() << std::endl;
 
 } // end PrintSelf()
 
@@ -87,7 +87,8 @@ protected:
    * where
    * r(x) = Euclidean norm = sqrt[x1^2 + x2^2 + x3^2]
    * \f[ r(x) = \sqrt{ x_1^2 + x_2^2 + x_3^2 }  \f]
-   * I = identity matrix. */
+   * I = identity matrix.
+   * Reentrant: depends on x only. */
   void ComputeG(const InputVectorType & x, GMatrixType & GMatrix) const;
 
 
@@ -218,6 +218,9 @@ public:
    */
   virtual bool IsLinear() const { return true; }
 
+  /** The offset follows from the parameters. */
+  virtual bool GetIsDefinedByParameters( void ) const { return true; }
+
  /** Set the fixed parameters and update internal transformation.
    * The Translation Transform does not require fixed parameters,
    * therefore the implementation of this method is a null operation. */
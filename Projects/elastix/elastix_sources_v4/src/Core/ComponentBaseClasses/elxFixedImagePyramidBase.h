@@ -48,6 +48,22 @@ using namespace itk;
    * \parameter WritePyramidImagesAfterEachResolution: ...\n
    *    example: <tt>(WritePyramidImagesAfterEachResolution "true")</tt>\n
    *    default "false".
+   * \parameter ComputePyramidImagesPerResolution: whether the pyramid images are
+   *    computed just before each resolution, instead of all at once before the
+   *    registration starts. This way only the images of one resolution are in
+   *    memory at a time. Pyramids that do not support this (the recursive pyramid,
+   *    which derives each level from the previous one) compute all levels at once.\n
+   *    example: <tt>(ComputePyramidImagesPerResolution "true")</tt>\n
+   *    default "false".
+   * \parameter ReusePyramidImages: whether the pyramid images are kept for the
+   *    registration with the next parameter file. If that registration uses the same
+   *    pyramid, schedule and input image, and also sets this parameter, the images
+   *    are not computed again. The kept images remain in memory until the next
+   *    registration. Ignored if ComputePyramidImagesPerResolution is "true".
+   *    Always "true" for the fixed image pyramid when elastix is run with
+   *    -mlist, so that the pyramid is computed once for all moving images.\n
+   *    example: <tt>(ReusePyramidImages "true")</tt>\n
+   *    default "false".
    *
    * \ingroup ImagePyramids
    * \ingroup ComponentBaseClasses
@@ -102,10 +118,35 @@ public:
   virtual void BeforeRegistrationBase( void );
 
   /** Execute stuff before each resolution:
+   * \li Compute the pyramid images of this resolution, if they are computed
+   * per resolution.
    * \li Write the pyramid image to file.
    */
   virtual void BeforeEachResolutionBase( void );
 
+  /** Returns whether the pyramid can compute the images of only one
+   * resolution level. Pyramids that can, override this function and
+   * SetComputePerResolution(). Default: false. */
+  virtual bool ComputingPerResolutionSupported( void ) const
+  {
+    return false;
+  }
+
+  /** Let the pyramid compute only the images of the given level, or all
+   * levels at once. Only called if ComputingPerResolutionSupported(). */
+  virtual void SetComputePerResolution( bool itkNotUsed( perResolution ),
+    unsigned int itkNotUsed( level ) ) {};
+
+  /** Graft the images of a previous registration onto the outputs of the
+   * pyramid, if ReusePyramidImages is set and they match the input and the
+   * schedule. Returns false otherwise. Called in the GenerateData() of the
+   * pyramids, before computing the images. */
+  virtual bool GraftCachedPyramidImages( void );
+
+  /** Keep the computed images for the next registration, if
+   * ReusePyramidImages is set. Called in the GenerateData() of the pyramids. */
+  virtual void StorePyramidImagesInCache( void );
+
   /** Method for setting the schedule. */
   virtual void SetFixedSchedule( void );
 
@@ -116,7 +157,11 @@ public:
 protected:
 
   /** The constructor. */
-  FixedImagePyramidBase() {}
+  FixedImagePyramidBase()
+  {
+    this->m_ComputePyramidImagesPerResolution = false;
+    this->m_ReusePyramidImages = false;
+  }
   /** The destructor. */
   virtual ~FixedImagePyramidBase() {}
 
@@ -127,6 +172,18 @@ private:
   /** The private copy constructor. */
   void operator=( const Self& );        // purposely not implemented
 
+  /** Whether the images are computed per resolution. */
+  bool m_ComputePyramidImagesPerResolution;
+
+  /** Whether the images are reused from and kept for other registrations. */
+  bool m_ReusePyramidImages;
+
+  /** The name of the images of this pyramid in the ImagePyramidCache. */
+  std::string GetPyramidCacheName( void ) const
+  {
+    return std::string( this->GetComponentLabel() ) + "." + this->elxGetClassName();
+  }
+
 }; // end class FixedImagePyramidBase
 
 
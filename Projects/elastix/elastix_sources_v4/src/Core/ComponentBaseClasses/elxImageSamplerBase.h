@@ -33,6 +33,18 @@ namespace elastix
    *
    * This class contains all the common functionality for ImageSamplers.
    *
+   * \parameter UseMultiThreadingForSamplers: Whether the sampler generates
+   *    its samples multi-threaded, if it supports this. The number of threads
+   *    is determined by the -threads command line argument. Can be given for
+   *    each resolution. \n
+   *    example: <tt>(UseMultiThreadingForSamplers "true")</tt> \n
+   *    The default is false.
+   * \parameter RandomSeed: The seed of the random number streams that the
+   *    random samplers use when UseMultiThreadingForSamplers is true. The
+   *    samples then only depend on the seed, not on the number of threads. \n
+   *    example: <tt>(RandomSeed 121212)</tt> \n
+   *    The default is 0.
+   *
    * \ingroup ImageSamplers
    * \ingroup ComponentBaseClasses
    */
@@ -78,6 +90,7 @@ namespace elastix
     /** Execute stuff before each resolution:
      * \li Give a warning when NewSamplesEveryIteration is specified,
      * but the sampler is ignoring it.
+     * \li Read UseMultiThreadingForSamplers and RandomSeed.
      */
     virtual void BeforeEachResolutionBase(void);
 
@@ -53,6 +53,22 @@ ImageSamplerBase<TElastix>
     }
   }
 
+  /** Should the sampler use multi-threading, if it supports it? */
+  bool useMultiThreading = false;
+  this->GetConfiguration()->ReadParameter( useMultiThreading,
+    "UseMultiThreadingForSamplers", this->GetComponentLabel(), level, 0 );
+  this->GetAsITKBaseType()->SetUseMultiThread( useMultiThreading );
+
+  /** The seed of the random streams. It is set only once, in the first
+   * resolution, so that every resolution gets new sample sets. */
+  if ( level == 0 )
+  {
+    unsigned int randomSeed = 0;
+    this->GetConfiguration()->ReadParameter( randomSeed,
+      "RandomSeed", this->GetComponentLabel(), 0, 0 );
+    this->GetAsITKBaseType()->SetRandomSeed( randomSeed );
+  }
+
 } // end BeforeEachResolutionBase()
 
 } // end namespace elastix
@@ -22,6 +22,8 @@
 #include "itkAdvancedImageToImageMetric.h"
 #include "itkImageFullSampler.h"
 #include "itkPointSet.h"
+#include "itkCommand.h"
+#include <string>
 
 #include "elxTimer.h"
 
@@ -53,6 +55,18 @@ using namespace itk;
    *    CheckNumberOfSamples. \n
    *    example: <tt>(RequiredRatioOfValidSamples 0.1)</tt> \n
    *    The default is 0.25.
+   * \parameter UseMultiThreadingForMetrics: Whether the metric computes its
+   *    value and derivative multi-threaded, if it supports this. The number
+   *    of threads is determined by the -threads command line argument. \n
+   *    example: <tt>(UseMultiThreadingForMetrics "true")</tt> \n
+   *    The default is false.
+   * \parameter UsePackedMovingImage: Whether the metric evaluates the moving
+   *    image value and derivative by linear interpolation of an image that
+   *    stores each voxel's value and gradient together. This is fast, but
+   *    replaces the moving image interpolator (also a B-spline interpolator)
+   *    by linear interpolation. Can be given for each resolution. \n
+   *    example: <tt>(UsePackedMovingImage "true" "true" "false")</tt> \n
+   *    The default is false.
    *
    * \ingroup Metrics
    * \ingroup ComponentBaseClasses
@@ -161,6 +175,25 @@ public:
    */
   virtual ImageSamplerBaseType * GetAdvancedMetricImageSampler( void ) const;
 
+  /** Create numberOfCopies independent copies of the metric, that can
+   * compute their value in other threads at the same time as this metric.
+   * Used by optimizers that evaluate several positions concurrently. The
+   * threads of the metric are divided among the metric and the copies.
+   * The default implementation uses
+   * AdvancedImageToImageMetric::CreateConcurrentCopies(). If the metric or
+   * its transform can not be copied, copies is left empty, false is
+   * returned, and reason tells why.
+   */
+  virtual bool CreateConcurrentCopies( unsigned int numberOfCopies,
+    std::vector< typename ITKBaseType::Pointer > & copies, std::string & reason );
+
+  /** Create a command that calls
+   * AdvancedImageToImageMetric::PrepareConcurrentEvaluation() of this
+   * metric, to pass to ConcurrentCostFunctionEvaluator::SetPrepareCommand().
+   * Returns 0 for other metrics.
+   */
+  virtual Command::Pointer CreatePrepareConcurrentEvaluationCommand( void );
+
 protected:
 
   /** The type returned by the GetValue methods. Used by the GetExactValue method. */
@@ -99,6 +99,18 @@ MetricBase<TElastix>
     {
       thisAsAdvanced->SetRequiredRatioOfValidSamples( ratio );
     }
+
+    /** Should the metric use multi-threading, if it supports it? */
+    bool useMultiThreading = false;
+    this->GetConfiguration()->ReadParameter( useMultiThreading,
+      "UseMultiThreadingForMetrics", this->GetComponentLabel(), level, 0 );
+    thisAsAdvanced->SetUseMultiThread( useMultiThreading );
+
+    /** Should the metric use the packed moving image value and gradient? */
+    bool usePackedMovingImage = false;
+    this->GetConfiguration()->ReadParameter( usePackedMovingImage,
+      "UsePackedMovingImage", this->GetComponentLabel(), level, 0 );
+    thisAsAdvanced->SetUsePackedMovingImage( usePackedMovingImage );
   } // end Advanced metric
 
 } // end BeforeEachResolutionBase()
@@ -302,6 +314,68 @@ MetricBase<TElastix>
 } // end GetAdvancedMetricImageSampler()
 
 
+/**
+ * ******************* CreateConcurrentCopies ******************
+ */
+
+template <class TElastix>
+bool
+MetricBase<TElastix>
+::CreateConcurrentCopies( unsigned int numberOfCopies,
+  std::vector< typename ITKBaseType::Pointer > & copies, std::string & reason )
+{
+  copies.clear();
+
+  /** Cast this to AdvancedMetricType. */
+  const AdvancedMetricType * thisAsAdvanced
+    = dynamic_cast< const AdvancedMetricType * >( this );
+
+  /** Only the advanced metrics know how to copy themselves. */
+  if ( thisAsAdvanced == 0 )
+  {
+    reason = "the metric is not an AdvancedImageToImageMetric";
+    return false;
+  }
+  typename AdvancedMetricType::ConcurrentCopyContainerType advancedCopies;
+  if ( !thisAsAdvanced->CreateConcurrentCopies( numberOfCopies, advancedCopies, reason ) )
+  {
+    return false;
+  }
+  for ( unsigned int i = 0; i < advancedCopies.size(); ++i )
+  {
+    copies.push_back( advancedCopies[ i ].GetPointer() );
+  }
+  return true;
+
+} // end CreateConcurrentCopies()
+
+
+/**
+ * ************** CreatePrepareConcurrentEvaluationCommand ***************
+ */
+
+template <class TElastix>
+Command::Pointer
+MetricBase<TElastix>
+::CreatePrepareConcurrentEvaluationCommand( void )
+{
+  /** Cast this to AdvancedMetricType. */
+  AdvancedMetricType * thisAsAdvanced
+    = dynamic_cast< AdvancedMetricType * >( this );
+  if ( thisAsAdvanced == 0 )
+  {
+    return 0;
+  }
+
+  typedef SimpleMemberCommand< AdvancedMetricType > PrepareCommandType;
+  typename PrepareCommandType::Pointer command = PrepareCommandType::New();
+  command->SetCallbackFunction( thisAsAdvanced,
+    &AdvancedMetricType::PrepareConcurrentEvaluation );
+  return command.GetPointer();
+
+} // end CreatePrepareConcurrentEvaluationCommand()
+
+
 } // end namespace elastix
 
 
@@ -34,6 +34,37 @@ MovingImagePyramidBase<TElastix>
   /** Call SetMovingSchedule.*/
   this->SetMovingSchedule();
 
+  /** Decide whether the pyramid images are computed per resolution. */
+  this->m_ComputePyramidImagesPerResolution = false;
+  this->m_Configuration->ReadParameter( this->m_ComputePyramidImagesPerResolution,
+    "ComputePyramidImagesPerResolution", this->GetComponentLabel(), 0, 0, false );
+  if ( this->m_ComputePyramidImagesPerResolution
+    && !this->ComputingPerResolutionSupported() )
+  {
+    xl::xout["warning"] << "WARNING: " << this->elxGetClassName()
+      << " does not support ComputePyramidImagesPerResolution.\n"
+      << "  The images of all resolutions are computed at once." << std::endl;
+    this->m_ComputePyramidImagesPerResolution = false;
+  }
+
+  /** Decide whether the images are reused from and kept for the registrations
+   * with the other parameter files. If not, forget the kept images. */
+  this->m_ReusePyramidImages = false;
+  this->m_Configuration->ReadParameter( this->m_ReusePyramidImages,
+    "ReusePyramidImages", this->GetComponentLabel(), 0, 0, false );
+  this->m_ReusePyramidImages &= !this->m_ComputePyramidImagesPerResolution;
+  ImagePyramidCache * cache = this->GetElastix()->GetImagePyramidCache();
+  if ( cache && !this->m_ReusePyramidImages )
+  {
+    cache->RemoveImages( this->GetPyramidCacheName() );
+  }
+
+  /** Start with the first level, before PreparePyramids() updates the pyramid. */
+  if ( this->ComputingPerResolutionSupported() )
+  {
+    this->SetComputePerResolution( this->m_ComputePyramidImagesPerResolution, 0 );
+  }
+
 } // end BeforeRegistrationBase()
 
 
@@ -49,6 +80,14 @@ MovingImagePyramidBase<TElastix>
   /** What is the current resolution level? */
   const unsigned int level = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
 
+  /** Compute the images of this resolution. This releases the images of
+   * the previous resolution. */
+  if ( this->m_ComputePyramidImagesPerResolution )
+  {
+    this->SetComputePerResolution( true, level );
+    this->GetAsITKBaseType()->GetOutput( level )->Update();
+  }
+
   /** Decide whether or not to write the pyramid images this resolution. */
   bool writePyramidImage = false;
   this->m_Configuration->ReadParameter( writePyramidImage,
@@ -89,6 +128,51 @@ MovingImagePyramidBase<TElastix>
 } // end BeforeEachResolutionBase()
 
 
+/**
+ * ******************* GraftCachedPyramidImages *******************
+ */
+
+template <class TElastix>
+bool
+MovingImagePyramidBase<TElastix>
+::GraftCachedPyramidImages( void )
+{
+  ImagePyramidCache * cache = this->GetElastix()->GetImagePyramidCache();
+  if ( !this->m_ReusePyramidImages || cache == 0 )
+  {
+    return false;
+  }
+
+  if ( !cache->GraftImages( this->GetPyramidCacheName(), this->GetAsITKBaseType() ) )
+  {
+    return false;
+  }
+
+  elxout << "Reusing the moving pyramid images of the previous registration for "
+    << this->GetComponentLabel() << "." << std::endl;
+  return true;
+
+} // end GraftCachedPyramidImages()
+
+
+/**
+ * ******************* StorePyramidImagesInCache *******************
+ */
+
+template <class TElastix>
+void
+MovingImagePyramidBase<TElastix>
+::StorePyramidImagesInCache( void )
+{
+  ImagePyramidCache * cache = this->GetElastix()->GetImagePyramidCache();
+  if ( this->m_ReusePyramidImages && cache != 0 )
+  {
+    cache->StoreImages( this->GetPyramidCacheName(), this->GetAsITKBaseType() );
+  }
+
+} // end StorePyramidImagesInCache()
+
+
 /**
  * ********************** SetMovingSchedule **********************
  */
@@ -20,6 +20,10 @@
 
 #include "elxBaseComponentSE.h"
 #include "itkOptimizer.h"
+#include "itkSingleValuedCostFunction.h"
+#include "itkCommand.h"
+#include <vector>
+#include <string>
 
 
 namespace elastix
@@ -42,6 +46,15 @@ using namespace itk;
    *    Choose one from {"true", "false"} for every resolution.\n
    *    example: <tt>(NewSamplesEveryIteration "true" "true" "true")</tt> \n
    *    Default is "false" for every resolution.\n
+   * \parameter NumberOfConcurrentEvaluations: the number of cost function
+   *    evaluations that optimizers which evaluate the cost function at several
+   *    independent positions (such as the CMAEvolutionStrategy) run at the same
+   *    time, each in its own thread, on the metric itself or on one of its
+   *    copies. The threads of the metric are divided among them. Only used with a single
+   *    metric that supports copies; otherwise the evaluations are done one
+   *    after the other.\n
+   *    example: <tt>(NumberOfConcurrentEvaluations 4 4 2)</tt> \n
+   *    Default is 1 for every resolution.\n
    *
    * \ingroup Optimizers
    * \ingroup ComponentBaseClasses
@@ -73,6 +86,10 @@ using namespace itk;
     /** Typedef needed for the SetCurrentPositionPublic function. */
     typedef typename ITKBaseType::ParametersType        ParametersType;
 
+    /** Typedefs for the concurrent evaluation of the cost function. */
+    typedef itk::SingleValuedCostFunction               CostFunctionType;
+    typedef std::vector< CostFunctionType::Pointer >    CostFunctionContainerType;
+
     /** Cast to ITKBaseType. */
     virtual ITKBaseType * GetAsITKBaseType(void)
     {
@@ -114,6 +131,23 @@ using namespace itk;
     /** Check whether the user asked to select new samples every iteration. */
     virtual const bool GetNewSamplesEveryIteration(void) const;
 
+    /** Fill costFunctions with the cost function of the optimizer, followed
+     * by NumberOfConcurrentEvaluations - 1 copies of it, created by the
+     * metric, and set prepareCommand to the command that updates what the
+     * copies share with the metric. The ConcurrentCostFunctionEvaluator
+     * executes that command in the calling thread, and then evaluates the
+     * positions concurrently with the cost function and its copies, which
+     * divide the threads of the metric among them.
+     * costFunctions is left empty, and prepareCommand 0, if
+     * NumberOfConcurrentEvaluations is 1, if the cost function is not a
+     * single metric, or if the metric or its transform does not support
+     * copies. Call after BeforeEachResolutionBase().
+     */
+    virtual void CreateConcurrentCostFunctions(
+      const CostFunctionType * costFunction,
+      CostFunctionContainerType & costFunctions,
+      Command::Pointer & prepareCommand ) const;
+
   private:
 
     /** The private constructor. */
@@ -126,6 +160,9 @@ using namespace itk;
      */
     bool m_NewSamplesEveryIteration;
 
+    /** The number of concurrent cost function evaluations in this resolution. */
+    unsigned int m_NumberOfConcurrentEvaluations;
+
   }; // end class OptimizerBase
 
 
@@ -30,6 +30,7 @@ OptimizerBase<TElastix>
 ::OptimizerBase()
 {
   this->m_NewSamplesEveryIteration = false;
+  this->m_NumberOfConcurrentEvaluations = 1;
 
 } // end Constructor
 
@@ -76,6 +77,11 @@ OptimizerBase<TElastix>
   this->GetConfiguration()->ReadParameter( this->m_NewSamplesEveryIteration,
     "NewSamplesEveryIteration", this->GetComponentLabel(), level, 0 );
 
+  /** Get the number of concurrent cost function evaluations. */
+  this->m_NumberOfConcurrentEvaluations = 1;
+  this->GetConfiguration()->ReadParameter( this->m_NumberOfConcurrentEvaluations,
+    "NumberOfConcurrentEvaluations", this->GetComponentLabel(), level, 0 );
+
 } // end BeforeEachResolutionBase()
 
 
@@ -114,6 +120,57 @@ OptimizerBase<TElastix>
 } // end GetNewSamplesEveryIteration()
 
 
+/**
+ * ****************** CreateConcurrentCostFunctions ********************
+ */
+
+template <class TElastix>
+void
+OptimizerBase<TElastix>
+::CreateConcurrentCostFunctions( const CostFunctionType * costFunction,
+  CostFunctionContainerType & costFunctions,
+  Command::Pointer & prepareCommand ) const
+{
+  costFunctions.clear();
+  prepareCommand = 0;
+  if ( this->m_NumberOfConcurrentEvaluations <= 1 )
+  {
+    return;
+  }
+
+  /** Copies can only be made of a single metric. With more than one metric
+   * the cost function is their combination.
+   */
+  if ( this->GetElastix()->GetNumberOfMetrics() != 1
+    || this->GetElastix()->GetElxMetricBase()->GetAsITKBaseType() != costFunction )
+  {
+    xl::xout["warning"] << "WARNING: NumberOfConcurrentEvaluations is only "
+      << "supported with a single metric.\n"
+      << "  The cost function is evaluated sequentially." << std::endl;
+    return;
+  }
+
+  /** The metric itself does one of the concurrent evaluations. */
+  const unsigned int numberOfCopies = this->m_NumberOfConcurrentEvaluations - 1;
+  CostFunctionContainerType copies;
+  std::string reason;
+  if ( !this->GetElastix()->GetElxMetricBase()->CreateConcurrentCopies(
+    numberOfCopies, copies, reason ) )
+  {
+    xl::xout["warning"] << "WARNING: NumberOfConcurrentEvaluations is not "
+      << "supported, since " << reason << ".\n"
+      << "  The cost function is evaluated sequentially." << std::endl;
+    return;
+  }
+  costFunctions.push_back(
+    this->GetElastix()->GetElxMetricBase()->GetAsITKBaseType() );
+  costFunctions.insert( costFunctions.end(), copies.begin(), copies.end() );
+  prepareCommand
+    = this->GetElastix()->GetElxMetricBase()->CreatePrepareConcurrentEvaluationCommand();
+
+} // end CreateConcurrentCostFunctions()
+
+
 /**
  * ****************** SetSinusScales ********************
  */
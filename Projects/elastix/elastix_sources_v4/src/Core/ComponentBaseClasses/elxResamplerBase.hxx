@@ -123,7 +123,7 @@ ResamplerBase<TElastix>
     /** Print the elapsed time for the resampling. */
     timer->StopTimer();
     elxout << "  Applying transform took "
-      << static_cast<long>( timer->GetElapsedClockSec() )
+      << static_cast<long>( timer->GetElapsedWallClockSec() )
       << " s." << std::endl;
 
   } // end if
@@ -189,7 +189,7 @@ ResamplerBase<TElastix>
     /** Print the elapsed time for the resampling. */
     timer->StopTimer();
     elxout << "  Applying final transform took "
-      << static_cast<long>( timer->GetElapsedClockSec() )
+      << static_cast<long>( timer->GetElapsedWallClockSec() )
       << " s." << std::endl;
   }
   else
@@ -989,11 +989,13 @@ TransformBase<TElastix>
 
   /** Apply the transform. */
   elxout << "  The input points are transformed." << std::endl;
+  if ( nrofpoints > 0 )
+  {
+    this->GetAsITKBaseType()->TransformPoints(
+      &( inputpointvec[ 0 ] ), &( outputpointvec[ 0 ] ), nrofpoints );
+  }
   for ( unsigned int j = 0; j < nrofpoints; j++ )
   {
-    /** Call TransformPoint. */
-    outputpointvec[ j ] = this->GetAsITKBaseType()->TransformPoint( inputpointvec[ j ] );
-
     /** Transform back to index in fixed image domain. */
     dummyImage->TransformPhysicalPointToContinuousIndex(
       outputpointvec[ j ], fixedcindex );
@@ -1548,18 +1550,13 @@ TransformBase<TElastix>
     itkExceptionMacro( << "No valid voxels found to estimate the scales." );
   }
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
-
   /** initialize */
   scales.Fill( 0.0 );
 
   /** Read fixed coordinates and get Jacobian. */
-  for ( iter = begin; iter != end; ++iter )
+  for ( unsigned long pos = 0; pos < nrofsamples; ++pos )
   {
-    const InputPointType & point = (*iter).Value().m_ImageCoordinates;
+    const InputPointType point = sampleContainer->GetImageCoordinates( pos );
     const JacobianType & jacobian = thisITK->GetJacobian( point );
 
     /** Square each element of the Jacobian and add each row
@@ -27,6 +27,7 @@
 #include "elxBaseComponent.h"
 #include "elxComponentDatabase.h"
 #include "elxConfiguration.h"
+#include "elxImagePyramidCache.h"
 #include "itkObject.h"
 #include "itkDataObject.h"
 #include "elxMacro.h"
@@ -159,6 +160,8 @@ public:
   typedef ComponentDatabaseType::Pointer      ComponentDatabasePointer;
   typedef ComponentDatabaseType::IndexType    DBIndexType;
   typedef std::vector<double>                 FlatDirectionCosinesType;
+  typedef ImagePyramidCache                   ImagePyramidCacheType;
+  typedef ImagePyramidCacheType::Pointer      ImagePyramidCachePointer;
 
   /** The itk class that ElastixTemplate is expected to inherit from
    * Of course ElastixTemplate also inherits from this class (ElastixBase).
@@ -231,6 +234,12 @@ public:
   elxSetObjectMacro( FixedMaskContainer, DataObjectContainerType );
   elxSetObjectMacro( MovingMaskContainer, DataObjectContainerType );
 
+  /** Set/Get the cache of pyramid images, shared with the registrations
+   * of the other parameter files. May be 0.
+   */
+  elxGetObjectMacro( ImagePyramidCache, ImagePyramidCacheType );
+  elxSetObjectMacro( ImagePyramidCache, ImagePyramidCacheType );
+
   /** Set/Get The Image FileName containers.
    * Normally, these are filled in the BeforeAllBase function.
    */
@@ -446,6 +455,9 @@ private:
   DataObjectContainerPointer m_FixedMaskContainer;
   DataObjectContainerPointer m_MovingMaskContainer;
 
+  /** The cache of pyramid images. */
+  ImagePyramidCachePointer m_ImagePyramidCache;
+
   /** The image and mask FileNameContainers. */
   FileNameContainerPointer    m_FixedImageFileNameContainer;
   FileNameContainerPointer    m_MovingImageFileNameContainer;
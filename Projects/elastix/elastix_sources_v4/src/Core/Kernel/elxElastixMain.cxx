@@ -27,6 +27,7 @@
 #include "elxElastixMain.h"
 #include "elxMacro.h"
 #include "itkMultiThreader.h"
+#include "itkAsynchronousOutputWriter.h"
 
 
 namespace elastix
@@ -52,6 +53,11 @@ xoutsimple_type g_CoutOnlyXout;
 xoutsimple_type g_LogOnlyXout;
 std::ofstream   g_LogFileStream;
 
+/** The writer of the logfile and std::cout. It is defined after the
+ * logfile, so that it is destructed (and writes its remaining output)
+ * before the logfile is closed. */
+AsynchronousOutputWriter::Pointer g_AsynchronousWriter;
+
 /**
  * ********************* xoutSetup ******************************
  *
@@ -75,13 +81,22 @@ int xoutSetup( const char * logfilename )
     return 1;
   }
 
+  /** Write std::cout and the logfile through a writer, which moves the
+   * writing to a background thread when the UseAsynchronousLogging
+   * parameter is set. Until then it passes everything on directly.
+   */
+  g_AsynchronousWriter = AsynchronousOutputWriter::New();
+  AsynchronousOutputWriter::SetGlobalWriter( g_AsynchronousWriter );
+  std::ostream * logStream = g_AsynchronousWriter->AddOutput( &g_LogFileStream );
+  std::ostream * coutStream = g_AsynchronousWriter->AddOutput( &std::cout );
+
   /** Set std::cout and the logfile as outputs of xout. */
-  returndummy |= xout.AddOutput("log", &g_LogFileStream);
-  returndummy |= xout.AddOutput("cout", &std::cout);
+  returndummy |= xout.AddOutput( "log", logStream );
+  returndummy |= xout.AddOutput( "cout", coutStream );
 
   /** Set outputs of LogOnly and CoutOnly. */
-  returndummy |= g_LogOnlyXout.AddOutput( "log", &g_LogFileStream );
-  returndummy |= g_CoutOnlyXout.AddOutput( "cout", &std::cout );
+  returndummy |= g_LogOnlyXout.AddOutput( "log", logStream );
+  returndummy |= g_CoutOnlyXout.AddOutput( "cout", coutStream );
 
   /** Copy the outputs to the warning-, error- and standard-xouts. */
   g_WarningXout.SetOutputs( xout.GetCOutputs() );
@@ -268,6 +283,9 @@ int ElastixMain::Run( void )
   this->GetElastixBase()->SetFixedMaskContainer( this->GetFixedMaskContainer() );
   this->GetElastixBase()->SetMovingMaskContainer( this->GetMovingMaskContainer() );
 
+  /** Set the cache of pyramid images of the previous registrations. */
+  this->GetElastixBase()->SetImagePyramidCache( this->GetImagePyramidCache() );
+
   /** Set the initial transform, if it happens to be there. */
   this->GetElastixBase()->SetInitialTransform( this->GetInitialTransform() );
 
@@ -124,6 +124,7 @@ public:
   typedef ElastixBase::ObjectContainerPointer             ObjectContainerPointer;
   typedef ElastixBase::DataObjectContainerPointer         DataObjectContainerPointer;
   typedef ElastixBase::FlatDirectionCosinesType           FlatDirectionCosinesType;
+  typedef ElastixBase::ImagePyramidCacheType              ImagePyramidCacheType;
 
   /** Typedefs for the database that holds pointers to New() functions.
    * Those functions are used to instantiate components, such as the metric etc.
@@ -168,6 +169,13 @@ public:
   itkGetObjectMacro( FixedMaskContainer, DataObjectContainerType );
   itkGetObjectMacro( MovingMaskContainer, DataObjectContainerType );
 
+  /** Set/Get the cache of pyramid images. Share one cache between the
+   * ElastixMain objects of consecutive registrations to let them reuse
+   * the pyramid images, see ImagePyramidCache.
+   */
+  itkSetObjectMacro( ImagePyramidCache, ImagePyramidCacheType );
+  itkGetObjectMacro( ImagePyramidCache, ImagePyramidCacheType );
+
   /** Set/Get the configuration object. */
   itkSetObjectMacro( Configuration, ConfigurationType );
   itkGetObjectMacro( Configuration, ConfigurationType );
@@ -289,6 +297,9 @@ protected:
   DataObjectContainerPointer  m_FixedMaskContainer;
   DataObjectContainerPointer  m_MovingMaskContainer;
 
+  /** The cache of pyramid images. */
+  ImagePyramidCacheType::Pointer  m_ImagePyramidCache;
+
   /** A transform that is the result of registration. */
   ObjectPointer m_FinalTransform;
 
@@ -36,6 +36,8 @@
 #include "elxTransformBase.h"
 
 #include "elxTimer.h"
+#include "elxProfiler.h"
+#include "itkAsynchronousOutputWriter.h"
 
 #include <sstream>
 #include <fstream>
@@ -93,6 +95,36 @@ using namespace itk;
  *    example: <tt>(WriteTransformParametersEachResolution "true")</tt>\n
  *    This parameter can not be specified for each resolution separately.
  *    Default value: "false".
+ * \parameter UseAsynchronousLogging: Controls whether the log file and the
+ *    screen output are written by a background thread, so that the
+ *    registration does not wait for the disk or the terminal. Output
+ *    written directly to std::cout, bypassing elastix' logging, may then
+ *    appear out of order.\n
+ *    example: <tt>(UseAsynchronousLogging "true")</tt>\n
+ *    This parameter can not be specified for each resolution separately.
+ *    Default value: "false".
+ * \parameter AsynchronousLoggingFlushInterval: The maximum time in
+ *    milliseconds that the background thread waits for new output before
+ *    it checks the log anyway, if UseAsynchronousLogging is "true". The
+ *    thread is woken as soon as output is written.\n
+ *    example: <tt>(AsynchronousLoggingFlushInterval 2000)</tt>\n
+ *    This parameter can not be specified for each resolution separately.
+ *    Default value: 500.
+ * \parameter IterationInfoFormat: The format of the IterationInfo files.
+ *    Choose "txt" for tab separated columns, written to
+ *    IterationInfo.<ElastixLevel>.R<Resolution>.txt, or "csv" for comma
+ *    separated values, written to IterationInfo.<ElastixLevel>.R<Resolution>.csv.\n
+ *    example: <tt>(IterationInfoFormat "csv")</tt>\n
+ *    This parameter can not be specified for each resolution separately.
+ *    Default value: "txt".
+ * \parameter EnableProfiling: Controls whether the time spent in the main
+ *    parts of the registration (image sampler, metric, optimizer, etc.) is
+ *    measured. After each resolution a breakdown is printed, and written to
+ *    the file Profile.<ElastixLevel>.R<Resolution>.csv. Only one registration
+ *    in a process can be profiled at the same time.\n
+ *    example: <tt>(EnableProfiling "true")</tt>\n
+ *    This parameter can not be specified for each resolution separately.
+ *    Default value: "false".
  * \parameter UseDirectionCosines: Controls whether to use or ignore the
  * direction cosines (world matrix, transform matrix) set in the images.
  * Voxel spacing and image origin are always taken into account, regardless
@@ -275,7 +307,7 @@ public:
 protected:
 
   ElastixTemplate();
-  virtual ~ElastixTemplate(){};
+  virtual ~ElastixTemplate();
 
   /** Classes that contain a function to load multiple images, given a filename container. */
   typedef typename Superclass2::MultipleImageLoader<FixedImageType>   FixedImageLoaderType;
@@ -299,14 +331,30 @@ protected:
   /** Count the number of iterations. */
   unsigned int m_IterationCounter;
 
+  /** The value of WriteTransformParametersEachIteration, read once per
+   * resolution in BeforeEachResolution(), instead of in every iteration. */
+  bool m_WriteTransformParametersEachIteration;
+
   /** CreateTransformParameterFile. */
   virtual void CreateTransformParameterFile( const std::string FileName,
     const bool ToLog );
 
   /** Open the IterationInfoFile, where the table with iteration info is written to. */
   virtual void OpenIterationInfoFile( void );
+  virtual void CloseIterationInfoFile( void );
   std::ofstream m_IterationInfoFile;
 
+  /** The stream through which the IterationInfoFile is written, and
+   * whether it is written as comma separated values. */
+  std::ostream * m_IterationInfoOutput;
+  bool           m_IterationInfoAsCSV;
+
+  /** Print the profile of the current resolution and write it to a file. */
+  virtual void WriteProfile( void );
+
+  /** Whether this registration is profiled. */
+  bool m_EnableProfiling;
+
   /** Used by the callback functions, BeforeEachResolution() etc.).
    * This method calls a function in each component, in the following order:
    * \li Registration
@@ -58,13 +58,36 @@ ElastixTemplate<TFixedImage, TMovingImage>
 
   /** Initialize the this->m_IterationCounter. */
   this->m_IterationCounter = 0;
+  this->m_WriteTransformParametersEachIteration = false;
 
   /** Initialize CurrentTransformParameterFileName. */
   this->m_CurrentTransformParameterFileName = "";
 
+  /** Initialize the IterationInfo output. */
+  this->m_IterationInfoOutput = 0;
+  this->m_IterationInfoAsCSV = false;
+
+  /** Profiling is enabled in BeforeRegistration(). */
+  this->m_EnableProfiling = false;
+
 } // end Constructor
 
 
+/**
+ * ********************* Destructor ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+ElastixTemplate<TFixedImage, TMovingImage>
+::~ElastixTemplate()
+{
+  /** The IterationInfo output writes to m_IterationInfoFile,
+   * so it has to be removed first. */
+  this->CloseIterationInfoFile();
+
+} // end Destructor
+
+
 /**
  * ********************** GetFixedImage *************************
  */
@@ -220,7 +243,7 @@ int ElastixTemplate<TFixedImage, TMovingImage>
   /** Print the time spent on reading images. */
   this->m_Timer0->StopTimer();
   elxout << "Reading images took " << static_cast<unsigned long>(
-    this->m_Timer0->GetElapsedClockSec() * 1000 ) << " ms.\n" << std::endl;
+    this->m_Timer0->GetElapsedWallClockSec() * 1000 ) << " ms.\n" << std::endl;
 
   /** Give all components the opportunity to do some initialization. */
   this->BeforeRegistration();
@@ -500,6 +523,38 @@ void ElastixTemplate<TFixedImage, TMovingImage>
   /** Start timer for initializing all components. */
   this->m_Timer0->StartTimer();
 
+  /** Enable the profiler, if desired. */
+  bool enableProfiling = false;
+  this->GetConfiguration()->ReadParameter( enableProfiling,
+    "EnableProfiling", 0, false );
+  this->m_EnableProfiling
+    = tmr::Profiler::SetEnabled( enableProfiling ) && enableProfiling;
+  if ( enableProfiling && !this->m_EnableProfiling )
+  {
+    xout["warning"] << "WARNING: EnableProfiling is ignored, because another "
+      << "registration in this process is being profiled." << std::endl;
+  }
+
+  /** Read the format of the IterationInfo files. */
+  std::string iterationInfoFormat = "txt";
+  this->GetConfiguration()->ReadParameter( iterationInfoFormat,
+    "IterationInfoFormat", 0, false );
+  this->m_IterationInfoAsCSV = ( iterationInfoFormat == "csv" );
+
+  /** Let a background thread write the log, if desired. */
+  AsynchronousOutputWriter * writer = AsynchronousOutputWriter::GetGlobalWriter();
+  if ( writer )
+  {
+    bool useAsynchronousLogging = false;
+    this->GetConfiguration()->ReadParameter( useAsynchronousLogging,
+      "UseAsynchronousLogging", 0, false );
+    unsigned int flushInterval = 500;
+    this->GetConfiguration()->ReadParameter( flushInterval,
+      "AsynchronousLoggingFlushInterval", 0, false );
+    writer->SetFlushInterval( flushInterval );
+    writer->SetAsynchronous( useAsynchronousLogging );
+  }
+
   /** Call all the BeforeRegistration() functions. */
   this->BeforeRegistrationBase();
   CallInEachComponent( &BaseComponentType::BeforeRegistrationBase );
@@ -508,13 +563,17 @@ void ElastixTemplate<TFixedImage, TMovingImage>
   /** Add a column to iteration with the iteration number. */
   xout["iteration"].AddTargetCell( "1:ItNr" );
 
-  /** Add a column to iteration with timing information. */
+  /** Add columns to iteration with timing information: the wall-clock
+   * time, the processor time of all threads, and their ratio.
+   */
   xout["iteration"].AddTargetCell( "Time[ms]" );
+  xout["iteration"].AddTargetCell( "CPUTime[ms]" );
+  xout["iteration"].AddTargetCell( "CPU/Wall" );
 
   /** Print time for initializing. */
   this->m_Timer0->StopTimer();
   elxout << "Initialization of all components (before registration) took: "
-    << static_cast<unsigned long>( this->m_Timer0->GetElapsedClockSec() * 1000 )
+    << static_cast<unsigned long>( this->m_Timer0->GetElapsedWallClockSec() * 1000 )
     << " ms.\n";
 
   /** Start Timer0 here, to make it possible to measure the time needed for
@@ -541,7 +600,7 @@ void ElastixTemplate<TFixedImage, TMovingImage>
   {
     this->m_Timer0->StopTimer();
     elxout << "Preparation of the image pyramids took: "
-      << static_cast<unsigned long>( this->m_Timer0->GetElapsedClockSec() * 1000 )
+      << static_cast<unsigned long>( this->m_Timer0->GetElapsedWallClockSec() * 1000 )
       << " ms.\n";
     this->m_Timer0->StartTimer();
   }
@@ -549,6 +608,11 @@ void ElastixTemplate<TFixedImage, TMovingImage>
   /** Reset the this->m_IterationCounter. */
   this->m_IterationCounter = 0;
 
+  /** Read the parameters that are needed in each iteration. */
+  this->m_WriteTransformParametersEachIteration = false;
+  this->GetConfiguration()->ReadParameter( this->m_WriteTransformParametersEachIteration,
+    "WriteTransformParametersEachIteration", 0, false );
+
   /** Print the current resolution. */
   elxout << "\nResolution: " << level << std::endl;
 
@@ -562,11 +626,17 @@ void ElastixTemplate<TFixedImage, TMovingImage>
   /** Print the extra preparation time needed for this resolution. */
   this->m_Timer0->StopTimer();
   elxout << "Elastix initialization of all components (for this resolution) took: "
-    << static_cast<unsigned long>( this->m_Timer0->GetElapsedClockSec() * 1000 ) << " ms.\n";
+    << static_cast<unsigned long>( this->m_Timer0->GetElapsedWallClockSec() * 1000 ) << " ms.\n";
 
   /** Start ResolutionTimer, which measures the total iteration time in this resolution. */
   this->m_ResolutionTimer->StartTimer();
 
+  /** Let the profile cover the same time. */
+  if ( this->m_EnableProfiling )
+  {
+    tmr::Profiler::Reset();
+  }
+
   /** Start IterationTimer here, to make it possible to measure the time
    * of the first iteration.
    */
@@ -594,10 +664,20 @@ void ElastixTemplate<TFixedImage, TMovingImage>
     << "Time spent in resolution "
     << ( level )
     << " (ITK initialisation and iterating): "
-    << this->m_ResolutionTimer->GetElapsedClockSec()
-    << " s.\n";
+    << this->m_ResolutionTimer->GetElapsedWallClockSec()
+    << " s (processor time: "
+    << this->m_ResolutionTimer->GetElapsedProcessorTimeSec()
+    << " s, CPU/wall: "
+    << this->m_ResolutionTimer->GetCPUWallRatio()
+    << ").\n";
   elxout << std::setprecision( this->GetDefaultOutputPrecision() );
 
+  /** Print the profile of this resolution and write it to file. */
+  if ( this->m_EnableProfiling )
+  {
+    this->WriteProfile();
+  }
+
   /** Call all the AfterEachResolution() functions. */
   this->AfterEachResolutionBase();
   CallInEachComponent( &BaseComponentType::AfterEachResolutionBase );
@@ -639,6 +719,8 @@ template <class TFixedImage, class TMovingImage>
 void ElastixTemplate<TFixedImage, TMovingImage>
 ::AfterEachIteration( void )
 {
+  tmrProfileScope( "ElastixTemplate::AfterEachIteration" );
+
   /** Write the headers of the colums that are printed each iteration. */
   if ( this->m_IterationCounter == 0 )
   {
@@ -656,18 +738,16 @@ void ElastixTemplate<TFixedImage, TMovingImage>
   /** Time in this iteration. */
   this->m_IterationTimer->StopTimer();
   xout["iteration"]["Time[ms]"]
-    << static_cast<unsigned long>( this->m_IterationTimer->GetElapsedClockSec() *1000 );
+    << static_cast<unsigned long>( this->m_IterationTimer->GetElapsedWallClockSec() *1000 );
+  xout["iteration"]["CPUTime[ms]"]
+    << static_cast<unsigned long>( this->m_IterationTimer->GetElapsedProcessorTimeSec() *1000 );
+  xout["iteration"]["CPU/Wall"] << this->m_IterationTimer->GetCPUWallRatio();
 
   /** Write the iteration info of this iteration. */
   xout["iteration"].WriteBufferedData();
 
   /** Create a TransformParameter-file for the current iteration. */
-  bool writeTansformParametersThisIteration = false;
-  this->GetConfiguration()->ReadParameter( writeTansformParametersThisIteration,
-    "WriteTransformParametersEachIteration", 0, false );
-  //this->GetConfiguration()->ReadParameter( writeTansformParametersThisIteration,
-  //"WriteTransformParametersEachIteration", level, true );
-  if ( writeTansformParametersThisIteration )
+  if ( this->m_WriteTransformParametersEachIteration )
   {
     /** Add zeros to the number of iterations, to make sure
      * it always consists of 7 digits.
@@ -722,6 +802,14 @@ template <class TFixedImage, class TMovingImage>
 void ElastixTemplate<TFixedImage, TMovingImage>
 ::AfterRegistration( void )
 {
+  /** Stop writing the log in the background, so that for example the
+   * progress of the resampler is shown immediately. */
+  AsynchronousOutputWriter * writer = AsynchronousOutputWriter::GetGlobalWriter();
+  if ( writer )
+  {
+    writer->SetAsynchronous( false );
+  }
+
   /** A white line. */
   elxout << std::endl;
 
@@ -736,15 +824,26 @@ void ElastixTemplate<TFixedImage, TMovingImage>
   /** Create a final TransformParameterFile. */
   this->CreateTransformParameterFile( FileName, true );
 
+  /** Close the IterationInfo file of the last resolution, before the
+   * "iteration" field is removed. */
+  this->CloseIterationInfoFile();
+
   /** Call all the AfterRegistration() functions. */
   this->AfterRegistrationBase();
   CallInEachComponent( &BaseComponentType::AfterRegistrationBase );
   CallInEachComponent( &BaseComponentType::AfterRegistration );
 
+  /** Release the profiler for the next registration. */
+  if ( this->m_EnableProfiling )
+  {
+    tmr::Profiler::SetEnabled( false );
+    this->m_EnableProfiling = false;
+  }
+
   /** Print the time spent on things after the registration. */
   this->m_Timer0->StopTimer();
   elxout << "Time spent on saving the results, applying the final transform etc.: "
-    << static_cast<unsigned long>( this->m_Timer0->GetElapsedClockSec() * 1000 ) << " ms.\n";
+    << static_cast<unsigned long>( this->m_Timer0->GetElapsedWallClockSec() * 1000 ) << " ms.\n";
 
 } // end AfterRegistration()
 
@@ -969,8 +1068,8 @@ void ElastixTemplate<TFixedImage, TMovingImage>
 /**
  * ************** OpenIterationInfoFile *************************
  *
- * Open a file called IterationInfo.<ElastixLevel>.R<Resolution>.txt,
- * which will contain the iteration info table.
+ * Open a file called IterationInfo.<ElastixLevel>.R<Resolution>.txt
+ * (or .csv), which will contain the iteration info table.
  */
 
 template <class TFixedImage, class TMovingImage>
@@ -980,12 +1079,7 @@ void ElastixTemplate<TFixedImage, TMovingImage>
   using namespace xl;
 
   /** Remove the current iteration info output file, if any. */
-  xout["iteration"].RemoveOutput( "IterationInfoFile" );
-
-  if ( this->m_IterationInfoFile.is_open() )
-  {
-    this->m_IterationInfoFile.close();
-  }
+  this->CloseIterationInfoFile();
 
   /** Create the IterationInfo filename for this resolution. */
   std::ostringstream makeFileName("");
@@ -993,7 +1087,7 @@ void ElastixTemplate<TFixedImage, TMovingImage>
     << "IterationInfo."
     << this->m_Configuration->GetElastixLevel()
     << ".R" << this->GetElxRegistrationBase()->GetAsITKBaseType()->GetCurrentLevel()
-    << ".txt";
+    << ( this->m_IterationInfoAsCSV ? ".csv" : ".txt" );
   std::string FileName = makeFileName.str();
 
   /** Open the IterationInfoFile. */
@@ -1004,13 +1098,92 @@ void ElastixTemplate<TFixedImage, TMovingImage>
   }
   else
   {
+    /** Write the file through the writer of the log, so that it is also
+     * written in the background if UseAsynchronousLogging is set. For the
+     * csv format the writer replaces the tabs between the columns.
+     */
+    this->m_IterationInfoOutput = &( this->m_IterationInfoFile );
+    AsynchronousOutputWriter * writer = AsynchronousOutputWriter::GetGlobalWriter();
+    if ( writer )
+    {
+      this->m_IterationInfoOutput = writer->AddOutput( &( this->m_IterationInfoFile ),
+        this->m_IterationInfoAsCSV ? ',' : 0 );
+    }
+
     /** Add this file to the list of outputs of xout["iteration"]. */
-    xout["iteration"].AddOutput( "IterationInfoFile", &(this->m_IterationInfoFile) );
+    xout["iteration"].AddOutput( "IterationInfoFile", this->m_IterationInfoOutput );
   }
 
 } // end OpenIterationInfoFile()
 
 
+/**
+ * ************** CloseIterationInfoFile *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void ElastixTemplate<TFixedImage, TMovingImage>
+::CloseIterationInfoFile( void )
+{
+  using namespace xl;
+
+  if ( this->m_IterationInfoOutput == 0 ) return;
+
+  /** Remove the file from the outputs of xout["iteration"], and write
+   * the remaining data. */
+  xout["iteration"].RemoveOutput( "IterationInfoFile" );
+  AsynchronousOutputWriter * writer = AsynchronousOutputWriter::GetGlobalWriter();
+  if ( writer && this->m_IterationInfoOutput != &( this->m_IterationInfoFile ) )
+  {
+    writer->RemoveOutput( this->m_IterationInfoOutput );
+  }
+  this->m_IterationInfoOutput = 0;
+
+  this->m_IterationInfoFile.close();
+
+} // end CloseIterationInfoFile()
+
+
+/**
+ * ************** WriteProfile *************************
+ *
+ * Print the profile of the current resolution, and write it to a file
+ * called Profile.<ElastixLevel>.R<Resolution>.csv.
+ */
+
+template <class TFixedImage, class TMovingImage>
+void ElastixTemplate<TFixedImage, TMovingImage>
+::WriteProfile( void )
+{
+  const double resolutionTime
+    = this->m_ResolutionTimer->GetElapsedWallClockSec();
+
+  /** Print the breakdown. */
+  std::ostringstream report( "" );
+  tmr::Profiler::Report( report, resolutionTime );
+  elxout << "Profile of resolution "
+    << this->GetElxRegistrationBase()->GetAsITKBaseType()->GetCurrentLevel()
+    << ":\n" << report.str();
+
+  /** Create the Profile filename for this resolution. */
+  std::ostringstream makeFileName( "" );
+  makeFileName << this->m_Configuration->GetCommandLineArgument( "-out" )
+    << "Profile."
+    << this->m_Configuration->GetElastixLevel()
+    << ".R" << this->GetElxRegistrationBase()->GetAsITKBaseType()->GetCurrentLevel()
+    << ".csv";
+  std::string FileName = makeFileName.str();
+
+  if ( !tmr::Profiler::WriteCSV( FileName, resolutionTime ) )
+  {
+    xout["error"] << "ERROR: File \"" << FileName << "\" could not be opened!" << std::endl;
+  }
+
+  tmr::Profiler::Reset();
+
+} // end WriteProfile()
+
+
 /**
  * ************** GetOriginalFixedImageDirection *********************
  * Determine the original fixed image direction (it might have been
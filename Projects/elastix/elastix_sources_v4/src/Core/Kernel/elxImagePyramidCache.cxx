@@ -0,0 +1,139 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __elxImagePyramidCache_cxx
+#define __elxImagePyramidCache_cxx
+
+#include "elxImagePyramidCache.h"
+
+namespace elastix
+{
+
+/**
+ * ********************* GetImages ****************************
+ */
+
+bool
+ImagePyramidCache
+::GetImages( const std::string & name,
+  const DataObjectType * input, const FlatScheduleType & schedule,
+  ImageVectorType & images ) const
+{
+  EntryMapType::const_iterator it = this->m_Entries.find( name );
+  if ( it == this->m_Entries.end() || input == 0 )
+  {
+    return false;
+  }
+
+  const EntryType & entry = it->second;
+  if ( entry.m_Input != input
+    || entry.m_InputMTime != input->GetMTime()
+    || entry.m_Schedule != schedule )
+  {
+    return false;
+  }
+
+  images = entry.m_Images;
+  return true;
+
+} // end GetImages()
+
+
+/**
+ * ********************* SetImages ****************************
+ */
+
+void
+ImagePyramidCache
+::SetImages( const std::string & name,
+  const DataObjectType * input, const FlatScheduleType & schedule,
+  const ImageVectorType & images )
+{
+  EntryType & entry = this->m_Entries[ name ];
+  entry.m_Input = input;
+  entry.m_InputMTime = input ? input->GetMTime() : 0;
+  entry.m_Schedule = schedule;
+  entry.m_Images = images;
+
+} // end SetImages()
+
+
+/**
+ * ********************* RemoveImages ****************************
+ */
+
+void
+ImagePyramidCache
+::RemoveImages( const std::string & name )
+{
+  this->m_Entries.erase( name );
+
+} // end RemoveImages()
+
+
+/**
+ * ********************* RemoveImagesWithPrefix ****************************
+ */
+
+void
+ImagePyramidCache
+::RemoveImagesWithPrefix( const std::string & prefix )
+{
+  EntryMapType::iterator it = this->m_Entries.lower_bound( prefix );
+  while ( it != this->m_Entries.end()
+    && it->first.compare( 0, prefix.size(), prefix ) == 0 )
+  {
+    this->m_Entries.erase( it++ );
+  }
+
+} // end RemoveImagesWithPrefix()
+
+
+/**
+ * ********************* Clear ****************************
+ */
+
+void
+ImagePyramidCache
+::Clear( void )
+{
+  this->m_Entries.clear();
+
+} // end Clear()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+void
+ImagePyramidCache
+::PrintSelf( std::ostream & os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Entries: " << this->m_Entries.size() << std::endl;
+  for ( EntryMapType::const_iterator it = this->m_Entries.begin();
+    it != this->m_Entries.end(); ++it )
+  {
+    os << indent.GetNextIndent() << it->first << ": "
+      << it->second.m_Images.size() << " images" << std::endl;
+  }
+
+} // end PrintSelf()
+
+
+} // end namespace elastix
+
+#endif // end #ifndef __elxImagePyramidCache_cxx
@@ -0,0 +1,227 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+
+#ifndef __elxImagePyramidCache_h
+#define __elxImagePyramidCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkDataObject.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace elastix
+{
+
+/**
+ * \class ImagePyramidCache
+ * \brief Keeps the images of the image pyramids of one registration, for
+ * the next registration.
+ *
+ * When elastix is run with multiple parameter files, a new set of
+ * components is created for each of them. The fixed and moving images are
+ * passed on from one registration to the next, but the pyramids would be
+ * computed again. The pyramids store their images in this cache, with the
+ * name of the pyramid, the input image and its modification time, and the
+ * schedule. A pyramid of the next registration that finds an entry with
+ * the same key does not compute its images, but grafts the stored ones.
+ *
+ * The cache is shared by consecutive ElastixMain objects, like the image
+ * containers. The stored images are not released after each resolution,
+ * so the cache costs memory. This is why the pyramids only use it when
+ * the parameter ReusePyramidImages is set, see FixedImagePyramidBase.
+ * In batch mode (-mlist) the cache is shared by all pairs; the fixed
+ * image pyramid always uses it, and the moving image pyramids are
+ * removed after each pair.
+ *
+ * \ingroup Kernel
+ */
+
+class ImagePyramidCache : public itk::Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef ImagePyramidCache               Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ImagePyramidCache, Object );
+
+  /** Typedefs. */
+  typedef itk::DataObject                     DataObjectType;
+  typedef DataObjectType::Pointer             DataObjectPointer;
+  typedef std::vector< DataObjectPointer >    ImageVectorType;
+  typedef std::vector< unsigned int >         FlatScheduleType;
+
+  /** Get the images that were stored under this name, for the same input
+   * image, unmodified since, and the same schedule. Returns false if
+   * there are none.
+   */
+  virtual bool GetImages( const std::string & name,
+    const DataObjectType * input, const FlatScheduleType & schedule,
+    ImageVectorType & images ) const;
+
+  /** Store the images of a pyramid, replacing the images stored earlier
+   * under this name.
+   */
+  virtual void SetImages( const std::string & name,
+    const DataObjectType * input, const FlatScheduleType & schedule,
+    const ImageVectorType & images );
+
+  /** Graft the images that are stored under this name onto the outputs
+   * of the pyramid, if they match its input and schedule. Returns false,
+   * without changing the pyramid, if there are no matching images.
+   */
+  template < class TPyramid >
+  bool GraftImages( const std::string & name, TPyramid * pyramid ) const;
+
+  /** Store the output images of the pyramid under this name. */
+  template < class TPyramid >
+  void StoreImages( const std::string & name, TPyramid * pyramid );
+
+  /** Remove the images that are stored under this name, if any. */
+  virtual void RemoveImages( const std::string & name );
+
+  /** Remove the images that are stored under a name that starts with
+   * this prefix, e.g. those of all moving image pyramids.
+   */
+  virtual void RemoveImagesWithPrefix( const std::string & prefix );
+
+  /** Remove all images. */
+  virtual void Clear( void );
+
+protected:
+
+  ImagePyramidCache() {}
+  virtual ~ImagePyramidCache() {}
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, itk::Indent indent ) const;
+
+  /** An entry of the cache. The input is referenced by a raw pointer
+   * only, to not keep it alive; its modification time guards against an
+   * input that was changed or replaced by another one at the same address.
+   */
+  struct EntryType
+  {
+    const DataObjectType *  m_Input;
+    unsigned long           m_InputMTime;
+    FlatScheduleType        m_Schedule;
+    ImageVectorType         m_Images;
+  };
+  typedef std::map< std::string, EntryType >  EntryMapType;
+
+  /** Convert the schedule of a pyramid to a vector. */
+  template < class TSchedule >
+  static FlatScheduleType FlattenSchedule( const TSchedule & schedule )
+  {
+    FlatScheduleType flatSchedule;
+    flatSchedule.reserve( schedule.rows() * schedule.cols() + 1 );
+    flatSchedule.push_back( schedule.cols() );
+    for ( unsigned int i = 0; i < schedule.rows(); ++i )
+    {
+      for ( unsigned int j = 0; j < schedule.cols(); ++j )
+      {
+        flatSchedule.push_back( schedule[ i ][ j ] );
+      }
+    }
+    return flatSchedule;
+  }
+
+private:
+
+  ImagePyramidCache( const Self & );  // purposely not implemented
+  void operator=( const Self & );     // purposely not implemented
+
+  EntryMapType  m_Entries;
+
+}; // end class ImagePyramidCache
+
+
+/**
+ * ********************* GraftImages ****************************
+ */
+
+template < class TPyramid >
+bool
+ImagePyramidCache
+::GraftImages( const std::string & name, TPyramid * pyramid ) const
+{
+  typedef typename TPyramid::OutputImageType    OutputImageType;
+
+  ImageVectorType images;
+  if ( !this->GetImages( name, pyramid->GetInput(),
+    FlattenSchedule( pyramid->GetSchedule() ), images )
+    || images.size() != pyramid->GetNumberOfLevels() )
+  {
+    return false;
+  }
+
+  /** Check all images before grafting any of them. */
+  for ( unsigned int level = 0; level < images.size(); ++level )
+  {
+    if ( dynamic_cast<OutputImageType *>( images[ level ].GetPointer() ) == 0 )
+    {
+      return false;
+    }
+  }
+
+  for ( unsigned int level = 0; level < images.size(); ++level )
+  {
+    pyramid->GetOutput( level )->Graft(
+      static_cast<OutputImageType *>( images[ level ].GetPointer() ) );
+  }
+  return true;
+
+} // end GraftImages()
+
+
+/**
+ * ********************* StoreImages ****************************
+ */
+
+template < class TPyramid >
+void
+ImagePyramidCache
+::StoreImages( const std::string & name, TPyramid * pyramid )
+{
+  typedef typename TPyramid::OutputImageType    OutputImageType;
+
+  /** The stored images share the buffers of the outputs, so they survive
+   * the release of the output data after each resolution.
+   */
+  ImageVectorType images( pyramid->GetNumberOfLevels() );
+  for ( unsigned int level = 0; level < images.size(); ++level )
+  {
+    typename OutputImageType::Pointer image = OutputImageType::New();
+    image->Graft( pyramid->GetOutput( level ) );
+    images[ level ] = image.GetPointer();
+  }
+
+  this->SetImages( name, pyramid->GetInput(),
+    FlattenSchedule( pyramid->GetSchedule() ), images );
+
+} // end StoreImages()
+
+
+} // end namespace elastix
+
+#endif // end #ifndef __elxImagePyramidCache_h
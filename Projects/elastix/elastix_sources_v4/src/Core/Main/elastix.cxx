@@ -56,6 +56,7 @@ int main( int argc, char **argv )
   typedef ElastixMainType::ObjectPointer              ObjectPointer;
   typedef ElastixMainType::DataObjectContainerPointer DataObjectContainerPointer;
   typedef ElastixMainType::FlatDirectionCosinesType   FlatDirectionCosinesType;
+  typedef ElastixMainType::ImagePyramidCacheType      ImagePyramidCacheType;
 
   typedef ElastixMainType::ArgumentMapType            ArgumentMapType;
   typedef ArgumentMapType::value_type                 ArgumentMapEntryType;
@@ -73,6 +74,7 @@ int main( int argc, char **argv )
   DataObjectContainerPointer fixedMaskContainer = 0;
   DataObjectContainerPointer movingMaskContainer = 0;
   FlatDirectionCosinesType  fixedImageOriginalDirection;
+  ImagePyramidCacheType::Pointer imagePyramidCache = ImagePyramidCacheType::New();
   int returndummy = 0;
   unsigned long nrOfParameterFiles = 0;
   ArgumentMapType argMap;
@@ -80,6 +82,9 @@ int main( int argc, char **argv )
   bool outFolderPresent = false;
   std::string outFolder = "";
   std::string logFileName = "";
+  std::string movingImageListFileName = "";
+  std::vector< std::string > movingImageList;
+  unsigned int nrOfFailedPairs = 0;
 
   /** Put command line parameters into parameterFileList. */
   for ( unsigned int i = 1; static_cast<long>(i) < ( argc - 1 ); i += 2 )
@@ -116,6 +121,12 @@ int main( int argc, char **argv )
 
       } // end if key == "-out"
 
+      /** Remember the file with the list of moving images. */
+      if ( key == "-mlist" )
+      {
+        movingImageListFileName = value;
+      }
+
       /** Attempt to save the arguments in the ArgumentMap. */
       if ( argMap.count( key.c_str() ) == 0 )
       {
@@ -172,6 +183,24 @@ int main( int argc, char **argv )
     std::cerr << "ERROR: No CommandLine option \"-out\" given!" << std::endl;
   }
 
+  /** Read the list of moving images, in batch mode. */
+  if ( !movingImageListFileName.empty() )
+  {
+    if ( argMap.count( "-m" ) )
+    {
+      std::cerr << "ERROR: the options \"-m\" and \"-mlist\" can not be combined." << std::endl;
+      returndummy |= -1;
+    }
+    else if ( ReadMovingImageList( movingImageListFileName, movingImageList ) != 0 )
+    {
+      std::cerr << "ERROR: the list of moving images \""
+        << movingImageListFileName << "\" could not be read, or is empty." << std::endl;
+      returndummy |= -1;
+    }
+  }
+  const bool batchMode = !movingImageList.empty();
+  const unsigned int nrOfPairs = batchMode ? movingImageList.size() : 1;
+
   /** Stop if some fatal errors occurred. */
   if ( returndummy )
   {
@@ -203,83 +232,155 @@ int main( int argc, char **argv )
   /**
    * ********************* START REGISTRATION *********************
    *
-   * Do the (possibly multiple) registration(s).
+   * Do the (possibly multiple) registration(s), for each moving image
+   * in batch mode. The pairs are registered one after the other, since
+   * they share the log. The fixed image and mask, the moving mask, and the
+   * pyramid cache are shared by all pairs. The fixed image pyramid is kept
+   * in the cache in batch mode, see FixedImagePyramidBase, so it is
+   * computed once.
    */
 
-  for ( unsigned int i = 0; i < nrOfParameterFiles; i++ )
+  for ( unsigned int pair = 0; pair < nrOfPairs; ++pair )
   {
-    /** Create another instance of ElastixMain. */
-    elastices.push_back( ElastixMainType::New() );
-
-    /** Set stuff we get from a former registration. */
-    elastices[ i ]->SetInitialTransform( transform );
-    elastices[ i ]->SetFixedImageContainer( fixedImageContainer );
-    elastices[ i ]->SetMovingImageContainer( movingImageContainer );
-    elastices[ i ]->SetFixedMaskContainer( fixedMaskContainer );
-    elastices[ i ]->SetMovingMaskContainer( movingMaskContainer );
-    elastices[ i ]->SetOriginalFixedImageDirectionFlat( fixedImageOriginalDirection );
-
-    /** Set the current elastix-level. */
-    elastices[ i ]->SetElastixLevel( i );
-    elastices[ i ]->SetTotalNumberOfElastixLevels( nrOfParameterFiles );
-
-    /** Delete the previous ParameterFileName. */
-    if ( argMap.count( "-p" ) )
+    /** Start each pair with the queue of parameter files and without
+     * the transform and moving image of the previous pair. */
+    ParameterFileListType parameterFiles = parameterFileList;
+    elastices.clear();
+    transform = 0;
+    movingImageContainer = 0;
+
+    if ( batchMode )
     {
-      argMap.erase( "-p" );
+      /** Each pair writes to its own output directory. */
+      const std::string & movingImageFileName = movingImageList[ pair ];
+      std::ostringstream pairOutFolder( "" );
+      pairOutFolder << outFolder << "Pair" << pair << "_"
+        << itksys::SystemTools::GetFilenameWithoutExtension( movingImageFileName )
+        << "/";
+      if ( !itksys::SystemTools::MakeDirectory( pairOutFolder.str().c_str() ) )
+      {
+        xl::xout["error"] << "ERROR: the output directory \""
+          << pairOutFolder.str() << "\" of moving image " << pair
+          << " could not be created." << std::endl;
+        ++nrOfFailedPairs;
+        continue;
+      }
+
+      argMap[ "-m" ] = movingImageFileName;
+      argMap[ "-out" ] = pairOutFolder.str();
+
+      elxout << "=========================================================================" << "\n" << std::endl;
+      elxout << "Registering moving image " << pair << " of " << nrOfPairs
+        << ": \"" << movingImageFileName << "\".\n"
+        << "Output directory: \"" << pairOutFolder.str() << "\".\n" << std::endl;
     }
 
-    /** Read the first parameterFileName in the queue. */
-    ArgPairType argPair = parameterFileList.front();
-    parameterFileList.pop();
+    for ( unsigned int i = 0; i < nrOfParameterFiles; i++ )
+    {
+      /** Create another instance of ElastixMain. */
+      elastices.push_back( ElastixMainType::New() );
+
+      /** Set stuff we get from a former registration. */
+      elastices[ i ]->SetInitialTransform( transform );
+      elastices[ i ]->SetFixedImageContainer( fixedImageContainer );
+      elastices[ i ]->SetMovingImageContainer( movingImageContainer );
+      elastices[ i ]->SetFixedMaskContainer( fixedMaskContainer );
+      elastices[ i ]->SetMovingMaskContainer( movingMaskContainer );
+      elastices[ i ]->SetOriginalFixedImageDirectionFlat( fixedImageOriginalDirection );
+      elastices[ i ]->SetImagePyramidCache( imagePyramidCache );
+
+      /** Set the current elastix-level. */
+      elastices[ i ]->SetElastixLevel( i );
+      elastices[ i ]->SetTotalNumberOfElastixLevels( nrOfParameterFiles );
+
+      /** Delete the previous ParameterFileName. */
+      if ( argMap.count( "-p" ) )
+      {
+        argMap.erase( "-p" );
+      }
 
-    /** Put it in the ArgumentMap. */
-    argMap.insert( ArgumentMapEntryType( argPair.first, argPair.second ) );
+      /** Read the first parameterFileName in the queue. */
+      ArgPairType argPair = parameterFiles.front();
+      parameterFiles.pop();
 
-    /** Print a start message. */
-    elxout << "-------------------------------------------------------------------------" << "\n" << std::endl;
-    elxout << "Running elastix with parameter file " << i
-      << ": \"" << argMap[ "-p" ] << "\".\n" << std::endl;
+      /** Put it in the ArgumentMap. */
+      argMap.insert( ArgumentMapEntryType( argPair.first, argPair.second ) );
 
-    /** Declare a timer, start it and print the start time. */
-    tmr::Timer::Pointer timer = tmr::Timer::New();
-    timer->StartTimer();
-    elxout << "Current time: " << timer->PrintStartTime() << "." << std::endl;
+      /** Print a start message. */
+      elxout << "-------------------------------------------------------------------------" << "\n" << std::endl;
+      elxout << "Running elastix with parameter file " << i
+        << ": \"" << argMap[ "-p" ] << "\".\n" << std::endl;
 
-    /** Start registration. */
-    returndummy = elastices[ i ]->Run( argMap );
+      /** Declare a timer, start it and print the start time. */
+      tmr::Timer::Pointer timer = tmr::Timer::New();
+      timer->StartTimer();
+      elxout << "Current time: " << timer->PrintStartTime() << "." << std::endl;
+
+      /** Start registration. */
+      returndummy = elastices[ i ]->Run( argMap );
+
+      /** Check for errors. In batch mode, continue with the next pair. */
+      if ( returndummy != 0 )
+      {
+        xl::xout["error"] << "Errors occurred!" << std::endl;
+        if ( !batchMode )
+        {
+          return returndummy;
+        }
+        ++nrOfFailedPairs;
 
-    /** Check for errors. */
-    if ( returndummy != 0 )
+        /** Keep the fixed image and the masks, if they were read, so that
+         * the next pairs do not read them again. */
+        fixedImageContainer  = elastices[ i ]->GetFixedImageContainer();
+        fixedMaskContainer   = elastices[ i ]->GetFixedMaskContainer();
+        movingMaskContainer  = elastices[ i ]->GetMovingMaskContainer();
+        fixedImageOriginalDirection = elastices[ i ]->GetOriginalFixedImageDirectionFlat();
+
+        elastices[ i ] = 0;
+        break;
+      }
+
+      /** Get the transform, the fixedImage and the movingImage
+       * in order to put it in the (possibly) next registration.
+       */
+      transform            = elastices[ i ]->GetFinalTransform();
+      fixedImageContainer  = elastices[ i ]->GetFixedImageContainer();
+      movingImageContainer = elastices[ i ]->GetMovingImageContainer();
+      fixedMaskContainer   = elastices[ i ]->GetFixedMaskContainer();
+      movingMaskContainer  = elastices[ i ]->GetMovingMaskContainer();
+      fixedImageOriginalDirection = elastices[ i ]->GetOriginalFixedImageDirectionFlat();
+
+      /** Print a finish message. */
+      elxout << "Running elastix with parameter file " << i
+        << ": \"" << argMap[ "-p" ] << "\", has finished.\n" << std::endl;
+
+      /** Stop timer and print it. */
+      timer->StopTimer();
+      elxout << "\nCurrent time: " << timer->PrintStopTime() << "." << std::endl;
+      elxout << "Time used for running elastix with this parameter file: "
+        << timer->PrintElapsedTimeDHMS() << ".\n" << std::endl;
+
+      /** Try to release some memory. */
+      elastices[ i ] = 0;
+
+    } // end loop over registrations
+
+    /** Forget the moving image pyramids of this pair, which the next pair
+     * can not use. Their names start with their component label. */
+    if ( batchMode )
     {
-      xl::xout["error"] << "Errors occurred!" << std::endl;
-      return returndummy;
+      imagePyramidCache->RemoveImagesWithPrefix( "MovingImagePyramid" );
     }
 
-    /** Get the transform, the fixedImage and the movingImage
-     * in order to put it in the (possibly) next registration.
-     */
-    transform            = elastices[ i ]->GetFinalTransform();
-    fixedImageContainer  = elastices[ i ]->GetFixedImageContainer();
-    movingImageContainer = elastices[ i ]->GetMovingImageContainer();
-    fixedMaskContainer   = elastices[ i ]->GetFixedMaskContainer();
-    movingMaskContainer  = elastices[ i ]->GetMovingMaskContainer();
-    fixedImageOriginalDirection = elastices[ i ]->GetOriginalFixedImageDirectionFlat();
-
-    /** Print a finish message. */
-    elxout << "Running elastix with parameter file " << i
-      << ": \"" << argMap[ "-p" ] << "\", has finished.\n" << std::endl;
-
-    /** Stop timer and print it. */
-    timer->StopTimer();
-    elxout << "\nCurrent time: " << timer->PrintStopTime() << "." << std::endl;
-    elxout << "Time used for running elastix with this parameter file: "
-      << timer->PrintElapsedTimeDHMS() << ".\n" << std::endl;
-
-    /** Try to release some memory. */
-    elastices[ i ] = 0;
+  } // end loop over pairs
 
-  } // end loop over registrations
+  /** Report the failed pairs. */
+  if ( nrOfFailedPairs > 0 )
+  {
+    xl::xout["error"] << "The registration of " << nrOfFailedPairs << " of the "
+      << nrOfPairs << " moving images failed." << std::endl;
+    returndummy = 1;
+  }
 
   elxout << "-------------------------------------------------------------------------" << "\n" << std::endl;
 
@@ -292,7 +393,7 @@ int main( int argc, char **argv )
    * are deleted before the modules are closed.
    */
 
-  for ( unsigned int i = 0; i < nrOfParameterFiles; i++ )
+  for ( unsigned int i = 0; i < elastices.size(); i++ )
   {
     elastices[ i ] = 0;
   }
@@ -302,6 +403,7 @@ int main( int argc, char **argv )
   movingImageContainer = 0;
   fixedMaskContainer = 0;
   movingMaskContainer = 0;
+  imagePyramidCache = 0;
 
   /** Close the modules. */
   ElastixMainType::UnloadComponents();
@@ -344,7 +446,11 @@ void PrintHelp( void )
   std::cout << "-t0       parameter file for initial transform\n";
   std::cout << "-priority set the process priority to high or belownormal "
     "(Windows only)\n";
-  std::cout << "-threads  set the maximum number of threads of elastix\n"
+  std::cout << "-threads  set the maximum number of threads of elastix\n";
+  std::cout << "-mlist    text file with a moving image per line, instead of -m;\n"
+    "          each is registered to the fixed image, in a subdirectory of -out;\n"
+    "          the images are registered one after the other, and the\n"
+    "          fixed image pyramid is computed once\n"
     << std::endl;
 
   /** The parameter file.*/
@@ -361,5 +467,37 @@ void PrintHelp( void )
 } // end PrintHelp()
 
 
+/**
+ * ******************* ReadMovingImageList **********************
+ */
+
+int ReadMovingImageList( const std::string & fileName,
+  std::vector< std::string > & movingImageList )
+{
+  std::ifstream listFile( fileName.c_str() );
+  if ( !listFile.is_open() )
+  {
+    return 1;
+  }
+
+  /** One file name per line; skip empty lines and comments. */
+  movingImageList.clear();
+  std::string line;
+  while ( std::getline( listFile, line ) )
+  {
+    const std::string::size_type begin = line.find_first_not_of( " \t\r" );
+    if ( begin == std::string::npos || line.compare( begin, 2, "//" ) == 0 )
+    {
+      continue;
+    }
+    const std::string::size_type end = line.find_last_not_of( " \t\r" );
+    movingImageList.push_back( line.substr( begin, end - begin + 1 ) );
+  }
+
+  return movingImageList.empty() ? 1 : 0;
+
+} // end ReadMovingImageList()
+
+
 #endif // end #ifndef __elastix_cxx
 
@@ -24,6 +24,8 @@
 #include <string>
 #include <vector>
 #include <queue>
+#include <fstream>
+#include <sstream>
 #include "itkObject.h"
 #include "itkDataObject.h"
 #include <itksys/SystemTools.hxx>
@@ -43,5 +45,21 @@
    */
   void PrintHelp(void);
 
+  /** Read the list of moving images of the batch mode: a text file with
+   * one file name per line. Empty lines and lines starting with "//" are
+   * skipped. Returns 0 on success, and 1 if the file can not be read or
+   * lists no images.
+   *
+   * \commandlinearg -mlist: optional argument for elastix with a text file
+   *    that lists moving images, instead of -m. Each moving image is registered
+   *    to the fixed image, with all parameter files, and writes its output in a
+   *    subdirectory Pair<i>_<name> of the -out directory. The moving images
+   *    are registered one after the other, not concurrently, since they write
+   *    to one elastix.log; each registration uses all threads (see -threads).\n
+   *    example: <tt>-mlist movingImages.txt</tt> \n
+   */
+  int ReadMovingImageList( const std::string & fileName,
+    std::vector< std::string > & movingImageList );
+
 #endif
 
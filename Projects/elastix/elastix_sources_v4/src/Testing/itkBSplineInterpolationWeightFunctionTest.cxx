@@ -13,6 +13,7 @@ PURPOSE. See the above copyright notices for more information.
 ======================================================================*/
 #include "itkBSplineInterpolationWeightFunction.h"
 #include "itkBSplineInterpolationWeightFunction2.h"
+#include "vnl/vnl_random.h"
 
 #include <ctime>
 #include <iomanip>
@@ -22,8 +23,80 @@ PURPOSE. See the above copyright notices for more information.
 // This test tests the itkBSplineInterpolationWeightFunction2 and compares
 // it with the ITK implementation. It should give equal results and comparable
 // performance. The test is performed in 2D and 3D, with spline order 3.
+// At random points the weights, which are computed with vector instructions
+// when available, are compared with the scalar formula.
 // Also the PrintSelf()-functions are called.
 
+
+/** The cubic B-spline weights on the support, with the scalar formula. */
+void ComputeScalarCubicWeights( const double u, double weights[ 4 ] )
+{
+  const double uu  = vnl_math_sqr( u );
+  const double uuu = uu * u;
+
+  weights[ 0 ] = ( 8.0 - 12 * u + 6.0 * uu - uuu ) / 6.0;
+  weights[ 1 ] = ( -5.0 + 21.0 * u - 15.0 * uu + 3.0 * uuu ) / 6.0;
+  weights[ 2 ] = ( 4.0 - 12.0 * u + 12.0 * uu - 3.0 * uuu ) / 6.0;
+  weights[ 3 ] = ( -1.0 + 3.0 * u - 3.0 * uu + uuu ) / 6.0;
+
+} // end ComputeScalarCubicWeights()
+
+
+/** Compare the weights at random points with the tensor product of the
+ * scalar weights, multiplied in the order of the dimensions, with the first
+ * dimension running fastest. The results are identical, unless the compiler
+ * contracts the scalar formula to fused multiply-adds, so a tolerance of
+ * a few rounding errors is used.
+ */
+template< class TWeightFunction >
+bool CompareWithScalarWeights( const TWeightFunction * weightFunction,
+  unsigned int numberOfPoints )
+{
+  typedef typename TWeightFunction::ContinuousIndexType ContinuousIndexType;
+  typedef typename TWeightFunction::IndexType           IndexType;
+  typedef typename TWeightFunction::WeightsType         WeightsType;
+  const unsigned int Dimension = TWeightFunction::SpaceDimension;
+
+  vnl_random random( 5678 );
+  ContinuousIndexType cindex;
+  IndexType startIndex;
+  double weights1D[ Dimension ][ 4 ];
+  for ( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+      cindex[ d ] = random.drand64( 0.0, 20.0 );
+    }
+    const WeightsType weights = weightFunction->Evaluate( cindex );
+
+    weightFunction->ComputeStartIndex( cindex, startIndex );
+    for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+      ComputeScalarCubicWeights(
+        cindex[ d ] - static_cast<double>( startIndex[ d ] ), weights1D[ d ] );
+    }
+
+    for ( unsigned int k = 0; k < weights.Size(); ++k )
+    {
+      double weight = 1.0;
+      unsigned int offset = k;
+      for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+        weight *= weights1D[ d ][ offset % 4 ];
+        offset /= 4;
+      }
+      if ( vnl_math_abs( weights[ k ] - weight ) > 1e-15 )
+      {
+        std::cerr << "ERROR: weight " << k << " at " << cindex << " is "
+          << weights[ k ] << " instead of " << weight << "." << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+
+} // end CompareWithScalarWeights()
+
 int main( int argc, char *argv[] )
 {
   /** Some basic type definitions. */
@@ -227,6 +300,20 @@ int main( int argc, char *argv[] )
     return 1;
   }
 
+  /**
+   * *********** Vectorized weights TESTING *******************************
+   */
+
+  std::cerr << "\n--------------------------------------------------------";
+  std::cerr << "\nVectorized weights TESTING:\n" << std::endl;
+
+  if ( !CompareWithScalarWeights( weight2Function2D.GetPointer(), 10000 )
+    || !CompareWithScalarWeights( weight2Function3D.GetPointer(), 10000 ) )
+  {
+    return 1;
+  }
+  std::cerr << "The weights are equal to the scalar formula." << std::endl;
+
   /**
    * *********** Function TESTING ****************************************
    */
@@ -0,0 +1,312 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+#include "itkBlockSparseJointPDFDerivatives.h"
+#include "itkMultiThreader.h"
+#include "vnl/vnl_random.h"
+#include "vnl/vnl_math.h"
+
+#include <iostream>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// This test checks the BlockSparseJointPDFDerivatives, which the
+// ParzenWindowHistogramImageToImageMetric uses for the derivatives of the
+// joint histogram to the transform parameters. Each sample adds its
+// contribution to the bins of a Parzen window, for runs of consecutive
+// parameters, like the nonzero Jacobian indices of a B-spline transform.
+// The container is compared with a dense reference:
+//  - every entry, through AddBinsToDense();
+//  - the weighted sum over the bins, through AddWeightedSum();
+//  - the threaded computation of the metric: each thread fills its own
+//    container with part of the samples, the blocks of all threads are
+//    allocated in the first container, and the bins are divided over the
+//    threads for the reduction with AddBins(). The reduction with one and
+//    with four threads gives exactly the same result.
+//  - after Reset() the container gives the same result again.
+
+typedef itk::BlockSparseJointPDFDerivatives< double >  ContainerType;
+typedef ContainerType::SizeValueType                   SizeValueType;
+
+/** The number of parameters is not a multiple of the block size, to test
+ * the partial blocks at the end. */
+const SizeValueType P = 4001;
+const SizeValueType NumberOfMovingBins = 16;
+const SizeValueType NumberOfFixedBins = 16;
+const unsigned int NumberOfSamples = 200;
+const unsigned int ParzenWindowSize = 4;
+const unsigned int RunLength = 4;
+const unsigned int NumberOfRuns = 4;
+const unsigned int NumberOfThreads = 4;
+
+
+/** A sample: the first bin of its Parzen window, the nonzero parameters,
+ * and the values. */
+struct SampleType
+{
+  SizeValueType                 m_MovingBin;
+  SizeValueType                 m_FixedBin;
+  std::vector< SizeValueType >  m_Parameters;
+  std::vector< double >         m_Values;
+};
+
+
+/** Create random samples. */
+void CreateSamples( std::vector< SampleType > & samples )
+{
+  vnl_random random( 343434 );
+  const unsigned int numberOfValues
+    = ParzenWindowSize * ParzenWindowSize * RunLength * NumberOfRuns;
+  samples.resize( NumberOfSamples );
+  for ( unsigned int s = 0; s < NumberOfSamples; ++s )
+  {
+    SampleType & sample = samples[ s ];
+    sample.m_MovingBin = random.lrand32( 0, NumberOfMovingBins - ParzenWindowSize );
+    sample.m_FixedBin = random.lrand32( 0, NumberOfFixedBins - ParzenWindowSize );
+    const SizeValueType first = random.lrand32( 0, 100 );
+    sample.m_Parameters.clear();
+    for ( unsigned int r = 0; r < NumberOfRuns; ++r )
+    {
+      for ( unsigned int i = 0; i < RunLength; ++i )
+      {
+        sample.m_Parameters.push_back( first + 1000 * r + i );
+      }
+    }
+    sample.m_Values.resize( numberOfValues );
+    for ( unsigned int i = 0; i < numberOfValues; ++i )
+    {
+      sample.m_Values[ i ] = random.drand64( -1.0, 1.0 );
+    }
+  }
+
+} // end CreateSamples()
+
+
+/** Add the samples s, for which s % numberOfThreads == threadID, to the
+ * container, as in UpdateJointPDFAndDerivatives(). Several threads may
+ * call this function at the same time for different containers.
+ */
+template < class TContainer >
+void AddSamples( const std::vector< SampleType > & samples,
+  unsigned int threadID, unsigned int numberOfThreads, TContainer & container )
+{
+  for ( unsigned int s = threadID; s < samples.size(); s += numberOfThreads )
+  {
+    const SampleType & sample = samples[ s ];
+    unsigned int v = 0;
+    for ( unsigned int f = 0; f < ParzenWindowSize; ++f )
+    {
+      for ( unsigned int m = 0; m < ParzenWindowSize; ++m )
+      {
+        const SizeValueType bin = ( sample.m_MovingBin + m )
+          + ( sample.m_FixedBin + f ) * NumberOfMovingBins;
+        for ( unsigned int i = 0; i < sample.m_Parameters.size(); ++i, ++v )
+        {
+          container.AddValue( bin, sample.m_Parameters[ i ], sample.m_Values[ v ] );
+        }
+      }
+    }
+  }
+
+} // end AddSamples()
+
+
+/** The dense reference, with the same interface. */
+struct DenseContainerType
+{
+  std::vector< double > m_Values;
+  DenseContainerType() : m_Values( NumberOfMovingBins * NumberOfFixedBins * P, 0.0 ) {}
+  void AddValue( SizeValueType bin, SizeValueType mu, double value )
+  {
+    this->m_Values[ bin * P + mu ] += value;
+  }
+};
+
+
+/** The data for the threads. */
+struct ThreadDataType
+{
+  const std::vector< SampleType > *     m_Samples;
+  std::vector< ContainerType::Pointer > m_Containers;
+};
+
+ITK_THREAD_RETURN_TYPE AddSamplesThreaderCallback( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  ThreadDataType * data = static_cast<ThreadDataType *>( infoStruct->UserData );
+  const unsigned int threadID = infoStruct->ThreadID;
+  AddSamples( *data->m_Samples, threadID, infoStruct->NumberOfThreads,
+    *data->m_Containers[ threadID ] );
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end AddSamplesThreaderCallback()
+
+ITK_THREAD_RETURN_TYPE ReduceThreaderCallback( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  ThreadDataType * data = static_cast<ThreadDataType *>( infoStruct->UserData );
+
+  /** Each thread adds a chunk of the bins of the other containers, in the
+   * order of the containers. */
+  const SizeValueType numberOfBins = data->m_Containers[ 0 ]->GetNumberOfBins();
+  const SizeValueType chunkSize = ( numberOfBins + infoStruct->NumberOfThreads - 1 )
+    / infoStruct->NumberOfThreads;
+  const SizeValueType binBegin = vnl_math_min(
+    infoStruct->ThreadID * chunkSize, numberOfBins );
+  const SizeValueType binEnd = vnl_math_min( binBegin + chunkSize, numberOfBins );
+  for ( unsigned int i = 1; i < data->m_Containers.size(); ++i )
+  {
+    data->m_Containers[ 0 ]->AddBins( data->m_Containers[ i ], binBegin, binEnd );
+  }
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ReduceThreaderCallback()
+
+
+/** Fill one container per thread, and reduce them into the first one with
+ * numberOfReducingThreads threads. Returns the dense version.
+ */
+std::vector< double > ComputeThreaded( const std::vector< SampleType > & samples,
+  unsigned int numberOfReducingThreads )
+{
+  ThreadDataType data;
+  data.m_Samples = &samples;
+  data.m_Containers.resize( NumberOfThreads );
+  for ( unsigned int i = 0; i < NumberOfThreads; ++i )
+  {
+    data.m_Containers[ i ] = ContainerType::New();
+    data.m_Containers[ i ]->SetSize( P, NumberOfMovingBins, NumberOfFixedBins );
+  }
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( NumberOfThreads );
+  threader->SetSingleMethod( AddSamplesThreaderCallback, &data );
+  threader->SingleMethodExecute();
+
+  for ( unsigned int i = 1; i < NumberOfThreads; ++i )
+  {
+    data.m_Containers[ 0 ]->AllocateBlocksOf( data.m_Containers[ i ] );
+  }
+  threader->SetNumberOfThreads( numberOfReducingThreads );
+  threader->SetSingleMethod( ReduceThreaderCallback, &data );
+  threader->SingleMethodExecute();
+
+  std::vector< double > dense( NumberOfMovingBins * NumberOfFixedBins * P, 0.0 );
+  data.m_Containers[ 0 ]->AddBinsToDense( &dense[ 0 ], 0,
+    data.m_Containers[ 0 ]->GetNumberOfBins() );
+  return dense;
+
+} // end ComputeThreaded()
+
+
+/** Compare with the dense reference. */
+bool Compare( const std::vector< double > & values,
+  const std::vector< double > & reference, const char * name )
+{
+  const double tolerance = 1e-10;
+  for ( SizeValueType i = 0; i < reference.size(); ++i )
+  {
+    if ( vnl_math_abs( values[ i ] - reference[ i ] ) > tolerance )
+    {
+      std::cerr << "ERROR: " << name << ": entry (" << i % P << ", bin "
+        << i / P << ") is " << values[ i ] << " instead of "
+        << reference[ i ] << ".\n";
+      return false;
+    }
+  }
+  return true;
+
+} // end Compare()
+
+
+int main( int argc, char *argv[] )
+{
+  std::vector< SampleType > samples;
+  CreateSamples( samples );
+
+  DenseContainerType reference;
+  AddSamples( samples, 0, 1, reference );
+
+  /** All samples in one container. */
+  ContainerType::Pointer container = ContainerType::New();
+  container->SetSize( P, NumberOfMovingBins, NumberOfFixedBins );
+  AddSamples( samples, 0, 1, *container );
+  std::vector< double > dense( reference.m_Values.size(), 0.0 );
+  container->AddBinsToDense( &dense[ 0 ], 0, container->GetNumberOfBins() );
+  if ( !Compare( dense, reference.m_Values, "single container" ) ) return 1;
+
+  /** Only the blocks of the runs of parameters are allocated. */
+  const SizeValueType numberOfBlocks = container->GetNumberOfAllocatedBlocks();
+  const SizeValueType numberOfDenseBlocks = container->GetNumberOfBins()
+    * ( ( P + ContainerType::BlockSize - 1 ) / ContainerType::BlockSize );
+  if ( numberOfBlocks >= numberOfDenseBlocks / 4 )
+  {
+    std::cerr << "ERROR: the container is not sparse: " << numberOfBlocks
+      << " of " << numberOfDenseBlocks << " blocks.\n";
+    return 1;
+  }
+
+  /** The weighted sum over the bins. */
+  vnl_random random( 565656 );
+  std::vector< double > binWeights( container->GetNumberOfBins() );
+  for ( SizeValueType bin = 0; bin < binWeights.size(); ++bin )
+  {
+    binWeights[ bin ] = random.drand64( -1.0, 1.0 );
+  }
+  std::vector< double > derivative( P, 0.0 );
+  std::vector< double > referenceDerivative( P, 0.0 );
+  container->AddWeightedSum( &binWeights[ 0 ], &derivative[ 0 ] );
+  for ( SizeValueType bin = 0; bin < binWeights.size(); ++bin )
+  {
+    for ( SizeValueType mu = 0; mu < P; ++mu )
+    {
+      referenceDerivative[ mu ] += binWeights[ bin ] * reference.m_Values[ bin * P + mu ];
+    }
+  }
+  if ( !Compare( derivative, referenceDerivative, "weighted sum" ) ) return 1;
+
+  /** The threaded computation, reduced with one and with several threads. */
+  const std::vector< double > dense1 = ComputeThreaded( samples, 1 );
+  const std::vector< double > denseN = ComputeThreaded( samples, NumberOfThreads );
+  if ( !Compare( dense1, reference.m_Values, "threaded" ) ) return 1;
+  if ( dense1 != denseN )
+  {
+    std::cerr << "ERROR: the reduction depends on the number of threads.\n";
+    return 1;
+  }
+
+  /** After a reset the container is empty, and can be filled again. */
+  container->Reset();
+  if ( container->GetNumberOfAllocatedBlocks() != 0 )
+  {
+    std::cerr << "ERROR: Reset() did not release the blocks.\n";
+    return 1;
+  }
+  AddSamples( samples, 0, 1, *container );
+  std::vector< double > denseReset( reference.m_Values.size(), 0.0 );
+  container->AddBinsToDense( &denseReset[ 0 ], 0, container->GetNumberOfBins() );
+  if ( denseReset != dense )
+  {
+    std::cerr << "ERROR: the container differs after Reset().\n";
+    return 1;
+  }
+
+  std::cerr << "BlockSparseJointPDFDerivatives: " << numberOfBlocks << " of "
+    << numberOfDenseBlocks << " blocks, "
+    << container->GetMemoryUsage() << " bytes.\n";
+
+  return 0;
+
+} // end main()
@@ -0,0 +1,213 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+#include "AdaptiveStochasticGradientDescent/itkBlockSparseSymmetricMatrix.h"
+#include "vnl/vnl_matrix.h"
+
+#include <iostream>
+#include <set>
+#include <utility>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// This test checks the BlockSparseSymmetricMatrix, which the
+// AdaptiveStochasticGradientDescent uses for the covariance matrix of the
+// Jacobian:
+//  - the accumulation of the upper triangle with AddValue(), compared with
+//    a dense symmetric reference, in both orders of (p,q);
+//  - only the blocks that were updated are allocated;
+//  - the merge of two partial matrices, through GetBlockInRow() and
+//    GetBlock(), gives the same matrix as the accumulation in one matrix.
+// The values are exactly representable, so the order of the additions does
+// not matter.
+
+typedef itk::BlockSparseSymmetricMatrix< double >   MatrixType;
+typedef MatrixType::SizeValueType                   SizeValueType;
+typedef vnl_matrix< double >                        DenseMatrixType;
+
+/** The number of rows is not a multiple of the block size, to test the
+ * partial blocks at the end. */
+const SizeValueType P = 21;
+
+
+/** A contribution to entry (p,q), with p <= q. */
+struct ContributionType
+{
+  SizeValueType m_P;
+  SizeValueType m_Q;
+  double        m_Value;
+};
+
+
+/** The diagonal and the first off-diagonal, twice, and two entries far
+ * from the diagonal. The other blocks are not updated. */
+void CreateContributions( std::vector< ContributionType > & contributions )
+{
+  contributions.clear();
+  for ( unsigned int repeat = 0; repeat < 2; ++repeat )
+  {
+    for ( SizeValueType p = 0; p < P; ++p )
+    {
+      for ( SizeValueType q = p; q < P && q <= p + 1; ++q )
+      {
+        ContributionType c = { p, q, 1.0 + p + 0.5 * q + 0.25 * repeat };
+        contributions.push_back( c );
+      }
+    }
+  }
+  ContributionType far1 = { 0, 20, -3.0 };
+  ContributionType far2 = { 3, 17, 2.5 };
+  contributions.push_back( far1 );
+  contributions.push_back( far2 );
+
+} // end CreateContributions()
+
+
+/** Add every step'th contribution, starting at first. */
+void AddContributions( const std::vector< ContributionType > & contributions,
+  unsigned int first, unsigned int step, MatrixType * matrix )
+{
+  for ( unsigned int i = first; i < contributions.size(); i += step )
+  {
+    const ContributionType & c = contributions[ i ];
+    matrix->AddValue( c.m_P, c.m_Q, c.m_Value );
+  }
+
+} // end AddContributions()
+
+
+/** Add the allocated blocks of source to target. */
+void MergeMatrix( MatrixType * source, MatrixType * target )
+{
+  for ( SizeValueType blockRow = 0; blockRow < source->GetNumberOfBlockRows(); ++blockRow )
+  {
+    for ( SizeValueType i = 0; i < source->GetNumberOfBlocksInRow( blockRow ); ++i )
+    {
+      SizeValueType blockColumn;
+      const double * sourceBlock = source->GetBlockInRow( blockRow, i, blockColumn );
+      double * targetBlock = target->GetBlock( blockRow, blockColumn );
+      for ( unsigned int e = 0; e < MatrixType::NumberOfBlockEntries; ++e )
+      {
+        targetBlock[ e ] += sourceBlock[ e ];
+      }
+    }
+  }
+
+} // end MergeMatrix()
+
+
+/** Compare all entries of matrix with the dense reference. */
+bool CompareWithDense( const MatrixType * matrix,
+  const DenseMatrixType & dense, const char * name )
+{
+  for ( SizeValueType p = 0; p < P; ++p )
+  {
+    for ( SizeValueType q = 0; q < P; ++q )
+    {
+      if ( matrix->GetValue( p, q ) != dense( p, q ) )
+      {
+        std::cerr << "ERROR: entry (" << p << "," << q << ") of the "
+          << name << " matrix is " << matrix->GetValue( p, q )
+          << " instead of " << dense( p, q ) << ".\n";
+        return false;
+      }
+    }
+  }
+  return true;
+
+} // end CompareWithDense()
+
+
+int main( int argc, char *argv[] )
+{
+  std::vector< ContributionType > contributions;
+  CreateContributions( contributions );
+
+  /** The dense symmetric reference, and the blocks that are updated. */
+  DenseMatrixType dense( P, P, 0.0 );
+  std::set< std::pair< SizeValueType, SizeValueType > > blocks;
+  for ( unsigned int i = 0; i < contributions.size(); ++i )
+  {
+    const ContributionType & c = contributions[ i ];
+    dense( c.m_P, c.m_Q ) += c.m_Value;
+    if ( c.m_P != c.m_Q )
+    {
+      dense( c.m_Q, c.m_P ) += c.m_Value;
+    }
+    blocks.insert( std::make_pair( c.m_P >> MatrixType::BlockSizeLog2,
+      c.m_Q >> MatrixType::BlockSizeLog2 ) );
+  }
+
+  /** Accumulate all contributions in one matrix. */
+  MatrixType::Pointer matrix = MatrixType::New();
+  matrix->SetSize( P );
+  AddContributions( contributions, 0, 1, matrix );
+  if ( !CompareWithDense( matrix, dense, "accumulated" ) )
+  {
+    return 1;
+  }
+
+  /** Only the updated blocks are allocated. */
+  if ( matrix->GetNumberOfAllocatedBlocks() != blocks.size() )
+  {
+    std::cerr << "ERROR: " << matrix->GetNumberOfAllocatedBlocks()
+      << " blocks are allocated instead of " << blocks.size() << ".\n";
+    return 1;
+  }
+  for ( SizeValueType blockRow = 0; blockRow < matrix->GetNumberOfBlockRows(); ++blockRow )
+  {
+    for ( SizeValueType blockColumn = blockRow;
+      blockColumn < matrix->GetNumberOfBlockRows(); ++blockColumn )
+    {
+      const bool allocated = matrix->FindBlock( blockRow, blockColumn ) != 0;
+      if ( allocated != ( blocks.count( std::make_pair( blockRow, blockColumn ) ) > 0 ) )
+      {
+        std::cerr << "ERROR: block (" << blockRow << "," << blockColumn
+          << ") is " << ( allocated ? "" : "not " ) << "allocated.\n";
+        return 1;
+      }
+    }
+  }
+
+  /** Accumulate the even and the odd contributions in two matrices, and
+   * merge them. */
+  MatrixType::Pointer merged = MatrixType::New();
+  MatrixType::Pointer odd = MatrixType::New();
+  merged->SetSize( P );
+  odd->SetSize( P );
+  AddContributions( contributions, 0, 2, merged );
+  AddContributions( contributions, 1, 2, odd );
+  MergeMatrix( odd, merged );
+  if ( !CompareWithDense( merged, dense, "merged" ) )
+  {
+    return 1;
+  }
+  if ( merged->GetNumberOfAllocatedBlocks() != blocks.size() )
+  {
+    std::cerr << "ERROR: the merged matrix has "
+      << merged->GetNumberOfAllocatedBlocks() << " blocks instead of "
+      << blocks.size() << ".\n";
+    return 1;
+  }
+
+  /** SetSize() removes all entries. */
+  merged->SetSize( P );
+  if ( merged->GetNumberOfAllocatedBlocks() != 0 || merged->GetValue( 0, 0 ) != 0.0 )
+  {
+    std::cerr << "ERROR: SetSize() does not remove the entries.\n";
+    return 1;
+  }
+
+  return 0;
+
+} // end main()
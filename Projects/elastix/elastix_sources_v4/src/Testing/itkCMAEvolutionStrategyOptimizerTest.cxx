@@ -0,0 +1,196 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+#include "itkCMAEvolutionStrategyOptimizer.h"
+#include "itkSingleValuedCostFunction.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "vcl_cmath.h"
+#include <iostream>
+#include <vector>
+
+/**
+ * This test runs the itk::CMAEvolutionStrategyOptimizer with the population
+ * evaluated sequentially, and concurrently by copies of the cost function.
+ * The cost function fails at part of the positions, so that members are
+ * redrawn. Both runs start from the same random seed, and have to give the
+ * same result. Only the failed members may be evaluated again, so each
+ * generation makes one successful evaluation per member, plus one at the
+ * new mean.
+ */
+
+namespace itk
+{
+
+/** A quadratic cost function, that throws at about a fifth of the positions. */
+class CMATestCostFunction : public SingleValuedCostFunction
+{
+public:
+  typedef CMATestCostFunction         Self;
+  typedef SingleValuedCostFunction    Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+  itkNewMacro( Self );
+  itkTypeMacro( CMATestCostFunction, SingleValuedCostFunction );
+
+  typedef Superclass::MeasureType     MeasureType;
+  typedef Superclass::ParametersType  ParametersType;
+  typedef Superclass::DerivativeType  DerivativeType;
+
+  unsigned int GetNumberOfParameters( void ) const { return 3; }
+
+  /** Each cost function is used by one thread at a time. */
+  itkGetConstMacro( NumberOfSuccessfulEvaluations, unsigned long );
+
+  MeasureType GetValue( const ParametersType & parameters ) const
+  {
+    if ( vcl_sin( 1000.0 * parameters[ 0 ] ) > 0.8 )
+    {
+      itkExceptionMacro( << "Sample failure at " << parameters );
+    }
+    ++this->m_NumberOfSuccessfulEvaluations;
+    MeasureType value = 0.0;
+    for ( unsigned int j = 0; j < parameters.GetSize(); ++j )
+    {
+      const double x = parameters[ j ] - static_cast<double>( j );
+      value += ( j + 1.0 ) * x * x;
+    }
+    return value;
+  }
+
+  void GetDerivative( const ParametersType &, DerivativeType & ) const
+  {
+    itkExceptionMacro( << "Not implemented." );
+  }
+
+protected:
+  CMATestCostFunction() : m_NumberOfSuccessfulEvaluations( 0 ) {}
+  virtual ~CMATestCostFunction() {}
+
+private:
+  mutable unsigned long m_NumberOfSuccessfulEvaluations;
+};
+
+} // end namespace itk
+
+
+int RunOptimizer( unsigned int numberOfCopies,
+  itk::CMAEvolutionStrategyOptimizer::ParametersType & position,
+  unsigned long & iterations )
+{
+  typedef itk::CMATestCostFunction                CostFunctionType;
+  typedef itk::CMAEvolutionStrategyOptimizer      OptimizerType;
+  typedef OptimizerType::ParametersType           ParametersType;
+  typedef OptimizerType::ScalesType               ScalesType;
+
+  ParametersType initialPosition( 3 );
+  ScalesType scales( 3 );
+  for ( unsigned int j = 0; j < 3; ++j )
+  {
+    initialPosition[ j ] = 2.0 - j;
+    scales[ j ] = 1.0 + j;
+  }
+
+  std::vector<CostFunctionType::Pointer> costFunctionList;
+  costFunctionList.push_back( CostFunctionType::New() );
+  for ( unsigned int i = 0; i < numberOfCopies; ++i )
+  {
+    costFunctionList.push_back( CostFunctionType::New() );
+  }
+  CostFunctionType * costFunction = costFunctionList[ 0 ];
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetCostFunction( costFunction );
+  optimizer->SetInitialPosition( initialPosition );
+  optimizer->SetScales( scales );
+  optimizer->SetUseScales( true );
+  optimizer->SetMaximumNumberOfIterations( 40 );
+  optimizer->SetInitialSigma( 0.5 );
+
+  if ( numberOfCopies > 0 )
+  {
+    OptimizerType::CostFunctionContainerType costFunctions;
+    for ( unsigned int i = 0; i <= numberOfCopies; ++i )
+    {
+      costFunctions.push_back( costFunctionList[ i ].GetPointer() );
+    }
+    optimizer->SetConcurrentCostFunctions( costFunctions );
+  }
+
+  /** The optimizer draws from the global random generator. */
+  itk::Statistics::MersenneTwisterRandomVariateGenerator::GetInstance()
+    ->Initialize( 121212 );
+
+  try
+  {
+    optimizer->StartOptimization();
+  }
+  catch ( itk::ExceptionObject & excp )
+  {
+    std::cerr << "Optimization with " << numberOfCopies
+      << " copies failed: " << excp << std::endl;
+    return 1;
+  }
+
+  position = optimizer->GetCurrentPosition();
+  iterations = optimizer->GetCurrentIteration();
+
+  /** Check that no successful evaluation was discarded. Besides the
+   * members, the mean is evaluated at the start and after each generation. */
+  unsigned long numberOfSuccessfulEvaluations = 0;
+  for ( unsigned int i = 0; i <= numberOfCopies; ++i )
+  {
+    numberOfSuccessfulEvaluations
+      += costFunctionList[ i ]->GetNumberOfSuccessfulEvaluations();
+  }
+  const unsigned long evaluationsPerGeneration
+    = optimizer->GetPopulationSize() + 1;
+  if ( ( numberOfSuccessfulEvaluations - 1 ) % evaluationsPerGeneration != 0 )
+  {
+    std::cerr << "Optimization with " << numberOfCopies << " copies made "
+      << numberOfSuccessfulEvaluations << " successful evaluations, "
+      << "which does not match a population size of "
+      << optimizer->GetPopulationSize() << "." << std::endl;
+    return 1;
+  }
+
+  return 0;
+
+} // end RunOptimizer()
+
+
+int main( int argc, char *argv[] )
+{
+  itk::CMAEvolutionStrategyOptimizer::ParametersType sequentialPosition;
+  itk::CMAEvolutionStrategyOptimizer::ParametersType concurrentPosition;
+  unsigned long sequentialIterations = 0;
+  unsigned long concurrentIterations = 0;
+
+  if ( RunOptimizer( 0, sequentialPosition, sequentialIterations )
+    || RunOptimizer( 3, concurrentPosition, concurrentIterations ) )
+  {
+    return 1;
+  }
+
+  if ( sequentialIterations != concurrentIterations
+    || sequentialPosition != concurrentPosition )
+  {
+    std::cerr << "Concurrent evaluation differs from sequential evaluation: "
+      << concurrentPosition << " after " << concurrentIterations
+      << " iterations, versus " << sequentialPosition << " after "
+      << sequentialIterations << " iterations." << std::endl;
+    return 1;
+  }
+
+  return 0;
+
+} // end main()
@@ -0,0 +1,210 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+#include "itkConcurrentCostFunctionEvaluator.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkCommand.h"
+#include "vnl/vnl_math.h"
+#include <itksys/SystemTools.hxx>
+#include <iostream>
+
+/**
+ * This test checks that the ConcurrentCostFunctionEvaluator evaluates the
+ * positions at the same time, the first cost function included, and that
+ * it executes the PrepareCommand once, before the evaluations. Each
+ * evaluation waits until the expected number of evaluations runs at the
+ * same time, or until a timeout, so a sequential evaluation fails.
+ */
+
+/** The state that the cost functions share. */
+struct ConcurrencyStateType
+{
+  itk::SimpleFastMutexLock  m_Lock;
+  unsigned int              m_Active;
+  unsigned int              m_MaximumActive;
+  unsigned int              m_Expected;
+  unsigned int              m_NumberOfPrepares;
+  unsigned int              m_NumberOfUnpreparedEvaluations;
+
+  void Reset( unsigned int expected )
+  {
+    this->m_Active = 0;
+    this->m_MaximumActive = 0;
+    this->m_Expected = expected;
+    this->m_NumberOfPrepares = 0;
+    this->m_NumberOfUnpreparedEvaluations = 0;
+  }
+
+  void Prepare( void )
+  {
+    ++this->m_NumberOfPrepares;
+  }
+};
+
+namespace itk
+{
+
+/** Returns the sum of the parameters, after waiting for the others. */
+class ConcurrencyTestCostFunction : public SingleValuedCostFunction
+{
+public:
+  typedef ConcurrencyTestCostFunction Self;
+  typedef SingleValuedCostFunction    Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+  itkNewMacro( Self );
+  itkTypeMacro( ConcurrencyTestCostFunction, SingleValuedCostFunction );
+
+  typedef Superclass::MeasureType     MeasureType;
+  typedef Superclass::ParametersType  ParametersType;
+  typedef Superclass::DerivativeType  DerivativeType;
+
+  void SetState( ConcurrencyStateType * state ) { this->m_State = state; }
+
+  unsigned int GetNumberOfParameters( void ) const { return 2; }
+
+  MeasureType GetValue( const ParametersType & parameters ) const
+  {
+    ConcurrencyStateType & state = *this->m_State;
+    state.m_Lock.Lock();
+    ++state.m_Active;
+    state.m_MaximumActive = vnl_math_max( state.m_MaximumActive, state.m_Active );
+    if ( state.m_NumberOfPrepares == 0 )
+    {
+      ++state.m_NumberOfUnpreparedEvaluations;
+    }
+    state.m_Lock.Unlock();
+
+    /** Wait at most 5 seconds for the other evaluations. */
+    for ( unsigned int ms = 0; ms < 5000; ++ms )
+    {
+      state.m_Lock.Lock();
+      const bool done = state.m_MaximumActive >= state.m_Expected;
+      state.m_Lock.Unlock();
+      if ( done ) break;
+      itksys::SystemTools::Delay( 1 );
+    }
+
+    state.m_Lock.Lock();
+    --state.m_Active;
+    state.m_Lock.Unlock();
+
+    if ( parameters[ 0 ] < 0.0 )
+    {
+      itkExceptionMacro( << "Negative parameter." );
+    }
+    return parameters[ 0 ] + parameters[ 1 ];
+  }
+
+  void GetDerivative( const ParametersType &, DerivativeType & ) const
+  {
+    itkExceptionMacro( << "Not implemented." );
+  }
+
+protected:
+  ConcurrencyTestCostFunction() : m_State( 0 ) {}
+  virtual ~ConcurrencyTestCostFunction() {}
+
+private:
+  ConcurrencyStateType * m_State;
+};
+
+} // end namespace itk
+
+
+int TestEvaluator( unsigned int numberOfCostFunctions,
+  unsigned int numberOfPositions )
+{
+  typedef itk::ConcurrentCostFunctionEvaluator      EvaluatorType;
+  typedef itk::ConcurrencyTestCostFunction          CostFunctionType;
+  typedef itk::SimpleMemberCommand< ConcurrencyStateType > PrepareCommandType;
+
+  /** With a single cost function or position, all evaluations are done in
+   * the calling thread, without preparation. */
+  const bool concurrent = numberOfCostFunctions > 1 && numberOfPositions > 1;
+  ConcurrencyStateType state;
+  state.Reset( concurrent
+    ? vnl_math_min( numberOfCostFunctions, numberOfPositions ) : 1 );
+
+  EvaluatorType::CostFunctionContainerType costFunctions;
+  for ( unsigned int i = 0; i < numberOfCostFunctions; ++i )
+  {
+    CostFunctionType::Pointer costFunction = CostFunctionType::New();
+    costFunction->SetState( &state );
+    costFunctions.push_back( costFunction.GetPointer() );
+  }
+  PrepareCommandType::Pointer prepareCommand = PrepareCommandType::New();
+  prepareCommand->SetCallbackFunction( &state, &ConcurrencyStateType::Prepare );
+
+  EvaluatorType::Pointer evaluator = EvaluatorType::New();
+  evaluator->SetCostFunctions( costFunctions );
+  evaluator->SetPrepareCommand( prepareCommand );
+
+  /** The last position fails. */
+  EvaluatorType::ParametersContainerType positions( numberOfPositions,
+    EvaluatorType::ParametersType( 2 ) );
+  for ( unsigned int i = 0; i < numberOfPositions; ++i )
+  {
+    positions[ i ][ 0 ] = ( i + 1 < numberOfPositions ) ? i : -1.0;
+    positions[ i ][ 1 ] = 0.5;
+  }
+
+  EvaluatorType::MeasureContainerType values;
+  EvaluatorType::FailedContainerType failed;
+  evaluator->GetValues( positions, values, failed );
+
+  for ( unsigned int i = 0; i < numberOfPositions; ++i )
+  {
+    const bool shouldFail = i + 1 == numberOfPositions;
+    if ( ( failed[ i ] != 0 ) != shouldFail
+      || ( !shouldFail && values[ i ] != i + 0.5 ) )
+    {
+      std::cerr << "ERROR: wrong result at position " << i << " with "
+        << numberOfCostFunctions << " cost functions." << std::endl;
+      return 1;
+    }
+  }
+
+  if ( state.m_MaximumActive != state.m_Expected )
+  {
+    std::cerr << "ERROR: " << state.m_MaximumActive << " instead of "
+      << state.m_Expected << " evaluations ran at the same time, with "
+      << numberOfCostFunctions << " cost functions and "
+      << numberOfPositions << " positions." << std::endl;
+    return 1;
+  }
+
+  const unsigned int expectedPrepares = concurrent ? 1 : 0;
+  if ( state.m_NumberOfPrepares != expectedPrepares
+    || ( concurrent && state.m_NumberOfUnpreparedEvaluations != 0 ) )
+  {
+    std::cerr << "ERROR: the PrepareCommand was executed "
+      << state.m_NumberOfPrepares << " times, and "
+      << state.m_NumberOfUnpreparedEvaluations
+      << " evaluations started before it." << std::endl;
+    return 1;
+  }
+
+  return 0;
+
+} // end TestEvaluator()
+
+
+int main( int argc, char *argv[] )
+{
+  /** Two positions on two cost functions, as the default SPSA; more
+   * positions than cost functions; and a single cost function. */
+  return TestEvaluator( 2, 2 ) || TestEvaluator( 3, 7 )
+    || TestEvaluator( 1, 3 );
+
+} // end main()
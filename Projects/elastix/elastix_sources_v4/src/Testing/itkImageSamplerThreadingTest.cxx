@@ -0,0 +1,210 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+#include "itkImage.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageMaskSpatialObject2.h"
+#include "itkImageFullSampler.h"
+#include "itkImageGridSampler.h"
+#include "itkImageRandomSampler.h"
+#include "itkImageRandomCoordinateSampler.h"
+
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test checks that the multi-threaded image samplers generate the same
+// sample set with one thread as with several threads, for the same random
+// seed. The samplers are run with a disc-shaped mask. For the random
+// samplers it also checks that a mask that is too sparse makes the sampler
+// fail, independent of the number of threads.
+
+const unsigned int Dimension = 2;
+typedef itk::Image< short, Dimension >                  ImageType;
+typedef itk::Image< unsigned char, Dimension >          MaskImageType;
+typedef itk::ImageMaskSpatialObject2< Dimension >       MaskType;
+typedef itk::ImageSamplerBase< ImageType >              SamplerBaseType;
+typedef SamplerBaseType::ImageSampleContainerType       SampleContainerType;
+
+
+/** Create an image of size x size with a ramp, and a mask with a disc of
+ * the given radius in the center. If the radius is 0, the mask only
+ * contains two opposite corners instead, so that the bounding box of the
+ * mask is the whole image. */
+void CreateImageAndMask( unsigned long size, double radius,
+  ImageType::Pointer & image, MaskType::Pointer & mask )
+{
+  ImageType::RegionType region;
+  region.SetSize( 0, size );
+  region.SetSize( 1, size );
+
+  image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  MaskImageType::Pointer maskImage = MaskImageType::New();
+  maskImage->SetRegions( region );
+  maskImage->Allocate();
+
+  itk::ImageRegionIterator< ImageType > it( image, region );
+  itk::ImageRegionIterator< MaskImageType > mit( maskImage, region );
+  const double center = 0.5 * ( size - 1 );
+  for ( it.GoToBegin(), mit.GoToBegin(); !it.IsAtEnd(); ++it, ++mit )
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set( static_cast<short>( index[ 0 ] + 3 * index[ 1 ] ) );
+    const double dx = index[ 0 ] - center;
+    const double dy = index[ 1 ] - center;
+    if ( radius > 0.0 )
+    {
+      mit.Set( dx * dx + dy * dy <= radius * radius ? 1 : 0 );
+    }
+    else
+    {
+      mit.Set( index[ 0 ] == index[ 1 ] && ( index[ 0 ] == 0
+        || index[ 0 ] == static_cast<long>( size - 1 ) ) ? 1 : 0 );
+    }
+  }
+
+  mask = MaskType::New();
+  mask->SetImage( maskImage );
+
+} // end CreateImageAndMask()
+
+
+/** Run the sampler with the given number of threads. Returns false if
+ * the sampler threw an exception. */
+bool RunSampler( SamplerBaseType * sampler, unsigned int numberOfThreads,
+  SampleContainerType::Pointer & samples )
+{
+  /** Setting the seed again restarts the random sample sets. */
+  sampler->SetUseMultiThread( true );
+  sampler->SetNumberOfThreads( numberOfThreads );
+  sampler->SetRandomSeed( sampler->GetRandomSeed() );
+  sampler->Modified();
+  try
+  {
+    sampler->Update();
+  }
+  catch ( itk::ExceptionObject & )
+  {
+    return false;
+  }
+  samples = sampler->GetOutput();
+  samples->DisconnectPipeline();
+
+  return true;
+
+} // end RunSampler()
+
+
+/** Returns 0 if the sampler gives the same samples, and the same failure
+ * state, with one thread and with four threads. */
+int TestSampler( const char * name, SamplerBaseType * sampler,
+  bool expectFailure )
+{
+  SampleContainerType::Pointer samples1;
+  SampleContainerType::Pointer samples4;
+  const bool success1 = RunSampler( sampler, 1, samples1 );
+  const bool success4 = RunSampler( sampler, 4, samples4 );
+
+  if ( success1 != success4 )
+  {
+    std::cerr << name << ": failure depends on the number of threads.\n";
+    return 1;
+  }
+  if ( success1 == expectFailure )
+  {
+    std::cerr << name << ": expected "
+      << ( expectFailure ? "failure" : "success" ) << ".\n";
+    return 1;
+  }
+  if ( !success1 ) return 0;
+
+  if ( samples1->Size() == 0 || samples1->Size() != samples4->Size() )
+  {
+    std::cerr << name << ": number of samples differs: "
+      << samples1->Size() << " and " << samples4->Size() << ".\n";
+    return 1;
+  }
+  for ( unsigned long i = 0; i < samples1->Size(); ++i )
+  {
+    if ( samples1->GetImageCoordinates( i ) != samples4->GetImageCoordinates( i )
+      || samples1->GetImageValue( i ) != samples4->GetImageValue( i ) )
+    {
+      std::cerr << name << ": sample " << i << " differs.\n";
+      return 1;
+    }
+  }
+
+  std::cerr << name << ": " << samples1->Size() << " equal samples.\n";
+  return 0;
+
+} // end TestSampler()
+
+
+int main( int argc, char *argv[] )
+{
+  ImageType::Pointer image;
+  MaskType::Pointer mask;
+  MaskType::Pointer sparseMask;
+  CreateImageAndMask( 64, 20.0, image, mask );
+  ImageType::Pointer dummy;
+  CreateImageAndMask( 64, 0.0, dummy, sparseMask );
+
+  int result = 0;
+
+  /** The full sampler. */
+  typedef itk::ImageFullSampler< ImageType > FullSamplerType;
+  FullSamplerType::Pointer fullSampler = FullSamplerType::New();
+  fullSampler->SetInput( image );
+  fullSampler->SetMask( mask );
+  result |= TestSampler( "ImageFullSampler", fullSampler, false );
+
+  /** The grid sampler. */
+  typedef itk::ImageGridSampler< ImageType > GridSamplerType;
+  GridSamplerType::Pointer gridSampler = GridSamplerType::New();
+  GridSamplerType::SampleGridSpacingType gridSpacing;
+  gridSpacing.Fill( 3 );
+  gridSampler->SetInput( image );
+  gridSampler->SetMask( mask );
+  gridSampler->SetSampleGridSpacing( gridSpacing );
+  result |= TestSampler( "ImageGridSampler", gridSampler, false );
+
+  /** The random sampler. */
+  typedef itk::ImageRandomSampler< ImageType > RandomSamplerType;
+  RandomSamplerType::Pointer randomSampler = RandomSamplerType::New();
+  randomSampler->SetInput( image );
+  randomSampler->SetMask( mask );
+  randomSampler->SetNumberOfSamples( 1000 );
+  randomSampler->SetRandomSeed( 121212 );
+  result |= TestSampler( "ImageRandomSampler", randomSampler, false );
+  randomSampler->SetMask( sparseMask );
+  result |= TestSampler( "ImageRandomSampler (sparse mask)", randomSampler, true );
+
+  /** The random coordinate sampler. */
+  typedef itk::ImageRandomCoordinateSampler< ImageType > RandomCoordinateSamplerType;
+  RandomCoordinateSamplerType::Pointer randomCoordinateSampler
+    = RandomCoordinateSamplerType::New();
+  randomCoordinateSampler->SetInput( image );
+  randomCoordinateSampler->SetMask( mask );
+  randomCoordinateSampler->SetNumberOfSamples( 1000 );
+  randomCoordinateSampler->SetRandomSeed( 121212 );
+  result |= TestSampler( "ImageRandomCoordinateSampler",
+    randomCoordinateSampler, false );
+  randomCoordinateSampler->SetMask( sparseMask );
+  result |= TestSampler( "ImageRandomCoordinateSampler (sparse mask)",
+    randomCoordinateSampler, true );
+
+  return result;
+
+} // end main()
@@ -0,0 +1,222 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+#include "itkListSampleCArray.h"
+#include "itkANNkDTree.h"
+#include "itkANNStandardTreeSearch.h"
+#include "itkANNFixedRadiusTreeSearch.h"
+#include "itkANNPriorityTreeSearch.h"
+#include "itkArray.h"
+#include "vnl/vnl_random.h"
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// This test checks the multi-threaded construction of the ANN kD-tree and
+// the multi-threaded BatchSearch(), which the KNNGraphAlphaMutualInformation
+// metric uses:
+//  - a tree that is built with four threads is identical to a tree that
+//    is built with one thread;
+//  - for the standard, the fixed radius and the priority search, the
+//    batch search with four threads gives exactly the same neighbours and
+//    distances as with one thread;
+//  - the standard search with an error bound of zero finds the same
+//    distances as a brute force search.
+
+typedef itk::Array< double >                            MeasurementVectorType;
+typedef itk::Statistics::ListSampleCArray<
+  MeasurementVectorType, double >                       ListSampleType;
+typedef itk::ANNkDTree< ListSampleType >                TreeType;
+typedef itk::BinaryTreeSearchBase< ListSampleType >     SearchType;
+typedef itk::ANNStandardTreeSearch< ListSampleType >    StandardSearchType;
+typedef itk::ANNFixedRadiusTreeSearch< ListSampleType > FixedRadiusSearchType;
+typedef itk::ANNPriorityTreeSearch< ListSampleType >    PrioritySearchType;
+typedef SearchType::IndexMatrixType                     IndexMatrixType;
+typedef SearchType::DistanceMatrixType                  DistanceMatrixType;
+
+const unsigned int Dimension = 5;
+const unsigned long NumberOfPoints = 5000;
+const unsigned int KNearestNeighbors = 5;
+const unsigned int NumberOfThreads = 4;
+
+
+/** Create a tree with the given number of threads. */
+TreeType::Pointer CreateTree( ListSampleType * sample, unsigned int numberOfThreads )
+{
+  TreeType::Pointer tree = TreeType::New();
+  tree->SetBucketSize( 5 );
+  tree->SetNumberOfThreads( numberOfThreads );
+  tree->SetSample( sample );
+  tree->GenerateTree();
+  return tree;
+
+} // end CreateTree()
+
+
+/** Dump the tree to a string. */
+std::string DumpTree( const TreeType * tree )
+{
+  ANNkd_tree * annTree = dynamic_cast<ANNkd_tree *>( tree->GetANNTree() );
+  std::ostringstream dump;
+  dump.precision( 17 );
+  annTree->Dump( ANNfalse, dump );
+  return dump.str();
+
+} // end DumpTree()
+
+
+/** Search all points, and compare the results for one thread and for
+ * NumberOfThreads threads.
+ */
+bool CompareBatchSearch( const char * name, SearchType * search1,
+  SearchType * searchN, ListSampleType * sample,
+  IndexMatrixType & ind, DistanceMatrixType & dists )
+{
+  IndexMatrixType indN;
+  DistanceMatrixType distsN;
+  search1->SetNumberOfThreads( 1 );
+  search1->BatchSearch( sample, NumberOfPoints, ind, dists );
+  searchN->SetNumberOfThreads( NumberOfThreads );
+  searchN->BatchSearch( sample, NumberOfPoints, indN, distsN );
+
+  for ( unsigned long i = 0; i < NumberOfPoints; ++i )
+  {
+    for ( unsigned int k = 0; k < KNearestNeighbors; ++k )
+    {
+      if ( ind( i, k ) != indN( i, k ) || dists( i, k ) != distsN( i, k ) )
+      {
+        std::cerr << "ERROR: the " << name << " search of point " << i
+          << " depends on the number of threads.\n";
+        return false;
+      }
+    }
+  }
+  std::cerr << "The " << name << " search gives the same result with 1 and "
+    << NumberOfThreads << " threads.\n";
+  return true;
+
+} // end CompareBatchSearch()
+
+
+int main( int argc, char *argv[] )
+{
+  /** Random points, in clusters, with some duplicates. */
+  vnl_random random( 787878 );
+  ListSampleType::Pointer sample = ListSampleType::New();
+  sample->SetMeasurementVectorSize( Dimension );
+  sample->Resize( NumberOfPoints );
+  for ( unsigned long i = 0; i < NumberOfPoints; ++i )
+  {
+    const double center = 10.0 * random.lrand32( 0, 4 );
+    for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+      double value = center + random.normal64();
+      if ( i % 10 == 9 )
+      {
+        value = sample->GetInternalContainer()[ i - 1 ][ d ];
+      }
+      sample->SetMeasurement( i, d, value );
+    }
+  }
+  sample->SetActualSize( NumberOfPoints );
+
+  /** The tree does not depend on the number of threads. */
+  TreeType::Pointer tree1 = CreateTree( sample, 1 );
+  TreeType::Pointer treeN = CreateTree( sample, NumberOfThreads );
+  if ( DumpTree( tree1 ) != DumpTree( treeN ) )
+  {
+    std::cerr << "ERROR: the tree depends on the number of threads.\n";
+    return 1;
+  }
+  std::cerr << "The tree is the same with 1 and " << NumberOfThreads
+    << " threads.\n";
+
+  /** The standard search. */
+  IndexMatrixType ind;
+  DistanceMatrixType dists;
+  StandardSearchType::Pointer standard1 = StandardSearchType::New();
+  StandardSearchType::Pointer standardN = StandardSearchType::New();
+  standard1->SetKNearestNeighbors( KNearestNeighbors );
+  standardN->SetKNearestNeighbors( KNearestNeighbors );
+  standard1->SetErrorBound( 0.0 );
+  standardN->SetErrorBound( 0.0 );
+  standard1->SetBinaryTree( tree1 );
+  standardN->SetBinaryTree( treeN );
+  if ( !CompareBatchSearch( "standard", standard1, standardN,
+    sample, ind, dists ) ) return 1;
+
+  /** Compare the distances of the standard search with a brute force
+   * search, for some of the points. */
+  MeasurementVectorType p( Dimension );
+  MeasurementVectorType q( Dimension );
+  std::vector< double > distances( NumberOfPoints );
+  for ( unsigned long i = 0; i < NumberOfPoints; i += 97 )
+  {
+    sample->GetMeasurementVector( i, p );
+    for ( unsigned long j = 0; j < NumberOfPoints; ++j )
+    {
+      sample->GetMeasurementVector( j, q );
+      distances[ j ] = 0.0;
+      for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+        distances[ j ] += vnl_math_sqr( p[ d ] - q[ d ] );
+      }
+    }
+    std::partial_sort( distances.begin(),
+      distances.begin() + KNearestNeighbors, distances.end() );
+    for ( unsigned int k = 0; k < KNearestNeighbors; ++k )
+    {
+      if ( vnl_math_abs( dists( i, k ) - distances[ k ] ) > 1e-10 )
+      {
+        std::cerr << "ERROR: neighbour " << k << " of point " << i
+          << " is at squared distance " << dists( i, k ) << " instead of "
+          << distances[ k ] << ".\n";
+        return 1;
+      }
+    }
+  }
+
+  /** The fixed radius search. */
+  FixedRadiusSearchType::Pointer fixedRadius1 = FixedRadiusSearchType::New();
+  FixedRadiusSearchType::Pointer fixedRadiusN = FixedRadiusSearchType::New();
+  fixedRadius1->SetKNearestNeighbors( KNearestNeighbors );
+  fixedRadiusN->SetKNearestNeighbors( KNearestNeighbors );
+  fixedRadius1->SetErrorBound( 0.0 );
+  fixedRadiusN->SetErrorBound( 0.0 );
+  fixedRadius1->SetSquaredRadius( 1.0 );
+  fixedRadiusN->SetSquaredRadius( 1.0 );
+  fixedRadius1->SetBinaryTree( tree1 );
+  fixedRadiusN->SetBinaryTree( treeN );
+  if ( !CompareBatchSearch( "fixed radius", fixedRadius1, fixedRadiusN,
+    sample, ind, dists ) ) return 1;
+
+  /** The priority search, with a nonzero error bound. */
+  PrioritySearchType::Pointer priority1 = PrioritySearchType::New();
+  PrioritySearchType::Pointer priorityN = PrioritySearchType::New();
+  priority1->SetKNearestNeighbors( KNearestNeighbors );
+  priorityN->SetKNearestNeighbors( KNearestNeighbors );
+  priority1->SetErrorBound( 0.5 );
+  priorityN->SetErrorBound( 0.5 );
+  priority1->SetBinaryTree( tree1 );
+  priorityN->SetBinaryTree( treeN );
+  if ( !CompareBatchSearch( "priority", priority1, priorityN,
+    sample, ind, dists ) ) return 1;
+
+  return 0;
+
+} // end main()
@@ -0,0 +1,342 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+#include "SplineKernelTransform/itkThinPlateR2LogRSplineKernelTransform2.h"
+#include "vnl/vnl_matrix.h"
+#include "vnl/vnl_random.h"
+#include "vnl/vnl_math.h"
+#include "vnl/algo/vnl_svd.h"
+
+#include <iostream>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// This test checks the KernelTransform2, with a 2D thin plate spline:
+//  - the inverse of L, computed with "SVD" and with "QR", gives the same
+//    W = L^-1 Y as the solve vnl_svd( L, 1e-8 ).solve( Y ) that was used
+//    before the inverse was stored;
+//  - the source landmarks are mapped on the target landmarks, and "SVD"
+//    and "QR" give the same transform;
+//  - TransformPoints() gives exactly the same points as TransformPoint();
+//  - the approximation by ComputeDisplacementGrid() is exact on the grid
+//    points, close to the exact transform in between, and not used outside
+//    the grid. This is tested with an identity and a rotated direction.
+
+const unsigned int Dimension = 2;
+const unsigned int NumberOfLandmarks = 20;
+const double DomainSize = 50.0;
+const double MaximumDisplacement = 3.0;
+
+typedef itk::ThinPlateR2LogRSplineKernelTransform2< double, Dimension > BaseTransformType;
+
+
+/** A transform that gives access to the matrices of the kernel transform. */
+class TestTransformType : public BaseTransformType
+{
+public:
+  typedef TestTransformType                 Self;
+  typedef BaseTransformType                 Superclass;
+  typedef itk::SmartPointer< Self >         Pointer;
+  typedef vnl_matrix< double >              MatrixType;
+
+  itkNewMacro( Self );
+
+  const MatrixType & GetLMatrix( void ) const { return this->m_LMatrix; }
+  const MatrixType & GetLMatrixInverse( void ) const { return this->m_LMatrixInverse; }
+  const MatrixType & GetYMatrix( void ) const { return this->m_YMatrix; }
+
+protected:
+  TestTransformType() {};
+  virtual ~TestTransformType() {};
+
+private:
+  TestTransformType( const Self& );   // purposely not implemented
+  void operator=( const Self& );      // purposely not implemented
+};
+
+typedef TestTransformType::ParametersType       ParametersType;
+typedef TestTransformType::InputPointType       PointType;
+typedef TestTransformType::OutputPointType      OutputPointType;
+typedef TestTransformType::MatrixType           MatrixType;
+typedef TestTransformType::GridOriginType       GridOriginType;
+typedef TestTransformType::GridSpacingType      GridSpacingType;
+typedef TestTransformType::GridSizeType         GridSizeType;
+typedef TestTransformType::GridDirectionType    GridDirectionType;
+
+
+/** The largest absolute value of a matrix. */
+double MaxAbs( const MatrixType & matrix )
+{
+  double maxAbs = 0.0;
+  for ( unsigned int i = 0; i < matrix.rows(); ++i )
+  {
+    for ( unsigned int j = 0; j < matrix.cols(); ++j )
+    {
+      maxAbs = vnl_math_max( maxAbs, vnl_math_abs( matrix( i, j ) ) );
+    }
+  }
+  return maxAbs;
+
+} // end MaxAbs()
+
+
+/** The distance between two points. */
+double Distance( const OutputPointType & p, const OutputPointType & q )
+{
+  return p.EuclideanDistanceTo( q );
+
+} // end Distance()
+
+
+/** Create a transform from the landmarks. */
+TestTransformType::Pointer CreateTransform( const std::string & method,
+  const ParametersType & sourceLandmarks, const ParametersType & targetLandmarks )
+{
+  TestTransformType::Pointer transform = TestTransformType::New();
+  transform->SetMatrixInversionMethod( method );
+  transform->SetFixedParameters( sourceLandmarks );
+  transform->SetParameters( targetLandmarks );
+  return transform;
+
+} // end CreateTransform()
+
+
+/** Check the inverse of L against the solve with the SVD. */
+bool TestInverse( const std::string & method, TestTransformType * transform )
+{
+  const MatrixType & L = transform->GetLMatrix();
+  const MatrixType & Y = transform->GetYMatrix();
+  const MatrixType W = transform->GetLMatrixInverse() * Y;
+  const MatrixType referenceW = vnl_svd< double >( L, 1e-8 ).solve( Y );
+
+  const double differenceW = MaxAbs( W - referenceW ) / MaxAbs( referenceW );
+  const double residual = MaxAbs( L * W - Y ) / MaxAbs( Y );
+  std::cerr << method << ": relative difference with the solve " << differenceW
+    << ", relative residual " << residual << ".\n";
+  if ( differenceW > 1e-6 || residual > 1e-6 )
+  {
+    std::cerr << "ERROR: the " << method << " inverse of L does not solve L W = Y.\n";
+    return false;
+  }
+  return true;
+
+} // end TestInverse()
+
+
+/** Check the approximation on a grid with the given direction. */
+bool TestGrid( TestTransformType * transform, const GridOriginType & origin,
+  const GridDirectionType & direction )
+{
+  GridSpacingType spacing;
+  spacing.Fill( 2.0 );
+  GridSizeType size;
+  size.Fill( 26 );
+
+  /** The grid points, with index u, and random points within the grid,
+   * with continuous index v. */
+  vnl_random random( 4321 );
+  std::vector< PointType > gridPoints;
+  std::vector< PointType > points;
+  for ( unsigned int i = 0; i < size[ 0 ]; ++i )
+  {
+    for ( unsigned int j = 0; j < size[ 1 ]; ++j )
+    {
+      double u[ Dimension ] = { static_cast<double>( i ), static_cast<double>( j ) };
+      double v[ Dimension ] = { random.drand64( 0.0, size[ 0 ] - 1.0 ),
+        random.drand64( 0.0, size[ 1 ] - 1.0 ) };
+      PointType gridPoint = origin;
+      PointType point = origin;
+      for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+        for ( unsigned int e = 0; e < Dimension; ++e )
+        {
+          gridPoint[ d ] += direction( d, e ) * u[ e ] * spacing[ e ];
+          point[ d ] += direction( d, e ) * v[ e ] * spacing[ e ];
+        }
+      }
+      gridPoints.push_back( gridPoint );
+      points.push_back( point );
+    }
+  }
+
+  /** Points outside the grid. */
+  std::vector< PointType > outsidePoints;
+  for ( unsigned int k = 0; k < 4; ++k )
+  {
+    double u[ Dimension ] = { -10.0 + 46.0 * ( k % 2 ), -10.0 + 46.0 * ( k / 2 ) };
+    PointType point = origin;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+      for ( unsigned int e = 0; e < Dimension; ++e )
+      {
+        point[ d ] += direction( d, e ) * u[ e ] * spacing[ e ];
+      }
+    }
+    outsidePoints.push_back( point );
+  }
+
+  /** The exact transform. */
+  transform->ClearDisplacementGrid();
+  std::vector< OutputPointType > exactGridPoints( gridPoints.size() );
+  std::vector< OutputPointType > exactPoints( points.size() );
+  std::vector< OutputPointType > exactOutsidePoints( outsidePoints.size() );
+  for ( unsigned int i = 0; i < gridPoints.size(); ++i )
+  {
+    exactGridPoints[ i ] = transform->TransformPoint( gridPoints[ i ] );
+    exactPoints[ i ] = transform->TransformPoint( points[ i ] );
+  }
+  for ( unsigned int i = 0; i < outsidePoints.size(); ++i )
+  {
+    exactOutsidePoints[ i ] = transform->TransformPoint( outsidePoints[ i ] );
+  }
+
+  /** The approximation. */
+  transform->ComputeDisplacementGrid( origin, spacing, size, direction );
+  if ( transform->GetDisplacementGridTransform() == 0 )
+  {
+    std::cerr << "ERROR: no displacement grid was computed.\n";
+    return false;
+  }
+  double maxGridError = 0.0;
+  double maxError = 0.0;
+  for ( unsigned int i = 0; i < gridPoints.size(); ++i )
+  {
+    maxGridError = vnl_math_max( maxGridError,
+      Distance( transform->TransformPoint( gridPoints[ i ] ), exactGridPoints[ i ] ) );
+    maxError = vnl_math_max( maxError,
+      Distance( transform->TransformPoint( points[ i ] ), exactPoints[ i ] ) );
+  }
+  std::cerr << "Grid: maximum error " << maxGridError << " on the grid points, "
+    << maxError << " in between.\n";
+  if ( maxGridError > 1e-6 )
+  {
+    std::cerr << "ERROR: the approximation is not exact on the grid points.\n";
+    return false;
+  }
+  if ( maxError > 0.05 * MaximumDisplacement )
+  {
+    std::cerr << "ERROR: the approximation is not accurate between the grid points.\n";
+    return false;
+  }
+  for ( unsigned int i = 0; i < outsidePoints.size(); ++i )
+  {
+    if ( transform->TransformPoint( outsidePoints[ i ] ) != exactOutsidePoints[ i ] )
+    {
+      std::cerr << "ERROR: the approximation is used outside the grid.\n";
+      return false;
+    }
+  }
+
+  /** The batch of points gives the same results, with the grid. */
+  std::vector< OutputPointType > batchPoints( points.size() );
+  transform->TransformPoints( &points[ 0 ], &batchPoints[ 0 ], points.size() );
+  for ( unsigned int i = 0; i < points.size(); ++i )
+  {
+    if ( batchPoints[ i ] != transform->TransformPoint( points[ i ] ) )
+    {
+      std::cerr << "ERROR: TransformPoints() differs from TransformPoint() with the grid.\n";
+      return false;
+    }
+  }
+
+  transform->ClearDisplacementGrid();
+  return true;
+
+} // end TestGrid()
+
+
+int main( int argc, char *argv[] )
+{
+  /** Random source landmarks, and target landmarks at a random displacement. */
+  vnl_random random( 1234 );
+  ParametersType sourceLandmarks( NumberOfLandmarks * Dimension );
+  ParametersType targetLandmarks( NumberOfLandmarks * Dimension );
+  for ( unsigned int i = 0; i < NumberOfLandmarks * Dimension; ++i )
+  {
+    sourceLandmarks[ i ] = random.drand64( 0.0, DomainSize );
+    targetLandmarks[ i ] = sourceLandmarks[ i ]
+      + random.drand64( -MaximumDisplacement, MaximumDisplacement ) / vnl_math::sqrt2;
+  }
+
+  TestTransformType::Pointer svdTransform
+    = CreateTransform( "SVD", sourceLandmarks, targetLandmarks );
+  TestTransformType::Pointer qrTransform
+    = CreateTransform( "QR", sourceLandmarks, targetLandmarks );
+  if ( !TestInverse( "SVD", svdTransform ) ) return 1;
+  if ( !TestInverse( "QR", qrTransform ) ) return 1;
+
+  /** The landmarks are mapped exactly, by both methods. */
+  for ( unsigned int i = 0; i < NumberOfLandmarks; ++i )
+  {
+    PointType source;
+    OutputPointType target;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+      source[ d ] = sourceLandmarks[ i * Dimension + d ];
+      target[ d ] = targetLandmarks[ i * Dimension + d ];
+    }
+    if ( Distance( svdTransform->TransformPoint( source ), target ) > 1e-6
+      || Distance( qrTransform->TransformPoint( source ), target ) > 1e-6 )
+    {
+      std::cerr << "ERROR: landmark " << i << " is not mapped on its target.\n";
+      return 1;
+    }
+  }
+
+  /** SVD and QR give the same transform, and TransformPoints() gives the
+   * same points as TransformPoint(). */
+  const unsigned int numberOfPoints = 1000;
+  std::vector< PointType > points( numberOfPoints );
+  for ( unsigned int i = 0; i < numberOfPoints; ++i )
+  {
+    for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+      points[ i ][ d ] = random.drand64( -0.2 * DomainSize, 1.2 * DomainSize );
+    }
+  }
+  std::vector< OutputPointType > batchPoints( numberOfPoints );
+  svdTransform->TransformPoints( &points[ 0 ], &batchPoints[ 0 ], numberOfPoints );
+  for ( unsigned int i = 0; i < numberOfPoints; ++i )
+  {
+    const OutputPointType svdPoint = svdTransform->TransformPoint( points[ i ] );
+    if ( Distance( svdPoint, qrTransform->TransformPoint( points[ i ] ) ) > 1e-6 )
+    {
+      std::cerr << "ERROR: SVD and QR give a different transform at "
+        << points[ i ] << ".\n";
+      return 1;
+    }
+    if ( batchPoints[ i ] != svdPoint )
+    {
+      std::cerr << "ERROR: TransformPoints() differs from TransformPoint() at "
+        << points[ i ] << ".\n";
+      return 1;
+    }
+  }
+
+  /** The approximation on a grid, with an identity and a rotated direction. */
+  GridOriginType origin;
+  origin.Fill( 0.0 );
+  GridDirectionType direction;
+  direction.SetIdentity();
+  if ( !TestGrid( svdTransform, origin, direction ) ) return 1;
+
+  const double angle = vnl_math::pi / 6.0;
+  origin[ 0 ] = 0.5 * DomainSize;
+  origin[ 1 ] = -0.25 * DomainSize;
+  direction( 0, 0 ) = vcl_cos( angle );  direction( 0, 1 ) = -vcl_sin( angle );
+  direction( 1, 0 ) = vcl_sin( angle );  direction( 1, 1 ) = vcl_cos( angle );
+  if ( !TestGrid( svdTransform, origin, direction ) ) return 1;
+
+  return 0;
+
+} // end main()
@@ -0,0 +1,184 @@
+/*======================================================================
+
+  This file is part of the elastix software.
+
+  Copyright (c) University Medical Center Utrecht. All rights reserved.
+  See src/CopyrightElastix.txt or http://elastix.isi.uu.nl/legal.php for
+  details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE. See the above copyright notices for more information.
+
+======================================================================*/
+#include "itkSimultaneousPerturbationOptimizer.h"
+#include "itkSingleValuedCostFunction.h"
+#include "vnl/vnl_math.h"
+#include <iostream>
+
+/**
+ * This test compares the gradient estimate of the
+ * itk::SimultaneousPerturbationOptimizer with that of the itk::SPSAOptimizer,
+ * with non-unit scales, several perturbations, and with and without
+ * concurrent copies of the cost function. Both optimizers draw the same
+ * perturbations.
+ */
+
+namespace itk
+{
+
+/** A cost function that is not symmetric around the test position. */
+class SPSATestCostFunction : public SingleValuedCostFunction
+{
+public:
+  typedef SPSATestCostFunction        Self;
+  typedef SingleValuedCostFunction    Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+  itkNewMacro( Self );
+  itkTypeMacro( SPSATestCostFunction, SingleValuedCostFunction );
+
+  typedef Superclass::MeasureType     MeasureType;
+  typedef Superclass::ParametersType  ParametersType;
+  typedef Superclass::DerivativeType  DerivativeType;
+
+  unsigned int GetNumberOfParameters( void ) const { return 4; }
+
+  MeasureType GetValue( const ParametersType & parameters ) const
+  {
+    MeasureType value = 0.0;
+    for ( unsigned int j = 0; j < parameters.GetSize(); ++j )
+    {
+      const double x = parameters[ j ] - static_cast<double>( j );
+      value += ( j + 1.0 ) * x * x + 0.1 * x * x * x;
+    }
+    return value;
+  }
+
+  void GetDerivative( const ParametersType &, DerivativeType & ) const
+  {
+    itkExceptionMacro( << "Not implemented." );
+  }
+
+protected:
+  SPSATestCostFunction() {}
+  virtual ~SPSATestCostFunction() {}
+};
+
+
+/** Draws the perturbations from a fixed sequence, and makes
+ * ComputeGradient() public.
+ */
+template< class TOptimizer >
+class SPSATestOptimizer : public TOptimizer
+{
+public:
+  typedef SPSATestOptimizer           Self;
+  typedef TOptimizer                  Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  itkNewMacro( Self );
+
+  typedef typename Superclass::ParametersType   ParametersType;
+  typedef typename Superclass::DerivativeType   DerivativeType;
+
+  void TestComputeGradient( const ParametersType & parameters,
+    DerivativeType & gradient )
+  {
+    this->m_Draw = 0;
+    this->ComputeGradient( parameters, gradient );
+  }
+
+protected:
+  SPSATestOptimizer() : m_Draw( 0 ) {}
+  virtual ~SPSATestOptimizer() {}
+
+  /** As in the itk::SPSAOptimizer: +1 or -1, divided by the scales. */
+  virtual void GenerateDelta( const unsigned int spaceDimension )
+  {
+    this->m_Delta = DerivativeType( spaceDimension );
+    const typename Superclass::ScalesType & scales = this->GetScales();
+    for ( unsigned int j = 0; j < spaceDimension; ++j )
+    {
+      const unsigned int bit = ( this->m_Draw * 7 + j * 3 + j * j ) % 5;
+      this->m_Delta[ j ] = ( bit < 2 ? -1.0 : 1.0 ) / scales[ j ];
+    }
+    ++this->m_Draw;
+  }
+
+private:
+  unsigned int m_Draw;
+};
+
+} // end namespace itk
+
+
+int TestGradient( unsigned int numberOfCopies )
+{
+  typedef itk::SPSATestOptimizer< itk::SPSAOptimizer >  ReferenceOptimizerType;
+  typedef itk::SPSATestOptimizer<
+    itk::SimultaneousPerturbationOptimizer >            OptimizerType;
+  typedef OptimizerType::ParametersType                 ParametersType;
+  typedef OptimizerType::DerivativeType                 DerivativeType;
+  typedef OptimizerType::ScalesType                     ScalesType;
+
+  ParametersType parameters( 4 );
+  ScalesType scales( 4 );
+  for ( unsigned int j = 0; j < 4; ++j )
+  {
+    parameters[ j ] = 0.5 * j - 1.0;
+    scales[ j ] = 0.25 + 2.0 * j;
+  }
+
+  itk::SPSATestCostFunction::Pointer costFunction
+    = itk::SPSATestCostFunction::New();
+
+  ReferenceOptimizerType::Pointer reference = ReferenceOptimizerType::New();
+  reference->SetCostFunction( costFunction );
+  reference->SetScales( scales );
+  reference->SetNumberOfPerturbations( 3 );
+  reference->Setc( 0.5 );
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetCostFunction( costFunction );
+  optimizer->SetScales( scales );
+  optimizer->SetNumberOfPerturbations( 3 );
+  optimizer->Setc( 0.5 );
+
+  if ( numberOfCopies > 0 )
+  {
+    OptimizerType::CostFunctionContainerType costFunctions;
+    costFunctions.push_back( costFunction.GetPointer() );
+    for ( unsigned int i = 0; i < numberOfCopies; ++i )
+    {
+      costFunctions.push_back(
+        itk::SPSATestCostFunction::New().GetPointer() );
+    }
+    optimizer->SetConcurrentCostFunctions( costFunctions );
+  }
+
+  DerivativeType referenceGradient;
+  DerivativeType gradient;
+  reference->TestComputeGradient( parameters, referenceGradient );
+  optimizer->TestComputeGradient( parameters, gradient );
+
+  for ( unsigned int j = 0; j < 4; ++j )
+  {
+    const double diff = vnl_math_abs( gradient[ j ] - referenceGradient[ j ] );
+    if ( diff > 1e-10 * ( 1.0 + vnl_math_abs( referenceGradient[ j ] ) ) )
+    {
+      std::cerr << "Gradient differs from the SPSAOptimizer with "
+        << numberOfCopies << " copies: " << gradient << " versus "
+        << referenceGradient << std::endl;
+      return 1;
+    }
+  }
+
+  return 0;
+
+} // end TestGradient()
+
+
+int main( int argc, char *argv[] )
+{
+  return TestGradient( 0 ) || TestGradient( 3 );
+} // end main()